@@ -6,3 +6,4 @@
 #include "cauchycoding.hh"
 #include "rscoding.hh"
 #include "evenoddcoding.hh"
+#include "lrccoding.hh"
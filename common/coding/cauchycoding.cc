@@ -31,7 +31,8 @@ CauchyCoding::CauchyCoding( uint32_t k, uint32_t m, uint32_t chunkSize ) {
 
 	this->_jmatrix = 0;
 	this->_jbitmatrix = 0;
-	this->_jschedule = 0;
+	for ( uint32_t i = 0; i < CRS_N_MAX; i++ )
+		this->_jschedule[ i ] = 0;
 #endif
 
 	// preallocate the matrix and schedule used by jerasure
@@ -42,60 +43,121 @@ CauchyCoding::~CauchyCoding() {
 #ifndef USE_ISAL
 	free( this->_jmatrix );
 	free( this->_jbitmatrix );
-	free( this->_jschedule );
+	for ( uint32_t i = 0; i < this->_m; i++ ) {
+		if ( this->_jschedule[ i ] != NULL )
+			jerasure_free_schedule( this->_jschedule[ i ] );
+	}
 #endif
 }
 
+#ifndef USE_ISAL
+CauchyDecodePlan::~CauchyDecodePlan() {
+	if ( this->dataSchedule )
+		jerasure_free_schedule( this->dataSchedule );
+	if ( this->paritySchedule )
+		jerasure_free_schedule( this->paritySchedule );
+}
+#endif
+
 void CauchyCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff, uint32_t endOff ) {
 	uint32_t k = this->_k;
-	uint32_t m = this->_m;
 	uint32_t chunkSize = this->_chunkSize;
+	dataType *data[ CRS_N_MAX ], *code[ 1 ];
 
-#ifndef USE_ISAL
+	for ( uint32_t idx = 0 ; idx < k ; idx ++ )
+		data[ idx ] = ( dataType * ) ChunkUtil::getData( dataChunks[ idx ] );
+	code[ 0 ] = ( dataType * ) ChunkUtil::getData( parityChunk );
+
+	// encode the ( index )-th parity chunk only (no buffers are needed for the other parity chunks)
+#ifdef USE_ISAL
+	ec_encode_data( chunkSize, k, 1, this->_gftbl + ( index - 1 ) * k * 32, data, code );
+#else
 	uint32_t w = this->_w;
 
 	if ( this->_jmatrix == NULL )
 		generateCodeMatrix();
 
-	int** schedule = this->_jschedule;
+	jerasure_schedule_encode( k, 1, w, this->_jschedule[ index - 1 ], data, code, chunkSize, chunkSize / w );
 #endif
-	dataType *data[ CRS_N_MAX ], *code[ CRS_N_MAX ];
+}
 
-	// use local buffer for encoding correctness
-	dataType *chunk = new dataType [ m * chunkSize ];
+void CauchyCoding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	uint32_t k = this->_k;
 
-	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
-		if ( idx < k ) {
-			data[ idx ] = ( dataType * ) ChunkUtil::getData( dataChunks[ idx ] );
-		} else if ( idx - k == index - 1 ) {
-			code[ idx - k ] = ( dataType * ) ChunkUtil::getData( parityChunk );
-		} else {
-			code[ idx - k ] = chunk + ( idx - k ) * chunkSize;
+	if ( length == 0 )
+		return;
+
+#ifdef USE_ISAL
+	dataType *code[ 1 ];
+	code[ 0 ] = ( dataType * ) ChunkUtil::getData( parity ) + offset;
+	// Use the tables of the ( parityIndex )-th row only; the update is in-place "xor"ed on the parity chunk
+	ec_encode_data_update(
+		length, k, 1, dataIndex,
+		this->_gftbl + ( parityIndex - 1 ) * k * 32,
+		( dataType * ) delta, code
+	);
+#else
+	uint32_t w = this->_w;
+	uint32_t packetSize = this->_chunkSize / w;
+	char *code = ChunkUtil::getData( parity );
+
+	if ( this->_jmatrix == NULL )
+		generateCodeMatrix();
+
+	// Rows of the bitmatrix that correspond to the ( parityIndex )-th parity chunk
+	int *bitmatrix = this->_jbitmatrix + ( parityIndex - 1 ) * w * k * w;
+
+	// Each modified data packet is XOR-ed into the parity packets whose bits are set
+	for ( uint32_t c = offset / packetSize; c <= ( offset + length - 1 ) / packetSize; c++ ) {
+		uint32_t start = c * packetSize, end = start + packetSize;
+		if ( start < offset ) start = offset;
+		if ( end > offset + length ) end = offset + length;
+
+		for ( uint32_t r = 0; r < w; r++ ) {
+			if ( ! bitmatrix[ r * k * w + dataIndex * w + c ] )
+				continue;
+			char *dst = code + r * packetSize + ( start - c * packetSize );
+			Coding::bitwiseXOR( dst, dst, delta + ( start - offset ), end - start );
 		}
 	}
+#endif
+}
 
-	// encode
+bool CauchyCoding::getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients ) {
 #ifdef USE_ISAL
-	ec_encode_data( chunkSize, k, m, this->_gftbl, data, code );
+	uint32_t k = this->_k;
+	return Coding::solveRepairCoefficients( this->_encodeMatrix + k * k, k, chunkId, helperIds, count, coefficients );
 #else
-	jerasure_schedule_encode( k, m, w, schedule, data, code, chunkSize, chunkSize / w );
+	// The bitmatrix operates on packets rather than bytes
+	return false;
 #endif
+}
 
-	delete chunk;
+void CauchyCoding::getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength ) {
+#ifdef USE_ISAL
+	parityOffset = offset;
+	parityLength = length;
+#else
+	// A data packet is XOR-ed into the parity packets of any rows of the bitmatrix
+	parityOffset = 0;
+	parityLength = length ? this->_chunkSize : 0;
+#endif
 }
 
 bool CauchyCoding::decode( Chunk **chunks, BitmaskArray * chunkStatus ) {
+	return this->decodeStripes( &chunks, chunkStatus, 0, 1 );
+}
+
+bool CauchyCoding::decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to ) {
 	uint32_t k = this->_k;
 	uint32_t m = this->_m;
-#ifndef USE_ISAL
-	uint32_t w = this->_w;
-#endif
 	uint32_t chunkSize = this->_chunkSize;
 
+	int erasures[ CRS_N_MAX ];
 	uint32_t failed = 0;
 	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
 		if ( chunkStatus->check( idx ) ==  0) {
-			failed++;
+			erasures[ failed++ ] = idx;
 		}
 	}
 
@@ -109,74 +171,149 @@ bool CauchyCoding::decode( Chunk **chunks, BitmaskArray * chunkStatus ) {
 		return true;
 	}
 
-	int erasures[ CRS_N_MAX ];
-	int pos = 0;
-	dataType *data[ CRS_N_MAX ], *code[ CRS_N_MAX ];
-#ifdef USE_ISAL
-	int rpos = 0;
-	dataType *alive[ CRS_N_MAX ], *missing[ CRS_N_MAX ];
+#ifndef USE_ISAL
+	if ( this->_jmatrix == NULL )
+		generateCodeMatrix();
 #endif
 
-	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
-		if ( idx < k )
-			data[ idx ] = ( dataType * ) ChunkUtil::getData( chunks[ idx ] );
-		else
-			code[ idx - k ] = ( dataType * ) ChunkUtil::getData( chunks[ idx ] );
+	// reuse the plan if the same set of chunks was lost before
+	uint64_t key;
+	std::shared_ptr<CauchyDecodePlan> plan;
+	if ( ! DecodePlanCache<CauchyDecodePlan>::getKey( chunkStatus, k + m, key ) ) {
+		// the pattern does not fit into a cache key: use the plan once
+		plan.reset( this->createDecodePlan( erasures, failed ) );
+		if ( ! plan )
+			return false;
+	} else {
+		plan = this->_planCache.get( key );
+		if ( ! plan ) {
+			CauchyDecodePlan *newPlan = this->createDecodePlan( erasures, failed );
+			if ( ! newPlan )
+				return false;
+			plan = this->_planCache.insert( key, newPlan );
+		}
+	}
 
+	// decode
 #ifdef USE_ISAL
-		if ( chunkStatus->check( idx ) == 0 ) {
-			erasures[ pos ] = idx;
-			missing[ pos++ ] = ( idx < k )? data[ idx ] : code[ idx - k ];
-		} else {
-			alive[ rpos++ ] = ( idx < k )? data[ idx ] : code[ idx - k ];
-		}
+	dataType *alive[ CRS_N_MAX ], *missing[ CRS_N_MAX ];
+	for ( uint32_t s = from; s < to; s++ ) {
+		Chunk **chunks = stripes[ s ];
+		for ( uint32_t i = 0; i < k; i++ )
+			alive[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ plan->alive[ i ] ] );
+		for ( uint32_t i = 0; i < failed; i++ )
+			missing[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ plan->erasures[ i ] ] );
+		ec_encode_data( chunkSize, k, failed, &plan->gftbl[ 0 ], alive, missing );
+	}
 #else
-		if ( chunkStatus->check( idx ) == 0 ) {
-			erasures[ pos++ ] = idx;
+	uint32_t packetSize = chunkSize / this->_w;
+	char *ptrs[ CRS_N_MAX * 2 ];
+
+	for ( uint32_t s = from; s < to; s++ ) {
+		Chunk **chunks = stripes[ s ];
+		if ( plan->dataSchedule ) {
+			for ( uint32_t i = 0; i < k; i++ )
+				ptrs[ i ] = ChunkUtil::getData( chunks[ plan->srcIds[ i ] ] );
+			for ( uint32_t i = 0; i < plan->lostData.size(); i++ )
+				ptrs[ k + i ] = ChunkUtil::getData( chunks[ plan->lostData[ i ] ] );
+			jerasure_do_scheduled_operations( ptrs, plan->dataSchedule, packetSize );
+		}
+		if ( plan->paritySchedule ) {
+			for ( uint32_t i = 0; i < k; i++ )
+				ptrs[ i ] = ChunkUtil::getData( chunks[ i ] );
+			for ( uint32_t i = 0; i < plan->lostParity.size(); i++ )
+				ptrs[ k + i ] = ChunkUtil::getData( chunks[ plan->lostParity[ i ] ] );
+			jerasure_do_scheduled_operations( ptrs, plan->paritySchedule, packetSize );
 		}
+	}
 #endif
 
-	}
+	return true;
+}
 
-	// required for jerasure
-	erasures[ failed ] = -1;
+CauchyDecodePlan *CauchyCoding::createDecodePlan( int *erasures, uint32_t failed ) {
+	uint32_t k = this->_k;
+	uint32_t m = this->_m;
+	CauchyDecodePlan *plan = new CauchyDecodePlan();
+	int lost[ CRS_N_MAX ];
+
+	plan->failed = failed;
+	memcpy( plan->erasures, erasures, sizeof( int ) * failed );
+	memset( lost, 0, sizeof( lost ) );
+	for ( uint32_t i = 0; i < failed; i++ )
+		lost[ erasures[ i ] ] = 1;
 
-	// decode
 #ifdef USE_ISAL
 	dataType decodeMatrix[ CRS_N_MAX * CRS_N_MAX ];
 	dataType invertedMatrix[ CRS_N_MAX * CRS_N_MAX ];
-	dataType gftbl[ CRS_N_MAX * CRS_N_MAX * 32 ];
-	// get the row where data is alive
-	for ( uint32_t i = 0, pos = 0, oi = 0; i < k+m; i++ ) {
-		if ( ( int ) i != erasures[ pos ] ) {
-			memcpy( decodeMatrix + k * oi, this->_encodeMatrix + k * i, k );
-			oi++;
-		} else if ( ( int ) i == erasures[ pos ] ) {
-			pos++;
-		}
+	// get the rows of the first k alive chunks
+	for ( uint32_t i = 0, oi = 0; i < k + m && oi < k; i++ ) {
+		if ( lost[ i ] )
+			continue;
+		memcpy( decodeMatrix + k * oi, this->_encodeMatrix + k * i, k );
+		plan->alive[ oi++ ] = i;
 	}
 	// get the inverse of the matrix of alive data
 	if ( gf_invert_matrix( decodeMatrix, invertedMatrix, k ) < 0 ) {
 		fprintf( stderr, "Cannot find the inverse for decoding ...\n" );
-		return false;
+		delete plan;
+		return 0;
 	}
-	memset( decodeMatrix, 0, CRS_N_MAX * CRS_N_MAX );
+	// express each lost chunk in terms of the alive chunks
 	for ( uint32_t i = 0; i < failed; i++ ) {
-		memcpy( decodeMatrix + k * i, invertedMatrix + k * erasures[ i ], k );
+		uint32_t e = erasures[ i ];
+		if ( e < k ) {
+			memcpy( decodeMatrix + k * i, invertedMatrix + k * e, k );
+		} else {
+			// parity: multiply its row in the encoding matrix with the inverse
+			for ( uint32_t j = 0; j < k; j++ ) {
+				dataType s = 0;
+				for ( uint32_t l = 0; l < k; l++ )
+					s ^= gf_mul( this->_encodeMatrix[ k * e + l ], invertedMatrix[ k * l + j ] );
+				decodeMatrix[ k * i + j ] = s;
+			}
+		}
 	}
-	ec_init_tables( k, failed, decodeMatrix, gftbl );
-	ec_encode_data( chunkSize, k, failed, gftbl, alive, missing );
+	plan->gftbl.resize( k * failed * 32 );
+	ec_init_tables( k, failed, decodeMatrix, &plan->gftbl[ 0 ] );
 #else
-	if ( this->_jmatrix == NULL )
-		generateCodeMatrix();
+	uint32_t w = this->_w;
+	uint32_t rowSize = k * w * w; // size of the rows of the bitmatrix for one chunk
 
-	int* bitmatrix = this->_jbitmatrix;
+	for ( uint32_t i = 0; i < failed; i++ ) {
+		if ( ( uint32_t ) erasures[ i ] < k )
+			plan->lostData.push_back( erasures[ i ] );
+		else
+			plan->lostParity.push_back( erasures[ i ] );
+	}
+
+	if ( plan->lostData.size() > 0 ) {
+		std::vector<int> decodingMatrix( k * rowSize );
+		std::vector<int> rows;
+		plan->srcIds.resize( k );
+		if ( jerasure_make_decoding_bitmatrix( k, m, w, this->_jbitmatrix, lost, &decodingMatrix[ 0 ], &plan->srcIds[ 0 ] ) < 0 ) {
+			fprintf( stderr, "Cannot find the inverse for decoding ...\n" );
+			delete plan;
+			return 0;
+		}
+		for ( uint32_t i = 0; i < plan->lostData.size(); i++ ) {
+			int *row = &decodingMatrix[ 0 ] + plan->lostData[ i ] * rowSize;
+			rows.insert( rows.end(), row, row + rowSize );
+		}
+		plan->dataSchedule = jerasure_smart_bitmatrix_to_schedule( k, plan->lostData.size(), w, &rows[ 0 ] );
+	}
 
-	jerasure_schedule_decode_lazy( k, m, w, bitmatrix, erasures, data, code,
-			chunkSize, chunkSize / w, 1 );
+	if ( plan->lostParity.size() > 0 ) {
+		std::vector<int> rows;
+		for ( uint32_t i = 0; i < plan->lostParity.size(); i++ ) {
+			int *row = this->_jbitmatrix + ( plan->lostParity[ i ] - k ) * rowSize;
+			rows.insert( rows.end(), row, row + rowSize );
+		}
+		plan->paritySchedule = jerasure_smart_bitmatrix_to_schedule( k, plan->lostParity.size(), w, &rows[ 0 ] );
+	}
 #endif
 
-	return true;
+	return plan;
 }
 
 uint32_t CauchyCoding::getW() {
@@ -218,8 +355,10 @@ void CauchyCoding::generateCodeMatrix() {
 		free( this->_jmatrix );
 	if ( this->_jbitmatrix != NULL )
 		free( this->_jbitmatrix );
-	if ( this->_jschedule != NULL )
-		free( this->_jschedule );
+	for ( uint32_t i = 0; i < m; i++ ) {
+		if ( this->_jschedule[ i ] != NULL )
+			jerasure_free_schedule( this->_jschedule[ i ] );
+	}
 
 	this->_jmatrix = cauchy_good_general_coding_matrix( k, m, w );
 	if ( this ->_jmatrix == NULL ) {
@@ -230,7 +369,9 @@ void CauchyCoding::generateCodeMatrix() {
 
 	this->_jbitmatrix = jerasure_matrix_to_bitmatrix( k, m, w, this->_jmatrix );
 
-	this->_jschedule = jerasure_smart_bitmatrix_to_schedule( k, m , w, this->_jbitmatrix );
+	// separate schedules so that each parity chunk can be encoded on its own
+	for ( uint32_t i = 0; i < m; i++ )
+		this->_jschedule[ i ] = jerasure_smart_bitmatrix_to_schedule( k, 1, w, this->_jbitmatrix + i * k * w * w );
 #endif
 
 }
@@ -1,9 +1,43 @@
 #ifndef __COMMON_CODING_CAUCHYCODING_HH__
 #define __COMMON_CODING_CAUCHYCODING_HH__
 
+#include <vector>
 #include "coding.hh"
+#include "decode_plan_cache.hh"
 #define CRS_N_MAX	(32)
 
+/**
+ * Everything needed to decode a stripe with a given erasure pattern,
+ * derived from the (inverted) coding matrix.
+ */
+struct CauchyDecodePlan {
+	uint32_t failed;
+	int erasures[ CRS_N_MAX ];
+#ifdef USE_ISAL
+	// The k available chunks used for decoding
+	uint32_t alive[ CRS_N_MAX ];
+	// Tables of the rows that recover the lost chunks from alive chunks
+	std::vector<unsigned char> gftbl;
+#else
+	// XOR schedule that recovers the lost data chunks from the k available
+	// chunks in srcIds (ids 0 to k - 1 in the schedule refer to srcIds and
+	// ids from k onwards refer to lostData)
+	std::vector<int> srcIds;
+	std::vector<int> lostData;
+	int **dataSchedule;
+	// XOR schedule that re-encodes the lost parity chunks from the data chunks
+	std::vector<int> lostParity;
+	int **paritySchedule;
+
+	CauchyDecodePlan() {
+		this->dataSchedule = 0;
+		this->paritySchedule = 0;
+	}
+
+	~CauchyDecodePlan();
+#endif
+};
+
 class CauchyCoding : public Coding {
 private:
 	/**
@@ -22,6 +56,19 @@ private:
 	 */
 	void generateCodeMatrix();
 
+	/**
+	 * Invert the coding matrix for an erasure pattern
+	 *
+	 * @param erasures indices of the lost chunks
+	 * @param failed   number of lost chunks
+	 * @return         the decode plan; NULL if the pattern is not decodable
+	 */
+	CauchyDecodePlan *createDecodePlan( int *erasures, uint32_t failed );
+protected:
+	bool decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to );
+
+private:
+
 	uint32_t _k;
 	uint32_t _m;
 	uint32_t _w;
@@ -33,15 +80,20 @@ private:
 #else
 	int *_jmatrix;
 	int *_jbitmatrix;
-	int **_jschedule;
+	int **_jschedule[ CRS_N_MAX ]; // one schedule per parity chunk
 #endif
 
+	DecodePlanCache<CauchyDecodePlan> _planCache;
+
 public:
 	CauchyCoding( uint32_t k = 0, uint32_t m = 0, uint32_t chunkSize = 0 );
 	~CauchyCoding();
 
 	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 );
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
+	void getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength );
 	bool decode( Chunk **chunks, BitmaskArray *chunkStatus );
+	bool getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients );
 
 };
 
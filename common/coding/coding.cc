@@ -1,20 +1,63 @@
+#include <algorithm>
 #include <cassert>
+#include <vector>
 #include "coding.hh"
 #include "all_coding.hh"
+#include "fixed_coding.hh"
+#include "xor_kernel.hh"
 #include "../util/debug.hh"
 #include "../ds/chunk_pool.hh"
 #include "../ds/chunk_util.hh"
 
+#ifndef USE_ISAL
+extern "C" {
+#include "../../lib/jerasure/include/galois.h"
+}
+#else
+#include "../../lib/isa-l-2.14.0/include/erasure_code.h"
+#endif
+
+#define GF_W (8)
+#define GF_REGION_ALIGNMENT (16)
+#define GF_REGION_BUFFER_SIZE (4096)
+
+#define XOR_SOURCE_BATCH ( 32 )
+
 Chunk *Coding::zeros;
 
+struct CodingScratchBuffers {
+	char *buffers[ CODING_SCRATCH_COUNT ];
+	uint32_t sizes[ CODING_SCRATCH_COUNT ];
+
+	CodingScratchBuffers() {
+		for ( uint32_t i = 0; i < CODING_SCRATCH_COUNT; i++ ) {
+			this->buffers[ i ] = 0;
+			this->sizes[ i ] = 0;
+		}
+	}
+
+	~CodingScratchBuffers() {
+		for ( uint32_t i = 0; i < CODING_SCRATCH_COUNT; i++ )
+			free( this->buffers[ i ] );
+	}
+};
+
+static thread_local CodingScratchBuffers scratchBuffers;
+
 Coding::~Coding() {}
 
-Coding *Coding::instantiate( CodingScheme scheme, CodingParams &params, uint32_t chunkSize ) {
+Coding *Coding::instantiate( CodingScheme scheme, CodingParams &params, uint32_t chunkSize, bool specialized ) {
 	// Initialize zero block
 	ChunkUtil::chunkSize = chunkSize;
 	TempChunkPool tempChunkPool;
 	Coding::zeros = tempChunkPool.alloc();
 
+	if ( specialized ) {
+		Coding *coding = FixedCoding::instantiate( scheme, params, chunkSize );
+		if ( coding )
+			return coding;
+	}
+
 	switch( scheme ) {
 		case CS_RAID0:
 		{
@@ -45,6 +88,8 @@ Coding *Coding::instantiate( CodingScheme scheme, CodingParams &params, uint32_t
 			return new EvenOddCoding( params.getK(), chunkSize );
 		case CS_CAUCHY:
 			return new CauchyCoding( params.getK(), params.getM(), chunkSize );
+		case CS_LRC:
+			return new LRCCoding( params.getK(), params.getM(), params.getL(), chunkSize );
 		default:
 			break;
 	}
@@ -76,6 +121,9 @@ void Coding::destroy( Coding *coding ) {
 		case CS_CAUCHY:
 			delete static_cast<CauchyCoding *>( coding );
 			break;
+		case CS_LRC:
+			delete static_cast<LRCCoding *>( coding );
+			break;
 		default:
 			return;
 	}
@@ -85,25 +133,213 @@ void Coding::destroy( Coding *coding ) {
 	}
 }
 
-char *Coding::bitwiseXOR( char *dst, char *srcA, char *srcB, uint32_t len ) {
-	uint64_t *srcA64 = ( uint64_t * ) srcA;
-	uint64_t *srcB64 = ( uint64_t * ) srcB;
-	uint64_t *dst64 = ( uint64_t * ) dst;
+void Coding::encodeDeltaByStripe( uint32_t dataChunkCount, uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	uint32_t bufferSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize;
+	Chunk **dataChunks = ( Chunk ** ) Coding::getScratch( CODING_SCRATCH_DELTA_STRIPE, dataChunkCount * sizeof( Chunk * ) );
+	Chunk *dataChunk = ( Chunk * ) Coding::getScratch( CODING_SCRATCH_DELTA_DATA, bufferSize );
+	Chunk *parityChunk = ( Chunk * ) Coding::getScratch( CODING_SCRATCH_DELTA_PARITY, bufferSize );
+
+	ChunkUtil::clear( dataChunk );
+	ChunkUtil::clear( parityChunk );
+
+	for ( uint32_t i = 0; i < dataChunkCount; i++ )
+		dataChunks[ i ] = Coding::zeros;
+	dataChunks[ dataIndex ] = dataChunk;
+	ChunkUtil::copy( dataChunk, offset, delta, length );
+
+	this->encode(
+		dataChunks, parityChunk, parityIndex,
+		dataIndex * ChunkUtil::chunkSize + offset,
+		dataIndex * ChunkUtil::chunkSize + offset + length
+	);
+	Coding::bitwiseXOR( parity, parity, parityChunk, ChunkUtil::chunkSize );
+}
+
+void Coding::getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength ) {
+	parityOffset = offset;
+	parityLength = length;
+}
+
+uint32_t Coding::getRepairSet( uint32_t chunkId, uint32_t *chunkIds ) {
+	return 0;
+}
+
+bool Coding::getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients ) {
+	return false;
+}
+
+uint8_t Coding::gfMultiply( uint8_t a, uint8_t b ) {
+#ifdef USE_ISAL
+	return gf_mul( a, b );
+#else
+	return ( uint8_t ) galois_single_multiply( a, b, GF_W );
+#endif
+}
+
+uint8_t Coding::gfInverse( uint8_t a ) {
+#ifdef USE_ISAL
+	return gf_inv( a );
+#else
+	return ( uint8_t ) galois_single_divide( 1, a, GF_W );
+#endif
+}
+
+void Coding::initMultiplyTables( uint8_t *coefficients, uint32_t count, unsigned char *tables ) {
+	for ( uint32_t i = 0; i < count; i++ ) {
+		for ( uint32_t x = 0; x < 16; x++ ) {
+			tables[ i * FIXED_GF_TABLE_SIZE + x ] = gfMultiply( coefficients[ i ], ( uint8_t ) x );
+			tables[ i * FIXED_GF_TABLE_SIZE + 16 + x ] = gfMultiply( coefficients[ i ], ( uint8_t ) ( x << 4 ) );
+		}
+	}
+}
+
+bool Coding::solveRepairCoefficients( uint8_t *parityRows, uint32_t k, uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients ) {
+	std::vector<uint8_t> selected( k * k ), inverted( k * k, 0 ), lost( k, 0 );
+
+	if ( count != k )
+		return false;
+
+	for ( uint32_t i = 0; i < k; i++ ) {
+		if ( helperIds[ i ] < k )
+			selected[ i * k + helperIds[ i ] ] = 1;
+		else
+			memcpy( &selected[ i * k ], parityRows + ( helperIds[ i ] - k ) * k, k );
+		inverted[ i * k + i ] = 1;
+	}
+	if ( chunkId < k )
+		lost[ chunkId ] = 1;
+	else
+		memcpy( &lost[ 0 ], parityRows + ( chunkId - k ) * k, k );
 
-	uint64_t xor64Count = len / sizeof( uint64_t );
-	uint64_t i = 0;
+	// invert the matrix of the helper rows (Gauss-Jordan elimination)
+	for ( uint32_t i = 0; i < k; i++ ) {
+		uint32_t p = i;
+		while ( p < k && selected[ p * k + i ] == 0 )
+			p++;
+		if ( p == k )
+			return false; // linearly dependent
+		if ( p != i ) {
+			for ( uint32_t j = 0; j < k; j++ ) {
+				std::swap( selected[ p * k + j ], selected[ i * k + j ] );
+				std::swap( inverted[ p * k + j ], inverted[ i * k + j ] );
+			}
+		}
+		uint8_t f = gfInverse( selected[ i * k + i ] );
+		for ( uint32_t j = 0; j < k; j++ ) {
+			selected[ i * k + j ] = gfMultiply( f, selected[ i * k + j ] );
+			inverted[ i * k + j ] = gfMultiply( f, inverted[ i * k + j ] );
+		}
+		for ( uint32_t r = 0; r < k; r++ ) {
+			f = selected[ r * k + i ];
+			if ( r == i || f == 0 )
+				continue;
+			for ( uint32_t j = 0; j < k; j++ ) {
+				selected[ r * k + j ] ^= gfMultiply( f, selected[ i * k + j ] );
+				inverted[ r * k + j ] ^= gfMultiply( f, inverted[ i * k + j ] );
+			}
+		}
+	}
+
+	// data chunk #d = sum over i of inverted[ d ][ i ] * helper #i, so the
+	// lost chunk = sum over d of lost[ d ] * data chunk #d
+	for ( uint32_t i = 0; i < k; i++ ) {
+		uint8_t c = 0;
+		for ( uint32_t d = 0; d < k; d++ ) {
+			if ( lost[ d ] )
+				c ^= gfMultiply( lost[ d ], inverted[ d * k + i ] );
+		}
+		coefficients[ i ] = c;
+	}
+	return true;
+}
+
+bool Coding::decodeBatch( Chunk ***chunks, uint32_t count, BitmaskArray *bitmap ) {
+	return this->decodeStripes( chunks, bitmap, 0, count );
+}
+
+bool Coding::decodeStripes( Chunk ***chunks, BitmaskArray *bitmap, uint32_t from, uint32_t to ) {
+	bool ret = true;
+	for ( uint32_t i = from; i < to; i++ )
+		ret = this->decode( chunks[ i ], bitmap ) && ret;
+	return ret;
+}
 
-	// Word-by-word XOR
-	for ( i = 0; i < xor64Count; i++ ) {
-		dst64[ i ] = srcA64[ i ] ^ srcB64[ i ];
+char *Coding::getScratch( CodingScratch type, uint32_t size ) {
+	CodingScratchBuffers &scratch = scratchBuffers;
+
+	if ( scratch.sizes[ type ] < size ) {
+		free( scratch.buffers[ type ] );
+		scratch.buffers[ type ] = ( char * ) malloc( size );
+		if ( ! scratch.buffers[ type ] ) {
+			__ERROR__( "Coding", "getScratch", "Cannot allocate a scratch buffer of %u bytes.", size );
+			exit( -1 );
+		}
+		scratch.sizes[ type ] = size;
 	}
+	return scratch.buffers[ type ];
+}
+
+char *Coding::bitwiseXOR( char *dst, char *srcA, char *srcB, uint32_t len ) {
+	XORKernel::xor2( dst, srcA, srcB, len );
+	return dst;
+}
+
+char *Coding::bitwiseXOR( char *dst, char **srcs, uint32_t count, uint32_t len ) {
+	XORKernel::xorN( dst, srcs, count, len );
+	return dst;
+}
 
-	i = xor64Count * sizeof( uint64_t );
+Chunk *Coding::accumulateXOR( Chunk *dst, Chunk **srcs, uint32_t count, uint32_t size, int skip ) {
+	char *inputs[ XOR_SOURCE_BATCH ];
+	uint32_t n = 0;
 
-	for ( ; i < len; i++ ) {
-		dst[ i ] = srcA[ i ] ^ srcB[ i ];
+	inputs[ n++ ] = ChunkUtil::getData( dst );
+	for ( uint32_t i = 0; i < count; i++ ) {
+		if ( ( int ) i == skip )
+			continue;
+		inputs[ n++ ] = ChunkUtil::getData( srcs[ i ] );
+		if ( n == XOR_SOURCE_BATCH ) {
+			XORKernel::xorN( inputs[ 0 ], inputs, n, size );
+			n = 1;
+		}
 	}
+	if ( n > 1 )
+		XORKernel::xorN( inputs[ 0 ], inputs, n, size );
+
+	return dst;
+}
 
+char *Coding::bitwiseXORDelta( char *delta, char *data, char *newData, uint32_t len ) {
+	XORKernel::delta( delta, data, newData, len );
+	return delta;
+}
+
+char *Coding::multiplyXOR( char *dst, char *src, uint8_t coefficient, uint32_t len ) {
+	if ( coefficient == 0 || len == 0 )
+		return dst;
+	if ( coefficient == 1 )
+		return Coding::bitwiseXOR( dst, dst, src, len );
+
+#ifdef USE_ISAL
+	unsigned char gftbl[ 32 ];
+	gf_vect_mul_init( coefficient, gftbl );
+	gf_vect_mad( len, 1, 0, gftbl, ( unsigned char * ) src, ( unsigned char * ) dst );
+#else
+	if ( ( ( uintptr_t ) src - ( uintptr_t ) dst ) % GF_REGION_ALIGNMENT == 0 ) {
+		galois_w08_region_multiply( src, coefficient, len, dst, 1 );
+	} else {
+		// gf-complete requires the source and destination to be aligned with respect to each other
+		char buf[ GF_REGION_BUFFER_SIZE + GF_REGION_ALIGNMENT ];
+		char *aligned = buf + ( ( uintptr_t ) dst - ( uintptr_t ) buf ) % GF_REGION_ALIGNMENT;
+		for ( uint32_t pos = 0, size; pos < len; pos += size ) {
+			size = len - pos;
+			if ( size > GF_REGION_BUFFER_SIZE )
+				size = GF_REGION_BUFFER_SIZE;
+			memcpy( aligned, src + pos, size );
+			galois_w08_region_multiply( aligned, coefficient, size, dst + pos, 1 );
+		}
+	}
+#endif
 	return dst;
 }
 
@@ -118,7 +354,6 @@ Chunk *Coding::bitwiseXOR( Chunk *dst, Chunk *srcA, Chunk *srcB, uint32_t size )
 }
 
 uint32_t Coding::forceSeal( Coding *coding, Chunk **chunks, Chunk *tmpParityChunk, bool **sealIndicator, uint32_t dataChunkCount, uint32_t parityChunkCount ) {
-	Chunk **tmpChunks = new Chunk *[ dataChunkCount ];
 	bool *trueSealIndicator = sealIndicator[ parityChunkCount ];
 	uint32_t fixedDataCount = 0;
 
@@ -154,23 +389,10 @@ uint32_t Coding::forceSeal( Coding *coding, Chunk **chunks, Chunk *tmpParityChun
 				assert( trueSealIndicator[ j ] );
 
 				// Seal the i-th parity chunk with the j-th data chunk
-				for ( uint32_t k = 0; k < dataChunkCount; k++ ) {
-					tmpChunks[ k ] = ( k == j ) ? chunks[ j ] : Coding::zeros;
-				}
-
-				ChunkUtil::clear( tmpParityChunk );
-
-				coding->encode(
-					tmpChunks, tmpParityChunk, i,
-					0, ChunkUtil::chunkSize
-				);
-
-				char *parity = ChunkUtil::getData( chunks[ i + dataChunkCount ] );
-				Coding::bitwiseXOR(
-					parity,
-					parity,
-					ChunkUtil::getData( tmpParityChunk ),
-					ChunkUtil::chunkSize
+				coding->encodeDelta(
+					j, ChunkUtil::getData( chunks[ j ] ),
+					0, ChunkUtil::chunkSize,
+					i + 1, chunks[ i + dataChunkCount ]
 				);
 				sealIndicator[ i ][ j ] = true;
 
@@ -179,7 +401,5 @@ uint32_t Coding::forceSeal( Coding *coding, Chunk **chunks, Chunk *tmpParityChun
 		}
 	}
 
-	delete[] tmpChunks;
-
 	return fixedDataCount;
 }
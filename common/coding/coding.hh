@@ -6,7 +6,65 @@
 #include "../ds/chunk.hh"
 #include "../ds/bitmask_array.hh"
 
+// Scratch buffers of a thread that may be in use at the same time
+enum CodingScratch {
+	CODING_SCRATCH_ENCODE,
+	CODING_SCRATCH_DECODE,
+	CODING_SCRATCH_DELTA_STRIPE,
+	CODING_SCRATCH_DELTA_DATA,
+	CODING_SCRATCH_DELTA_PARITY,
+	CODING_SCRATCH_COUNT
+};
+
 class Coding {
+protected:
+	/**
+	 * Generic (slow) implementation of encodeDelta() that encodes a
+	 * whole stripe with only the modified data chunk being non-zero.
+	 */
+	void encodeDeltaByStripe( uint32_t dataChunkCount, uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
+
+	/**
+	 * Get a scratch buffer private to the calling (worker) thread. Since a
+	 * coding instance is shared by all workers, temporary buffers are kept
+	 * per thread and reused across calls instead of being allocated on
+	 * every encode/decode. The content of the buffer is undefined.
+	 *
+	 * @param type which buffer to use
+	 * @param size minimum size of the buffer
+	 * @return     the buffer
+	 */
+	static char *getScratch( CodingScratch type, uint32_t size );
+
+	/**
+	 * Decode the stripes [ from, to ) of a batch. All stripes have lost the
+	 * same set of chunks.
+	 */
+	virtual bool decodeStripes( Chunk ***chunks, BitmaskArray *bitmap, uint32_t from, uint32_t to );
+
+	static uint8_t gfMultiply( uint8_t a, uint8_t b );
+	static uint8_t gfInverse( uint8_t a );
+
+	/**
+	 * Build the tables used by the GF(2^8) kernels of FixedKernel: 16
+	 * products of each coefficient with the low nibbles followed by 16
+	 * products with the high nibbles.
+	 *
+	 * @param coefficients constants in GF(2^8)
+	 * @param count        number of coefficients
+	 * @param tables       (output) count * FIXED_GF_TABLE_SIZE bytes
+	 */
+	static void initMultiplyTables( uint8_t *coefficients, uint32_t count, unsigned char *tables );
+
+	/**
+	 * Solve for the repair coefficients of k helper chunks given the coding
+	 * matrix in GF(2^8), where chunk i < k is the i-th data chunk and chunk
+	 * k + j is encoded with parityRows[ j * k ] ... parityRows[ j * k + k - 1 ].
+	 *
+	 * @return false if the rows of the helper chunks are not independent
+	 */
+	static bool solveRepairCoefficients( uint8_t *parityRows, uint32_t k, uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients );
+
 public:
 	CodingScheme scheme;
 	static Chunk *zeros;
@@ -30,6 +88,30 @@ public:
 	 */
 	virtual void encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 ) = 0;
 
+	/**
+	 * Compute the parity delta caused by a data delta and apply it to a
+	 * parity chunk in place. The cost is proportional to the modified range.
+	 *
+	 * @param dataIndex   index of the modified data chunk (0-based)
+	 * @param delta       data delta (XOR of old and new data) of the modified range
+	 * @param offset      starting offset of the modified range in the data chunk
+	 * @param length      length of the modified range
+	 * @param parityIndex indicate which parity chunk should be updated (1-based, same as encode())
+	 * @param parity      the parity chunk to be updated (XOR-ed with the parity delta)
+	 */
+	virtual void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) = 0;
+
+	/**
+	 * Get the range of the parity chunk that encodeDelta() modifies for the
+	 * same arguments, e.g., for preserving it before the update. By default
+	 * it is the modified range of the data chunk, as in the schemes that
+	 * combine the bytes at the same offset of the data chunks.
+	 *
+	 * @param parityOffset (output) starting offset of the range in the parity chunk
+	 * @param parityLength (output) length of the range (covering the gaps between the modified parts)
+	 */
+	virtual void getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength );
+
 	/**
 	 * Decode k data/parity chunks.
 	 *
@@ -39,7 +121,51 @@ public:
 	 */
 	virtual bool decode( Chunk **chunks, BitmaskArray *bitmap ) = 0;
 
-	static Coding *instantiate( CodingScheme scheme, CodingParams &params, uint32_t chunkSize );
+	/**
+	 * Get the chunks that suffice to reconstruct a single lost chunk if the
+	 * scheme can do so with fewer than k chunks (e.g., from a local group).
+	 * Passing only these chunks (and marking the rest as available) to
+	 * decode() reconstructs the lost chunk.
+	 *
+	 * @param  chunkId  the lost chunk
+	 * @param  chunkIds (output) chunks to be read; at least k - 1 entries
+	 * @return          number of entries in chunkIds; 0 if any k chunks are needed
+	 */
+	virtual uint32_t getRepairSet( uint32_t chunkId, uint32_t *chunkIds );
+
+	/**
+	 * Express a lost chunk as a linear combination of helper chunks in
+	 * GF(2^8), i.e., chunk = XOR of ( coefficients[ i ] * helperIds[ i ]-th chunk ),
+	 * so that each helper can add its own term to a partial result (see
+	 * multiplyXOR()) instead of sending its whole chunk to the decoder.
+	 *
+	 * @param  chunkId      the lost chunk
+	 * @param  helperIds    chunks to be combined (k chunks, or a repair set returned by getRepairSet())
+	 * @param  count        number of entries in helperIds
+	 * @param  coefficients (output) coefficient of each helper chunk
+	 * @return              false if the scheme is not a linear code over GF(2^8) or the helpers do not suffice
+	 */
+	virtual bool getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients );
+
+	/**
+	 * Decode multiple stripes that have lost the same set of chunks in one
+	 * call. The decode plan is looked up once instead of once per stripe,
+	 * and the stripes are processed lost chunk by lost chunk where the
+	 * scheme allows, so that the coefficients and tables stay in the cache.
+	 *
+	 * @param  chunks array of stripes, each of which has n = k + m entries (same as decode())
+	 * @param  count  number of stripes
+	 * @param  bitmap indicate which entries in every stripe are available
+	 * @return        indicate whether the decoding is successful for all stripes
+	 */
+	bool decodeBatch( Chunk ***chunks, uint32_t count, BitmaskArray *bitmap );
+
+	/**
+	 * Create a coding instance. Configurations with a compile-time
+	 * specialized implementation (see FixedCoding) use it unless
+	 * specialized is false.
+	 */
+	static Coding *instantiate( CodingScheme scheme, CodingParams &params, uint32_t chunkSize, bool specialized = true );
 	static void destroy( Coding *coding );
 
 	/**
@@ -53,6 +179,50 @@ public:
 	static char *bitwiseXOR( char *dst, char *srcA, char *srcB, uint32_t len );
 	static Chunk *bitwiseXOR( Chunk *dst, Chunk *srcA, Chunk *srcB, uint32_t size );
 
+	/**
+	 * Perform bitwise XOR on multiple inputs in a single pass.
+	 * @param dst   Output (XOR-ed value); may be one of the inputs
+	 * @param srcs  Array of inputs
+	 * @param count Number of inputs
+	 * @param len   Size of each input
+	 * @return      Output (same as dst)
+	 */
+	static char *bitwiseXOR( char *dst, char **srcs, uint32_t count, uint32_t len );
+
+	/**
+	 * XOR multiple chunks into a destination chunk in place, i.e.,
+	 * dst := dst XOR srcs[ 0 ] XOR ... XOR srcs[ count - 1 ].
+	 * @param dst   Output (XOR-ed value)
+	 * @param srcs  Array of input chunks
+	 * @param count Number of input chunks
+	 * @param size  Size of the input
+	 * @param skip  Index of the input to be skipped (-1 if none)
+	 * @return      Output (same as dst)
+	 */
+	static Chunk *accumulateXOR( Chunk *dst, Chunk **srcs, uint32_t count, uint32_t size, int skip = -1 );
+
+	/**
+	 * Compute the delta between the original and the new data, and apply
+	 * the new data in place (i.e., delta := data XOR newData; data := newData).
+	 * @param delta   Output (delta); may be the same as newData
+	 * @param data    Original data (updated in place)
+	 * @param newData New data
+	 * @param len     Size of the input
+	 * @return        Output (same as delta)
+	 */
+	static char *bitwiseXORDelta( char *delta, char *data, char *newData, uint32_t len );
+
+	/**
+	 * Multiply a region by a constant in GF(2^8) and XOR the product into
+	 * the destination in place, i.e., dst := dst XOR ( coefficient * src ).
+	 * @param dst         Output (updated in place)
+	 * @param src         Input
+	 * @param coefficient Constant in GF(2^8)
+	 * @param len         Size of the input
+	 * @return            Output (same as dst)
+	 */
+	static char *multiplyXOR( char *dst, char *src, uint8_t coefficient, uint32_t len );
+
 	static uint32_t forceSeal(
 		Coding *coding, Chunk **chunks, Chunk *tmpParityChunk,
 		bool **sealIndicator,
@@ -43,6 +43,7 @@ public:
 		switch( this->scheme ) {
 			case CS_RS:
 			case CS_CAUCHY:
+			case CS_LRC:
 				return this->set( 0, k );
 			default:
 				return;
@@ -53,6 +54,7 @@ public:
 		switch( this->scheme ) {
 			case CS_RS:
 			case CS_CAUCHY:
+			case CS_LRC:
 				return this->set( 1, m );
 			default:
 				return;
@@ -69,6 +71,16 @@ public:
 		}
 	}
 
+	// Number of local groups
+	inline void setL( uint32_t l ) {
+		switch( this->scheme ) {
+			case CS_LRC:
+				return this->set( 2, l );
+			default:
+				return;
+		}
+	}
+
 	inline uint32_t getN() {
 		switch( this->scheme ) {
 			case CS_RAID0:
@@ -91,6 +103,7 @@ public:
 				return this->get( 0 ) - 2;
 			case CS_RS:
 			case CS_CAUCHY:
+			case CS_LRC:
 				return this->get( 0 );
 			default:
 				return 0;
@@ -101,6 +114,7 @@ public:
 		switch( this->scheme ) {
 			case CS_RS:
 			case CS_CAUCHY:
+			case CS_LRC:
 				return this->get( 1 );
 			default:
 				return 0;
@@ -117,6 +131,15 @@ public:
 		}
 	}
 
+	inline uint32_t getL() {
+		switch( this->scheme ) {
+			case CS_LRC:
+				return this->get( 2 );
+			default:
+				return 0;
+		}
+	}
+
 	inline uint32_t getRS_K() {
 		return 0;
 	}
@@ -141,6 +164,8 @@ public:
 				return this->getN() - 2;
 			case CS_CAUCHY:
 				return this->getK();
+			case CS_LRC:
+				return this->getK();
 			default:
 				return 0;
 		}
@@ -162,6 +187,8 @@ public:
 				return 2;
 			case CS_CAUCHY:
 				return this->getM();
+			case CS_LRC:
+				return this->getL() + this->getM();
 			default:
 				return 0;
 		}
@@ -9,7 +9,8 @@ enum CodingScheme {
 	CS_RS,
 	CS_RDP,
 	CS_EVENODD,
-	CS_CAUCHY
+	CS_CAUCHY,
+	CS_LRC
 };
 
 #endif
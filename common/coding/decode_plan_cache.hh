@@ -0,0 +1,108 @@
+#ifndef __COMMON_CODING_DECODE_PLAN_CACHE_HH__
+#define __COMMON_CODING_DECODE_PLAN_CACHE_HH__
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+#include "../ds/bitmask_array.hh"
+#include "../lock/lock.hh"
+
+#define DECODE_PLAN_CACHE_SIZE ( 64 )
+
+/**
+ * LRU cache of decode plans (e.g., inverted matrices and XOR schedules)
+ * keyed by the erasure pattern of a stripe. Plans are immutable once
+ * inserted and reference-counted, so an evicted plan remains valid until
+ * the last decoder holding it returns.
+ */
+template <class Plan> class DecodePlanCache {
+private:
+	typedef std::pair< uint64_t, std::shared_ptr<Plan> > Entry;
+
+	size_t capacity;
+	std::list<Entry> entries; // Most recently used first
+	std::unordered_map< uint64_t, typename std::list<Entry>::iterator > index;
+	LOCK_T lock;
+
+public:
+	uint64_t hits;
+	uint64_t misses;
+
+	DecodePlanCache( size_t capacity = DECODE_PLAN_CACHE_SIZE ) {
+		this->capacity = capacity;
+		this->hits = 0;
+		this->misses = 0;
+		LOCK_INIT( &this->lock );
+	}
+
+	~DecodePlanCache() {
+		pthread_mutex_destroy( &this->lock );
+	}
+
+	/**
+	 * Encode the erasure pattern of the first n entries of a bitmap.
+	 * @param bitmap indicate which chunks are available
+	 * @param n      number of chunks in the stripe
+	 * @param key    (output) bit i is set if the i-th chunk is lost
+	 * @return       false if the pattern does not fit into a key
+	 */
+	static bool getKey( BitmaskArray *bitmap, uint32_t n, uint64_t &key ) {
+		if ( n > 64 )
+			return false;
+		key = 0;
+		for ( uint32_t i = 0; i < n; i++ ) {
+			if ( ! bitmap->check( i ) )
+				key |= ( ( uint64_t ) 1 ) << i;
+		}
+		return true;
+	}
+
+	std::shared_ptr<Plan> get( uint64_t key ) {
+		std::shared_ptr<Plan> ret;
+		LOCK( &this->lock );
+		typename std::unordered_map< uint64_t, typename std::list<Entry>::iterator >::iterator it = this->index.find( key );
+		if ( it != this->index.end() ) {
+			this->entries.splice( this->entries.begin(), this->entries, it->second );
+			ret = it->second->second;
+			this->hits++;
+		} else {
+			this->misses++;
+		}
+		UNLOCK( &this->lock );
+		return ret;
+	}
+
+	/**
+	 * Insert a newly created plan and take over its ownership. If another
+	 * thread has inserted a plan for the same key in the meantime, the
+	 * existing one is returned and the new one is discarded.
+	 */
+	std::shared_ptr<Plan> insert( uint64_t key, Plan *plan ) {
+		std::shared_ptr<Plan> ret( plan );
+		LOCK( &this->lock );
+		typename std::unordered_map< uint64_t, typename std::list<Entry>::iterator >::iterator it = this->index.find( key );
+		if ( it != this->index.end() ) {
+			ret = it->second->second;
+		} else {
+			this->entries.push_front( Entry( key, ret ) );
+			this->index[ key ] = this->entries.begin();
+			if ( this->entries.size() > this->capacity ) {
+				this->index.erase( this->entries.back().first );
+				this->entries.pop_back();
+			}
+		}
+		UNLOCK( &this->lock );
+		return ret;
+	}
+
+	size_t size() {
+		size_t ret;
+		LOCK( &this->lock );
+		ret = this->entries.size();
+		UNLOCK( &this->lock );
+		return ret;
+	}
+};
+
+#endif
@@ -25,7 +25,7 @@ void EvenOddCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t ind
 	} else if ( index == 2 ) {
 
 		// the missing diagonal parity S
-		char *s = new char [ symbolSize ];
+		char *s = Coding::getScratch( CODING_SCRATCH_ENCODE, symbolSize );
 		memset( s, 0, symbolSize );
 
 		// construct the diagonal xor on data symbols, including S
@@ -71,18 +71,78 @@ void EvenOddCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t ind
 				symbolSize
 			);
 		}
+	}
+
+}
+
+void EvenOddCoding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	uint32_t p = this->_p;
+	uint32_t symbolSize = this->_symbolSize;
+	char *code = ChunkUtil::getData( parity );
+
+	if ( length == 0 )
+		return;
+
+	if ( parityIndex == 1 ) {
+		// row parity
+		this->_raid5Coding->encodeDelta( dataIndex, delta, offset, length, parityIndex, parity );
+	} else if ( parityIndex == 2 ) {
+		for ( uint32_t sidx = offset / symbolSize; sidx <= ( offset + length - 1 ) / symbolSize; sidx++ ) {
+			uint32_t start = sidx * symbolSize, end = start + symbolSize;
+			if ( start < offset ) start = offset;
+			if ( end > offset + length ) end = offset + length;
+
+			uint32_t symbolOff = start - sidx * symbolSize;
+			uint32_t pidx = ( dataIndex + sidx ) % p;
+			char *src = delta + ( start - offset );
+			if ( pidx == p - 1 ) {
+				// the missing diagonal S is added to every diagonal parity symbol
+				for ( uint32_t i = 0; i < p - 1; i++ ) {
+					char *dst = code + i * symbolSize + symbolOff;
+					this->bitwiseXOR( dst, dst, src, end - start );
+				}
+			} else {
+				char *dst = code + pidx * symbolSize + symbolOff;
+				this->bitwiseXOR( dst, dst, src, end - start );
+			}
+		}
+	}
+}
+
+void EvenOddCoding::getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength ) {
+	uint32_t p = this->_p;
+	uint32_t symbolSize = this->_symbolSize;
+	uint32_t begin = UINT32_MAX, end = 0;
 
-		delete [] s;
+	if ( parityIndex != 2 || length == 0 ) {
+		parityOffset = offset;
+		parityLength = length;
+		return;
 	}
 
+	// Span of the diagonal parity symbols written by encodeDelta()
+	for ( uint32_t sidx = offset / symbolSize; sidx <= ( offset + length - 1 ) / symbolSize; sidx++ ) {
+		uint32_t start = sidx * symbolSize, stop = start + symbolSize;
+		if ( start < offset ) start = offset;
+		if ( stop > offset + length ) stop = offset + length;
+
+		uint32_t symbolOff = start - sidx * symbolSize;
+		uint32_t pidx = ( dataIndex + sidx ) % p;
+		// The missing diagonal S is added to every diagonal parity symbol
+		uint32_t first = ( pidx == p - 1 ) ? 0 : pidx, last = ( pidx == p - 1 ) ? p - 2 : pidx;
+		if ( first * symbolSize + symbolOff < begin )
+			begin = first * symbolSize + symbolOff;
+		if ( last * symbolSize + symbolOff + ( stop - start ) > end )
+			end = last * symbolSize + symbolOff + ( stop - start );
+	}
+	parityOffset = begin < end ? begin : 0;
+	parityLength = begin < end ? end - begin : 0;
 }
 
 bool EvenOddCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
 
 	uint32_t k = this->_k;
-	uint32_t p = this->_p;
 	uint32_t chunkSize = this->_chunkSize;
-	uint32_t symbolSize = this->_symbolSize;
 	std::vector< uint32_t > failed;
 
 	// check for failed disk
@@ -104,7 +164,6 @@ bool EvenOddCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
 		memset( ChunkUtil::getData( chunks[ failed[ idx ] ] ), 0, chunkSize );
 	}
 
-	char* s;
 	// data chunk loss only
 	if ( failed.size() == 1 ) {
 		// TODO : optimize for single failure recovery
@@ -120,128 +179,115 @@ bool EvenOddCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
 		this->_raid5Coding->decode( chunks, chunkStatus );
 		this->encode( chunks, chunks[ k + 1 ], 2 );
 
-	} else if ( failed[ 1 ] == k ) {
-		// missing row parity ... find the diagonal that gives S directly
+	} else {
+
+		// data + row parity / data + data: recover S and the data following the cached plan
+		std::shared_ptr<XORDecodePlan> plan = this->getDecodePlan( chunkStatus, failed );
+		this->performPlan( chunks, plan.get() );
+
+		// recover row parity
+		if ( failed[ 1 ] == k )
+			this->encode( chunks, chunks[ k ], 1 );
+
+	}
+
+	return true;
+}
+
+XORDecodePlan *EvenOddCoding::createDecodePlan( std::vector<uint32_t> &failed ) {
+	uint32_t k = this->_k;
+	uint32_t p = this->_p;
+	XORDecodePlan *plan = new XORDecodePlan();
+	std::vector<bool> known( ( k + 2 ) * p, true );
+
+	for ( uint32_t idx = 0 ; idx < failed.size() ; idx ++ ) {
+		for ( uint32_t sidx = 0 ; sidx < p ; sidx ++ )
+			known[ failed[ idx ] * p + sidx ] = false;
+	}
 
-		// recover S first
+	if ( failed[ 1 ] == k ) {
+		// missing row parity ... find the diagonal that gives S directly
 		uint32_t pidx =  ( failed[ 0 ] - 1 + p ) % p;
-		s = new char [ symbolSize ];
-		memset( s, 0, symbolSize );
+		XOREquation s( XOR_PLAN_SCRATCH, 0 );
 		// data symbols
 		for ( uint32_t cidx = 0 ; cidx < k ; cidx ++ ) {
 			if ( cidx == failed[ 0 ] )
 				continue;
-			uint32_t sidx = ( pidx + p - cidx ) % p;
-			this->bitwiseXOR( s, ChunkUtil::getData( chunks[ cidx ] ) + sidx * symbolSize, s , symbolSize );
+			this->addSource( s, known, cidx, ( pidx + p - cidx ) % p );
 		}
 		// diagonal symbol
 		if ( pidx != p - 1 )
-			this->bitwiseXOR( s, ChunkUtil::getData( chunks[ k + 1 ] ) + pidx * symbolSize, s , symbolSize );
+			s.srcs.push_back( std::make_pair( k + 1, pidx ) );
+		plan->equations.push_back( s );
 
 		// recover data using diagonal parity and S
 		for ( uint32_t sidxToRepair = 0 ; sidxToRepair < p - 1 ; sidxToRepair ++ ) {
-			char* failedSymbol = ChunkUtil::getData( chunks[ failed[ 0 ] ] ) + sidxToRepair * symbolSize;
+			XOREquation symbol( failed[ 0 ], sidxToRepair );
 			pidx = ( failed[ 0 ] +  sidxToRepair ) % p;
 			for ( uint32_t cidx = 0 ; cidx < k ; cidx ++ ) {
 				if ( cidx == failed[ 0 ] )
 					continue;
-				uint32_t sidx = ( pidx + p - cidx ) % p;
-				if ( sidx > p - 2 )
-					continue;
-				this->bitwiseXOR(
-					failedSymbol,
-					ChunkUtil::getData( chunks[ cidx ] ) + sidx * symbolSize,
-					failedSymbol,
-					symbolSize
-				);
+				this->addSource( symbol, known, cidx, ( pidx + p - cidx ) % p );
 			}
-			if ( pidx != p - 1 ) {
-				this->bitwiseXOR(
-					failedSymbol,
-					ChunkUtil::getData( chunks[ k + 1 ] ) + pidx * symbolSize,
-					failedSymbol,
-					symbolSize
-				);
-			}
-			this->bitwiseXOR( failedSymbol, s, failedSymbol, symbolSize );
-		}
-
-		// recover row parity
-		this->encode( chunks, chunks[ k ], 1 );
-
-		delete [] s;
-
-	} else {
-
-		// get back S, xor all symbols in chunk[ k + 1 ] and chunk[ k ]
-		s = new char [ symbolSize ];
-		// first symbol
-		memcpy( s, ChunkUtil::getData( chunks[ k ] ), symbolSize );
-		this->bitwiseXOR( s, ChunkUtil::getData( chunks[ k + 1 ] ), s, symbolSize );
-		// remainging symbols
-		for ( uint32_t sidx = 1 ; sidx < p - 1 ; sidx ++ ) {
-			this->bitwiseXOR( s, ChunkUtil::getData( chunks[ k ] ) + sidx * symbolSize, s, symbolSize );
-			this->bitwiseXOR( s, ChunkUtil::getData( chunks[ k + 1 ] ) + sidx * symbolSize, s, symbolSize );
+			if ( pidx != p - 1 )
+				symbol.srcs.push_back( std::make_pair( k + 1, pidx ) );
+			symbol.srcs.push_back( std::make_pair( XOR_PLAN_SCRATCH, 0 ) );
+			plan->equations.push_back( symbol );
+			known[ failed[ 0 ] * p + sidxToRepair ] = true;
 		}
 
-		uint32_t idx = 1;
-		uint32_t cidxToRepair = failed[ idx % 2 ];
-		uint32_t pidx = ( failed[ ( idx + 1 ) % 2 ] - 1 + p ) % p;
-		uint32_t sidxToRepair = ( pidx + p - cidxToRepair ) % p;
-		char* symbolToRepair;
-
-		for ( uint32_t recoveredSymbolCount = 0;
-				recoveredSymbolCount < ( p - 1 ) * failed.size();
-				recoveredSymbolCount += 2 ) {
-
-			// diagonal
-			symbolToRepair = ChunkUtil::getData( chunks[ cidxToRepair ] ) + sidxToRepair * symbolSize;
-			// data symbols
-			for ( uint32_t cidx = 0 ; cidx < k ; cidx ++ ) {
-				if ( cidx == cidxToRepair )
-					continue;
-
-				uint32_t sidx = ( p + pidx - cidx ) % p;
-				if ( sidx == sidxToRepair || sidx == p - 1 )
-					continue;
-
-				this->bitwiseXOR( symbolToRepair, ChunkUtil::getData( chunks[ cidx ] ) + sidx * symbolSize,
-						symbolToRepair, symbolSize );
-			}
-			// diagonal parity symbols
-			if ( pidx != p - 1 ) {
-				this->bitwiseXOR( symbolToRepair, ChunkUtil::getData( chunks[ k + 1 ] ) + pidx * symbolSize,
-						symbolToRepair, symbolSize );
-			}
-			// S
-			this->bitwiseXOR( symbolToRepair, s, symbolToRepair, symbolSize );
+		return plan;
+	}
 
-			// row
-			cidxToRepair = failed[ ( idx + 1 ) % 2 ];
-			symbolToRepair = ChunkUtil::getData( chunks[ cidxToRepair ] ) + sidxToRepair * symbolSize;
+	// get back S, xor all symbols in chunk[ k + 1 ] and chunk[ k ]
+	XOREquation s( XOR_PLAN_SCRATCH, 0 );
+	for ( uint32_t sidx = 0 ; sidx < p - 1 ; sidx ++ ) {
+		s.srcs.push_back( std::make_pair( k, sidx ) );
+		s.srcs.push_back( std::make_pair( k + 1, sidx ) );
+	}
+	plan->equations.push_back( s );
 
-			for ( uint32_t cidx = 0 ; cidx < k + 1 ; cidx ++ ) {
-				if ( cidx == cidxToRepair )
-					continue;
-				this->bitwiseXOR(
-					symbolToRepair,
-					ChunkUtil::getData( chunks[ cidx ] ) + sidxToRepair * symbolSize,
-					symbolToRepair,
-					symbolSize
-				);
-			}
+	uint32_t idx = 1;
+	uint32_t cidxToRepair = failed[ idx % 2 ];
+	uint32_t pidx = ( failed[ ( idx + 1 ) % 2 ] - 1 + p ) % p;
+	uint32_t sidxToRepair = ( pidx + p - cidxToRepair ) % p;
 
-			// next ("row") symbol
-			pidx = ( cidxToRepair + sidxToRepair ) % p;
-			cidxToRepair = failed[ idx % 2 ];
-			sidxToRepair = ( pidx + p - cidxToRepair ) % p;
+	for ( uint32_t recoveredSymbolCount = 0;
+			recoveredSymbolCount < ( p - 1 ) * failed.size();
+			recoveredSymbolCount += 2 ) {
 
+		// diagonal: data symbols, diagonal parity symbol and S
+		XOREquation diagonal( cidxToRepair, sidxToRepair );
+		for ( uint32_t cidx = 0 ; cidx < k ; cidx ++ ) {
+			if ( cidx == cidxToRepair )
+				continue;
+			this->addSource( diagonal, known, cidx, ( p + pidx - cidx ) % p );
+		}
+		if ( pidx != p - 1 )
+			diagonal.srcs.push_back( std::make_pair( k + 1, pidx ) );
+		diagonal.srcs.push_back( std::make_pair( XOR_PLAN_SCRATCH, 0 ) );
+		plan->equations.push_back( diagonal );
+		known[ cidxToRepair * p + sidxToRepair ] = true;
+
+		// row
+		cidxToRepair = failed[ ( idx + 1 ) % 2 ];
+		XOREquation row( cidxToRepair, sidxToRepair );
+		for ( uint32_t cidx = 0 ; cidx < k + 1 ; cidx ++ ) {
+			if ( cidx == cidxToRepair )
+				continue;
+			this->addSource( row, known, cidx, sidxToRepair );
 		}
-		delete [] s;
+		plan->equations.push_back( row );
+		known[ cidxToRepair * p + sidxToRepair ] = true;
+
+		// next ("row") symbol
+		pidx = ( cidxToRepair + sidxToRepair ) % p;
+		cidxToRepair = failed[ idx % 2 ];
+		sidxToRepair = ( pidx + p - cidxToRepair ) % p;
 
 	}
 
-	return true;
+	return plan;
 }
 
 uint32_t EvenOddCoding::getPrime() {
@@ -22,11 +22,22 @@ protected:
 	 */
 	uint32_t getSymbolSize();
 
+	/**
+	 * Resolve the recovery of two lost chunks (data + data, or data + row
+	 * parity) into a decode plan, with S kept in the scratch symbol
+	 *
+	 * @param failed indices of the lost chunks (in ascending order)
+	 * @return       the decode plan
+	 */
+	XORDecodePlan *createDecodePlan( std::vector<uint32_t> &failed );
+
 public:
 	EvenOddCoding( uint32_t k = 0, uint32_t chunkSize = 0 );
 	~EvenOddCoding();
 
 	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 );
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
+	void getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength );
 	bool decode( Chunk **chunks, BitmaskArray *chunkStatus );
 };
 
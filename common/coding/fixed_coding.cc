@@ -0,0 +1,37 @@
+#include "fixed_coding.hh"
+
+Coding *FixedCoding::instantiate( CodingScheme scheme, CodingParams &params, uint32_t chunkSize ) {
+	switch( scheme ) {
+		case CS_RAID5:
+			switch( params.getN() ) {
+				case 4: return new RAID5FixedCoding<4>();
+				case 5: return new RAID5FixedCoding<5>();
+				case 6: return new RAID5FixedCoding<6>();
+				case 7: return new RAID5FixedCoding<7>();
+				case 8: return new RAID5FixedCoding<8>();
+				default: break;
+			}
+			break;
+#ifndef USE_ISAL
+		case CS_RS:
+			if ( params.getK() == 4 && params.getM() == 2 )
+				return new RSFixedCoding<4, 2>( chunkSize );
+			if ( params.getK() == 6 && params.getM() == 3 )
+				return new RSFixedCoding<6, 3>( chunkSize );
+			if ( params.getK() == 10 && params.getM() == 4 )
+				return new RSFixedCoding<10, 4>( chunkSize );
+			break;
+#endif
+		case CS_RDP:
+			if ( params.getN() == 6 )
+				return new RDPFixedCoding<4>( chunkSize );
+			break;
+		case CS_EVENODD:
+			if ( params.getN() == 6 )
+				return new EvenOddFixedCoding<4>( chunkSize );
+			break;
+		default:
+			break;
+	}
+	return 0;
+}
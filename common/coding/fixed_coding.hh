@@ -0,0 +1,249 @@
+#ifndef __COMMON_CODING_FIXED_CODING_HH__
+#define __COMMON_CODING_FIXED_CODING_HH__
+
+#include "coding.hh"
+#include "raid5coding.hh"
+#include "rscoding.hh"
+#include "rdpcoding.hh"
+#include "evenoddcoding.hh"
+#include "fixed_kernel.hh"
+#include "../ds/chunk_util.hh"
+
+/**
+ * RAID-5 with n = N chunks in a stripe. Encoding and decoding XOR the
+ * destination and the other N - 1 chunks in a single unrolled pass.
+ */
+template <uint32_t N> class RAID5FixedCoding : public RAID5Coding {
+private:
+	FixedXORFunc _xor;
+
+public:
+	RAID5FixedCoding() {
+		this->scheme = CS_RAID5;
+		this->init( N );
+		this->_xor = FixedKernel::getXOR<N>();
+	}
+
+	void encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 ) {
+		char *srcs[ N ];
+		// same as RAID5Coding: the data chunks are XOR-ed onto the parity chunk
+		srcs[ 0 ] = ChunkUtil::getData( parity );
+		for ( uint32_t i = 0; i < N - 1; i++ )
+			srcs[ i + 1 ] = ChunkUtil::getData( data[ i ] );
+		this->_xor( srcs[ 0 ], srcs, ChunkUtil::chunkSize );
+	}
+
+	bool decode( Chunk **chunks, BitmaskArray *bitmap ) {
+		char *srcs[ N ];
+		uint32_t lostIndex = N, n = 1;
+
+		for ( uint32_t i = 0; i < N; i++ ) {
+			if ( bitmap->check( i ) ) {
+				if ( n < N )
+					srcs[ n ] = ChunkUtil::getData( chunks[ i ] );
+				n++;
+			} else if ( lostIndex == N ) {
+				lostIndex = i;
+			} else {
+				return false;
+			}
+		}
+		if ( lostIndex == N )
+			return RAID5Coding::decode( chunks, bitmap );
+
+		srcs[ 0 ] = ChunkUtil::getData( chunks[ lostIndex ] );
+		this->_xor( srcs[ 0 ], srcs, ChunkUtil::chunkSize );
+		return true;
+	}
+};
+
+#ifndef USE_ISAL
+/**
+ * Reed-Solomon code with K data and M parity chunks (w = 8). Each parity or
+ * lost chunk is computed as a dot product of K chunks with the tables of
+ * its row hoisted into registers.
+ *
+ * With ISA-L, RSCoding already dispatches to its hand-unrolled kernels, so
+ * only the Jerasure build is specialized.
+ */
+template <uint32_t K, uint32_t M> class RSFixedCoding : public RSCoding {
+private:
+	unsigned char _tables[ M * K * FIXED_GF_TABLE_SIZE ];
+	FixedDotProductFunc _dotProduct;
+	FixedXORFunc _xor; // for rows with all coefficients being 1
+
+protected:
+	bool decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to ) {
+		std::shared_ptr<RSDecodePlan> plan;
+		char *srcs[ K ];
+
+		if ( ! this->getDecodePlan( chunkStatus, plan ) )
+			return false;
+		if ( ! plan )
+			return true;
+
+		// recover one lost chunk in all stripes before moving on to the next one
+		for ( uint32_t i = 0; i < plan->lostData.size(); i++ ) {
+			const unsigned char *tables = &plan->gftbl[ i * K * FIXED_GF_TABLE_SIZE ];
+			const int *srcIds = &plan->srcIds[ i * K ];
+			bool isXOR = true;
+			for ( uint32_t j = 0; j < K && isXOR; j++ )
+				isXOR = ( plan->rows[ i * K + j ] == 1 );
+			for ( uint32_t s = from; s < to; s++ ) {
+				Chunk **chunks = stripes[ s ];
+				char *dst = ChunkUtil::getData( chunks[ plan->lostData[ i ] ] );
+				for ( uint32_t j = 0; j < K; j++ )
+					srcs[ j ] = ChunkUtil::getData( chunks[ srcIds[ j ] ] );
+				if ( isXOR )
+					this->_xor( dst, srcs, this->_chunkSize );
+				else
+					this->_dotProduct( tables, srcs, dst, this->_chunkSize );
+			}
+		}
+		// lost parity chunks are re-encoded from the recovered data chunks
+		for ( uint32_t i = 0; i < plan->lostParity.size(); i++ ) {
+			int parity = plan->lostParity[ i ];
+			for ( uint32_t s = from; s < to; s++ )
+				this->encode( stripes[ s ], stripes[ s ][ parity ], parity - K + 1 );
+		}
+		return true;
+	}
+
+public:
+	RSFixedCoding( uint32_t chunkSize ) : RSCoding( K, M, chunkSize ) {
+		uint8_t coefficients[ M * K ];
+
+		this->scheme = CS_RS;
+		for ( uint32_t i = 0; i < M * K; i++ )
+			coefficients[ i ] = ( uint8_t ) this->_jmatrix[ i ];
+		Coding::initMultiplyTables( coefficients, M * K, this->_tables );
+		this->_dotProduct = FixedKernel::getDotProduct<K>();
+		this->_xor = FixedKernel::getXOR<K>();
+	}
+
+	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 ) {
+		char *srcs[ K ];
+		for ( uint32_t j = 0; j < K; j++ )
+			srcs[ j ] = ChunkUtil::getData( dataChunks[ j ] );
+		this->_dotProduct( this->_tables + ( index - 1 ) * K * FIXED_GF_TABLE_SIZE, srcs, ChunkUtil::getData( parityChunk ), this->_chunkSize );
+	}
+};
+#endif
+
+/**
+ * RDP with K data chunks and p = K + 1, where every diagonal parity symbol
+ * covers exactly K symbols. Other primes (e.g., due to the chunk size) and
+ * partial encoding use RDPCoding.
+ */
+template <uint32_t K> class RDPFixedCoding : public RDPCoding {
+private:
+	FixedXORFunc _xorRow;      // K data chunks
+	FixedXORFunc _xorDiagonal; // diagonal parity symbol and K symbols on the diagonal
+
+public:
+	RDPFixedCoding( uint32_t chunkSize ) : RDPCoding( K, chunkSize ) {
+		this->scheme = CS_RDP;
+		delete this->_raid5Coding;
+		this->_raid5Coding = new RAID5FixedCoding<K + 1>();
+		this->_xorRow = FixedKernel::getXOR<K>();
+		this->_xorDiagonal = FixedKernel::getXOR<K + 1>();
+	}
+
+	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 ) {
+		const uint32_t p = K + 1;
+		uint32_t symbolSize = this->_symbolSize;
+		char *columns[ K + 1 ], *srcs[ K + 1 ];
+
+		if ( index != 2 || this->_p != p || endOff != 0 )
+			return RDPCoding::encode( dataChunks, parityChunk, index, startOff, endOff );
+
+		// the row parity is the K-th column
+		for ( uint32_t c = 0; c < K; c++ )
+			columns[ c ] = ChunkUtil::getData( dataChunks[ c ] );
+		columns[ K ] = Coding::getScratch( CODING_SCRATCH_ENCODE, this->_chunkSize );
+		this->_xorRow( columns[ K ], columns, this->_chunkSize );
+
+		// diagonal d misses column d + 1 (the symbol on the imaginary ( p - 1 )-th row)
+		for ( uint32_t d = 0; d < p - 1; d++ ) {
+			char *dst = ChunkUtil::getData( parityChunk ) + d * symbolSize;
+			uint32_t n = 0;
+			srcs[ n++ ] = dst;
+			for ( uint32_t c = 0; c < K + 1; c++ ) {
+				if ( c != d + 1 )
+					srcs[ n++ ] = columns[ c ] + ( ( d + p - c ) % p ) * symbolSize;
+			}
+			this->_xorDiagonal( dst, srcs, symbolSize );
+		}
+	}
+};
+
+/**
+ * EVENODD with K data chunks and p = K + 1, where every diagonal parity
+ * symbol covers S and K - 1 or K data symbols. Other primes (e.g., due to
+ * the chunk size) and partial encoding use EvenOddCoding.
+ */
+template <uint32_t K> class EvenOddFixedCoding : public EvenOddCoding {
+private:
+	FixedXORFunc _xorS;    // K - 1 symbols on the missing diagonal
+	FixedXORFunc _xorLast; // parity symbol, S and K symbols on the last diagonal
+	FixedXORFunc _xorRest; // parity symbol, S and K - 1 symbols on the other diagonals
+
+public:
+	EvenOddFixedCoding( uint32_t chunkSize ) : EvenOddCoding( K, chunkSize ) {
+		this->scheme = CS_EVENODD;
+		delete this->_raid5Coding;
+		this->_raid5Coding = new RAID5FixedCoding<K + 1>();
+		this->_xorS = FixedKernel::getXOR<K - 1>();
+		this->_xorLast = FixedKernel::getXOR<K + 2>();
+		this->_xorRest = FixedKernel::getXOR<K + 1>();
+	}
+
+	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 ) {
+		const uint32_t p = K + 1;
+		uint32_t symbolSize = this->_symbolSize;
+		char *columns[ K ], *srcs[ K + 2 ], *s;
+
+		if ( index != 2 || this->_p != p || endOff != 0 )
+			return EvenOddCoding::encode( dataChunks, parityChunk, index, startOff, endOff );
+
+		for ( uint32_t c = 0; c < K; c++ )
+			columns[ c ] = ChunkUtil::getData( dataChunks[ c ] );
+
+		// the missing diagonal S
+		s = Coding::getScratch( CODING_SCRATCH_ENCODE, symbolSize );
+		for ( uint32_t c = 1; c < K; c++ )
+			srcs[ c - 1 ] = columns[ c ] + ( p - 1 - c ) * symbolSize;
+		this->_xorS( s, srcs, symbolSize );
+
+		// diagonal d misses column d + 1, which only exists for d < K - 1
+		for ( uint32_t d = 0; d < p - 1; d++ ) {
+			char *dst = ChunkUtil::getData( parityChunk ) + d * symbolSize;
+			uint32_t n = 0;
+			srcs[ n++ ] = dst;
+			srcs[ n++ ] = s;
+			for ( uint32_t c = 0; c < K; c++ ) {
+				if ( c != d + 1 )
+					srcs[ n++ ] = columns[ c ] + ( ( d + p - c ) % p ) * symbolSize;
+			}
+			if ( d == K - 1 )
+				this->_xorLast( dst, srcs, symbolSize );
+			else
+				this->_xorRest( dst, srcs, symbolSize );
+		}
+	}
+};
+
+/**
+ * Compile-time specialized implementations of the configurations in
+ * deployment: RS( 4, 2 ), RS( 6, 3 ), RS( 10, 4 ), RAID-5 with n = 4 ... 8,
+ * and RDP / EVENODD with n = 6.
+ */
+class FixedCoding {
+public:
+	/**
+	 * @return the specialized implementation; 0 if the configuration has none
+	 */
+	static Coding *instantiate( CodingScheme scheme, CodingParams &params, uint32_t chunkSize );
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef __COMMON_CODING_FIXED_KERNEL_HH__
+#define __COMMON_CODING_FIXED_KERNEL_HH__
+
+#include <stdint.h>
+#include "xor_kernel.hh"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIXED_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// Fully unroll loops over the (compile-time) number of sources
+#if defined(__clang__)
+#define FIXED_UNROLL _Pragma( "unroll" )
+#elif defined(__GNUC__) && __GNUC__ >= 8
+#define FIXED_UNROLL _Pragma( "GCC unroll 32" )
+#else
+#define FIXED_UNROLL
+#endif
+
+// Size of the multiplication tables of a coefficient in GF(2^8) (see Coding::initMultiplyTables())
+#define FIXED_GF_TABLE_SIZE ( 32 )
+
+// dst := srcs[ 0 ] ^ ... ^ srcs[ COUNT - 1 ] (dst may be one of the sources)
+typedef void ( *FixedXORFunc )( char *dst, char **srcs, uint32_t len );
+// dst := coefficient[ 0 ] * srcs[ 0 ] + ... + coefficient[ K - 1 ] * srcs[ K - 1 ] in GF(2^8)
+typedef void ( *FixedDotProductFunc )( const unsigned char *tables, char **srcs, char *dst, uint32_t len );
+
+/**
+ * Coding kernels with the number of sources fixed at compile time, so that
+ * the loops over the sources are fully unrolled and the source pointers and
+ * multiplication tables stay in registers. The instruction set follows the
+ * choice of XORKernel (see getXOR() and getDotProduct()).
+ */
+class FixedKernel {
+public:
+	/////////////////////////////
+	// XOR                     //
+	/////////////////////////////
+	template <uint32_t COUNT> static void xorScalar( char *dst, char **srcs, uint32_t len, uint32_t i = 0 ) {
+		char *s[ COUNT ];
+		uint64_t acc;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < COUNT; j++ )
+			s[ j ] = srcs[ j ];
+		for ( ; i + sizeof( uint64_t ) <= len; i += sizeof( uint64_t ) ) {
+			acc = *( uint64_t * )( s[ 0 ] + i );
+			FIXED_UNROLL
+			for ( uint32_t j = 1; j < COUNT; j++ )
+				acc ^= *( uint64_t * )( s[ j ] + i );
+			*( uint64_t * )( dst + i ) = acc;
+		}
+		for ( ; i < len; i++ ) {
+			char c = s[ 0 ][ i ];
+			FIXED_UNROLL
+			for ( uint32_t j = 1; j < COUNT; j++ )
+				c ^= s[ j ][ i ];
+			dst[ i ] = c;
+		}
+	}
+
+	template <uint32_t COUNT> static void xorScalarEntry( char *dst, char **srcs, uint32_t len ) {
+		FixedKernel::xorScalar<COUNT>( dst, srcs, len );
+	}
+
+#ifdef FIXED_KERNEL_X86
+	template <uint32_t COUNT> __attribute__((target("sse2")))
+	static void xorSSE2( char *dst, char **srcs, uint32_t len ) {
+		char *s[ COUNT ];
+		uint32_t i;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < COUNT; j++ )
+			s[ j ] = srcs[ j ];
+		for ( i = 0; i + 64 <= len; i += 64 ) {
+			__m128i a0 = _mm_loadu_si128( ( __m128i * )( s[ 0 ] + i ) );
+			__m128i a1 = _mm_loadu_si128( ( __m128i * )( s[ 0 ] + i + 16 ) );
+			__m128i a2 = _mm_loadu_si128( ( __m128i * )( s[ 0 ] + i + 32 ) );
+			__m128i a3 = _mm_loadu_si128( ( __m128i * )( s[ 0 ] + i + 48 ) );
+			FIXED_UNROLL
+			for ( uint32_t j = 1; j < COUNT; j++ ) {
+				a0 = _mm_xor_si128( a0, _mm_loadu_si128( ( __m128i * )( s[ j ] + i ) ) );
+				a1 = _mm_xor_si128( a1, _mm_loadu_si128( ( __m128i * )( s[ j ] + i + 16 ) ) );
+				a2 = _mm_xor_si128( a2, _mm_loadu_si128( ( __m128i * )( s[ j ] + i + 32 ) ) );
+				a3 = _mm_xor_si128( a3, _mm_loadu_si128( ( __m128i * )( s[ j ] + i + 48 ) ) );
+			}
+			_mm_storeu_si128( ( __m128i * )( dst + i ), a0 );
+			_mm_storeu_si128( ( __m128i * )( dst + i + 16 ), a1 );
+			_mm_storeu_si128( ( __m128i * )( dst + i + 32 ), a2 );
+			_mm_storeu_si128( ( __m128i * )( dst + i + 48 ), a3 );
+		}
+		if ( i < len )
+			FixedKernel::xorScalar<COUNT>( dst, s, len, i );
+	}
+
+	template <uint32_t COUNT> __attribute__((target("avx2")))
+	static void xorAVX2( char *dst, char **srcs, uint32_t len ) {
+		char *s[ COUNT ];
+		uint32_t i;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < COUNT; j++ )
+			s[ j ] = srcs[ j ];
+		for ( i = 0; i + 128 <= len; i += 128 ) {
+			__m256i a0 = _mm256_loadu_si256( ( __m256i * )( s[ 0 ] + i ) );
+			__m256i a1 = _mm256_loadu_si256( ( __m256i * )( s[ 0 ] + i + 32 ) );
+			__m256i a2 = _mm256_loadu_si256( ( __m256i * )( s[ 0 ] + i + 64 ) );
+			__m256i a3 = _mm256_loadu_si256( ( __m256i * )( s[ 0 ] + i + 96 ) );
+			FIXED_UNROLL
+			for ( uint32_t j = 1; j < COUNT; j++ ) {
+				a0 = _mm256_xor_si256( a0, _mm256_loadu_si256( ( __m256i * )( s[ j ] + i ) ) );
+				a1 = _mm256_xor_si256( a1, _mm256_loadu_si256( ( __m256i * )( s[ j ] + i + 32 ) ) );
+				a2 = _mm256_xor_si256( a2, _mm256_loadu_si256( ( __m256i * )( s[ j ] + i + 64 ) ) );
+				a3 = _mm256_xor_si256( a3, _mm256_loadu_si256( ( __m256i * )( s[ j ] + i + 96 ) ) );
+			}
+			_mm256_storeu_si256( ( __m256i * )( dst + i ), a0 );
+			_mm256_storeu_si256( ( __m256i * )( dst + i + 32 ), a1 );
+			_mm256_storeu_si256( ( __m256i * )( dst + i + 64 ), a2 );
+			_mm256_storeu_si256( ( __m256i * )( dst + i + 96 ), a3 );
+		}
+		if ( i < len )
+			FixedKernel::xorScalar<COUNT>( dst, s, len, i );
+	}
+
+	template <uint32_t COUNT> __attribute__((target("avx512f")))
+	static void xorAVX512( char *dst, char **srcs, uint32_t len ) {
+		char *s[ COUNT ];
+		uint32_t i;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < COUNT; j++ )
+			s[ j ] = srcs[ j ];
+		for ( i = 0; i + 256 <= len; i += 256 ) {
+			__m512i a0 = _mm512_loadu_si512( ( void * )( s[ 0 ] + i ) );
+			__m512i a1 = _mm512_loadu_si512( ( void * )( s[ 0 ] + i + 64 ) );
+			__m512i a2 = _mm512_loadu_si512( ( void * )( s[ 0 ] + i + 128 ) );
+			__m512i a3 = _mm512_loadu_si512( ( void * )( s[ 0 ] + i + 192 ) );
+			FIXED_UNROLL
+			for ( uint32_t j = 1; j < COUNT; j++ ) {
+				a0 = _mm512_xor_si512( a0, _mm512_loadu_si512( ( void * )( s[ j ] + i ) ) );
+				a1 = _mm512_xor_si512( a1, _mm512_loadu_si512( ( void * )( s[ j ] + i + 64 ) ) );
+				a2 = _mm512_xor_si512( a2, _mm512_loadu_si512( ( void * )( s[ j ] + i + 128 ) ) );
+				a3 = _mm512_xor_si512( a3, _mm512_loadu_si512( ( void * )( s[ j ] + i + 192 ) ) );
+			}
+			_mm512_storeu_si512( ( void * )( dst + i ), a0 );
+			_mm512_storeu_si512( ( void * )( dst + i + 64 ), a1 );
+			_mm512_storeu_si512( ( void * )( dst + i + 128 ), a2 );
+			_mm512_storeu_si512( ( void * )( dst + i + 192 ), a3 );
+		}
+		if ( i < len )
+			FixedKernel::xorScalar<COUNT>( dst, s, len, i );
+	}
+#endif
+
+	/////////////////////////////
+	// GF(2^8) dot product     //
+	/////////////////////////////
+	// tables[ j * 32 ... j * 32 + 15 ]: products of the j-th coefficient and the low nibbles
+	// tables[ j * 32 + 16 ... j * 32 + 31 ]: products of the j-th coefficient and the high nibbles
+	template <uint32_t K> static void dotProductScalar( const unsigned char *tables, char **srcs, char *dst, uint32_t len, uint32_t i = 0 ) {
+		unsigned char *s[ K ];
+		unsigned char acc, x;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < K; j++ )
+			s[ j ] = ( unsigned char * ) srcs[ j ];
+		for ( ; i < len; i++ ) {
+			acc = 0;
+			FIXED_UNROLL
+			for ( uint32_t j = 0; j < K; j++ ) {
+				x = s[ j ][ i ];
+				acc ^= tables[ j * FIXED_GF_TABLE_SIZE + ( x & 0x0f ) ] ^ tables[ j * FIXED_GF_TABLE_SIZE + 16 + ( x >> 4 ) ];
+			}
+			dst[ i ] = ( char ) acc;
+		}
+	}
+
+	template <uint32_t K> static void dotProductScalarEntry( const unsigned char *tables, char **srcs, char *dst, uint32_t len ) {
+		FixedKernel::dotProductScalar<K>( tables, srcs, dst, len );
+	}
+
+#ifdef FIXED_KERNEL_X86
+	template <uint32_t K> __attribute__((target("ssse3")))
+	static void dotProductSSSE3( const unsigned char *tables, char **srcs, char *dst, uint32_t len ) {
+		char *s[ K ];
+		__m128i lo[ K ], hi[ K ];
+		const __m128i mask = _mm_set1_epi8( 0x0f );
+		uint32_t i;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < K; j++ ) {
+			s[ j ] = srcs[ j ];
+			lo[ j ] = _mm_loadu_si128( ( __m128i * )( tables + j * FIXED_GF_TABLE_SIZE ) );
+			hi[ j ] = _mm_loadu_si128( ( __m128i * )( tables + j * FIXED_GF_TABLE_SIZE + 16 ) );
+		}
+		for ( i = 0; i + 16 <= len; i += 16 ) {
+			__m128i acc = _mm_setzero_si128();
+			FIXED_UNROLL
+			for ( uint32_t j = 0; j < K; j++ ) {
+				__m128i x = _mm_loadu_si128( ( __m128i * )( s[ j ] + i ) );
+				acc = _mm_xor_si128( acc, _mm_shuffle_epi8( lo[ j ], _mm_and_si128( x, mask ) ) );
+				acc = _mm_xor_si128( acc, _mm_shuffle_epi8( hi[ j ], _mm_and_si128( _mm_srli_epi64( x, 4 ), mask ) ) );
+			}
+			_mm_storeu_si128( ( __m128i * )( dst + i ), acc );
+		}
+		if ( i < len )
+			FixedKernel::dotProductScalar<K>( tables, s, dst, len, i );
+	}
+
+	template <uint32_t K> __attribute__((target("avx2")))
+	static void dotProductAVX2( const unsigned char *tables, char **srcs, char *dst, uint32_t len ) {
+		char *s[ K ];
+		__m256i lo[ K ], hi[ K ];
+		const __m256i mask = _mm256_set1_epi8( 0x0f );
+		uint32_t i;
+
+		FIXED_UNROLL
+		for ( uint32_t j = 0; j < K; j++ ) {
+			s[ j ] = srcs[ j ];
+			lo[ j ] = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( __m128i * )( tables + j * FIXED_GF_TABLE_SIZE ) ) );
+			hi[ j ] = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( __m128i * )( tables + j * FIXED_GF_TABLE_SIZE + 16 ) ) );
+		}
+		for ( i = 0; i + 32 <= len; i += 32 ) {
+			__m256i acc = _mm256_setzero_si256();
+			FIXED_UNROLL
+			for ( uint32_t j = 0; j < K; j++ ) {
+				__m256i x = _mm256_loadu_si256( ( __m256i * )( s[ j ] + i ) );
+				acc = _mm256_xor_si256( acc, _mm256_shuffle_epi8( lo[ j ], _mm256_and_si256( x, mask ) ) );
+				acc = _mm256_xor_si256( acc, _mm256_shuffle_epi8( hi[ j ], _mm256_and_si256( _mm256_srli_epi64( x, 4 ), mask ) ) );
+			}
+			_mm256_storeu_si256( ( __m256i * )( dst + i ), acc );
+		}
+		if ( i < len )
+			FixedKernel::dotProductScalar<K>( tables, s, dst, len, i );
+	}
+#endif
+
+	/////////////////////////////
+	// Dispatch                //
+	/////////////////////////////
+	static XORKernelType getType() {
+		if ( XORKernel::getType() == XOR_KERNEL_AUTO )
+			XORKernel::select();
+		return XORKernel::getType();
+	}
+
+	template <uint32_t COUNT> static FixedXORFunc getXOR() {
+		switch( FixedKernel::getType() ) {
+#ifdef FIXED_KERNEL_X86
+			case XOR_KERNEL_AVX512:
+				return FixedKernel::xorAVX512<COUNT>;
+			case XOR_KERNEL_AVX2:
+				return FixedKernel::xorAVX2<COUNT>;
+			case XOR_KERNEL_SSE2:
+				return FixedKernel::xorSSE2<COUNT>;
+#endif
+			default:
+				return FixedKernel::xorScalarEntry<COUNT>;
+		}
+	}
+
+	template <uint32_t K> static FixedDotProductFunc getDotProduct() {
+		switch( FixedKernel::getType() ) {
+#ifdef FIXED_KERNEL_X86
+			case XOR_KERNEL_AVX512:
+			case XOR_KERNEL_AVX2:
+				return FixedKernel::dotProductAVX2<K>;
+			case XOR_KERNEL_SSE2:
+				__builtin_cpu_init();
+				if ( __builtin_cpu_supports( "ssse3" ) )
+					return FixedKernel::dotProductSSSE3<K>;
+				return FixedKernel::dotProductScalarEntry<K>;
+#endif
+			default:
+				return FixedKernel::dotProductScalarEntry<K>;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,405 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "lrccoding.hh"
+#include "../ds/chunk_util.hh"
+
+#ifndef USE_ISAL
+extern "C" {
+#include "../../lib/jerasure/include/galois.h"
+#include "../../lib/jerasure/include/jerasure.h"
+}
+typedef char dataType;
+#else
+#include "../../lib/isa-l-2.14.0/include/erasure_code.h"
+typedef unsigned char dataType;
+#endif
+
+#define LRC_W (8)
+
+LRCCoding::LRCCoding( uint32_t k, uint32_t m, uint32_t l, uint32_t chunkSize ) {
+	this->scheme = CS_LRC;
+	this->_k = k;
+	this->_m = m;
+	this->_l = l;
+	this->_chunkSize = chunkSize;
+
+	if ( k + l + m > LRC_N_MAX ) {
+		fprintf( stderr, "Only support N up to %u for LRC coding.\n", LRC_N_MAX );
+		exit( -1 );
+	}
+	if ( l < 1 || l > k ) {
+		fprintf( stderr, "LRC coding: The number of local groups should be between 1 and k.\n" );
+		exit( -1 );
+	}
+
+#ifndef USE_ISAL
+	// force init on gfp_array for w = 8
+	galois_single_divide( 10, 2, LRC_W );
+#endif
+
+	// spread the data chunks evenly over the local groups
+	for ( uint32_t i = 0; i <= l; i++ )
+		this->_groupStart[ i ] = i * k / l;
+	for ( uint32_t i = 0; i < l; i++ ) {
+		for ( uint32_t j = this->_groupStart[ i ]; j < this->_groupStart[ i + 1 ]; j++ )
+			this->_group[ j ] = i;
+	}
+
+	generateCodeMatrix();
+}
+
+void LRCCoding::generateCodeMatrix() {
+	uint32_t k = this->_k;
+	uint32_t m = this->_m;
+	uint32_t l = this->_l;
+
+	memset( this->_matrix, 0, sizeof( this->_matrix ) );
+
+	// local parity: XOR of the data chunks in the group
+	for ( uint32_t i = 0; i < k; i++ )
+		this->_matrix[ this->_group[ i ] * k + i ] = 1;
+
+	// global parity: the j-th row is ( a_0^( j + 1 ), ..., a_{k-1}^( j + 1 ) ) with distinct a_i = 2^i,
+	// so that any m + 1 lost data chunks in the same group can be recovered together with the local parity
+	for ( uint32_t i = 0; i < k; i++ ) {
+		unsigned char a = 1, c = 1;
+		for ( uint32_t x = 0; x < i; x++ )
+			a = gfMultiply( a, 2 );
+		for ( uint32_t j = 0; j < m; j++ ) {
+			c = gfMultiply( c, a );
+			this->_matrix[ ( l + j ) * k + i ] = c;
+		}
+	}
+
+#ifdef USE_ISAL
+	ec_init_tables( k, m, this->_matrix + l * k, this->_gftbl );
+#else
+	for ( uint32_t i = 0; i < m * k; i++ )
+		this->_jmatrix[ i ] = this->_matrix[ l * k + i ];
+#endif
+}
+
+void LRCCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff, uint32_t endOff ) {
+	uint32_t k = this->_k;
+	uint32_t l = this->_l;
+	uint32_t chunkSize = this->_chunkSize;
+
+	if ( index <= l ) {
+		// local parity
+		char *srcs[ LRC_N_MAX ];
+		uint32_t count = 0;
+		for ( uint32_t i = this->_groupStart[ index - 1 ]; i < this->_groupStart[ index ]; i++ )
+			srcs[ count++ ] = ChunkUtil::getData( dataChunks[ i ] );
+		Coding::bitwiseXOR( ChunkUtil::getData( parityChunk ), srcs, count, chunkSize );
+		return;
+	}
+
+	// global parity
+	dataType *data[ LRC_N_MAX ], *code[ LRC_N_MAX ];
+	for ( uint32_t i = 0; i < k; i++ )
+		data[ i ] = ( dataType * ) ChunkUtil::getData( dataChunks[ i ] );
+	code[ index - 1 ] = ( dataType * ) ChunkUtil::getData( parityChunk );
+
+#ifdef USE_ISAL
+	ec_encode_data( chunkSize, k, 1, this->_gftbl + ( index - l - 1 ) * k * 32, data, code + index - 1 );
+#else
+	jerasure_matrix_dotprod( k, LRC_W, this->_jmatrix + ( index - l - 1 ) * k, NULL, k + index - 1, data, code, chunkSize );
+#endif
+}
+
+void LRCCoding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	uint32_t k = this->_k;
+	uint32_t l = this->_l;
+	dataType *code[ 1 ];
+
+	if ( length == 0 )
+		return;
+
+	code[ 0 ] = ( dataType * ) ChunkUtil::getData( parity ) + offset;
+
+	if ( parityIndex <= l ) {
+		// only the data chunks in the group contribute to the local parity
+		if ( this->_group[ dataIndex ] == parityIndex - 1 )
+			Coding::bitwiseXOR( ( char * ) code[ 0 ], ( char * ) code[ 0 ], delta, length );
+		return;
+	}
+
+#ifdef USE_ISAL
+	// Use the tables of the ( parityIndex )-th row only; the update is in-place "xor"ed on the parity chunk
+	ec_encode_data_update(
+		length, k, 1, dataIndex,
+		this->_gftbl + ( parityIndex - l - 1 ) * k * 32,
+		( dataType * ) delta, code
+	);
+#else
+	Coding::multiplyXOR(
+		code[ 0 ], delta,
+		this->_matrix[ ( parityIndex - 1 ) * k + dataIndex ],
+		length
+	);
+#endif
+}
+
+bool LRCCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
+	return this->decodeStripes( &chunks, chunkStatus, 0, 1 );
+}
+
+bool LRCCoding::decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to ) {
+	uint32_t k = this->_k;
+	uint32_t n = this->_k + this->_l + this->_m;
+	uint32_t chunkSize = this->_chunkSize;
+	bool lost[ LRC_N_MAX ];
+	uint32_t failed = 0;
+
+	for ( uint32_t idx = 0; idx < n; idx++ ) {
+		lost[ idx ] = ! chunkStatus->check( idx );
+		if ( lost[ idx ] )
+			failed++;
+	}
+
+	if ( failed == 0 )
+		return true;
+
+	// reuse the plan if the same set of chunks was lost before
+	uint64_t key;
+	std::shared_ptr<LRCDecodePlan> plan;
+	bool isCached = DecodePlanCache<LRCDecodePlan>::getKey( chunkStatus, n, key );
+	if ( isCached )
+		plan = this->_planCache.get( key );
+	if ( ! plan ) {
+		LRCDecodePlan *newPlan = this->createDecodePlan( lost );
+		if ( ! newPlan ) {
+			fprintf( stderr, "LRC coding: The %u lost chunks cannot be recovered!!\n", failed );
+			return false;
+		}
+		if ( isCached )
+			plan = this->_planCache.insert( key, newPlan );
+		else // the pattern does not fit into a cache key: use the plan once
+			plan.reset( newPlan );
+	}
+
+	char *srcs[ LRC_N_MAX ];
+	dataType *data[ LRC_N_MAX ], *code[ LRC_N_MAX ];
+	for ( uint32_t s = from; s < to; s++ ) {
+		Chunk **chunks = stripes[ s ];
+
+		// local repair
+		for ( uint32_t i = 0; i < plan->localChunks.size(); i++ ) {
+			uint32_t count = 0;
+			for ( uint32_t j = plan->localOffsets[ i ]; j < plan->localOffsets[ i + 1 ]; j++ )
+				srcs[ count++ ] = ChunkUtil::getData( chunks[ plan->localSrcs[ j ] ] );
+			Coding::bitwiseXOR( ChunkUtil::getData( chunks[ plan->localChunks[ i ] ] ), srcs, count, chunkSize );
+		}
+
+		// lost data chunks that cannot be repaired locally
+		if ( plan->lostData.size() ) {
+#ifdef USE_ISAL
+			for ( uint32_t i = 0; i < k; i++ )
+				data[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ plan->srcIds[ i ] ] );
+			for ( uint32_t i = 0; i < plan->lostData.size(); i++ )
+				code[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ plan->lostData[ i ] ] );
+			ec_encode_data( chunkSize, k, plan->lostData.size(), &plan->gftbl[ 0 ], data, code );
+#else
+			for ( uint32_t i = 0; i < n; i++ ) {
+				if ( i < k )
+					data[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ i ] );
+				else
+					code[ i - k ] = ( dataType * ) ChunkUtil::getData( chunks[ i ] );
+			}
+			for ( uint32_t i = 0; i < plan->lostData.size(); i++ ) {
+				jerasure_matrix_dotprod(
+					k, LRC_W, &plan->jrows[ i * k ], &plan->jsrcIds[ 0 ],
+					plan->lostData[ i ], data, code, chunkSize
+				);
+			}
+#endif
+		}
+
+		// re-encode the lost parity chunks
+		for ( uint32_t i = 0; i < plan->lostParity.size(); i++ )
+			this->encode( chunks, chunks[ plan->lostParity[ i ] ], plan->lostParity[ i ] - k + 1 );
+	}
+
+	return true;
+}
+
+LRCDecodePlan *LRCCoding::createDecodePlan( bool *lost ) {
+	uint32_t k = this->_k;
+	uint32_t l = this->_l;
+	uint32_t n = this->_k + this->_l + this->_m;
+	LRCDecodePlan *plan = new LRCDecodePlan();
+	bool available[ LRC_N_MAX ];
+
+	for ( uint32_t i = 0; i < n; i++ )
+		available[ i ] = ! lost[ i ];
+
+	// a group (data chunks and the local parity chunk) with one lost member is repaired locally
+	plan->localOffsets.push_back( 0 );
+	for ( uint32_t g = 0; g < l; g++ ) {
+		uint32_t missing = n, count = 0;
+		for ( uint32_t i = this->_groupStart[ g ]; i < this->_groupStart[ g + 1 ]; i++ ) {
+			if ( ! available[ i ] ) {
+				missing = i;
+				count++;
+			}
+		}
+		if ( ! available[ k + g ] ) {
+			missing = k + g;
+			count++;
+		}
+		if ( count != 1 )
+			continue;
+
+		for ( uint32_t i = this->_groupStart[ g ]; i < this->_groupStart[ g + 1 ]; i++ ) {
+			if ( i != missing )
+				plan->localSrcs.push_back( i );
+		}
+		if ( missing != k + g )
+			plan->localSrcs.push_back( k + g );
+		plan->localChunks.push_back( missing );
+		plan->localOffsets.push_back( plan->localSrcs.size() );
+		available[ missing ] = true;
+	}
+
+	for ( uint32_t i = 0; i < k; i++ ) {
+		if ( ! available[ i ] )
+			plan->lostData.push_back( i );
+	}
+	for ( uint32_t i = k; i < n; i++ ) {
+		if ( ! available[ i ] )
+			plan->lostParity.push_back( i );
+	}
+
+	if ( plan->lostData.empty() )
+		return plan;
+
+	// pick k available chunks with linearly independent rows (data chunks first)
+	unsigned char selected[ LRC_N_MAX * LRC_N_MAX ];
+	unsigned char basis[ LRC_N_MAX * LRC_N_MAX ];
+	uint32_t pivots[ LRC_N_MAX ];
+	uint32_t rank = 0;
+
+	for ( uint32_t c = 0; c < n && rank < k; c++ ) {
+		unsigned char *row = basis + rank * k;
+		if ( ! available[ c ] )
+			continue;
+		if ( c < k ) {
+			memset( row, 0, k );
+			row[ c ] = 1;
+		} else {
+			memcpy( row, this->_matrix + ( c - k ) * k, k );
+		}
+		memcpy( selected + rank * k, row, k );
+
+		// eliminate the pivots of the selected rows
+		for ( uint32_t r = 0; r < rank; r++ ) {
+			unsigned char f = row[ pivots[ r ] ];
+			if ( f == 0 )
+				continue;
+			for ( uint32_t j = 0; j < k; j++ )
+				row[ j ] ^= gfMultiply( f, basis[ r * k + j ] );
+		}
+		uint32_t pivot = 0;
+		while ( pivot < k && row[ pivot ] == 0 )
+			pivot++;
+		if ( pivot == k )
+			continue; // linearly dependent
+
+		unsigned char f = gfInverse( row[ pivot ] );
+		for ( uint32_t j = 0; j < k; j++ )
+			row[ j ] = gfMultiply( f, row[ j ] );
+		pivots[ rank++ ] = pivot;
+		plan->srcIds.push_back( c );
+	}
+
+	if ( rank < k ) {
+		delete plan;
+		return 0;
+	}
+
+	// invert the matrix of the selected rows (Gauss-Jordan elimination)
+	unsigned char inverted[ LRC_N_MAX * LRC_N_MAX ];
+	memset( inverted, 0, k * k );
+	for ( uint32_t i = 0; i < k; i++ )
+		inverted[ i * k + i ] = 1;
+	for ( uint32_t i = 0; i < k; i++ ) {
+		uint32_t p = i;
+		while ( selected[ p * k + i ] == 0 )
+			p++;
+		if ( p != i ) {
+			for ( uint32_t j = 0; j < k; j++ ) {
+				std::swap( selected[ p * k + j ], selected[ i * k + j ] );
+				std::swap( inverted[ p * k + j ], inverted[ i * k + j ] );
+			}
+		}
+		unsigned char f = gfInverse( selected[ i * k + i ] );
+		for ( uint32_t j = 0; j < k; j++ ) {
+			selected[ i * k + j ] = gfMultiply( f, selected[ i * k + j ] );
+			inverted[ i * k + j ] = gfMultiply( f, inverted[ i * k + j ] );
+		}
+		for ( uint32_t r = 0; r < k; r++ ) {
+			f = selected[ r * k + i ];
+			if ( r == i || f == 0 )
+				continue;
+			for ( uint32_t j = 0; j < k; j++ ) {
+				selected[ r * k + j ] ^= gfMultiply( f, selected[ i * k + j ] );
+				inverted[ r * k + j ] ^= gfMultiply( f, inverted[ i * k + j ] );
+			}
+		}
+	}
+
+	// the d-th row of the inverse expresses data chunk #d in terms of the selected chunks
+	for ( uint32_t i = 0; i < plan->lostData.size(); i++ ) {
+		unsigned char *row = inverted + plan->lostData[ i ] * k;
+		plan->rows.insert( plan->rows.end(), row, row + k );
+	}
+#ifdef USE_ISAL
+	plan->gftbl.resize( k * plan->lostData.size() * 32 );
+	ec_init_tables( k, plan->lostData.size(), &plan->rows[ 0 ], &plan->gftbl[ 0 ] );
+#else
+	plan->jrows.assign( plan->rows.begin(), plan->rows.end() );
+	plan->jsrcIds.assign( plan->srcIds.begin(), plan->srcIds.end() );
+#endif
+
+	return plan;
+}
+
+uint32_t LRCCoding::getRepairSet( uint32_t chunkId, uint32_t *chunkIds ) {
+	uint32_t k = this->_k;
+	uint32_t count = 0, g;
+
+	if ( chunkId < k )
+		g = this->_group[ chunkId ];
+	else if ( chunkId < k + this->_l )
+		g = chunkId - k;
+	else
+		return 0; // global parity chunks depend on all data chunks
+
+	for ( uint32_t i = this->_groupStart[ g ]; i < this->_groupStart[ g + 1 ]; i++ ) {
+		if ( i != chunkId )
+			chunkIds[ count++ ] = i;
+	}
+	if ( chunkId != k + g )
+		chunkIds[ count++ ] = k + g;
+
+	// no saving with a single group
+	return count < k ? count : 0;
+}
+
+bool LRCCoding::getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients ) {
+	uint32_t repairSet[ LRC_N_MAX ];
+	uint32_t repairSetSize = this->getRepairSet( chunkId, repairSet );
+
+	if ( repairSetSize && count == repairSetSize ) {
+		// a local group is repaired by XOR-ing the surviving members
+		bool isLocal = true;
+		for ( uint32_t i = 0; i < count && isLocal; i++ )
+			isLocal = std::find( repairSet, repairSet + repairSetSize, helperIds[ i ] ) != repairSet + repairSetSize;
+		if ( isLocal ) {
+			memset( coefficients, 1, count );
+			return true;
+		}
+	}
+	return Coding::solveRepairCoefficients( this->_matrix, this->_k, chunkId, helperIds, count, coefficients );
+}
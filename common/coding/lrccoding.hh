@@ -0,0 +1,87 @@
+#ifndef __COMMON_CODING_LRCCODING_HH__
+#define __COMMON_CODING_LRCCODING_HH__
+
+#include <vector>
+#include "coding.hh"
+#include "decode_plan_cache.hh"
+#define LRC_N_MAX (32)
+
+/**
+ * Everything needed to decode a stripe with a given erasure pattern.
+ */
+struct LRCDecodePlan {
+	// Chunks recovered by XOR-ing the surviving members of their local
+	// groups; the sources of localChunks[ i ] are
+	// localSrcs[ localOffsets[ i ] ] ... localSrcs[ localOffsets[ i + 1 ] - 1 ]
+	std::vector<uint32_t> localChunks;
+	std::vector<uint32_t> localSrcs;
+	std::vector<uint32_t> localOffsets;
+	// The remaining lost data chunks are recovered from k independent
+	// chunks (srcIds) with rows[ i * k ] ... rows[ i * k + k - 1 ]
+	std::vector<uint32_t> lostData;
+	std::vector<uint32_t> srcIds;
+	std::vector<unsigned char> rows;
+#ifdef USE_ISAL
+	std::vector<unsigned char> gftbl;
+#else
+	std::vector<int> jrows;
+	std::vector<int> jsrcIds;
+#endif
+	// Lost parity chunks are re-encoded after the data chunks are recovered
+	std::vector<uint32_t> lostParity;
+};
+
+/**
+ * Azure-style locally repairable code: the k data chunks are divided into
+ * l local groups, each of which is protected by an XOR local parity chunk,
+ * and m global parity chunks are computed over all data chunks in GF(2^8).
+ *
+ * Chunk k + i (i < l) is the local parity chunk of the i-th group and
+ * chunks k + l ... k + l + m - 1 are the global parity chunks. A lost data
+ * or local parity chunk is repaired from the about k / l surviving chunks
+ * of its group instead of k chunks.
+ */
+class LRCCoding : public Coding {
+private:
+	uint32_t _k;
+	uint32_t _m;
+	uint32_t _l;
+	uint32_t _chunkSize;
+
+	// Data chunks groupStart[ i ] ... groupStart[ i + 1 ] - 1 belong to the i-th local group
+	uint32_t _groupStart[ LRC_N_MAX + 1 ];
+	uint32_t _group[ LRC_N_MAX ];
+	// Coding matrix of the parity chunks ( ( l + m ) rows of k coefficients)
+	unsigned char _matrix[ LRC_N_MAX * LRC_N_MAX ];
+#ifdef USE_ISAL
+	unsigned char _gftbl[ LRC_N_MAX * LRC_N_MAX * 32 ];
+#else
+	int _jmatrix[ LRC_N_MAX * LRC_N_MAX ];
+#endif
+
+	DecodePlanCache<LRCDecodePlan> _planCache;
+
+	void generateCodeMatrix();
+
+	/**
+	 * Find the steps to recover the lost chunks
+	 *
+	 * @param lost indicate whether each chunk is lost
+	 * @return     the decode plan; NULL if the pattern is not decodable
+	 */
+	LRCDecodePlan *createDecodePlan( bool *lost );
+
+protected:
+	bool decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to );
+
+public:
+	LRCCoding( uint32_t k, uint32_t m, uint32_t l, uint32_t chunkSize );
+
+	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 );
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
+	bool decode( Chunk **chunks, BitmaskArray *chunkStatus );
+	uint32_t getRepairSet( uint32_t chunkId, uint32_t *chunkIds );
+	bool getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients );
+};
+
+#endif
@@ -9,6 +9,10 @@ void RAID0Coding::encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t
 	// No parity chunk to encode
 }
 
+void RAID0Coding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	// No parity chunk to update
+}
+
 bool RAID0Coding::decode( Chunk **chunks, BitmaskArray *bitmap ) {
 	// Check whether any chunk is lost
 	for ( uint32_t i = 0; i < this->n; i++ ) {
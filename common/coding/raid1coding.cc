@@ -14,6 +14,12 @@ void RAID1Coding::encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t
 	);
 }
 
+void RAID1Coding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	// The replica changes by the same delta
+	char *dst = ChunkUtil::getData( parity ) + offset;
+	Coding::bitwiseXOR( dst, dst, delta, length );
+}
+
 bool RAID1Coding::decode( Chunk **chunks, BitmaskArray *bitmap ) {
 	uint32_t survivingIndex = 0;
 	bool ret = false;
@@ -10,6 +10,7 @@ private:
 public:
 	bool init( uint32_t n );
 	void encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0);
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
 	bool decode( Chunk **chunks, BitmaskArray *bitmap );
 };
 
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include "raid5coding.hh"
 #include "../ds/chunk_pool.hh"
 
@@ -27,17 +28,28 @@ void RAID5Coding::encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t
 // 		}
 // 	}
 // #else
-	for ( uint32_t i = 0; i < this->n - 1; i++ ) {
-		this->bitwiseXOR(
-			parity,
-			parity,
-			data[ i ],
-			ChunkUtil::chunkSize
-		);
-	}
+	this->accumulateXOR( parity, data, this->n - 1, ChunkUtil::chunkSize );
 // #endif
 }
 
+void RAID5Coding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	// The parity changes by the same delta at the same offset
+	char *dst = ChunkUtil::getData( parity ) + offset;
+	this->bitwiseXOR( dst, dst, delta, length );
+}
+
+bool RAID5Coding::getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients ) {
+	// The lost chunk is the XOR of all the other chunks
+	if ( count != this->n - 1 )
+		return false;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		if ( helperIds[ i ] == chunkId || helperIds[ i ] >= this->n )
+			return false;
+	}
+	memset( coefficients, 1, count );
+	return true;
+}
+
 bool RAID5Coding::decode( Chunk **chunks, BitmaskArray *bitmap ) {
 	uint32_t lostIndex = 0;
 	uint32_t failed = 0;
@@ -86,17 +98,7 @@ bool RAID5Coding::decode( Chunk **chunks, BitmaskArray *bitmap ) {
 // 	ec_encode_data( ChunkUtil::chunkSize, n - 1, failed, gftbl, alive, missing );
 // #else
 	// Reconstruct the lost chunk
-	Chunk *lostChunk = chunks[ lostIndex ];
-	for ( uint32_t i = 0; i < this->n; i++ ) {
-		if ( i == lostIndex )
-			continue;
-		this->bitwiseXOR(
-			lostChunk,
-			lostChunk,
-			chunks[ i ],
-			ChunkUtil::chunkSize
-		);
-	}
+	this->accumulateXOR( chunks[ lostIndex ], chunks, this->n, ChunkUtil::chunkSize, lostIndex );
 // #endif
 
 	return true;
@@ -12,7 +12,7 @@ typedef char dataType;
 #define RAID5_N_MAX	(32)
 
 class RAID5Coding : public Coding {
-private:
+protected:
 	uint32_t n; // Number of chunks in a stripe
 #ifdef USE_ISAL
 	unsigned char _gftbl[ RAID5_N_MAX * RAID5_N_MAX * 32 ];
@@ -22,7 +22,9 @@ private:
 public:
 	bool init( uint32_t n );
 	void encode( Chunk **data, Chunk *parity, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0);
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
 	bool decode( Chunk **chunks, BitmaskArray *bitmap );
+	bool getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients );
 };
 
 #endif
@@ -4,6 +4,8 @@
 #include "rdpcoding.hh"
 #include "../ds/chunk_util.hh"
 
+#define XOR_PLAN_BATCH ( 32 )
+
 const uint32_t RDPCoding::primeList[ primeCount ] = {
 			2, 3, 5, 7, 11, 13, 17, 19, 23, 29,
 			31, 37, 41, 43, 47, 53, 59, 61, 67, 71,
@@ -49,7 +51,8 @@ void RDPCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index,
 		this->_raid5Coding->encode( dataChunks, parityChunk, index, startOff, endOff );
 	} else if ( index == 2 ) {
 		// need the row parity for encoding the diagonal parity
-		Chunk *firstParity = this->tempChunkPool.alloc();
+		Chunk *firstParity = ( Chunk * ) Coding::getScratch( CODING_SCRATCH_ENCODE, CHUNK_IDENTIFIER_SIZE + chunkSize );
+		ChunkUtil::clear( firstParity );
 		this->_raid5Coding->encode( dataChunks, firstParity, 1 );
 
 		// XOR symbols for diagonal parity, assume
@@ -93,17 +96,80 @@ void RDPCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index,
 					);
 			}
 		}
-		this->tempChunkPool.free( firstParity );
 	} else {
 		// ignored
 	}
 }
 
-bool RDPCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
+void RDPCoding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	uint32_t k = this->_k;
+	uint32_t p = this->_p;
+	uint32_t symbolSize = this->_symbolSize;
+	char *code = ChunkUtil::getData( parity );
+
+	if ( length == 0 )
+		return;
 
+	if ( parityIndex == 1 ) {
+		// row parity
+		this->_raid5Coding->encodeDelta( dataIndex, delta, offset, length, parityIndex, parity );
+	} else if ( parityIndex == 2 ) {
+		// diagonal parity: each modified symbol changes its own diagonal and,
+		// through the row parity (i.e., the k-th column), the diagonal of the row parity symbol
+		for ( uint32_t sidx = offset / symbolSize; sidx <= ( offset + length - 1 ) / symbolSize; sidx++ ) {
+			uint32_t start = sidx * symbolSize, end = start + symbolSize;
+			if ( start < offset ) start = offset;
+			if ( end > offset + length ) end = offset + length;
+
+			uint32_t symbolOff = start - sidx * symbolSize;
+			uint32_t pidx[ 2 ] = { ( dataIndex + sidx ) % p, ( k + sidx ) % p };
+			for ( uint32_t i = 0; i < 2; i++ ) {
+				// missing diagonal
+				if ( pidx[ i ] == p - 1 )
+					continue;
+				char *dst = code + pidx[ i ] * symbolSize + symbolOff;
+				this->bitwiseXOR( dst, dst, delta + ( start - offset ), end - start );
+			}
+		}
+	}
+}
+
+void RDPCoding::getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength ) {
 	uint32_t k = this->_k;
 	uint32_t p = this->_p;
 	uint32_t symbolSize = this->_symbolSize;
+	uint32_t begin = UINT32_MAX, end = 0;
+
+	if ( parityIndex != 2 || length == 0 ) {
+		parityOffset = offset;
+		parityLength = length;
+		return;
+	}
+
+	// Span of the diagonal parity symbols written by encodeDelta()
+	for ( uint32_t sidx = offset / symbolSize; sidx <= ( offset + length - 1 ) / symbolSize; sidx++ ) {
+		uint32_t start = sidx * symbolSize, stop = start + symbolSize;
+		if ( start < offset ) start = offset;
+		if ( stop > offset + length ) stop = offset + length;
+
+		uint32_t symbolOff = start - sidx * symbolSize;
+		uint32_t pidx[ 2 ] = { ( dataIndex + sidx ) % p, ( k + sidx ) % p };
+		for ( uint32_t i = 0; i < 2; i++ ) {
+			if ( pidx[ i ] == p - 1 )
+				continue;
+			if ( pidx[ i ] * symbolSize + symbolOff < begin )
+				begin = pidx[ i ] * symbolSize + symbolOff;
+			if ( pidx[ i ] * symbolSize + symbolOff + ( stop - start ) > end )
+				end = pidx[ i ] * symbolSize + symbolOff + ( stop - start );
+		}
+	}
+	parityOffset = begin < end ? begin : 0;
+	parityLength = begin < end ? end - begin : 0;
+}
+
+bool RDPCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
+
+	uint32_t k = this->_k;
 	std::vector< uint32_t > failed;
 
 	// check for failed disk
@@ -141,99 +207,124 @@ bool RDPCoding::decode( Chunk **chunks, BitmaskArray *chunkStatus ) {
 
 	} else {
 
-		// zero out the chunks for XOR
-		for ( uint32_t idx = 0 ; idx < failed.size() ; idx ++ ) {
-			ChunkUtil::clear( chunks[ failed[ idx ] ] );
-		}
+		// data/row parity + data: follow the recovery chain in the cached plan
+		std::shared_ptr<XORDecodePlan> plan = this->getDecodePlan( chunkStatus, failed );
+		this->performPlan( chunks, plan.get() );
 
-		uint32_t chunkToRRepair = failed[ 0 ];
-		uint32_t chunkToDRepair = failed[ 1 ];
+	}
 
-		// avoid the missing diagonal
-		if ( failed[ 0 ] == 0 ) {
-			chunkToDRepair = failed[ 0 ];
-			chunkToRRepair = failed[ 1 ];
-		}
-		uint32_t didxToRepair = chunkToRRepair - 1;
-		uint32_t sidxToRepair = ( didxToRepair + p - chunkToDRepair ) % p;
+	return true;
+}
 
-		for ( uint32_t recoveredSymbolCount = 0;
-				recoveredSymbolCount < ( p - 1 ) * failed.size();
-				recoveredSymbolCount += 2 ) {
+XORDecodePlan *RDPCoding::createDecodePlan( std::vector<uint32_t> &failed ) {
+	uint32_t k = this->_k;
+	uint32_t p = this->_p;
+	XORDecodePlan *plan = new XORDecodePlan();
+	std::vector<bool> known( ( k + 2 ) * p, true );
 
-			uint32_t sidx;
+	for ( uint32_t idx = 0 ; idx < failed.size() ; idx ++ ) {
+		for ( uint32_t sidx = 0 ; sidx < p ; sidx ++ )
+			known[ failed[ idx ] * p + sidx ] = false;
+	}
 
-			//fprintf( stderr, "repair symbol (%d,%d) (%d,%d)\n", chunkToDRepair,
-			//		sidxToRepair, chunkToRRepair, sidxToRepair );
+	uint32_t chunkToRRepair = failed[ 0 ];
+	uint32_t chunkToDRepair = failed[ 1 ];
 
-			// xor in both diagonal and row for data and row parities
-			for ( uint32_t cidx = 0 ; cidx < k + 1 ; cidx ++ ) {
+	// avoid the missing diagonal
+	if ( failed[ 0 ] == 0 ) {
+		chunkToDRepair = failed[ 0 ];
+		chunkToRRepair = failed[ 1 ];
+	}
+	uint32_t didxToRepair = chunkToRRepair - 1;
+	uint32_t sidxToRepair = ( didxToRepair + p - chunkToDRepair ) % p;
 
-				// skip the symbol to repair in the diagonal direction
-				if ( cidx == chunkToDRepair )
-					continue;
+	for ( uint32_t recoveredSymbolCount = 0;
+			recoveredSymbolCount < ( p - 1 ) * failed.size();
+			recoveredSymbolCount += 2 ) {
 
-				// figure out the symbol id contribute to the diagonal parity
-				sidx = ( didxToRepair + p - cidx ) % p;
+		// diagonal: XOR all symbols on the diagonal and the diagonal parity
+		XOREquation diagonal( chunkToDRepair, sidxToRepair );
+		for ( uint32_t cidx = 0 ; cidx < k + 1 ; cidx ++ ) {
+			if ( cidx == chunkToDRepair )
+				continue;
+			this->addSource( diagonal, known, cidx, ( didxToRepair + p - cidx ) % p );
+		}
+		diagonal.srcs.push_back( std::make_pair( k + 1, didxToRepair ) );
+		plan->equations.push_back( diagonal );
+		known[ chunkToDRepair * p + sidxToRepair ] = true;
 
-				// diagonal, max. idx of symbols (within a chunk) is p-2
-				if ( sidx != p - 1 ) {
-					this->bitwiseXOR(
-						ChunkUtil::getData( chunks[ chunkToDRepair ] ) + sidxToRepair * symbolSize,
-						ChunkUtil::getData( chunks[ cidx ]           ) + sidx * symbolSize,
-						ChunkUtil::getData( chunks[ chunkToDRepair ] ) + sidxToRepair * symbolSize,
-						symbolSize
-					);
+		// row: XOR all symbols in the same row, including the just recovered symbol
+		XOREquation row( chunkToRRepair, sidxToRepair );
+		for ( uint32_t cidx = 0 ; cidx < k + 1 ; cidx ++ ) {
+			if ( cidx == chunkToRRepair )
+				continue;
+			this->addSource( row, known, cidx, sidxToRepair );
+		}
+		plan->equations.push_back( row );
+		known[ chunkToRRepair * p + sidxToRepair ] = true;
+
+		// search for next symbol to recover
+		didxToRepair = ( chunkToRRepair + sidxToRepair ) % p;
+		sidxToRepair = ( didxToRepair + p - chunkToDRepair ) % p;
+		// avoid missing diagonal
+		if ( didxToRepair == p - 1 ) {
+			std::swap( chunkToRRepair, chunkToDRepair );
+			didxToRepair = chunkToRRepair - 1;
+			sidxToRepair = ( didxToRepair + p - chunkToDRepair ) % p;
+		}
+	}
 
-				}
+	return plan;
+}
 
-				// skip the symbol to repair in the row direction
-				if ( cidx == chunkToRRepair )
-					continue;
+std::shared_ptr<XORDecodePlan> RDPCoding::getDecodePlan( BitmaskArray *chunkStatus, std::vector<uint32_t> &failed ) {
+	uint64_t key;
+	std::shared_ptr<XORDecodePlan> plan;
 
-				// row, XOR symbols in the same row
-				sidx = sidxToRepair;
-				this->bitwiseXOR(
-					ChunkUtil::getData( chunks[ chunkToRRepair ] ) + sidxToRepair * symbolSize,
-					ChunkUtil::getData( chunks[ cidx ]           )  + sidxToRepair * symbolSize,
-					ChunkUtil::getData( chunks[ chunkToRRepair ] ) + sidxToRepair * symbolSize,
-					symbolSize
-				);
+	if ( ! DecodePlanCache<XORDecodePlan>::getKey( chunkStatus, this->_k + 2, key ) )
+		return std::shared_ptr<XORDecodePlan>( this->createDecodePlan( failed ) );
 
-			}
+	plan = this->_planCache.get( key );
+	if ( ! plan )
+		plan = this->_planCache.insert( key, this->createDecodePlan( failed ) );
+	return plan;
+}
 
-			// diagonal, XOR the diagonal parity
-			this->bitwiseXOR(
-				ChunkUtil::getData( chunks[ chunkToDRepair ] ) + sidxToRepair * symbolSize,
-				ChunkUtil::getData( chunks[ k + 1 ]          ) + didxToRepair * symbolSize,
-				ChunkUtil::getData( chunks[ chunkToDRepair ] ) + sidxToRepair * symbolSize,
-				symbolSize
-			);
-			//fprintf( stderr, " decode (%d, %d) on (%d, %d) with len %d \n", k + 1, didxToRepair , chunkToDRepair , sidxToRepair, len );
-
-			// row, add back the just recovered symbol from diagonal decoding
-			this->bitwiseXOR (
-				ChunkUtil::getData( chunks[ chunkToRRepair ] ) + sidxToRepair * symbolSize,
-				ChunkUtil::getData( chunks[ chunkToDRepair ] ) + sidxToRepair * symbolSize,
-				ChunkUtil::getData( chunks[ chunkToRRepair ] ) + sidxToRepair * symbolSize,
-				symbolSize
-			);
-			//fprintf( stderr, " decode (%d, %d) on (%d, %d) with len %d \n", chunkToDRepair, sidxToRepair , chunkToRRepair , sidxToRepair, len );
-
-			// search for next symbol to recover
-			didxToRepair = ( chunkToRRepair + sidxToRepair ) % p;
-			sidxToRepair = ( didxToRepair + p - chunkToDRepair ) % p;
-			// avoid missing diagonal
-			if ( didxToRepair == p - 1 ) {
-				std::swap( chunkToRRepair, chunkToDRepair );
-				didxToRepair = chunkToRRepair - 1;
-				sidxToRepair = ( didxToRepair + p - chunkToDRepair ) % p;
+void RDPCoding::addSource( XOREquation &equation, std::vector<bool> &known, uint32_t chunk, uint32_t symbol ) {
+	uint32_t p = this->_p;
+	if ( symbol < p - 1 && known[ chunk * p + symbol ] )
+		equation.srcs.push_back( std::make_pair( chunk, symbol ) );
+}
+
+void RDPCoding::performPlan( Chunk **chunks, XORDecodePlan *plan ) {
+	uint32_t symbolSize = this->_symbolSize;
+	char *scratch = Coding::getScratch( CODING_SCRATCH_DECODE, symbolSize );
+	char *inputs[ XOR_PLAN_BATCH ];
+
+	for ( uint32_t i = 0; i < plan->equations.size(); i++ ) {
+		XOREquation &equation = plan->equations[ i ];
+		char *dst = ( equation.chunk == XOR_PLAN_SCRATCH )? scratch : ChunkUtil::getData( chunks[ equation.chunk ] );
+		uint32_t n = 0;
+		bool partial = false;
+
+		dst += equation.symbol * symbolSize;
+		for ( uint32_t j = 0; j < equation.srcs.size(); j++ ) {
+			uint32_t chunk = equation.srcs[ j ].first, symbol = equation.srcs[ j ].second;
+			inputs[ n++ ] = ( ( chunk == XOR_PLAN_SCRATCH )? scratch : ChunkUtil::getData( chunks[ chunk ] ) ) + symbol * symbolSize;
+			if ( n == XOR_PLAN_BATCH ) {
+				this->bitwiseXOR( dst, inputs, n, symbolSize );
+				inputs[ 0 ] = dst;
+				n = 1;
+				partial = true;
 			}
 		}
 
+		// the first batch overwrites the lost symbol and the following batches accumulate on it
+		if ( n == 0 )
+			memset( dst, 0, symbolSize );
+		else if ( ! partial || n > 1 )
+			this->bitwiseXOR( dst, inputs, n, symbolSize );
 	}
-
-	return true;
 }
 
 uint32_t RDPCoding::getPrime() {
@@ -292,14 +383,5 @@ void RDPCoding::performXOR( Chunk **chunks, uint32_t target ) {
 				target );
 		return;
 	}
-	for ( uint32_t cidx = 0 ; cidx < k + 1 ; cidx ++ ) {
-		if ( cidx == target )
-			continue;
-		this->bitwiseXOR(
-			chunks[ target ],
-			chunks[ cidx ],
-			chunks[ target ],
-			ChunkUtil::chunkSize
-		);
-	}
+	this->accumulateXOR( chunks[ target ], chunks, k + 1, ChunkUtil::chunkSize, target );
 }
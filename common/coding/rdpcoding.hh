@@ -4,8 +4,32 @@
 #include <vector>
 #include "coding.hh"
 #include "raid5coding.hh"
+#include "decode_plan_cache.hh"
 #include "../ds/chunk_pool.hh"
 
+// Chunk index that refers to the scratch symbol (e.g., S of EVENODD) in a decode plan
+#define XOR_PLAN_SCRATCH ( ( uint32_t ) -1 )
+
+struct XOREquation {
+	uint32_t chunk;  // The symbol to be recovered
+	uint32_t symbol;
+	std::vector< std::pair<uint32_t, uint32_t> > srcs; // ( chunk, symbol ) of the symbols to be XOR-ed
+
+	XOREquation( uint32_t chunk, uint32_t symbol ) {
+		this->chunk = chunk;
+		this->symbol = symbol;
+	}
+};
+
+/**
+ * Decode plan of the XOR-based array codes: the symbol-level recovery
+ * chain resolved into equations, each of which recovers one symbol from
+ * the available (or previously recovered) symbols in a single pass.
+ */
+struct XORDecodePlan {
+	std::vector<XOREquation> equations;
+};
+
 class RDPCoding : public Coding {
 protected:
 	/**
@@ -32,12 +56,43 @@ protected:
 	 */
 	void performXOR( Chunk **chunks, uint32_t target );
 
+	/**
+	 * Resolve the recovery chain for two lost chunks into a decode plan
+	 *
+	 * @param failed indices of the lost chunks (in ascending order)
+	 * @return       the decode plan
+	 */
+	virtual XORDecodePlan *createDecodePlan( std::vector<uint32_t> &failed );
+
+	/**
+	 * Get the decode plan for an erasure pattern from the cache, or create one
+	 *
+	 * @param chunkStatus indicate which chunks are available
+	 * @param failed      indices of the lost chunks (in ascending order)
+	 * @return            the decode plan
+	 */
+	std::shared_ptr<XORDecodePlan> getDecodePlan( BitmaskArray *chunkStatus, std::vector<uint32_t> &failed );
+
+	/**
+	 * Add a symbol to an equation unless it is lost and not yet recovered
+	 * (i.e., contributes zero) or is on the imaginary ( p - 1 )-th row
+	 */
+	void addSource( XOREquation &equation, std::vector<bool> &known, uint32_t chunk, uint32_t symbol );
+
+	/**
+	 * Recover the lost symbols following a decode plan
+	 *
+	 * @param chunks data and parity chunks
+	 * @param plan   the decode plan
+	 */
+	void performPlan( Chunk **chunks, XORDecodePlan *plan );
+
 	RAID5Coding* _raid5Coding;
 	uint32_t _k;
 	uint32_t _p;
 	uint32_t _chunkSize;
 	uint32_t _symbolSize;
-	TempChunkPool tempChunkPool;
+	DecodePlanCache<XORDecodePlan> _planCache;
 
 	// use some memory to save computation (assume p < 200)
 	static const uint32_t primeCount = 168;
@@ -48,6 +103,8 @@ public:
 	~RDPCoding();
 
 	void encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 );
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
+	void getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength );
 	bool decode( Chunk **chunks, BitmaskArray *chunkStatus );
 };
 
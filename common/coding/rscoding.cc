@@ -1,6 +1,7 @@
 #include <cstdlib>
 #include <vector>
 #include "rscoding.hh"
+#include "fixed_kernel.hh"
 #include "../ds/chunk_pool.hh"
 
 #ifndef USE_ISAL
@@ -50,62 +51,109 @@ RSCoding::~RSCoding() {
 
 void RSCoding::encode( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff, uint32_t endOff ) {
 	uint32_t k = this->_k;
-	uint32_t m = this->_m;
 	uint32_t chunkSize = this->_chunkSize;
+	dataType *data[ RS_N_MAX ], *code[ RS_N_MAX ];
 
-#ifndef USE_ISAL
-	uint32_t w = this->_w;
+	for ( uint32_t idx = 0 ; idx < k ; idx ++ )
+		data[ idx ] = ( dataType * ) ChunkUtil::getData( dataChunks[ idx ] );
+	code[ index - 1 ] = ( dataType * ) ChunkUtil::getData( parityChunk );
 
+	// encode the ( index )-th parity chunk only (no buffers are needed for the other parity chunks)
+#ifdef USE_ISAL
+	dataType *gftbl = this->_gftbl + ( index - 1 ) * k * 32;
+	if ( startOff == 0 && endOff == 0 ) {
+		ec_encode_data( chunkSize, k, 1, gftbl, data, code + index - 1 );
+	} else {
+		for ( uint32_t i = startOff / chunkSize; i <= ( endOff - 1 ) / chunkSize; i++ ) {
+			// note: the update is in-place "xor"ed on parityChunk
+			ec_encode_data_update( chunkSize, k, 1, i, gftbl, data[ i ], code + index - 1 );
+		}
+	}
+#else
 	if ( this->_jmatrix == NULL )
 		generateCodeMatrix();
 
-	int* matrix = this->_jmatrix;
+	jerasure_matrix_dotprod( k, this->_w, this->_jmatrix + ( index - 1 ) * k, NULL, k + index - 1, data, code, chunkSize );
 #endif
+}
 
-	dataType *data[ RS_N_MAX ], *code[ RS_N_MAX ];
+void RSCoding::encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity ) {
+	uint32_t k = this->_k;
+	dataType *code[ 1 ];
 
-	// use local buffer for encoding correctness
-	dataType *chunk = new dataType[ m * chunkSize ];
+	if ( length == 0 )
+		return;
 
-	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
-		if ( idx < k ) {
-			data[ idx ] = ( dataType * ) ChunkUtil::getData( dataChunks[ idx ] );
-		} else if ( idx - k == index - 1 ) {
-			code[ idx - k ] = ( dataType * ) ChunkUtil::getData( parityChunk );
-		} else {
-			code[ idx - k ] = chunk + ( idx - k ) * chunkSize;
-		}
-	}
+	code[ 0 ] = ( dataType * ) ChunkUtil::getData( parity ) + offset;
 
-	// encode
 #ifdef USE_ISAL
-	if ( startOff == 0 && endOff == 0 ) {
-		ec_encode_data( chunkSize, k, m, this->_gftbl, data, code );
-	} else {
-		for ( uint32_t i = startOff / chunkSize; i <= ( endOff - 1 ) / chunkSize; i++ ) {
-			// note: the update is in-place "xor"ed on parityChunk
-			ec_encode_data_update( chunkSize, k, m, i, this->_gftbl, data[ i ], code );
-		}
+	// Use the tables of the ( parityIndex )-th row only; the update is in-place "xor"ed on the parity chunk
+	ec_encode_data_update(
+		length, k, 1, dataIndex,
+		this->_gftbl + ( parityIndex - 1 ) * k * 32,
+		( dataType * ) delta, code
+	);
+#else
+	if ( this->_jmatrix == NULL )
+		generateCodeMatrix();
+
+	if ( this->_w != 8 ) {
+		// Symbols span multiple bytes and the modified range may not be aligned to symbol boundaries
+		this->encodeDeltaByStripe( k, dataIndex, delta, offset, length, parityIndex, parity );
+		return;
 	}
+
+	Coding::multiplyXOR(
+		code[ 0 ], delta,
+		( uint8_t ) this->_jmatrix[ ( parityIndex - 1 ) * k + dataIndex ],
+		length
+	);
+#endif
+}
+
+bool RSCoding::getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients ) {
+	uint32_t k = this->_k;
+#ifdef USE_ISAL
+	return Coding::solveRepairCoefficients( this->_encodeMatrix + k * k, k, chunkId, helperIds, count, coefficients );
 #else
-	jerasure_matrix_encode( k, m, w, matrix, data, code, chunkSize );
+	if ( this->_jmatrix == NULL )
+		generateCodeMatrix();
+
+	if ( this->_w != 8 )
+		return false; // symbols span multiple bytes
+
+	uint8_t parityRows[ RS_N_MAX * RS_N_MAX ];
+	for ( uint32_t i = 0; i < this->_m * k; i++ )
+		parityRows[ i ] = ( uint8_t ) this->_jmatrix[ i ];
+	return Coding::solveRepairCoefficients( parityRows, k, chunkId, helperIds, count, coefficients );
 #endif
+}
 
-	delete chunk;
+void RSCoding::getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength ) {
+	parityOffset = offset;
+	parityLength = length;
+#ifndef USE_ISAL
+	if ( this->_w != 8 && length ) {
+		// See encodeDeltaByStripe()
+		parityOffset = 0;
+		parityLength = this->_chunkSize;
+	}
+#endif
 }
 
 bool RSCoding::decode( Chunk **chunks, BitmaskArray * chunkStatus ) {
+	return this->decodeStripes( &chunks, chunkStatus, 0, 1 );
+}
+
+bool RSCoding::getDecodePlan( BitmaskArray *chunkStatus, std::shared_ptr<RSDecodePlan> &plan ) {
 	uint32_t k = this->_k;
 	uint32_t m = this->_m;
-#ifndef USE_ISAL
-	uint32_t w = this->_w;
-#endif
-	uint32_t chunkSize = this->_chunkSize;
 
+	int erasures[ RS_N_MAX ];
 	uint32_t failed = 0;
 	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
 		if ( chunkStatus->check( idx ) ==  0) {
-			failed++;
+			erasures[ failed++ ] = idx;
 		}
 	}
 
@@ -115,75 +163,178 @@ bool RSCoding::decode( Chunk **chunks, BitmaskArray * chunkStatus ) {
 		return false;
 	}
 
+	plan.reset();
 	if ( failed == 0 ) {
 		return true;
 	}
 
-	int erasures[ RS_N_MAX ];
-	int pos = 0;
-	dataType *data[ RS_N_MAX ], *code[ RS_N_MAX ];
-#ifdef USE_ISAL
-	int rpos = 0;
-	dataType *alive[ RS_N_MAX ], *missing[ RS_N_MAX ];
+#ifndef USE_ISAL
+	if ( this->_jmatrix == NULL )
+		generateCodeMatrix();
 #endif
 
-	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
-		if ( idx < k )
-			data[ idx ] = ( dataType * ) ChunkUtil::getData( chunks[ idx ] );
-		else
-			code[ idx - k ] = ( dataType * ) ChunkUtil::getData( chunks[ idx ] );
+	// reuse the plan if the same set of chunks was lost before
+	uint64_t key;
+	if ( ! DecodePlanCache<RSDecodePlan>::getKey( chunkStatus, k + m, key ) ) {
+		// the pattern does not fit into a cache key: use the plan once
+		plan.reset( this->createDecodePlan( erasures, failed ) );
+		return plan != 0;
+	}
+	plan = this->_planCache.get( key );
+	if ( ! plan ) {
+		RSDecodePlan *newPlan = this->createDecodePlan( erasures, failed );
+		if ( ! newPlan )
+			return false;
+		plan = this->_planCache.insert( key, newPlan );
+	}
+	return true;
+}
+
+bool RSCoding::decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to ) {
+	uint32_t k = this->_k;
+	uint32_t chunkSize = this->_chunkSize;
+	std::shared_ptr<RSDecodePlan> plan;
+
+	if ( ! this->getDecodePlan( chunkStatus, plan ) )
+		return false;
+	if ( ! plan )
+		return true;
 
+	// decode
 #ifdef USE_ISAL
-		if ( chunkStatus->check( idx ) == 0 ) {
-			erasures[ pos ] = idx;
-			missing[ pos++ ] = ( idx < k )? data[ idx ] : code[ idx - k ];
-		} else {
-			alive[ rpos++ ] = ( idx < k )? data[ idx ] : code[ idx - k ];
-		}
+	dataType *alive[ RS_N_MAX ], *missing[ RS_N_MAX ];
+	for ( uint32_t s = from; s < to; s++ ) {
+		Chunk **chunks = stripes[ s ];
+		for ( uint32_t i = 0; i < k; i++ )
+			alive[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ plan->alive[ i ] ] );
+		for ( uint32_t i = 0; i < plan->failed; i++ )
+			missing[ i ] = ( dataType * ) ChunkUtil::getData( chunks[ plan->erasures[ i ] ] );
+		ec_encode_data( chunkSize, k, plan->failed, &plan->gftbl[ 0 ], alive, missing );
+	}
 #else
-		if ( chunkStatus->check( idx ) == 0 ) {
-			erasures[ pos++ ] = idx;
+	uint32_t m = this->_m;
+	uint32_t w = this->_w;
+	dataType *data[ RS_N_MAX ], *code[ RS_N_MAX ];
+
+	// recover one lost chunk in all stripes before moving on to the next one
+	for ( uint32_t i = 0; i < plan->lostData.size() + plan->lostParity.size(); i++ ) {
+		for ( uint32_t s = from; s < to; s++ ) {
+			Chunk **chunks = stripes[ s ];
+			for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
+				if ( idx < k )
+					data[ idx ] = ( dataType * ) ChunkUtil::getData( chunks[ idx ] );
+				else
+					code[ idx - k ] = ( dataType * ) ChunkUtil::getData( chunks[ idx ] );
+			}
+
+			if ( i < plan->lostData.size() ) {
+				jerasure_matrix_dotprod(
+					k, w, &plan->rows[ i * k ], &plan->srcIds[ i * k ],
+					plan->lostData[ i ], data, code, chunkSize
+				);
+			} else {
+				// lost parity chunks are re-encoded from the recovered data chunks
+				int parity = plan->lostParity[ i - plan->lostData.size() ];
+				jerasure_matrix_dotprod(
+					k, w, this->_jmatrix + ( parity - k ) * k, NULL,
+					parity, data, code, chunkSize
+				);
+			}
 		}
+	}
 #endif
 
-	}
+	return true;
+}
 
-	// required for jerasure
-	erasures[ failed ] = -1;
+RSDecodePlan *RSCoding::createDecodePlan( int *erasures, uint32_t failed ) {
+	uint32_t k = this->_k;
+	uint32_t m = this->_m;
+	RSDecodePlan *plan = new RSDecodePlan();
+	int lost[ RS_N_MAX ];
+
+	plan->failed = failed;
+	memcpy( plan->erasures, erasures, sizeof( int ) * failed );
+	memset( lost, 0, sizeof( lost ) );
+	for ( uint32_t i = 0; i < failed; i++ )
+		lost[ erasures[ i ] ] = 1;
 
-	// decode
 #ifdef USE_ISAL
 	dataType decodeMatrix[ RS_N_MAX * RS_N_MAX ];
 	dataType invertedMatrix[ RS_N_MAX * RS_N_MAX ];
-	dataType gftbl[ RS_N_MAX * RS_N_MAX * 32 ];
-	// get the row where data is alive
-	for ( uint32_t i = 0, pos = 0, oi = 0; i < k+m; i++ ) {
-		if ( ( int ) i != erasures[ pos ] ) {
-			memcpy( decodeMatrix + k * oi++, this->_encodeMatrix + k * i, k );
-		} else {
-			pos++;
-		}
+	// get the rows of the first k alive chunks
+	for ( uint32_t i = 0, oi = 0; i < k + m && oi < k; i++ ) {
+		if ( lost[ i ] )
+			continue;
+		memcpy( decodeMatrix + k * oi, this->_encodeMatrix + k * i, k );
+		plan->alive[ oi++ ] = i;
 	}
 	// get the inverse of the matrix of alive data
 	if ( gf_invert_matrix( decodeMatrix, invertedMatrix, k ) < 0 ) {
 		fprintf( stderr, "Cannot find the inverse for decoding ...\n" );
-		return false;
+		delete plan;
+		return 0;
 	}
-	memset( decodeMatrix, 0, RS_N_MAX * RS_N_MAX );
+	// express each lost chunk in terms of the alive chunks
 	for ( uint32_t i = 0; i < failed; i++ ) {
-		memcpy( decodeMatrix + k * i, invertedMatrix + k * erasures[ i ], k );
+		uint32_t e = erasures[ i ];
+		if ( e < k ) {
+			memcpy( decodeMatrix + k * i, invertedMatrix + k * e, k );
+		} else {
+			// parity: multiply its row in the encoding matrix with the inverse
+			for ( uint32_t j = 0; j < k; j++ ) {
+				dataType s = 0;
+				for ( uint32_t l = 0; l < k; l++ )
+					s ^= gf_mul( this->_encodeMatrix[ k * e + l ], invertedMatrix[ k * l + j ] );
+				decodeMatrix[ k * i + j ] = s;
+			}
+		}
 	}
-	ec_init_tables( k, failed, decodeMatrix, gftbl );
-	ec_encode_data( chunkSize, k, failed, gftbl, alive, missing );
+	plan->gftbl.resize( k * failed * 32 );
+	ec_init_tables( k, failed, decodeMatrix, &plan->gftbl[ 0 ] );
 #else
-	if ( this->_jmatrix == NULL )
-		generateCodeMatrix();
+	int *matrix = this->_jmatrix;
+
+	for ( uint32_t i = 0; i < failed; i++ ) {
+		if ( ( uint32_t ) erasures[ i ] < k )
+			plan->lostData.push_back( erasures[ i ] );
+		else
+			plan->lostParity.push_back( erasures[ i ] );
+	}
 
-	jerasure_matrix_decode( k, m, w, this->_jmatrix, 1, erasures, data, code,
-			chunkSize);
+	bool rowOnes = ! lost[ k ];
+	for ( uint32_t j = 0; j < k && rowOnes; j++ )
+		rowOnes = ( matrix[ j ] == 1 );
+
+	if ( plan->lostData.size() == 1 && rowOnes ) {
+		// the first parity chunk is the XOR of all data chunks; no inversion is needed
+		int e = plan->lostData[ 0 ];
+		plan->rows.assign( matrix, matrix + k );
+		for ( uint32_t j = 0; j < k; j++ )
+			plan->srcIds.push_back( ( int ) j < e ? j : j + 1 );
+	} else if ( plan->lostData.size() > 0 ) {
+		int decodingMatrix[ RS_N_MAX * RS_N_MAX ];
+		int dmIds[ RS_N_MAX ];
+		if ( jerasure_make_decoding_matrix( k, m, this->_w, matrix, lost, decodingMatrix, dmIds ) < 0 ) {
+			fprintf( stderr, "Cannot find the inverse for decoding ...\n" );
+			delete plan;
+			return 0;
+		}
+		for ( uint32_t i = 0; i < plan->lostData.size(); i++ ) {
+			int *row = decodingMatrix + plan->lostData[ i ] * k;
+			plan->rows.insert( plan->rows.end(), row, row + k );
+			plan->srcIds.insert( plan->srcIds.end(), dmIds, dmIds + k );
+		}
+	}
+
+	if ( this->_w == 8 && plan->rows.size() > 0 ) {
+		std::vector<uint8_t> coefficients( plan->rows.begin(), plan->rows.end() );
+		plan->gftbl.resize( coefficients.size() * FIXED_GF_TABLE_SIZE );
+		Coding::initMultiplyTables( &coefficients[ 0 ], coefficients.size(), &plan->gftbl[ 0 ] );
+	}
 #endif
 
-	return true;
+	return plan;
 }
 
 uint32_t RSCoding::getW() {
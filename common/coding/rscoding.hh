@@ -1,9 +1,36 @@
 #ifndef __COMMON_CODING_RSCODING_HH__
 #define __COMMON_CODING_RSCODING_HH__
 
+#include <vector>
 #include "coding.hh"
+#include "decode_plan_cache.hh"
 #define RS_N_MAX (32)
 
+/**
+ * Everything needed to decode a stripe with a given erasure pattern,
+ * derived from the (inverted) coding matrix.
+ */
+struct RSDecodePlan {
+	uint32_t failed;
+	int erasures[ RS_N_MAX ];
+#ifdef USE_ISAL
+	// The k available chunks used for decoding
+	uint32_t alive[ RS_N_MAX ];
+	// Tables of the rows that recover the lost chunks from alive chunks
+	std::vector<unsigned char> gftbl;
+#else
+	// Lost data chunks are recovered from k available chunks
+	// (i.e., srcIds[ i * k ] ... srcIds[ i * k + k - 1 ]) with rows[ i * k ] ... rows[ i * k + k - 1 ]
+	std::vector<int> lostData;
+	std::vector<int> rows;
+	std::vector<int> srcIds;
+	// Lost parity chunks are re-encoded after the data chunks are recovered
+	std::vector<int> lostParity;
+	// Multiplication tables of the rows for the specialized kernels (w = 8 only)
+	std::vector<unsigned char> gftbl;
+#endif
+};
+
 class RSCoding : public Coding {
 private:
 	/**
@@ -22,6 +49,26 @@ private:
 	 */
 	void generateCodeMatrix();
 
+	/**
+	 * Invert the coding matrix for an erasure pattern
+	 *
+	 * @param erasures indices of the lost chunks
+	 * @param failed   number of lost chunks
+	 * @return         the decode plan; NULL if the pattern is not decodable
+	 */
+	RSDecodePlan *createDecodePlan( int *erasures, uint32_t failed );
+protected:
+	bool decodeStripes( Chunk ***stripes, BitmaskArray *chunkStatus, uint32_t from, uint32_t to );
+
+	/**
+	 * Get the decode plan for the erasure pattern from the cache, or create one
+	 *
+	 * @param chunkStatus indicate which chunks are available
+	 * @param plan        (output) the decode plan; empty if no chunks are lost
+	 * @return            false if the pattern is not decodable
+	 */
+	bool getDecodePlan( BitmaskArray *chunkStatus, std::shared_ptr<RSDecodePlan> &plan );
+
 	uint32_t _k;
 	uint32_t _m;
 	uint32_t _w;
@@ -34,12 +81,17 @@ private:
 	int *_jmatrix;
 #endif
 
+	DecodePlanCache<RSDecodePlan> _planCache;
+
 public:
 	RSCoding( uint32_t k = 0, uint32_t m = 0, uint32_t chunkSize = 0 );
 	~RSCoding();
 
 	void encode ( Chunk **dataChunks, Chunk *parityChunk, uint32_t index, uint32_t startOff = 0, uint32_t endOff = 0 );
+	void encodeDelta( uint32_t dataIndex, char *delta, uint32_t offset, uint32_t length, uint32_t parityIndex, Chunk *parity );
+	void getDeltaRange( uint32_t dataIndex, uint32_t offset, uint32_t length, uint32_t parityIndex, uint32_t &parityOffset, uint32_t &parityLength );
 	bool decode ( Chunk **chunks, BitmaskArray * chunkStatus );
+	bool getRepairCoefficients( uint32_t chunkId, uint32_t *helperIds, uint32_t count, uint8_t *coefficients );
 };
 
 #endif
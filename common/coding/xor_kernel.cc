@@ -0,0 +1,313 @@
+#include "xor_kernel.hh"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define XOR_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+/////////////////////////////
+// Scalar (64-bit words)   //
+/////////////////////////////
+static void xor2Scalar( char *dst, char *srcA, char *srcB, uint32_t len ) {
+	uint64_t *srcA64 = ( uint64_t * ) srcA;
+	uint64_t *srcB64 = ( uint64_t * ) srcB;
+	uint64_t *dst64 = ( uint64_t * ) dst;
+	uint32_t count = len / sizeof( uint64_t ), i;
+
+	for ( i = 0; i < count; i++ )
+		dst64[ i ] = srcA64[ i ] ^ srcB64[ i ];
+	for ( i = count * sizeof( uint64_t ); i < len; i++ )
+		dst[ i ] = srcA[ i ] ^ srcB[ i ];
+}
+
+static void xorNScalar( char *dst, char **srcs, uint32_t count, uint32_t len, uint32_t i = 0 ) {
+	uint64_t acc;
+	uint32_t j;
+
+	for ( ; i + sizeof( uint64_t ) <= len; i += sizeof( uint64_t ) ) {
+		acc = *( uint64_t * )( srcs[ 0 ] + i );
+		for ( j = 1; j < count; j++ )
+			acc ^= *( uint64_t * )( srcs[ j ] + i );
+		*( uint64_t * )( dst + i ) = acc;
+	}
+	for ( ; i < len; i++ ) {
+		char c = srcs[ 0 ][ i ];
+		for ( j = 1; j < count; j++ )
+			c ^= srcs[ j ][ i ];
+		dst[ i ] = c;
+	}
+}
+
+static void deltaScalar( char *delta, char *data, char *newData, uint32_t len ) {
+	uint64_t a, b;
+	uint32_t i;
+
+	for ( i = 0; i + sizeof( uint64_t ) <= len; i += sizeof( uint64_t ) ) {
+		a = *( uint64_t * )( data + i );
+		b = *( uint64_t * )( newData + i );
+		*( uint64_t * )( delta + i ) = a ^ b;
+		*( uint64_t * )( data + i ) = b;
+	}
+	for ( ; i < len; i++ ) {
+		char c = newData[ i ];
+		delta[ i ] = data[ i ] ^ c;
+		data[ i ] = c;
+	}
+}
+
+#ifdef XOR_KERNEL_X86
+/////////////////////////////
+// SSE2 (128-bit vectors)  //
+/////////////////////////////
+__attribute__((target("sse2")))
+static void xor2SSE2( char *dst, char *srcA, char *srcB, uint32_t len ) {
+	uint32_t i;
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		__m128i a = _mm_loadu_si128( ( __m128i * )( srcA + i ) );
+		__m128i b = _mm_loadu_si128( ( __m128i * )( srcB + i ) );
+		_mm_storeu_si128( ( __m128i * )( dst + i ), _mm_xor_si128( a, b ) );
+	}
+	if ( i < len )
+		xor2Scalar( dst + i, srcA + i, srcB + i, len - i );
+}
+
+__attribute__((target("sse2")))
+static void xorNSSE2( char *dst, char **srcs, uint32_t count, uint32_t len ) {
+	uint32_t i, j;
+	for ( i = 0; i + 64 <= len; i += 64 ) {
+		__m128i a0 = _mm_loadu_si128( ( __m128i * )( srcs[ 0 ] + i ) );
+		__m128i a1 = _mm_loadu_si128( ( __m128i * )( srcs[ 0 ] + i + 16 ) );
+		__m128i a2 = _mm_loadu_si128( ( __m128i * )( srcs[ 0 ] + i + 32 ) );
+		__m128i a3 = _mm_loadu_si128( ( __m128i * )( srcs[ 0 ] + i + 48 ) );
+		for ( j = 1; j < count; j++ ) {
+			a0 = _mm_xor_si128( a0, _mm_loadu_si128( ( __m128i * )( srcs[ j ] + i ) ) );
+			a1 = _mm_xor_si128( a1, _mm_loadu_si128( ( __m128i * )( srcs[ j ] + i + 16 ) ) );
+			a2 = _mm_xor_si128( a2, _mm_loadu_si128( ( __m128i * )( srcs[ j ] + i + 32 ) ) );
+			a3 = _mm_xor_si128( a3, _mm_loadu_si128( ( __m128i * )( srcs[ j ] + i + 48 ) ) );
+		}
+		_mm_storeu_si128( ( __m128i * )( dst + i ), a0 );
+		_mm_storeu_si128( ( __m128i * )( dst + i + 16 ), a1 );
+		_mm_storeu_si128( ( __m128i * )( dst + i + 32 ), a2 );
+		_mm_storeu_si128( ( __m128i * )( dst + i + 48 ), a3 );
+	}
+	if ( i < len )
+		xorNScalar( dst, srcs, count, len, i );
+}
+
+__attribute__((target("sse2")))
+static void deltaSSE2( char *delta, char *data, char *newData, uint32_t len ) {
+	uint32_t i;
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		__m128i a = _mm_loadu_si128( ( __m128i * )( data + i ) );
+		__m128i b = _mm_loadu_si128( ( __m128i * )( newData + i ) );
+		_mm_storeu_si128( ( __m128i * )( delta + i ), _mm_xor_si128( a, b ) );
+		_mm_storeu_si128( ( __m128i * )( data + i ), b );
+	}
+	if ( i < len )
+		deltaScalar( delta + i, data + i, newData + i, len - i );
+}
+
+/////////////////////////////
+// AVX2 (256-bit vectors)  //
+/////////////////////////////
+__attribute__((target("avx2")))
+static void xor2AVX2( char *dst, char *srcA, char *srcB, uint32_t len ) {
+	uint32_t i;
+	for ( i = 0; i + 32 <= len; i += 32 ) {
+		__m256i a = _mm256_loadu_si256( ( __m256i * )( srcA + i ) );
+		__m256i b = _mm256_loadu_si256( ( __m256i * )( srcB + i ) );
+		_mm256_storeu_si256( ( __m256i * )( dst + i ), _mm256_xor_si256( a, b ) );
+	}
+	if ( i < len )
+		xor2Scalar( dst + i, srcA + i, srcB + i, len - i );
+}
+
+__attribute__((target("avx2")))
+static void xorNAVX2( char *dst, char **srcs, uint32_t count, uint32_t len ) {
+	uint32_t i, j;
+	for ( i = 0; i + 128 <= len; i += 128 ) {
+		__m256i a0 = _mm256_loadu_si256( ( __m256i * )( srcs[ 0 ] + i ) );
+		__m256i a1 = _mm256_loadu_si256( ( __m256i * )( srcs[ 0 ] + i + 32 ) );
+		__m256i a2 = _mm256_loadu_si256( ( __m256i * )( srcs[ 0 ] + i + 64 ) );
+		__m256i a3 = _mm256_loadu_si256( ( __m256i * )( srcs[ 0 ] + i + 96 ) );
+		for ( j = 1; j < count; j++ ) {
+			a0 = _mm256_xor_si256( a0, _mm256_loadu_si256( ( __m256i * )( srcs[ j ] + i ) ) );
+			a1 = _mm256_xor_si256( a1, _mm256_loadu_si256( ( __m256i * )( srcs[ j ] + i + 32 ) ) );
+			a2 = _mm256_xor_si256( a2, _mm256_loadu_si256( ( __m256i * )( srcs[ j ] + i + 64 ) ) );
+			a3 = _mm256_xor_si256( a3, _mm256_loadu_si256( ( __m256i * )( srcs[ j ] + i + 96 ) ) );
+		}
+		_mm256_storeu_si256( ( __m256i * )( dst + i ), a0 );
+		_mm256_storeu_si256( ( __m256i * )( dst + i + 32 ), a1 );
+		_mm256_storeu_si256( ( __m256i * )( dst + i + 64 ), a2 );
+		_mm256_storeu_si256( ( __m256i * )( dst + i + 96 ), a3 );
+	}
+	if ( i < len )
+		xorNScalar( dst, srcs, count, len, i );
+}
+
+__attribute__((target("avx2")))
+static void deltaAVX2( char *delta, char *data, char *newData, uint32_t len ) {
+	uint32_t i;
+	for ( i = 0; i + 32 <= len; i += 32 ) {
+		__m256i a = _mm256_loadu_si256( ( __m256i * )( data + i ) );
+		__m256i b = _mm256_loadu_si256( ( __m256i * )( newData + i ) );
+		_mm256_storeu_si256( ( __m256i * )( delta + i ), _mm256_xor_si256( a, b ) );
+		_mm256_storeu_si256( ( __m256i * )( data + i ), b );
+	}
+	if ( i < len )
+		deltaScalar( delta + i, data + i, newData + i, len - i );
+}
+
+/////////////////////////////
+// AVX-512 (512-bit)       //
+/////////////////////////////
+__attribute__((target("avx512f")))
+static void xor2AVX512( char *dst, char *srcA, char *srcB, uint32_t len ) {
+	uint32_t i;
+	for ( i = 0; i + 64 <= len; i += 64 ) {
+		__m512i a = _mm512_loadu_si512( ( void * )( srcA + i ) );
+		__m512i b = _mm512_loadu_si512( ( void * )( srcB + i ) );
+		_mm512_storeu_si512( ( void * )( dst + i ), _mm512_xor_si512( a, b ) );
+	}
+	if ( i < len )
+		xor2Scalar( dst + i, srcA + i, srcB + i, len - i );
+}
+
+__attribute__((target("avx512f")))
+static void xorNAVX512( char *dst, char **srcs, uint32_t count, uint32_t len ) {
+	uint32_t i, j;
+	for ( i = 0; i + 256 <= len; i += 256 ) {
+		__m512i a0 = _mm512_loadu_si512( ( void * )( srcs[ 0 ] + i ) );
+		__m512i a1 = _mm512_loadu_si512( ( void * )( srcs[ 0 ] + i + 64 ) );
+		__m512i a2 = _mm512_loadu_si512( ( void * )( srcs[ 0 ] + i + 128 ) );
+		__m512i a3 = _mm512_loadu_si512( ( void * )( srcs[ 0 ] + i + 192 ) );
+		for ( j = 1; j < count; j++ ) {
+			a0 = _mm512_xor_si512( a0, _mm512_loadu_si512( ( void * )( srcs[ j ] + i ) ) );
+			a1 = _mm512_xor_si512( a1, _mm512_loadu_si512( ( void * )( srcs[ j ] + i + 64 ) ) );
+			a2 = _mm512_xor_si512( a2, _mm512_loadu_si512( ( void * )( srcs[ j ] + i + 128 ) ) );
+			a3 = _mm512_xor_si512( a3, _mm512_loadu_si512( ( void * )( srcs[ j ] + i + 192 ) ) );
+		}
+		_mm512_storeu_si512( ( void * )( dst + i ), a0 );
+		_mm512_storeu_si512( ( void * )( dst + i + 64 ), a1 );
+		_mm512_storeu_si512( ( void * )( dst + i + 128 ), a2 );
+		_mm512_storeu_si512( ( void * )( dst + i + 192 ), a3 );
+	}
+	if ( i < len )
+		xorNScalar( dst, srcs, count, len, i );
+}
+
+__attribute__((target("avx512f")))
+static void deltaAVX512( char *delta, char *data, char *newData, uint32_t len ) {
+	uint32_t i;
+	for ( i = 0; i + 64 <= len; i += 64 ) {
+		__m512i a = _mm512_loadu_si512( ( void * )( data + i ) );
+		__m512i b = _mm512_loadu_si512( ( void * )( newData + i ) );
+		_mm512_storeu_si512( ( void * )( delta + i ), _mm512_xor_si512( a, b ) );
+		_mm512_storeu_si512( ( void * )( data + i ), b );
+	}
+	if ( i < len )
+		deltaScalar( delta + i, data + i, newData + i, len - i );
+}
+#endif
+
+static void xorNScalarEntry( char *dst, char **srcs, uint32_t count, uint32_t len ) {
+	xorNScalar( dst, srcs, count, len );
+}
+
+XORKernelType XORKernel::type = XOR_KERNEL_AUTO;
+void ( *XORKernel::xor2 )( char *, char *, char *, uint32_t ) = XORKernel::resolveXOR2;
+void ( *XORKernel::xorN )( char *, char **, uint32_t, uint32_t ) = XORKernel::resolveXORN;
+void ( *XORKernel::delta )( char *, char *, char *, uint32_t ) = XORKernel::resolveDelta;
+
+void XORKernel::resolveXOR2( char *dst, char *srcA, char *srcB, uint32_t len ) {
+	XORKernel::select();
+	XORKernel::xor2( dst, srcA, srcB, len );
+}
+
+void XORKernel::resolveXORN( char *dst, char **srcs, uint32_t count, uint32_t len ) {
+	XORKernel::select();
+	XORKernel::xorN( dst, srcs, count, len );
+}
+
+void XORKernel::resolveDelta( char *delta, char *data, char *newData, uint32_t len ) {
+	XORKernel::select();
+	XORKernel::delta( delta, data, newData, len );
+}
+
+bool XORKernel::isSupported( XORKernelType type ) {
+	switch( type ) {
+		case XOR_KERNEL_AUTO:
+		case XOR_KERNEL_SCALAR:
+			return true;
+#ifdef XOR_KERNEL_X86
+		case XOR_KERNEL_SSE2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports( "sse2" );
+		case XOR_KERNEL_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports( "avx2" );
+		case XOR_KERNEL_AVX512:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports( "avx512f" );
+#endif
+		default:
+			return false;
+	}
+}
+
+bool XORKernel::select( XORKernelType type ) {
+	if ( type == XOR_KERNEL_AUTO ) {
+		if ( XORKernel::isSupported( XOR_KERNEL_AVX512 ) )
+			type = XOR_KERNEL_AVX512;
+		else if ( XORKernel::isSupported( XOR_KERNEL_AVX2 ) )
+			type = XOR_KERNEL_AVX2;
+		else if ( XORKernel::isSupported( XOR_KERNEL_SSE2 ) )
+			type = XOR_KERNEL_SSE2;
+		else
+			type = XOR_KERNEL_SCALAR;
+	} else if ( ! XORKernel::isSupported( type ) ) {
+		return false;
+	}
+
+	switch( type ) {
+#ifdef XOR_KERNEL_X86
+		case XOR_KERNEL_SSE2:
+			XORKernel::xor2 = xor2SSE2;
+			XORKernel::xorN = xorNSSE2;
+			XORKernel::delta = deltaSSE2;
+			break;
+		case XOR_KERNEL_AVX2:
+			XORKernel::xor2 = xor2AVX2;
+			XORKernel::xorN = xorNAVX2;
+			XORKernel::delta = deltaAVX2;
+			break;
+		case XOR_KERNEL_AVX512:
+			XORKernel::xor2 = xor2AVX512;
+			XORKernel::xorN = xorNAVX512;
+			XORKernel::delta = deltaAVX512;
+			break;
+#endif
+		default:
+			XORKernel::xor2 = xor2Scalar;
+			XORKernel::xorN = xorNScalarEntry;
+			XORKernel::delta = deltaScalar;
+			break;
+	}
+	XORKernel::type = type;
+	return true;
+}
+
+XORKernelType XORKernel::getType() {
+	return XORKernel::type;
+}
+
+const char *XORKernel::getName( XORKernelType type ) {
+	switch( type ) {
+		case XOR_KERNEL_AUTO:   return "auto";
+		case XOR_KERNEL_SCALAR: return "scalar";
+		case XOR_KERNEL_SSE2:   return "sse2";
+		case XOR_KERNEL_AVX2:   return "avx2";
+		case XOR_KERNEL_AVX512: return "avx512";
+		default:                return "unknown";
+	}
+}
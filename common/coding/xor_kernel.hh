@@ -0,0 +1,41 @@
+#ifndef __COMMON_CODING_XOR_KERNEL_HH__
+#define __COMMON_CODING_XOR_KERNEL_HH__
+
+#include <stdint.h>
+
+enum XORKernelType {
+	XOR_KERNEL_AUTO,
+	XOR_KERNEL_SCALAR,
+	XOR_KERNEL_SSE2,
+	XOR_KERNEL_AVX2,
+	XOR_KERNEL_AVX512
+};
+
+/**
+ * Runtime-dispatched XOR routines. The widest instruction set supported
+ * by the CPU is selected on first use; select() overrides the choice
+ * (e.g., for testing and benchmarking).
+ */
+class XORKernel {
+private:
+	static XORKernelType type;
+
+	static void resolveXOR2( char *dst, char *srcA, char *srcB, uint32_t len );
+	static void resolveXORN( char *dst, char **srcs, uint32_t count, uint32_t len );
+	static void resolveDelta( char *delta, char *data, char *newData, uint32_t len );
+
+public:
+	// dst := srcA ^ srcB
+	static void ( *xor2 )( char *dst, char *srcA, char *srcB, uint32_t len );
+	// dst := srcs[ 0 ] ^ srcs[ 1 ] ^ ... ^ srcs[ count - 1 ] (in one pass)
+	static void ( *xorN )( char *dst, char **srcs, uint32_t count, uint32_t len );
+	// delta := data ^ newData; data := newData (delta may alias newData)
+	static void ( *delta )( char *delta, char *data, char *newData, uint32_t len );
+
+	static bool isSupported( XORKernelType type );
+	static bool select( XORKernelType type = XOR_KERNEL_AUTO );
+	static XORKernelType getType();
+	static const char *getName( XORKernelType type );
+};
+
+#endif
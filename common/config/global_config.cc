@@ -126,6 +126,8 @@ bool GlobalConfig::set( const char *section, const char *name, const char *value
 			this->coding.scheme = CS_EVENODD;
 		} else if ( match( value, "cauchy" ) ) {
 			this->coding.scheme = CS_CAUCHY;
+		} else if ( match( value, "lrc" ) ) {
+			this->coding.scheme = CS_LRC;
 		} else {
 			this->coding.scheme = CS_UNDEFINED;
 			this->coding.params.setScheme( this->coding.scheme );
@@ -162,6 +164,13 @@ bool GlobalConfig::set( const char *section, const char *name, const char *value
 				this->coding.params.setM( atoi( value ) );
 			else if ( match( name, "c_w" ) )
 				this->coding.params.setW( atoi( value ) );
+		} else if ( this->coding.scheme == CS_LRC && match( section, "lrc" ) ) {
+			if ( match( name, "k" ) )
+				this->coding.params.setK( atoi( value ) );
+			else if ( match( name, "l" ) )
+				this->coding.params.setL( atoi( value ) );
+			else if ( match( name, "m" ) )
+				this->coding.params.setM( atoi( value ) );
 		} else {
 			return false;
 		}
@@ -277,6 +286,19 @@ bool GlobalConfig::validate() {
 					CFG_PARSE_ERROR( "GlobalConfig", "Cauchy-based Reed-Solomon Code: Parameters `c_k', `c_m', and `c_w' should satisfy c_k + c_m <= ( 1 << c_w ) when c_w < 30." );
 			}
 			break;
+		case CS_LRC:
+			{
+				uint32_t k = this->coding.params.getK(),
+				         l = this->coding.params.getL(),
+				         m = this->coding.params.getM();
+				if ( k < 1 )
+					CFG_PARSE_ERROR( "GlobalConfig", "Locally Repairable Code: Parameter `k' should be at least 1." );
+				if ( l < 1 || l > k )
+					CFG_PARSE_ERROR( "GlobalConfig", "Locally Repairable Code: Parameter `l' should be between 1 and k." );
+				if ( k + l + m > 32 )
+					CFG_PARSE_ERROR( "GlobalConfig", "Locally Repairable Code: Parameters `k', `l', and `m' should satisfy k + l + m <= 32." );
+			}
+			break;
 		default:
 			CFG_PARSE_ERROR( "GlobalConfig", "Unsupported coding scheme." );
 			break;
@@ -367,6 +389,9 @@ void GlobalConfig::print( FILE *f ) {
 		case CS_CAUCHY:
 			fprintf( f, "Cauchy-based Reed-Solomon Code (k = %u, m = %u, w = %u)\n", this->coding.params.getK(), this->coding.params.getM(), this->coding.params.getW() );
 			break;
+		case CS_LRC:
+			fprintf( f, "Locally Repairable Code (k = %u, l = %u, m = %u)\n", this->coding.params.getK(), this->coding.params.getL(), this->coding.params.getM() );
+			break;
 		default:
 			fprintf( f, "Undefined coding scheme\n" );
 			break;
@@ -9,11 +9,14 @@ ChunkPool::ChunkPool() {
 	this->total = 0;
 	this->count = 0;
 	this->startAddress = 0;
+	this->dirty = 0;
 }
 
 ChunkPool::~ChunkPool() {
 	if ( this->startAddress )
 		free( this->startAddress );
+	delete[] this->dirty;
+	this->dirty = 0;
 	this->total = 0;
 	this->count = 0;
 	this->startAddress = 0;
@@ -30,6 +33,7 @@ void ChunkPool::init( uint32_t chunkSize, uint64_t capacity ) {
 	} else {
 		memset( this->startAddress, 0, capacity );
 	}
+	this->dirty = new std::atomic<uint64_t>[ ( this->total + 63 ) / 64 ]();
 }
 
 Chunk *ChunkPool::alloc( uint32_t listId, uint32_t stripeId, uint32_t chunkId ) {
@@ -88,6 +92,23 @@ void ChunkPool::print( FILE *f ) {
 	);
 }
 
+uint32_t ChunkPool::nextDirty( uint32_t from ) {
+	uint32_t words = ( this->total + 63 ) / 64, i = from >> 6;
+	uint64_t word;
+
+	if ( from >= this->total )
+		return this->total;
+	// Skip the clean chunks 64 at a time
+	word = this->dirty[ i ].load() & ( ~0ULL << ( from & 63 ) );
+	while ( ! word ) {
+		if ( ++i >= words )
+			return this->total;
+		word = this->dirty[ i ].load();
+	}
+	from = ( i << 6 ) + __builtin_ctzll( word );
+	return from < this->total ? from : this->total;
+}
+
 void ChunkPool::exportVars( uint32_t *total, std::atomic<unsigned int> *count, char **startAddress ) {
 	*total = this->total;
 	*count = this->count.load();
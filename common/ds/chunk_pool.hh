@@ -15,6 +15,7 @@ private:
 	uint32_t total;                  // Number of chunks allocated
 	std::atomic<unsigned int> count; // Current index
 	char *startAddress;
+	std::atomic<uint64_t> *dirty;    // Bitmap of the chunks modified since they are last flushed
 
 public:
 	ChunkPool();
@@ -33,6 +34,25 @@ public:
 	void print( FILE *f = stdout );
 
 	void exportVars( uint32_t *total, std::atomic<unsigned int> *count, char **startAddress );
+
+	// Mark the chunk as modified; chunks outside the pool are ignored
+	inline void setDirty( Chunk *chunk ) {
+		uint64_t chunkSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize;
+		uint64_t index;
+		if ( ! this->dirty || ( char * ) chunk < this->startAddress )
+			return;
+		index = ( uint64_t )( ( char * ) chunk - this->startAddress ) / chunkSize;
+		if ( index >= this->total )
+			return;
+		this->dirty[ index >> 6 ].fetch_or( 1ULL << ( index & 63 ) );
+	}
+	// Clear the dirty bit of a chunk; returns whether it was set
+	inline bool clearDirty( uint32_t index ) {
+		uint64_t mask = 1ULL << ( index & 63 );
+		return this->dirty[ index >> 6 ].fetch_and( ~mask ) & mask;
+	}
+	// Index of the first dirty chunk at or after from (total if none)
+	uint32_t nextDirty( uint32_t from );
 };
 
 class TempChunkPool {
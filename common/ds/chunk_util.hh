@@ -226,17 +226,19 @@ public:
 		bool applyUpdate = true
 	) {
 		char *data = getData( chunk ) + offset;
-		Coding::bitwiseXOR(
-			delta,
-			data,    // original data
-			newData, // new data
-			length
-		);
 		if ( applyUpdate ) {
+			// Compute delta and apply the new data in a single pass
+			Coding::bitwiseXORDelta(
+				delta,
+				data,    // original data
+				newData, // new data
+				length
+			);
+		} else {
 			Coding::bitwiseXOR(
-				data,
-				data,  // original data
-				delta, // new data
+				delta,
+				data,    // original data
+				newData, // new data
 				length
 			);
 		}
@@ -257,21 +259,14 @@ public:
 			memset( delta, 0, KEY_VALUE_METADATA_SIZE + length );
 			KeyValue::setSize( delta, 0, length );
 
-			// Compute delta' := data XOR delta
-			Coding::bitwiseXOR(
+			// Compute delta' := data XOR delta and apply delta by setting
+			// data := data XOR delta' = data XOR ( data XOR delta ) = delta
+			Coding::bitwiseXORDelta(
 				delta,
 				data,  // original data
 				delta, // new data
 				length
 			);
-
-			// Apply delta by setting data := data XOR delta' = data XOR ( data XOR delta ) = delta
-			Coding::bitwiseXOR(
-				data,
-				data,  // original data
-				delta, // new data
-				length
-			);
 		} else {
 			memset( data, 0, KEY_VALUE_METADATA_SIZE + length );
 		}
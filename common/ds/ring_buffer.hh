@@ -74,6 +74,21 @@ public:
 		return 0;
 	}
 
+	// Same as Extract() but return -1 instead of waiting if the buffer is empty
+	int TryExtract(T* data) {
+		pthread_mutex_lock(&mAccess);
+		if (count == 0) {
+			pthread_mutex_unlock(&mAccess);
+			return -1;
+		}
+		memcpy(data, &(buffer[readIndex].data), buffer[readIndex].len);
+		readIndex = nextVal(readIndex);
+		count--;
+		pthread_cond_signal(&cvFull);
+		pthread_mutex_unlock(&mAccess);
+		return 0;
+	}
+
 	int GetCount() {
 		return count;
 	}
@@ -54,6 +54,11 @@ public:
 		return ret;
 	}
 
+	// Return false instead of waiting if no events are queued
+	bool tryExtract( EventType &event ) {
+		return this->queue->TryExtract( &event ) == 0;
+	}
+
 	inline int count( size_t *size = 0 ) {
 		if ( size ) *size = this->config.size;
 		return this->queue->GetCount();
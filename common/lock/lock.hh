@@ -25,6 +25,13 @@
 #define TRY_LOCK( l )        pthread_mutex_trylock( l )
 #define UNLOCK( l )          pthread_mutex_unlock( l )
 
+// Readers-writer lock
+#define RW_LOCK_T            pthread_rwlock_t
+#define RW_LOCK_INIT( l )    pthread_rwlock_init( l, 0 )
+#define READ_LOCK( l )       pthread_rwlock_rdlock( l )
+#define WRITE_LOCK( l )      pthread_rwlock_wrlock( l )
+#define RW_UNLOCK( l )       pthread_rwlock_unlock( l )
+
 // #define LOCK_T               pthread_spinlock_t
 // #define LOCK_INIT( l )       pthread_spin_init( l, 0 )
 // #define LOCK( l )            pthread_spin_lock( l )
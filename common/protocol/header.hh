@@ -323,6 +323,27 @@ struct ReconstructionHeader {
 	uint32_t *stripeIds;
 };
 
+// For repairing a chunk along a chain of helpers: the helper at "position"
+// adds its coefficient times its chunk to the partial result of the slice
+// [ offset, offset + size ) and forwards it to the next helper; the last
+// helper (the one that repairs the chunk) receives the combined result
+#define PROTO_REPAIR_CHUNK_SIZE 23
+struct RepairChunkHeader {
+	uint32_t listId;
+	uint32_t stripeId;
+	uint32_t chunkId; // The lost chunk
+	uint8_t position;
+	uint8_t count;
+	uint8_t sealIndicatorCount;
+	uint32_t offset;
+	uint32_t size;
+	uint8_t *helperIds;
+	uint8_t *coefficients;
+	// The seal status reported by each helper ( count * sealIndicatorCount entries )
+	bool *sealIndicators;
+	char *data; // NULL if the request is sent to the first helper
+};
+
 //////////
 // Seal //
 //////////
@@ -341,6 +362,13 @@ struct ChunkSealHeaderData {
 	char *key;
 };
 
+#define PROTO_BATCH_CHUNK_SEAL_SIZE 4
+#define PROTO_BATCH_CHUNK_SEAL_DATA_SIZE 4 // Size of a SEAL_CHUNK request (excluding the protocol header)
+struct BatchChunkSealHeader {
+	uint32_t count;
+	char *seals;
+};
+
 //////////////////////
 // Chunk operations //
 //////////////////////
@@ -55,6 +55,8 @@
 #define PROTO_OPCODE_BATCH_KEY_VALUES             0x62
 #define PROTO_OPCODE_UPDATE_CHUNK_CHECK           0x63
 #define PROTO_OPCODE_DELETE_CHUNK_CHECK           0x64
+#define PROTO_OPCODE_REPAIR_CHUNK                 0x65
+#define PROTO_OPCODE_BATCH_SEAL_CHUNK             0x66
 
 #define PROTO_UNINITIALIZED_INSTANCE              0
 
@@ -166,6 +166,8 @@ bool Protocol::parseHeader( struct ProtocolHeader &header, char *buf, size_t siz
 		case PROTO_OPCODE_BATCH_KEY_VALUES:
 		case PROTO_OPCODE_UPDATE_CHUNK_CHECK:
 		case PROTO_OPCODE_DELETE_CHUNK_CHECK:
+		case PROTO_OPCODE_REPAIR_CHUNK:
+		case PROTO_OPCODE_BATCH_SEAL_CHUNK:
 			break;
 		default:
 			fprintf( stderr, "Error #4: (magic, from, to, opcode, length, instanceId, requestId) = (%x, %x, %x, %x, %u, %u, %u)\n", header.magic, header.from, header.to, header.opcode, header.length, header.instanceId, header.requestId );
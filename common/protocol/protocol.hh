@@ -652,6 +652,18 @@ public:
 		struct ReconstructionHeader &header, bool isRequest,
 		char *buf = 0, size_t size = 0, size_t offset = 0
 	);
+	size_t generateRepairChunkHeader(
+		uint8_t magic, uint8_t to, uint8_t opcode, uint16_t instanceId, uint32_t requestId,
+		uint32_t listId, uint32_t stripeId, uint32_t chunkId,
+		uint8_t position, uint8_t count, uint8_t *helperIds, uint8_t *coefficients,
+		uint8_t sealIndicatorCount, bool *sealIndicators,
+		uint32_t offset, uint32_t size, char *data,
+		bool *&sealIndicatorsPtr, char *&dataPtr
+	);
+	bool parseRepairChunkHeader(
+		struct RepairChunkHeader &header,
+		char *buf = 0, size_t size = 0, size_t offset = 0
+	);
 
 	//////////
 	// Seal //
@@ -670,6 +682,18 @@ public:
 		struct ChunkSealHeaderData &header,
 		char *buf = 0, size_t size = 0, size_t offset = 0
 	);
+	size_t generateBatchChunkSealHeader(
+		uint8_t magic, uint8_t to, uint8_t opcode, uint16_t instanceId, uint32_t requestId,
+		uint32_t count, uint32_t dataLength, char *sendBuf = 0
+	);
+	bool parseBatchChunkSealHeader(
+		struct BatchChunkSealHeader &header,
+		char *buf = 0, size_t size = 0, size_t offset = 0
+	);
+	void nextChunkSealInBatchChunkSealHeader(
+		struct BatchChunkSealHeader &header,
+		char *&seal, uint32_t &sealSize, uint32_t &offset
+	);
 
 	//////////////////////
 	// Chunk operations //
@@ -136,3 +136,70 @@ bool Protocol::parseReconstructionHeader( struct ReconstructionHeader &header, b
 	}
 	return true;
 }
+
+size_t Protocol::generateRepairChunkHeader( uint8_t magic, uint8_t to, uint8_t opcode, uint16_t instanceId, uint32_t requestId, uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint8_t position, uint8_t count, uint8_t *helperIds, uint8_t *coefficients, uint8_t sealIndicatorCount, bool *sealIndicators, uint32_t offset, uint32_t size, char *data, bool *&sealIndicatorsPtr, char *&dataPtr ) {
+	char *buf = this->buffer.send + PROTO_HEADER_SIZE;
+	uint32_t rowsSize = ( uint32_t ) count * sealIndicatorCount;
+	uint32_t dataSize = data ? size : 0;
+	size_t bytes = this->generateHeader( magic, to, opcode, PROTO_REPAIR_CHUNK_SIZE + count * 2 + rowsSize + dataSize, instanceId, requestId );
+
+	bytes += ProtocolUtil::write4Bytes( buf, listId             );
+	bytes += ProtocolUtil::write4Bytes( buf, stripeId           );
+	bytes += ProtocolUtil::write4Bytes( buf, chunkId            );
+	bytes += ProtocolUtil::write1Byte ( buf, position           );
+	bytes += ProtocolUtil::write1Byte ( buf, count              );
+	bytes += ProtocolUtil::write1Byte ( buf, sealIndicatorCount );
+	bytes += ProtocolUtil::write4Bytes( buf, offset             );
+	bytes += ProtocolUtil::write4Bytes( buf, size               );
+	bytes += ProtocolUtil::write( buf, ( char * ) helperIds, count );
+	bytes += ProtocolUtil::write( buf, ( char * ) coefficients, count );
+
+	// The caller fills in its own entries in place
+	sealIndicatorsPtr = ( bool * ) buf;
+	if ( sealIndicators )
+		memcpy( buf, sealIndicators, rowsSize );
+	else
+		memset( buf, 0, rowsSize );
+	buf += rowsSize;
+	bytes += rowsSize;
+
+	dataPtr = data ? buf : 0;
+	if ( data )
+		bytes += ProtocolUtil::write( buf, data, dataSize );
+	return bytes;
+}
+
+bool Protocol::parseRepairChunkHeader( struct RepairChunkHeader &header, char *buf, size_t size, size_t offset ) {
+	if ( ! buf || ! size ) {
+		buf = this->buffer.recv;
+		size = this->buffer.size;
+	}
+	if ( size - offset < PROTO_REPAIR_CHUNK_SIZE ) return false;
+	char *ptr = buf + offset;
+	header.listId             = ProtocolUtil::read4Bytes( ptr );
+	header.stripeId           = ProtocolUtil::read4Bytes( ptr );
+	header.chunkId            = ProtocolUtil::read4Bytes( ptr );
+	header.position           = ProtocolUtil::read1Byte ( ptr );
+	header.count              = ProtocolUtil::read1Byte ( ptr );
+	header.sealIndicatorCount = ProtocolUtil::read1Byte ( ptr );
+	header.offset             = ProtocolUtil::read4Bytes( ptr );
+	header.size               = ProtocolUtil::read4Bytes( ptr );
+
+	size_t rowsSize = ( size_t ) header.count * header.sealIndicatorCount;
+	size_t expected = PROTO_REPAIR_CHUNK_SIZE + header.count * 2 + rowsSize;
+	if ( size - offset < expected ) return false;
+	header.helperIds = ( uint8_t * ) ptr;
+	ptr += header.count;
+	header.coefficients = ( uint8_t * ) ptr;
+	ptr += header.count;
+	header.sealIndicators = ( bool * ) ptr;
+	ptr += rowsSize;
+
+	// The request to the first helper does not carry any data
+	if ( header.position == 0 ) {
+		header.data = 0;
+		return true;
+	}
+	header.data = ptr;
+	return ( size - offset >= expected + header.size );
+}
@@ -39,3 +39,32 @@ bool Protocol::parseChunkSealHeaderData( struct ChunkSealHeaderData &header, cha
 	header.key     = ptr;
 	return ( size - offset >= ( size_t ) PROTO_CHUNK_SEAL_DATA_SIZE + header.keySize );
 }
+
+size_t Protocol::generateBatchChunkSealHeader( uint8_t magic, uint8_t to, uint8_t opcode, uint16_t instanceId, uint32_t requestId, uint32_t count, uint32_t dataLength, char *sendBuf ) {
+	// The SEAL_CHUNK requests are already in sendBuf
+	if ( ! sendBuf ) sendBuf = this->buffer.send;
+	char *buf = sendBuf + PROTO_HEADER_SIZE;
+	size_t bytes = this->generateHeader( magic, to, opcode, PROTO_BATCH_CHUNK_SEAL_SIZE + dataLength, instanceId, requestId, sendBuf );
+	bytes += ProtocolUtil::write4Bytes( buf, count );
+	bytes += dataLength;
+	return bytes;
+}
+
+bool Protocol::parseBatchChunkSealHeader( struct BatchChunkSealHeader &header, char *buf, size_t size, size_t offset ) {
+	if ( ! buf || ! size ) {
+		buf = this->buffer.recv;
+		size = this->buffer.size;
+	}
+	if ( size - offset < PROTO_BATCH_CHUNK_SEAL_SIZE ) return false;
+	char *ptr = buf + offset;
+	header.count = ProtocolUtil::read4Bytes( ptr );
+	header.seals = ptr;
+	return true;
+}
+
+void Protocol::nextChunkSealInBatchChunkSealHeader( struct BatchChunkSealHeader &header, char *&seal, uint32_t &sealSize, uint32_t &offset ) {
+	char *ptr = header.seals + offset;
+	sealSize = ProtocolUtil::read4Bytes( ptr );
+	seal = ptr;
+	offset += PROTO_BATCH_CHUNK_SEAL_DATA_SIZE + sealSize;
+}
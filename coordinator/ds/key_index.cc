@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <cstring>
+#include "key_index.hh"
+
+uint64_t KeyIndex::hash( char *key, uint8_t keySize, bool isLarge ) {
+	// FNV-1a followed by the MurmurHash3 finalizer so that all bits are mixed
+	uint64_t hash = 14695981039346656037UL;
+	for ( size_t i = 0, size = KeyIndex::getKeySize( keySize, isLarge ); i < size; i++ ) {
+		hash ^= ( uint8_t ) key[ i ];
+		hash *= 1099511628211UL;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdUL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53UL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+KeyIndex::KeyIndex() {
+	this->capacity = KEY_INDEX_INIT_CAPACITY;
+	this->tags = ( uint16_t * ) calloc( this->capacity, sizeof( uint16_t ) );
+	this->entries = ( struct KeyIndexEntry * ) malloc( this->capacity * sizeof( struct KeyIndexEntry ) );
+	this->count = 0;
+	this->used = 0;
+	this->copies = 0;
+	this->copyBytes = 0;
+	this->nextRelease = KEY_INDEX_MIN_RELEASE;
+	LOCK_INIT( &this->lock );
+}
+
+KeyIndex::~KeyIndex() {
+	for ( uint32_t i = 0; i < this->capacity; i++ ) {
+		if ( this->tags[ i ] > KEY_INDEX_TAG_DELETED && this->entries[ i ].key )
+			::free( this->entries[ i ].key );
+	}
+	for ( std::unordered_set<Key>::iterator it = this->lockedKeys.begin(); it != this->lockedKeys.end(); it++ )
+		::free( it->data );
+	::free( this->tags );
+	::free( this->entries );
+}
+
+void KeyIndex::resize( uint32_t capacity ) {
+	uint16_t *tags = ( uint16_t * ) calloc( capacity, sizeof( uint16_t ) );
+	struct KeyIndexEntry *entries = ( struct KeyIndexEntry * ) malloc( capacity * sizeof( struct KeyIndexEntry ) );
+	uint32_t mask = capacity - 1, index;
+
+	for ( uint32_t i = 0; i < this->capacity; i++ ) {
+		if ( this->tags[ i ] <= KEY_INDEX_TAG_DELETED )
+			continue;
+		for ( index = this->entries[ i ].hash & mask; tags[ index ] != KEY_INDEX_TAG_EMPTY; index = ( index + 1 ) & mask );
+		tags[ index ] = this->tags[ i ];
+		entries[ index ] = this->entries[ i ];
+	}
+
+	::free( this->tags );
+	::free( this->entries );
+	this->tags = tags;
+	this->entries = entries;
+	this->capacity = capacity;
+	// The deleted slots are dropped
+	this->used = this->count;
+}
+
+struct KeyIndexEntry *KeyIndex::find( uint64_t hash, char *key, uint8_t keySize, bool isLarge ) {
+	uint32_t mask = this->capacity - 1, index;
+	uint16_t tag = KeyIndex::getTag( hash );
+	struct KeyIndexEntry *entry;
+
+	for ( index = hash & mask; this->tags[ index ] != KEY_INDEX_TAG_EMPTY; index = ( index + 1 ) & mask ) {
+		if ( this->tags[ index ] != tag )
+			continue;
+		entry = this->entries + index;
+		if (
+			entry->hash == hash &&
+			entry->keySize == keySize &&
+			entry->isLarge == isLarge &&
+			// Keys without a copy are matched by their hashes
+			( ! entry->key || memcmp( entry->key, key, KeyIndex::getKeySize( keySize, isLarge ) ) == 0 )
+		)
+			return entry;
+	}
+	return 0;
+}
+
+struct KeyIndexEntry *KeyIndex::insert( uint64_t hash, uint8_t keySize, bool isLarge ) {
+	uint32_t mask, index;
+	struct KeyIndexEntry *entry;
+
+	// Keep the load factor (including the deleted slots) below 3/4
+	if ( ( uint64_t )( this->used + 1 ) * 4 > ( uint64_t ) this->capacity * 3 )
+		this->resize( ( uint64_t )( this->count + 1 ) * 2 > this->capacity ? this->capacity * 2 : this->capacity );
+
+	mask = this->capacity - 1;
+	for ( index = hash & mask; this->tags[ index ] > KEY_INDEX_TAG_DELETED; index = ( index + 1 ) & mask );
+	if ( this->tags[ index ] == KEY_INDEX_TAG_EMPTY )
+		this->used++;
+	this->tags[ index ] = KeyIndex::getTag( hash );
+	this->count++;
+
+	entry = this->entries + index;
+	entry->hash = hash;
+	entry->key = 0;
+	entry->keySize = keySize;
+	entry->isLarge = isLarge;
+	return entry;
+}
+
+void KeyIndex::erase( struct KeyIndexEntry *entry ) {
+	this->release( entry );
+	this->tags[ entry - this->entries ] = KEY_INDEX_TAG_DELETED;
+	this->count--;
+}
+
+void KeyIndex::copy( struct KeyIndexEntry *entry, char *key ) {
+	size_t size = KeyIndex::getKeySize( entry->keySize, entry->isLarge );
+	if ( entry->key )
+		return;
+	entry->key = ( char * ) malloc( size );
+	memcpy( entry->key, key, size );
+	this->copies++;
+	this->copyBytes += size;
+}
+
+void KeyIndex::release( struct KeyIndexEntry *entry ) {
+	if ( ! entry->key )
+		return;
+	::free( entry->key );
+	entry->key = 0;
+	this->copies--;
+	this->copyBytes -= KeyIndex::getKeySize( entry->keySize, entry->isLarge );
+}
+
+void KeyIndex::setNextRelease() {
+	// Amortize the scan over at least count / 8 insertions
+	this->nextRelease = this->copies * 2;
+	if ( this->nextRelease < this->count / 8 )
+		this->nextRelease = this->count / 8;
+	if ( this->nextRelease < KEY_INDEX_MIN_RELEASE )
+		this->nextRelease = KEY_INDEX_MIN_RELEASE;
+}
+
+void KeyIndex::getMemoryUsage( struct KeyIndexMemoryUsage &usage ) {
+	usage.keys += this->count;
+	usage.slots += this->capacity;
+	usage.tableBytes += ( uint64_t ) this->capacity * ( sizeof( uint16_t ) + sizeof( struct KeyIndexEntry ) );
+	usage.copies += this->copies;
+	usage.copyBytes += this->copyBytes;
+	usage.lockedKeys += this->lockedKeys.size();
+	for ( std::unordered_set<Key>::iterator it = this->lockedKeys.begin(); it != this->lockedKeys.end(); it++ )
+		usage.lockedKeyBytes += sizeof( Key ) + KeyIndex::getKeySize( it->size, it->isLarge );
+}
@@ -0,0 +1,106 @@
+#ifndef __COORDINATOR_DS_KEY_INDEX_HH__
+#define __COORDINATOR_DS_KEY_INDEX_HH__
+
+#include <unordered_set>
+#include <stdint.h>
+#include "../../common/ds/key.hh"
+#include "../../common/lock/lock.hh"
+
+#define KEY_INDEX_TAG_EMPTY       0
+#define KEY_INDEX_TAG_DELETED     1
+#define KEY_INDEX_INIT_CAPACITY   256  // Number of slots in a new shard
+#define KEY_INDEX_MIN_RELEASE     4096 // Minimum number of key copies before they are released
+
+struct KeyIndexEntry {
+	uint64_t hash;
+	char *key; // Copy of the key (with the split offset of large objects); 0 if referenced by hash only
+	uint32_t listId;
+	uint32_t stripeId;
+	uint32_t chunkId;
+	uint32_t timestamp;
+	uint8_t opcode;
+	uint8_t keySize;
+	bool isLarge;
+} __attribute__((__packed__));
+
+struct KeyIndexMemoryUsage {
+	uint64_t keys;         // Number of keys
+	uint64_t slots;        // Number of slots in the tables
+	uint64_t tableBytes;   // Fingerprints and entries
+	uint64_t copies;       // Number of keys stored with a copy
+	uint64_t copyBytes;
+	uint64_t lockedKeys;
+	uint64_t lockedKeyBytes;
+};
+
+/**
+ * One shard of the key index of a server: an open-addressing table
+ * (linear probing) with a 16-bit fingerprint per slot, so that a probe
+ * compares the entries only if their fingerprints match. The fingerprints
+ * are kept apart from the entries to keep the probe sequence in a few
+ * cache lines.
+ *
+ * A key is identified by its 64-bit hash. The key itself is copied only
+ * while it may be needed by the recovery, i.e., while its chunk is not
+ * sealed; releaseKeys() drops the copies of the keys in sealed chunks.
+ *
+ * The shard is not thread-safe; the caller holds the lock.
+ */
+class KeyIndex {
+private:
+	uint16_t *tags;
+	struct KeyIndexEntry *entries;
+	uint32_t capacity; // Power of 2
+	uint32_t count;    // Number of entries
+	uint32_t used;     // Number of entries and deleted slots
+	uint32_t copies;   // Number of entries with a copy of the key
+	uint64_t copyBytes;
+	uint32_t nextRelease;
+
+	static inline uint16_t getTag( uint64_t hash ) {
+		uint16_t tag = ( uint16_t )( hash >> 48 );
+		return tag > KEY_INDEX_TAG_DELETED ? tag : tag + 2;
+	}
+	void resize( uint32_t capacity );
+
+public:
+	LOCK_T lock;
+	/**
+	 * Store the set of keys with lock acquired
+	 */
+	std::unordered_set<Key> lockedKeys;
+
+	static inline size_t getKeySize( uint8_t keySize, bool isLarge ) {
+		return keySize + ( isLarge ? SPLIT_OFFSET_SIZE : 0 );
+	}
+	static uint64_t hash( char *key, uint8_t keySize, bool isLarge );
+
+	KeyIndex();
+	~KeyIndex();
+	struct KeyIndexEntry *find( uint64_t hash, char *key, uint8_t keySize, bool isLarge );
+	// The new entry only has its hash and key size set
+	struct KeyIndexEntry *insert( uint64_t hash, uint8_t keySize, bool isLarge );
+	void erase( struct KeyIndexEntry *entry );
+	void copy( struct KeyIndexEntry *entry, char *key );
+	void release( struct KeyIndexEntry *entry );
+	inline bool needsRelease() {
+		return this->copies >= this->nextRelease;
+	}
+	// Called after the copies of the keys in sealed chunks are released
+	void setNextRelease();
+
+	// Iteration over the slots; returns 0 for empty slots
+	inline uint32_t getCapacity() {
+		return this->capacity;
+	}
+	inline struct KeyIndexEntry *at( uint32_t index ) {
+		return this->tags[ index ] > KEY_INDEX_TAG_DELETED ? this->entries + index : 0;
+	}
+	inline uint32_t size() {
+		return this->count;
+	}
+
+	void getMemoryUsage( struct KeyIndexMemoryUsage &usage );
+};
+
+#endif
@@ -1,17 +1,29 @@
+#include <unistd.h>
 #include "map.hh"
+#include "../../common/util/debug.hh"
 
 uint32_t *Map::stripes;
 LOCK_T Map::stripesLock;
 std::unordered_map<ListStripe, DegradedLock> Map::degradedLocks;
 std::unordered_map<ListStripe, DegradedLock> Map::releasingDegradedLocks;
 LOCK_T Map::degradedLocksLock;
+uint32_t Map::numStripeList;
+uint32_t Map::chunkCount;
+uint32_t Map::numShards;
+
+void Map::init( uint32_t numStripeList, uint32_t chunkCount ) {
+	long numCores = sysconf( _SC_NPROCESSORS_ONLN );
 
-void Map::init( uint32_t numStripeList ) {
 	Map::stripes = new uint32_t[ numStripeList ];
 	LOCK_INIT( &Map::stripesLock );
 	for ( uint32_t i = 0; i < numStripeList; i++ )
 		Map::stripes[ i ] = 0;
 	LOCK_INIT( &Map::degradedLocksLock );
+
+	Map::numStripeList = numStripeList;
+	Map::chunkCount = chunkCount;
+	// One shard of the key index per core
+	for ( Map::numShards = 1; Map::numShards < numCores && Map::numShards < 64; Map::numShards <<= 1 );
 }
 
 void Map::free() {
@@ -19,8 +31,27 @@ void Map::free() {
 }
 
 Map::Map() {
-	LOCK_INIT( &this->chunksLock );
-	LOCK_INIT( &this->keysLock );
+	this->sealed = new struct SealedStripeList[ Map::numStripeList ];
+	for ( uint32_t i = 0; i < Map::numStripeList; i++ ) {
+		this->sealed[ i ].chunks = new struct SealedStripes[ Map::chunkCount ];
+		for ( uint32_t j = 0; j < Map::chunkCount; j++ ) {
+			this->sealed[ i ].chunks[ j ].bitmap = 0;
+			this->sealed[ i ].chunks[ j ].size = 0;
+			this->sealed[ i ].chunks[ j ].count = 0;
+		}
+		RW_LOCK_INIT( &this->sealed[ i ].lock );
+	}
+	this->keys = new KeyIndex[ Map::numShards ];
+}
+
+Map::~Map() {
+	for ( uint32_t i = 0; i < Map::numStripeList; i++ ) {
+		for ( uint32_t j = 0; j < Map::chunkCount; j++ )
+			::free( this->sealed[ i ].chunks[ j ].bitmap );
+		delete[] this->sealed[ i ].chunks;
+	}
+	delete[] this->sealed;
+	delete[] this->keys;
 }
 
 bool Map::updateMaxStripeId( uint32_t listId, uint32_t stripeId ) {
@@ -34,114 +65,138 @@ bool Map::updateMaxStripeId( uint32_t listId, uint32_t stripeId ) {
 	return ret;
 }
 
-bool Map::insertChunk( uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool needsLock, bool needsUnlock ) {
-	Metadata metadata;
-	metadata.set( listId, stripeId, chunkId );
+bool Map::insertChunk( uint32_t listId, uint32_t stripeId, uint32_t chunkId ) {
+	struct SealedStripes *s;
+	uint32_t index = stripeId >> 6, size;
+	uint64_t mask = 1UL << ( stripeId & 63 );
+	bool ret;
 
-	std::pair<std::unordered_set<Metadata>::iterator, bool> ret;
+	if ( listId >= Map::numStripeList || chunkId >= Map::chunkCount )
+		return false;
 
-	if ( needsLock ) LOCK( &this->chunksLock );
-	ret = this->chunks.insert( metadata );
-	if ( needsUnlock ) UNLOCK( &this->chunksLock );
+	WRITE_LOCK( &this->sealed[ listId ].lock );
+	s = this->sealed[ listId ].chunks + chunkId;
+	if ( index >= s->size ) {
+		size = s->size * 2 > index + 1 ? s->size * 2 : index + 1;
+		s->bitmap = ( uint64_t * ) realloc( s->bitmap, size * sizeof( uint64_t ) );
+		memset( s->bitmap + s->size, 0, ( size - s->size ) * sizeof( uint64_t ) );
+		s->size = size;
+	}
+	ret = ! ( s->bitmap[ index ] & mask );
+	if ( ret ) {
+		s->bitmap[ index ] |= mask;
+		s->count++;
+	}
+	RW_UNLOCK( &this->sealed[ listId ].lock );
 
 	this->updateMaxStripeId( listId, stripeId );
 
-	return ret.second;
+	return ret;
+}
+
+void Map::setMetadata( KeyIndex *shard, struct KeyIndexEntry *entry, char *keyStr, uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint8_t opcode, uint32_t timestamp ) {
+	entry->listId = listId;
+	entry->stripeId = stripeId;
+	entry->chunkId = chunkId;
+	entry->opcode = opcode;
+	entry->timestamp = timestamp;
+	// The key is needed by the recovery until its chunk is sealed
+	if ( ! this->isSealed( listId, stripeId, chunkId ) )
+		shard->copy( entry, keyStr );
 }
 
-bool Map::insertKey( bool isLarge, char *keyStr, uint8_t keySize, uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint8_t opcode, uint32_t timestamp, bool needsLock, bool needsUnlock ) {
+void Map::unlockKey( KeyIndex *shard, char *keyStr, uint8_t keySize, bool isLarge ) {
+	std::unordered_set<Key>::iterator it;
 	Key key;
+
 	key.set( keySize, keyStr, 0, isLarge );
+	it = shard->lockedKeys.find( key );
+	if ( it != shard->lockedKeys.end() ) {
+		::free( it->data );
+		shard->lockedKeys.erase( it );
+	}
+}
 
-	OpMetadata opMetadata;
-	opMetadata.set( listId, stripeId, chunkId );
-	opMetadata.opcode = opcode;
-	opMetadata.timestamp = timestamp;
+void Map::releaseKeys( KeyIndex *shard ) {
+	struct KeyIndexEntry *entry;
+
+	for ( uint32_t i = 0, capacity = shard->getCapacity(); i < capacity; i++ ) {
+		entry = shard->at( i );
+		if ( entry && entry->key && this->isSealed( entry->listId, entry->stripeId, entry->chunkId ) )
+			shard->release( entry );
+	}
+	shard->setNextRelease();
+}
 
-	std::unordered_map<Key, OpMetadata>::iterator it;
-	bool ret = true, exist;
+bool Map::insertKey( bool isLarge, char *keyStr, uint8_t keySize, uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint8_t opcode, uint32_t timestamp ) {
+	uint64_t hash = KeyIndex::hash( keyStr, keySize, isLarge );
+	KeyIndex *shard = this->getShard( hash );
+	struct KeyIndexEntry *entry;
+	bool ret = true;
 
-	if ( needsLock ) LOCK( &this->keysLock );
-	it = this->keys.find( key );
-	exist = it != this->keys.end();
+	LOCK( &shard->lock );
+	entry = shard->find( hash, keyStr, keySize, isLarge );
 
 	switch( opcode ) {
 		case PROTO_OPCODE_SET:
 		case PROTO_OPCODE_DEGRADED_SET:
-			if ( exist ) {
-				if ( it->second.timestamp > timestamp ) {
-					switch( it->second.opcode ) {
+			if ( entry ) {
+				if ( entry->timestamp > timestamp ) {
+					switch( entry->opcode ) {
 						case PROTO_OPCODE_SET:
 						case PROTO_OPCODE_DEGRADED_SET:
 							// Replace with the latest record
-							it->second = opMetadata;
+							this->setMetadata( shard, entry, keyStr, listId, stripeId, chunkId, opcode, timestamp );
 							break;
 						case PROTO_OPCODE_DELETE:
 							// This key should be deleted
-							key = it->first;
-							key.free();
-							this->keys.erase( it );
+							shard->erase( entry );
 							break;
 						default:
 							ret = false;
 					}
 				} else {
 					// Replace with the latest record
-					it->second = opMetadata;
+					this->setMetadata( shard, entry, keyStr, listId, stripeId, chunkId, opcode, timestamp );
 				}
 			} else {
-				key.dup( 0, 0, 0, key.isLarge );
-
-				std::pair<Key, OpMetadata> p( key, opMetadata );
-				std::pair<std::unordered_map<Key, OpMetadata>::iterator, bool> r;
-
-				r = this->keys.insert( p );
-				this->lockedKeys.erase( key );
-
-				ret = r.second;
+				entry = shard->insert( hash, keySize, isLarge );
+				this->setMetadata( shard, entry, keyStr, listId, stripeId, chunkId, opcode, timestamp );
+				this->unlockKey( shard, keyStr, keySize, isLarge );
 			}
 			break;
 		case PROTO_OPCODE_DELETE:
-			if ( exist ) {
-				key = it->first;
-				key.free();
-				this->keys.erase( it );
+			if ( entry ) {
+				shard->erase( entry );
 			} else {
-				key.dup( 0, 0, 0, key.isLarge );
-
-				std::pair<Key, OpMetadata> p( key, opMetadata );
-				std::pair<std::unordered_map<Key, OpMetadata>::iterator, bool> r;
-
-				r = this->keys.insert( p );
-				this->lockedKeys.erase( key );
-
-				ret = r.second;
+				entry = shard->insert( hash, keySize, isLarge );
+				this->setMetadata( shard, entry, keyStr, listId, stripeId, chunkId, opcode, timestamp );
+				this->unlockKey( shard, keyStr, keySize, isLarge );
 			}
 			break;
 		case PROTO_OPCODE_REMAPPING_LOCK:
-			if ( exist ) {
-				// fprintf(
-				// 	stderr, "TODO: Map::insertKey(): opcode == PROTO_OPCODE_REMAPPING_LOCK && exist. Key = %.*s at (%u, %u, %u).\n",
-				// 	it->first.size, it->first.data,
-				// 	it->second.listId, it->second.stripeId, it->second.chunkId
-				// );
+			if ( entry ) {
 				ret = false;
 			} else {
+				Key key;
+				key.set( keySize, keyStr, 0, isLarge );
 				// check if lock is already acquired by others
-				if ( this->lockedKeys.count( key ) ) {
+				if ( shard->lockedKeys.count( key ) ) {
 					ret = false;
 				} else {
 					key.dup( 0, 0, 0, key.isLarge );
-					this->lockedKeys.insert( key );
+					shard->lockedKeys.insert( key );
 				}
 			}
 			break;
 		default:
-			printf( "Unknown opcode %d for key: %.*s for (timestamp: %u vs. %u).\n", opcode, keySize, keyStr, timestamp, it->second.timestamp );
+			printf( "Unknown opcode %d for key: %.*s (timestamp: %u).\n", opcode, keySize, keyStr, timestamp );
 			ret = false;
 			break;
 	}
-	if ( needsUnlock ) UNLOCK( &this->keysLock );
+	if ( shard->needsRelease() )
+		this->releaseKeys( shard );
+	UNLOCK( &shard->lock );
 
 	Map::updateMaxStripeId( listId, stripeId );
 
@@ -199,20 +254,19 @@ uint32_t *original, uint32_t *reconstructed, uint32_t reconstructedCount, uint32
 }
 
 bool Map::findMetadataByKey( char *keyStr, uint8_t keySize, bool isLarge, Metadata &metadata ) {
-	std::unordered_map<Key, OpMetadata>::iterator it;
-	Key key;
-
-	key.set( keySize, keyStr, 0, isLarge );
-
-	LOCK( &this->keysLock );
-	it = this->keys.find( key );
-	if ( it == this->keys.end() ) {
-		UNLOCK( &this->keysLock );
+	uint64_t hash = KeyIndex::hash( keyStr, keySize, isLarge );
+	KeyIndex *shard = this->getShard( hash );
+	struct KeyIndexEntry *entry;
+
+	LOCK( &shard->lock );
+	entry = shard->find( hash, keyStr, keySize, isLarge );
+	if ( ! entry ) {
+		UNLOCK( &shard->lock );
 		return false;
 	} else {
-		metadata = it->second;
+		metadata.set( entry->listId, entry->stripeId, entry->chunkId );
 	}
-	UNLOCK( &this->keysLock );
+	UNLOCK( &shard->lock );
 	return true;
 }
 
@@ -234,58 +288,123 @@ bool Map::findDegradedLock( uint32_t listId, uint32_t stripeId, DegradedLock &de
 	return true;
 }
 
-bool Map::isSealed( Metadata metadata ) {
-	std::unordered_set<Metadata>::iterator it;
+bool Map::isSealed( uint32_t listId, uint32_t stripeId, uint32_t chunkId ) {
+	struct SealedStripes *s;
+	uint32_t index = stripeId >> 6;
 	bool ret;
 
-	LOCK( &this->chunksLock );
-	it = this->chunks.find( metadata );
-	ret = ( it != this->chunks.end() );
-	UNLOCK( &this->chunksLock );
+	if ( listId >= Map::numStripeList || chunkId >= Map::chunkCount )
+		return false;
+
+	READ_LOCK( &this->sealed[ listId ].lock );
+	s = this->sealed[ listId ].chunks + chunkId;
+	ret = index < s->size && ( s->bitmap[ index ] & ( 1UL << ( stripeId & 63 ) ) );
+	RW_UNLOCK( &this->sealed[ listId ].lock );
 	return ret;
 }
 
+bool Map::isSealed( Metadata metadata ) {
+	return this->isSealed( metadata.listId, metadata.stripeId, metadata.chunkId );
+}
+
+size_t Map::getSealedChunks( std::unordered_set<Metadata> &chunks ) {
+	struct SealedStripes *s;
+	Metadata metadata;
+	uint64_t bitmap;
+	size_t count = 0;
+
+	for ( uint32_t listId = 0; listId < Map::numStripeList; listId++ ) {
+		READ_LOCK( &this->sealed[ listId ].lock );
+		for ( uint32_t chunkId = 0; chunkId < Map::chunkCount; chunkId++ ) {
+			s = this->sealed[ listId ].chunks + chunkId;
+			for ( uint32_t i = 0; i < s->size; i++ ) {
+				for ( bitmap = s->bitmap[ i ]; bitmap; bitmap &= bitmap - 1 ) {
+					metadata.set( listId, ( i << 6 ) + __builtin_ctzl( bitmap ), chunkId );
+					chunks.insert( metadata );
+					count++;
+				}
+			}
+		}
+		RW_UNLOCK( &this->sealed[ listId ].lock );
+	}
+	return count;
+}
+
+size_t Map::getUnsealedKeys( std::unordered_map<uint32_t, std::unordered_set<Key>> &unsealed ) {
+	struct KeyIndexEntry *entry;
+	size_t count = 0;
+	Key key;
+
+	for ( uint32_t i = 0; i < Map::numShards; i++ ) {
+		LOCK( &this->keys[ i ].lock );
+		for ( uint32_t j = 0, capacity = this->keys[ i ].getCapacity(); j < capacity; j++ ) {
+			entry = this->keys[ i ].at( j );
+			if ( ! entry || this->isSealed( entry->listId, entry->stripeId, entry->chunkId ) )
+				continue;
+			if ( ! entry->key ) {
+				__ERROR__( "Map", "getUnsealedKeys", "The key with hash %016lx in (%u, %u, %u) is not copied.", entry->hash, entry->listId, entry->stripeId, entry->chunkId );
+				continue;
+			}
+			key.dup( entry->keySize, entry->key, 0, entry->isLarge );
+			unsealed[ entry->listId ].insert( key );
+			entry->stripeId = -1; // Reset stripe ID
+			count++;
+		}
+		UNLOCK( &this->keys[ i ].lock );
+	}
+	return count;
+}
+
+void Map::getMemoryUsage( struct MapMemoryUsage &usage ) {
+	for ( uint32_t i = 0; i < Map::numStripeList; i++ ) {
+		READ_LOCK( &this->sealed[ i ].lock );
+		for ( uint32_t j = 0; j < Map::chunkCount; j++ ) {
+			usage.sealedChunks += this->sealed[ i ].chunks[ j ].count;
+			usage.sealedBytes += this->sealed[ i ].chunks[ j ].size * sizeof( uint64_t );
+		}
+		RW_UNLOCK( &this->sealed[ i ].lock );
+	}
+	for ( uint32_t i = 0; i < Map::numShards; i++ ) {
+		LOCK( &this->keys[ i ].lock );
+		this->keys[ i ].getMemoryUsage( usage.keys );
+		UNLOCK( &this->keys[ i ].lock );
+	}
+}
+
 size_t Map::dump( FILE *f ) {
-	size_t numKeys;
+	struct MapMemoryUsage usage;
+
+	memset( &usage, 0, sizeof( usage ) );
+	this->getMemoryUsage( usage );
 
 	fprintf( f, "List of sealed chunks:\n----------------------\n" );
-	LOCK( &this->chunksLock );
-	if ( ! this->chunks.size() ) {
+	if ( ! usage.sealedChunks ) {
 		fprintf( f, "(None)\n" );
 	} else {
-		// for ( std::unordered_set<Metadata>::iterator it = this->chunks.begin(); it != this->chunks.end(); it++ ) {
-		// 	const Metadata &m = *it;
-		// 	fprintf(
-		// 		f, "(%u, %u, %u)\n",
-		// 		m.listId, m.stripeId, m.chunkId
-		// 	);
-		// }
-		fprintf( f, "Count: %lu\n", this->chunks.size() );
+		fprintf( f, "Count: %lu\n", usage.sealedChunks );
+		fprintf( f, "Memory: %lu bytes (bitmaps)\n", usage.sealedBytes );
 	}
-	UNLOCK( &this->chunksLock );
 	fprintf( f, "\n" );
 
 	fprintf( f, "List of key-value pairs:\n------------------------\n" );
-	LOCK( &this->keysLock );
-	if ( ! this->keys.size() ) {
+	if ( ! usage.keys.keys ) {
 		fprintf( f, "(None)\n" );
 	} else {
-		/*
-		for ( std::unordered_map<Key, OpMetadata>::iterator it = this->keys.begin(); it != this->keys.end(); it++ ) {
-			fprintf(
-				f, "%.*s --> (list ID: %u, stripe ID: %u, chunk ID: %u)\n",
-				it->first.size, it->first.data,
-				it->second.listId, it->second.stripeId, it->second.chunkId
-			);
-		}
-		*/
-		fprintf( f, "Count: %lu\n", this->keys.size() );
+		fprintf( f, "Count: %lu\n", usage.keys.keys );
 	}
-	numKeys = this->keys.size();
-	UNLOCK( &this->keysLock );
+	fprintf(
+		f,
+		"Memory:\n"
+		"- Table       : %lu bytes (%lu slots in %u shards)\n"
+		"- Key copies  : %lu bytes (%lu keys in unsealed chunks)\n"
+		"- Locked keys : %lu bytes (%lu keys)\n",
+		usage.keys.tableBytes, usage.keys.slots, Map::numShards,
+		usage.keys.copyBytes, usage.keys.copies,
+		usage.keys.lockedKeyBytes, usage.keys.lockedKeys
+	);
 	fprintf( f, "\n" );
 
-	return numKeys;
+	return usage.keys.keys;
 }
 
 size_t Map::dumpDegradedLocks( FILE *f ) {
@@ -322,12 +441,20 @@ size_t Map::dumpDegradedLocks( FILE *f ) {
 }
 
 void Map::persist( FILE *f ) {
-	LOCK( &this->keysLock );
-	for ( std::unordered_map<Key, OpMetadata>::iterator it = this->keys.begin(); it != this->keys.end(); it++ ) {
-		Key key = it->first;
-		OpMetadata opMetadata = it->second;
-
-		fprintf( f, "%.*s\t%u\t%u\t%u\n", key.size, key.data, opMetadata.listId, opMetadata.stripeId, opMetadata.chunkId );
+	struct KeyIndexEntry *entry;
+
+	for ( uint32_t i = 0; i < Map::numShards; i++ ) {
+		LOCK( &this->keys[ i ].lock );
+		for ( uint32_t j = 0, capacity = this->keys[ i ].getCapacity(); j < capacity; j++ ) {
+			entry = this->keys[ i ].at( j );
+			if ( ! entry )
+				continue;
+			// Keys in sealed chunks are only referenced by their hashes
+			if ( entry->key )
+				fprintf( f, "%.*s\t%u\t%u\t%u\n", entry->keySize, entry->key, entry->listId, entry->stripeId, entry->chunkId );
+			else
+				fprintf( f, "#%016lx\t%u\t%u\t%u\n", entry->hash, entry->listId, entry->stripeId, entry->chunkId );
+		}
+		UNLOCK( &this->keys[ i ].lock );
 	}
-	UNLOCK( &this->keysLock );
 }
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <cassert>
+#include "key_index.hh"
 #include "../../common/ds/key.hh"
 #include "../../common/ds/metadata.hh"
 #include "../../common/lock/lock.hh"
@@ -257,29 +258,58 @@ struct DegradedLock {
 	}
 };
 
+/**
+ * Bitmap of the sealed stripes of a chunk ID in a stripe list
+ */
+struct SealedStripes {
+	uint64_t *bitmap;
+	uint32_t size;  // Number of 64-bit words
+	uint32_t count; // Number of sealed stripes
+};
+
+struct SealedStripeList {
+	struct SealedStripes *chunks; // Indexed by chunk ID
+	RW_LOCK_T lock;
+};
+
+struct MapMemoryUsage {
+	uint64_t sealedChunks;
+	uint64_t sealedBytes;
+	struct KeyIndexMemoryUsage keys;
+};
+
 class Map {
 private:
-	bool updateMaxStripeId( uint32_t listId, uint32_t stripeId );
-
-public:
 	/**
 	 * Store the set of sealed chunks
 	 * (list ID, stripe ID, chunk ID)
 	 */
-	std::unordered_set<Metadata> chunks;
-	LOCK_T chunksLock;
-
+	struct SealedStripeList *sealed;
 	/**
-	 * Store the mapping between keys and chunks
+	 * Store the mapping between keys and chunks, sharded by the key hashes
 	 * Key |-> (list ID, stripe ID, chunk ID)
 	 */
-	std::unordered_map<Key, OpMetadata> keys;
-	/**
-	 * Store the set of keys with lock acquired
-	 */
-	std::unordered_set<Key> lockedKeys;
-	LOCK_T keysLock;
+	KeyIndex *keys;
+
+	static uint32_t numStripeList;
+	static uint32_t chunkCount;
+	static uint32_t numShards; // Power of 2
 
+	bool updateMaxStripeId( uint32_t listId, uint32_t stripeId );
+	inline KeyIndex *getShard( uint64_t hash ) {
+		return this->keys + ( ( hash >> 32 ) & ( Map::numShards - 1 ) );
+	}
+	bool isSealed( uint32_t listId, uint32_t stripeId, uint32_t chunkId );
+	void setMetadata(
+		KeyIndex *shard, struct KeyIndexEntry *entry, char *keyStr,
+		uint32_t listId, uint32_t stripeId, uint32_t chunkId,
+		uint8_t opcode, uint32_t timestamp
+	);
+	void unlockKey( KeyIndex *shard, char *keyStr, uint8_t keySize, bool isLarge );
+	// Drop the copies of the keys in sealed chunks
+	void releaseKeys( KeyIndex *shard );
+
+public:
 	/**
 	 * Store the degraded locks
 	 * (list ID, stripe ID) |-> (original, reconstructed, reconstructedCount)
@@ -298,19 +328,18 @@ public:
 	static uint32_t *stripes;
 	static LOCK_T stripesLock;
 
-	static void init( uint32_t numStripeList );
+	// Should be called before any Map is constructed
+	static void init( uint32_t numStripeList, uint32_t chunkCount );
 	static void free();
 
 	Map();
+	~Map();
 	// Insertion //
-	bool insertChunk(
-		uint32_t listId, uint32_t stripeId, uint32_t chunkId,
-		bool needsLock = true, bool needsUnlock = true
-	);
+	bool insertChunk( uint32_t listId, uint32_t stripeId, uint32_t chunkId );
 	bool insertKey(
 		bool isLarge, char *keyStr, uint8_t keySize,
 		uint32_t listId, uint32_t stripeId, uint32_t chunkId,
-		uint8_t opcode, uint32_t timestamp, bool needsLock = true, bool needsUnlock = true
+		uint8_t opcode, uint32_t timestamp
 	);
 	bool insertDegradedLock(
 		uint32_t listId, uint32_t stripeId,
@@ -334,7 +363,18 @@ public:
 	);
 	bool isSealed( Metadata metadata );
 
+	// Recovery //
+	size_t getSealedChunks( std::unordered_set<Metadata> &chunks );
+	/**
+	 * Copy the keys in the unsealed chunks (grouped by list ID) and reset
+	 * their stripe IDs.
+	 *
+	 * @return number of keys
+	 */
+	size_t getUnsealedKeys( std::unordered_map<uint32_t, std::unordered_set<Key>> &unsealed );
+
 	// Debug //
+	void getMemoryUsage( struct MapMemoryUsage &usage );
 	size_t dump( FILE *f = stdout );
 	static size_t dumpDegradedLocks( FILE *f = stdout );
 	void persist( FILE *f );
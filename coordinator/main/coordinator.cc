@@ -266,13 +266,16 @@ bool Coordinator::init( char *path, OptionList &globalOptions, OptionList &coord
 	this->sockets.clients.reserve( this->config.global.servers.size() );
 	this->sockets.servers.reserve( this->config.global.servers.size() );
 	this->sockets.backupServers.needsDelete = false;
+	Map::init(
+		this->config.global.stripeLists.count,
+		this->config.global.coding.params.getChunkCount()
+	);
 	for ( int i = 0, len = this->config.global.servers.size(); i < len; i++ ) {
 		ServerSocket *socket = new ServerSocket();
 		int tmpfd = - ( i + 1 );
 		socket->init( tmpfd, this->config.global.servers[ i ], &this->sockets.epoll );
 		this->sockets.servers.set( tmpfd, socket );
 	}
-	Map::init( this->config.global.stripeLists.count );
 	/* Stripe list */
 	this->stripeList = new StripeList<ServerSocket>(
 		this->config.global.coding.params.getChunkCount(),
@@ -647,6 +650,9 @@ void Coordinator::interactive() {
 		} else if ( strcmp( command, "dump" ) == 0 ) {
 			valid = true;
 			this->dump();
+		} else if ( strcmp( command, "memory" ) == 0 ) {
+			valid = true;
+			this->memory();
 		} else if ( strcmp( command, "remapping" ) == 0 ) {
 			valid = true;
 			this->printRemapping();
@@ -716,6 +722,49 @@ void Coordinator::dump() {
 	Map::dumpDegradedLocks();
 }
 
+void Coordinator::memory( FILE *f ) {
+	struct MapMemoryUsage usage;
+	uint64_t numDegradedLocks, degradedLockBytes = 0;
+	uint64_t total;
+
+	memset( &usage, 0, sizeof( usage ) );
+	for ( size_t i = 0, len = this->sockets.servers.size(); i < len; i++ )
+		this->sockets.servers[ i ]->map.getMemoryUsage( usage );
+
+	LOCK( &Map::degradedLocksLock );
+	numDegradedLocks = Map::degradedLocks.size();
+	for ( std::unordered_map<ListStripe, DegradedLock>::iterator it = Map::degradedLocks.begin(); it != Map::degradedLocks.end(); it++ )
+		degradedLockBytes += sizeof( ListStripe ) + sizeof( DegradedLock ) + it->second.reconstructedCount * 4 * sizeof( uint32_t );
+	UNLOCK( &Map::degradedLocksLock );
+
+	total = usage.sealedBytes + usage.keys.tableBytes + usage.keys.copyBytes + usage.keys.lockedKeyBytes + degradedLockBytes;
+
+	int width = 25;
+	fprintf(
+		f,
+		"Sealed chunks\n"
+		"\t- %-*s : %lu\n"
+		"\t- %-*s : %lu bytes\n"
+		"Keys\n"
+		"\t- %-*s : %lu\n"
+		"\t- %-*s : %lu bytes (%lu slots)\n"
+		"\t- %-*s : %lu bytes (%lu keys)\n"
+		"\t- %-*s : %lu bytes (%lu keys)\n"
+		"Degraded locks\n"
+		"\t- %-*s : %lu bytes (%lu locks)\n"
+		"Total\n"
+		"\t- %-*s : %lu bytes (%.2lf bytes per key)\n",
+		width, "Count", usage.sealedChunks,
+		width, "Stripe bitmaps", usage.sealedBytes,
+		width, "Count", usage.keys.keys,
+		width, "Index table", usage.keys.tableBytes, usage.keys.slots,
+		width, "Key copies", usage.keys.copyBytes, usage.keys.copies,
+		width, "Locked keys", usage.keys.lockedKeyBytes, usage.keys.lockedKeys,
+		width, "Locks", degradedLockBytes, numDegradedLocks,
+		width, "Memory", total, usage.keys.keys ? ( double ) total / usage.keys.keys : 0.0
+	);
+}
+
 void Coordinator::metadata() {
 	FILE *f = fopen( "coordinator.meta", "w+" );
 	if ( ! f ) {
@@ -766,6 +815,7 @@ void Coordinator::help() {
 		"- hash: Show the stripe list hashed by an input key\n"
 		"- lookup: Search for the metadata of an input key\n"
 		"- stripe: Query the seal status of a stripe\n"
+		"- memory: Print memory usage of the key and chunk indexes\n"
 		"- seal: Force all servers to seal all its chunks\n"
 		"- flush: Force all servers to flush all its chunks\n"
 		"- log: Write the log to coordinator.log\n"
@@ -112,6 +112,7 @@ public:
 	void info( FILE *f = stdout );
 	void debug( FILE *f = stdout );
 	void dump();
+	void memory( FILE *f = stdout );
 	void printInstanceId( FILE *f = stdout );
 	void printRemapping( FILE *f = stdout );
 	void printPending( FILE *f = stdout );
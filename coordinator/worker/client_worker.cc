@@ -338,23 +338,19 @@ bool CoordinatorWorker::handleSyncMetadata( ClientEvent event, char *buf, size_t
 		return false;
 	}
 
-	LOCK( &target->map.chunksLock );
 	for ( count = 0; count < heartbeat.sealed; count++ ) {
 		if ( this->protocol.parseMetadataHeader( header.metadata, processed, buf, size, offset ) ) {
 			target->map.insertChunk(
 				header.metadata.listId,
 				header.metadata.stripeId,
-				header.metadata.chunkId,
-				false, false
+				header.metadata.chunkId
 			);
 		} else {
 			failed++;
 		}
 		offset += processed;
 	}
-	UNLOCK( &target->map.chunksLock );
 
-	LOCK( &target->map.keysLock );
 	for ( count = 0; count < heartbeat.keys; count++ ) {
 		if ( this->protocol.parseKeyOpMetadataHeader( header.op, processed, buf, size, offset ) ) {
 			ServerSocket *s = target;
@@ -380,15 +376,13 @@ bool CoordinatorWorker::handleSyncMetadata( ClientEvent event, char *buf, size_t
 				header.op.stripeId,
 				header.op.chunkId,
 				header.op.opcode,
-				header.op.timestamp,
-				false, false
+				header.op.timestamp
 			);
 		} else {
 			failed++;
 		}
 		offset += processed;
 	}
-	UNLOCK( &target->map.keysLock );
 
 	if ( failed ) {
 		__ERROR__( "CoordinatorWorker", "handleSyncMetadata", "Number of failed objects = %lu", failed );
@@ -163,8 +163,8 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 		char *data;
 	} buffer;
 
+	std::unordered_set<Metadata> sealed;
 	std::unordered_set<Metadata>::iterator chunksIt;
-	std::unordered_map<Key, OpMetadata>::iterator keysIt;
 	std::unordered_map<uint32_t, std::unordered_set<uint32_t>> stripeIds;
 	std::unordered_map<uint32_t, std::unordered_set<uint32_t>>::iterator stripeIdsIt;
 	std::unordered_set<uint32_t>::iterator stripeIdSetIt;
@@ -202,13 +202,11 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 	}
 	UNLOCK( &map.lock );
 
-	LOCK( &socket->map.chunksLock );
-	LOCK( &socket->map.keysLock );
-
 	///////////////////////////////////////
 	// Prepare the list of sealed chunks //
 	///////////////////////////////////////
-	for ( chunksIt = socket->map.chunks.begin(); chunksIt != socket->map.chunks.end(); chunksIt++ ) {
+	socket->map.getSealedChunks( sealed );
+	for ( chunksIt = sealed.begin(); chunksIt != sealed.end(); chunksIt++ ) {
 		listId = chunksIt->listId;
 		stripeId = chunksIt->stripeId;
 
@@ -222,30 +220,16 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 		}
 		numLostChunks++;
 	}
-	assert( numLostChunks == socket->map.chunks.size() );
+	assert( numLostChunks == sealed.size() );
 
 	///////////////////////////////////////
 	// Prepare the list of unsealed keys //
 	///////////////////////////////////////
-	for ( keysIt = socket->map.keys.begin(); keysIt != socket->map.keys.end(); keysIt++ ) {
-		const Key &key = keysIt->first;
-		OpMetadata &opMetadata = keysIt->second;
-
-		chunksIt = socket->map.chunks.find( opMetadata );
-		if ( chunksIt == socket->map.chunks.end() ) {
-			unsealedIt = unsealed.find( opMetadata.listId );
-			if ( unsealedIt == unsealed.end() ) {
-				std::pair<uint32_t, std::unordered_set<Key>> p( opMetadata.listId, std::unordered_set<Key>() );
-				std::pair<std::unordered_map<uint32_t, std::unordered_set<Key>>::iterator, bool> r = unsealed.insert( p );
-				unsealedIt = r.first;
-			}
-			unsealedKeysIt = unsealedKeysAggregated.find( key );
-			if ( unsealedKeysIt == unsealedKeysAggregated.end() ) {
-				unsealedIt->second.insert( key );
-				unsealedKeysAggregated.insert( key );
+	socket->map.getUnsealedKeys( unsealed );
+	for ( unsealedIt = unsealed.begin(); unsealedIt != unsealed.end(); unsealedIt++ ) {
+		for ( unsealedKeysIt = unsealedIt->second.begin(); unsealedKeysIt != unsealedIt->second.end(); unsealedKeysIt++ ) {
+			if ( unsealedKeysAggregated.insert( *unsealedKeysIt ).second )
 				numLostUnsealedKeys++;
-			}
-			opMetadata.stripeId = -1; // Reset stripe ID
 		}
 	}
 	printf( "Number of unsealed chunks: %lu\n", unsealed.size() );
@@ -254,7 +238,7 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 	// Promote the backup server //
 	//////////////////////////////
 	requestId = CoordinatorWorker::idGenerator->nextVal( this->workerId );
-	chunksIt = socket->map.chunks.begin();
+	chunksIt = sealed.begin();
 	unsealedKeysIt = unsealedKeysAggregated.begin();
 
 	buffer.data = this->protocol.buffer.send;
@@ -267,7 +251,7 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 			Coordinator::instanceId, requestId,
 			srcAddr.addr,
 			srcAddr.port,
-			socket->map.chunks, chunksIt,
+			sealed, chunksIt,
 			unsealedKeysAggregated, unsealedKeysIt,
 			isCompleted
 		);
@@ -285,7 +269,7 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 		requestId,
 		srcAddr.addr,
 		srcAddr.port,
-		socket->map.chunks.size(),
+		sealed.size(),
 		numLostUnsealedKeys,
 		startTime,
 		backupServerSocket,
@@ -422,9 +406,6 @@ bool CoordinatorWorker::handleReconstructionRequest( ServerSocket *socket ) {
 		);
 	}
 
-	UNLOCK( &socket->map.keysLock );
-	UNLOCK( &socket->map.chunksLock );
-
 	printf( "Number of chunks that need to be recovered: %u\n", numLostChunks );
 
 	return true;
@@ -53,8 +53,7 @@ bool CoordinatorWorker::handleDegradedSetLockRequest( ClientEvent event, char *b
 		header.isLarge,
 		header.key, header.keySize,
 		originalListId, -1 /* stripeId */, originalChunkId,
-		PROTO_OPCODE_REMAPPING_LOCK, 0 /* timestamp */,
-		true, true )
+		PROTO_OPCODE_REMAPPING_LOCK, 0 /* timestamp */ )
 		|| true /***** HACK FOR YCSB which sends duplicated keys for SET *****/
 	) {
 		RemappingRecord remappingRecord;
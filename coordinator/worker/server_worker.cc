@@ -357,23 +357,19 @@ bool CoordinatorWorker::processHeartbeat( ServerEvent event, char *buf, size_t s
 
 	offset += PROTO_HEARTBEAT_SIZE;
 
-	LOCK( &event.socket->map.chunksLock );
 	for ( count = 0; count < heartbeat.sealed; count++ ) {
 		if ( this->protocol.parseMetadataHeader( header.metadata, processed, buf, size, offset ) ) {
 			event.socket->map.insertChunk(
 				header.metadata.listId,
 				header.metadata.stripeId,
-				header.metadata.chunkId,
-				false, false
+				header.metadata.chunkId
 			);
 		} else {
 			failed++;
 		}
 		offset += processed;
 	}
-	UNLOCK( &event.socket->map.chunksLock );
 
-	LOCK( &event.socket->map.keysLock );
 	for ( count = 0; count < heartbeat.keys; count++ ) {
 		if ( this->protocol.parseKeyOpMetadataHeader( header.op, processed, buf, size, offset ) ) {
 			ServerSocket *s = event.socket;
@@ -388,8 +384,7 @@ bool CoordinatorWorker::processHeartbeat( ServerEvent event, char *buf, size_t s
 				header.op.stripeId,
 				header.op.chunkId,
 				header.op.opcode,
-				header.op.timestamp,
-				false, false
+				header.op.timestamp
 			);
 
 			// if ( header.op.isLarge ) {
@@ -400,7 +395,6 @@ bool CoordinatorWorker::processHeartbeat( ServerEvent event, char *buf, size_t s
 		}
 		offset += processed;
 	}
-	UNLOCK( &event.socket->map.keysLock );
 
 	if ( failed ) {
 		__ERROR__( "CoordinatorWorker", "processHeartbeat", "Number of failed objects = %lu", failed );
@@ -8,6 +8,9 @@ Coding *ChunkBuffer::coding;
 ChunkPool *ChunkBuffer::chunkPool;
 ServerEventQueue *ChunkBuffer::eventQueue;
 Map *ChunkBuffer::map;
+GetChunkBuffer *ChunkBuffer::backup;
+Snapshot *ChunkBuffer::snapshot;
+WriteAheadLog *ChunkBuffer::wal;
 
 void ChunkBuffer::init() {
 	Server *server = Server::getInstance();
@@ -17,6 +20,9 @@ void ChunkBuffer::init() {
 	ChunkBuffer::chunkPool = &server->chunkPool;
 	ChunkBuffer::eventQueue = &server->eventQueue;
 	ChunkBuffer::map = &server->map;
+	ChunkBuffer::backup = &server->getChunkBuffer;
+	ChunkBuffer::snapshot = &server->snapshot;
+	ChunkBuffer::wal = &server->wal;
 }
 
 ChunkBuffer::ChunkBuffer( bool isReady ) {
@@ -3,7 +3,9 @@
 
 #include <cstdio>
 #include <pthread.h>
+#include "get_chunk_buffer.hh"
 #include "../ds/map.hh"
+#include "../ds/snapshot.hh"
 #include "../event/event_queue.hh"
 #include "../../common/coding/coding.hh"
 #include "../../common/ds/chunk.hh"
@@ -12,6 +14,8 @@
 
 #define CHUNK_BUFFER_FLUSH_THRESHOLD	4 // excluding metadata (4 bytes)
 
+class WriteAheadLog;
+
 class ChunkBuffer {
 protected:
 	LOCK_T lock;                           // Lock for the whole buffer
@@ -21,6 +25,9 @@ protected:
 	static ChunkPool *chunkPool;           // Memory pool for chunks
 	static ServerEventQueue *eventQueue;   // Event queue
 	static Map *map;                       // Maps in server
+	static GetChunkBuffer *backup;         // Unmodified chunks for serving GET_CHUNK requests
+	static Snapshot *snapshot;             // Online snapshot of the chunks
+	static WriteAheadLog *wal;             // Write-ahead log of the modifications
 
 public:
 	static uint32_t capacity;              // Chunk size
@@ -3,23 +3,31 @@
 #include "../worker/worker.hh"
 
 DataChunkBuffer::DataChunkBuffer( uint32_t count, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isReady ) : ChunkBuffer( isReady ) {
+	pthread_rwlockattr_t attr;
+
+	pthread_rwlockattr_init( &attr );
+#ifdef __GLIBC__
+	// Do not let a stream of SETs starve sealing
+	pthread_rwlockattr_setkind_np( &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP );
+#endif
+
 	this->count = count;
-	this->locks = new LOCK_T[ count ];
+	this->locks = new RW_LOCK_T[ count ];
 	this->chunks = new Chunk*[ count ];
-#ifndef REINSERTED_CHUNKS_IS_SET
-	this->reInsertedChunks = new Chunk*[ count ];
-#endif
-	this->sizes = new uint32_t[ count ];
+	this->reInsertedChunkMaxSpace = 0;
+	this->sizes = new std::atomic<uint32_t>[ count ];
+	this->writers = new std::atomic<uint32_t>[ count ];
+	this->openedAt = new std::atomic<uint64_t>[ count ];
 
 	for ( uint32_t i = 0; i < count; i++ ) {
-		LOCK_INIT( this->locks + i );
+		pthread_rwlock_init( this->locks + i, &attr );
 		this->sizes[ i ] = 0;
-		this->chunks[ i ] = ChunkBuffer::chunkPool->alloc();
-
-#ifndef REINSERTED_CHUNKS_IS_SET
-		this->reInsertedChunks[ i ] = 0;
-#endif
+		this->writers[ i ] = 0;
+		this->openedAt[ i ] = 0;
+		// Allocated by init() unless restored
+		this->chunks[ i ] = 0;
 	}
+	pthread_rwlockattr_destroy( &attr );
 
 	this->listId = listId;
 	this->stripeId = stripeId;
@@ -32,8 +40,11 @@ void DataChunkBuffer::init() {
 	uint32_t stripeId;
 
 	for ( uint32_t i = 0; i < this->count; i++ ) {
+		if ( this->chunks[ i ] )
+			continue;
 		stripeId = ChunkBuffer::map->nextStripeID( this->listId, this->stripeId );
 
+		this->chunks[ i ] = ChunkBuffer::chunkPool->alloc();
 		ChunkUtil::set( this->chunks[ i ], this->listId, stripeId, this->chunkId );
 
 		ChunkBuffer::map->setChunk(
@@ -46,6 +57,37 @@ void DataChunkBuffer::init() {
 	}
 }
 
+bool DataChunkBuffer::restore( Chunk *chunk ) {
+	for ( uint32_t i = 0; i < this->count; i++ ) {
+		if ( this->chunks[ i ] )
+			continue;
+		this->chunks[ i ] = chunk;
+		this->sizes[ i ] = ChunkUtil::getSize( chunk );
+		// Aged from now on, as the time it is opened is not kept
+		this->openedAt[ i ] = this->sizes[ i ] ? DataChunkBuffer::getTime() : 0;
+		return true;
+	}
+	return false;
+}
+
+int DataChunkBuffer::findChunk( uint32_t size ) {
+	int index = -1;
+	uint32_t max = 0, minWriters = 0, tmp, writers;
+
+	for ( uint32_t i = 0; i < this->count; i++ ) {
+		tmp = this->sizes[ i ] + size;
+		if ( tmp > ChunkBuffer::capacity )
+			continue;
+		writers = this->writers[ i ];
+		if ( index == -1 || writers < minWriters || ( writers == minWriters && tmp > max ) ) {
+			index = i;
+			max = tmp;
+			minWriters = writers;
+		}
+	}
+	return index;
+}
+
 KeyMetadata DataChunkBuffer::set(
 	ServerWorker *worker,
 	char *key, uint8_t keySize,
@@ -55,11 +97,11 @@ KeyMetadata DataChunkBuffer::set(
 	uint8_t *sealedCount, Metadata *sealed1, Metadata *sealed2
 ) {
 	KeyMetadata keyMetadata;
-	uint32_t size = PROTO_KEY_VALUE_SIZE + keySize + valueSize, max = 0, tmp, splitSize;
+	uint32_t size = PROTO_KEY_VALUE_SIZE + keySize + valueSize, offset, splitSize;
 	int index = -1;
-	Chunk *reInsertedChunk = 0, *chunk = 0;
+	Chunk *chunk = 0;
 	char *ptr;
-	bool isLarge = LargeObjectUtil::isLarge( keySize, valueSize, 0, &splitSize );
+	bool isLarge = LargeObjectUtil::isLarge( keySize, valueSize, 0, &splitSize ), isFull;
 
 	if ( sealedCount ) *sealedCount = 0;
 
@@ -69,140 +111,92 @@ KeyMetadata DataChunkBuffer::set(
 		size += SPLIT_OFFSET_SIZE;
 	}
 
-	// Choose one chunk buffer with minimum free space
-	LOCK( &this->lock );
+	// Set up key metadata
+	keyMetadata.listId = this->listId;
+	keyMetadata.chunkId = this->chunkId;
+	keyMetadata.length = size;
+	keyMetadata.isParityRemapped = ( opcode == PROTO_OPCODE_DEGRADED_SET );
+
 	if ( size <= this->reInsertedChunkMaxSpace ) {
-		uint32_t space, min = ChunkBuffer::capacity;
-		Chunk *c;
-		// Choose one from the re-inserted chunks
-#ifdef REINSERTED_CHUNKS_IS_SET
-		std::unordered_set<Chunk *>::iterator it;
-		for ( it = this->reInsertedChunks.begin(); it != this->reInsertedChunks.end(); it++ ) {
-			c = *it;
-			space = ChunkBuffer::capacity - ChunkUtil::getSize( c );
-			if ( space >= size && space < min ) {
-				min = space;
-				reInsertedChunk = c;
-			}
-		}
-#else
-		for ( uint32_t i = 0; i < this->count; i++ ) {
-			if ( ( c = this->reInsertedChunks[ i ] ) ) {
-				space = ChunkBuffer::capacity - ChunkUtil::getSize( c );
-				if ( space >= size && space < min ) {
-					min = space;
-					reInsertedChunk = c;
-				}
+		uint32_t space;
+		// Choose the re-inserted chunk with minimum free space
+		LOCK( &this->lock );
+		while ( ( chunk = this->reInsertedChunks.findBestFit( size, space ) ) ) {
+			// The indexed free space is estimated at re-insertion; correct it if the chunk cannot fit
+			space = ChunkBuffer::capacity - ChunkUtil::getSize( chunk );
+			if ( space >= size ) {
+				this->reInsertedChunks.update( chunk, space - size );
+				break;
 			}
+			this->reInsertedChunks.update( chunk, space );
 		}
-#endif
-		if ( reInsertedChunk ) {
-			// Update reInsertedChunkMaxSpace if the chunk with reInsertedChunkMaxSpace is chosen
-			if ( ChunkBuffer::capacity - ChunkUtil::getSize( reInsertedChunk ) == this->reInsertedChunkMaxSpace ) {
-				this->reInsertedChunkMaxSpace = 0;
-
-#ifdef REINSERTED_CHUNKS_IS_SET
-				for ( it = this->reInsertedChunks.begin(); it != this->reInsertedChunks.end(); it++ ) {
-					c = *it;
-					space = ChunkBuffer::capacity - ChunkUtil::getSize( c );
-					if ( space > this->reInsertedChunkMaxSpace )
-						this->reInsertedChunkMaxSpace = space;
-				}
-#else
-				for ( uint32_t i = 0; i < this->count; i++ ) {
-					if ( ( c = this->reInsertedChunks[ i ] ) ) {
-						space = ChunkBuffer::capacity - ChunkUtil::getSize( c );
-						if ( space > this->reInsertedChunkMaxSpace )
-							this->reInsertedChunkMaxSpace = space;
-					}
-				}
-#endif
+		if ( chunk ) {
+			// Allocate memory from chunk and copy data to the buffer
+			ChunkBuffer::snapshot->skip( chunk );
+			ptr = ChunkUtil::alloc( chunk, size, keyMetadata.offset );
+			KeyValue::serialize( ptr, key, keySize, value, valueSize, splitOffset );
+			ChunkBuffer::chunkPool->setDirty( chunk );
+			keyMetadata.stripeId = ChunkUtil::getStripeId( chunk );
+			keyMetadata.obj = ptr;
+
+			if ( keyMetadata.offset + size + PROTO_KEY_VALUE_SIZE + CHUNK_BUFFER_FLUSH_THRESHOLD >= ChunkBuffer::capacity ) {
+				__ERROR__( "DataChunkBuffer", "set", "TODO: Fix lastDelPos." );
+				// worker->issueSealChunkRequest( chunk, chunk->lastDelPos );
+				this->reInsertedChunks.erase( chunk );
 			}
 		}
+		this->reInsertedChunkMaxSpace = this->reInsertedChunks.getMaxSpace();
+		UNLOCK( &this->lock );
 	}
-	if ( reInsertedChunk ) {
-		chunk = reInsertedChunk;
-		index = -1;
-	} else {
-		// Choose from chunk buffer if no re-inserted chunks can be used
-		for ( uint32_t i = 0; i < this->count; i++ ) {
-			tmp = this->sizes[ i ] + size;
-			if ( tmp <= ChunkBuffer::capacity ) {
-				if ( tmp > max ) {
-					max = tmp;
-					index = i;
-				} else if ( tmp == max && index != -1 ) {
-					if ( ChunkUtil::getStripeId( this->chunks[ i ] ) < ChunkUtil::getStripeId( this->chunks[ index ] ) )
-						index = i;
-				}
-			}
-		}
 
-		if ( index == -1 ) {
-			// A chunk is sealed
-			if ( sealedCount ) {
-				index = this->flush( worker, false, true, *sealedCount == 0 ? sealed1 : sealed2 );
-				( *sealedCount )++;
-			} else {
-				index = this->flush( worker, false, true, 0 );
+	if ( ! chunk ) {
+		// Append to one of the open chunks; SETs on different chunks do not block each other
+		while ( true ) {
+			index = this->findChunk( size );
+			if ( index == -1 ) {
+				// Seal the fullest chunk if there is still no space
+				LOCK( &this->lock );
+				if ( this->findChunk( size ) == -1 )
+					this->flush( worker, false, true, this->nextSealed( sealedCount, sealed1, sealed2 ) );
+				UNLOCK( &this->lock );
+				continue;
 			}
+
+			READ_LOCK( this->locks + index );
+			if ( this->reserve( index, size, offset ) )
+				break;
+			RW_UNLOCK( this->locks + index );
 		}
+		this->writers[ index ]++;
+		if ( offset == 0 )
+			this->openedAt[ index ] = DataChunkBuffer::getTime();
 
-		// Allocate memory in the selected chunk
-		LOCK( this->locks + index );
+		// The chunk is not replaced until all ongoing SETs release the lock
 		chunk = this->chunks[ index ];
-	}
-
-	// Set up key metadata
-	keyMetadata.listId = this->listId;
-	keyMetadata.stripeId = ChunkUtil::getStripeId( chunk );
-	keyMetadata.chunkId = this->chunkId;
-	keyMetadata.length = size;
-	keyMetadata.isParityRemapped = ( opcode == PROTO_OPCODE_DEGRADED_SET );
-	// keyMetadata.ptr = ( char * ) chunk;
-
-	// Allocate memory from chunk
-	ptr = ChunkUtil::alloc( chunk, size, keyMetadata.offset );
-	if ( index != -1 )
-		this->sizes[ index ] += size;
-
-	keyMetadata.obj = ptr;
-
-	// Copy data to the buffer
-	KeyValue::serialize( ptr, key, keySize, value, valueSize, splitOffset );
-
-	// Flush if the current buffer is full
-	if ( ChunkUtil::getSize( chunk ) + PROTO_KEY_VALUE_SIZE + CHUNK_BUFFER_FLUSH_THRESHOLD >= ChunkBuffer::capacity ) {
-		if ( index != -1 ) {
-			if ( sealedCount ) {
-				this->flushAt( worker, index, false, *sealedCount == 0 ? sealed1 : sealed2 );
-				( *sealedCount )++;
-			} else {
-				this->flushAt( worker, index, false, 0 );
-			}
-
-
-
-		} else {
-			__ERROR__( "DataChunkBuffer", "set", "TODO: Fix lastDelPos." );
-			// worker->issueSealChunkRequest( chunk, chunk->lastDelPos );
-#ifdef REINSERTED_CHUNKS_IS_SET
-			this->reInsertedChunks.erase( chunk );
-#else
-			for ( uint32_t i = 0; i < this->count; i++ ) {
-				if ( this->reInsertedChunks[ i ] == chunk ) {
-					this->reInsertedChunks[ i ] = 0;
-					break;
-				}
-			}
-#endif
+		ChunkBuffer::snapshot->skip( chunk );
+		ptr = ChunkUtil::getData( chunk ) + offset;
+		KeyValue::serialize( ptr, key, keySize, value, valueSize, splitOffset );
+		ChunkBuffer::chunkPool->setDirty( chunk );
+		keyMetadata.stripeId = ChunkUtil::getStripeId( chunk );
+		keyMetadata.offset = offset;
+		keyMetadata.obj = ptr;
+		isFull = ( offset + size + PROTO_KEY_VALUE_SIZE + CHUNK_BUFFER_FLUSH_THRESHOLD >= ChunkBuffer::capacity );
+
+		this->writers[ index ]--;
+		RW_UNLOCK( this->locks + index );
+
+		// Flush if the current buffer is full
+		if ( isFull ) {
+			LOCK( &this->lock );
+			WRITE_LOCK( this->locks + index );
+			// Skip if another SET has sealed the chunk
+			if ( this->chunks[ index ] == chunk )
+				this->flushAt( worker, index, false, this->nextSealed( sealedCount, sealed1, sealed2 ) );
+			RW_UNLOCK( this->locks + index );
+			UNLOCK( &this->lock );
 		}
 	}
 
-	if ( index != -1 )
-		UNLOCK( this->locks + index );
-	UNLOCK( &this->lock );
-
 	// Update key map
 	Key keyObj;
 	keyObj.set( keySize, key, 0, isLarge );
@@ -218,101 +212,94 @@ KeyMetadata DataChunkBuffer::set(
 
 size_t DataChunkBuffer::seal( ServerWorker *worker ) {
 	uint32_t count = 0;
-	Chunk *c;
 	LOCK( &this->lock );
 	for ( uint32_t i = 0; i < this->count; i++ ) {
+		WRITE_LOCK( this->locks + i );
 		this->flushAt( worker, i, false );
+		RW_UNLOCK( this->locks + i );
 		count++;
 	}
-#ifdef REINSERTED_CHUNKS_IS_SET
-	for (
-		std::unordered_set<Chunk *>::iterator it = this->reInsertedChunks.begin();
-		it != this->reInsertedChunks.end();
-		it++
-	) {
-		c = *it;
-		if ( c ) {
-			__ERROR__( "DataChunkBuffer", "set", "TODO: Fix lastDelPos." );
-			// worker->issueSealChunkRequest( c, c->lastDelPos );
-			count++;
-		}
+	for ( size_t i = 0, size = this->reInsertedChunks.size(); i < size; i++ ) {
+		__ERROR__( "DataChunkBuffer", "set", "TODO: Fix lastDelPos." );
+		// worker->issueSealChunkRequest( c, c->lastDelPos );
+		count++;
 	}
-#else
+	UNLOCK( &this->lock );
+	return count;
+}
+
+uint32_t DataChunkBuffer::sealAged( ServerWorker *worker, uint64_t now, uint64_t maxAge ) {
+	uint32_t count = 0;
+	uint64_t openedAt;
+
+	LOCK( &this->lock );
 	for ( uint32_t i = 0; i < this->count; i++ ) {
-		c = this->reInsertedChunks[ i ];
-		if ( c ) {
-			__ERROR__( "DataChunkBuffer", "set", "TODO: Fix lastDelPos." );
-			// worker->issueSealChunkRequest( c, c->lastDelPos );
-			count++;
-		}
+		openedAt = this->openedAt[ i ];
+		if ( ! openedAt || openedAt + maxAge > now )
+			continue;
+		WRITE_LOCK( this->locks + i );
+		this->flushAt( worker, i, false );
+		RW_UNLOCK( this->locks + i );
+		count++;
 	}
-#endif
 	UNLOCK( &this->lock );
 	return count;
 }
 
+uint64_t DataChunkBuffer::getOldest( int &index ) {
+	uint64_t oldest = 0, openedAt;
+
+	index = -1;
+	for ( uint32_t i = 0; i < this->count; i++ ) {
+		openedAt = this->openedAt[ i ];
+		if ( openedAt && ( index == -1 || openedAt < oldest ) ) {
+			index = i;
+			oldest = openedAt;
+		}
+	}
+	return oldest;
+}
+
+uint32_t DataChunkBuffer::sealAt( ServerWorker *worker, int index, uint64_t openedAt ) {
+	uint32_t size = 0;
+
+	LOCK( &this->lock );
+	WRITE_LOCK( this->locks + index );
+	if ( this->openedAt[ index ] == openedAt ) {
+		size = this->sizes[ index ];
+		this->flushAt( worker, index, false );
+	}
+	RW_UNLOCK( this->locks + index );
+	UNLOCK( &this->lock );
+	return size;
+}
+
+uint32_t DataChunkBuffer::getUnsealedSize() {
+	uint32_t size = 0;
+	for ( uint32_t i = 0; i < this->count; i++ )
+		size += this->sizes[ i ];
+	return size;
+}
+
+uint64_t DataChunkBuffer::getTime() {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ( uint64_t ) ts.tv_sec * MILLION + ts.tv_nsec / 1000;
+}
+
 bool DataChunkBuffer::reInsert( ServerWorker *worker, Chunk *chunk, uint32_t sizeToBeFreed, bool needsLock, bool needsUnlock ) {
-#ifdef REINSERTED_CHUNKS_IS_SET
-	std::unordered_set<Chunk *>::iterator it;
-	std::pair<std::unordered_set<Chunk *>::iterator, bool> ret;
-#else
-	bool ret = true;
-#endif
+	bool ret;
 	uint32_t space;
 
 	if ( needsLock ) LOCK( &this->lock );
 
 	space = ChunkBuffer::capacity - ChunkUtil::getSize( chunk ) + sizeToBeFreed;
-
-#ifdef REINSERTED_CHUNKS_IS_SET
-	ret = this->reInsertedChunks.insert( chunk );
-#else
-	// Limit the number of re-inserted chunks to be this->count
-	Chunk *c;
-	uint32_t i, j = this->count, min = space, index = this->count;
-	Chunk *selected = chunk;
-	bool isFull = true;
-	for ( i = 0; i < this->count; i++ ) {
-		if ( ( c = this->reInsertedChunks[ i ] ) ) {
-			if ( c == chunk ) {
-				// No need to insert as the chunk is already re-inserted
-				ret = false;
-				goto reInsertExit;
-			} else if ( ChunkBuffer::capacity - c->getSize() < min ) {
-				min = ChunkBuffer::capacity - c->getSize();
-				index = i;
-				selected = c;
-			}
-		} else {
-			isFull = false;
-			j = ( j == this->count ) ? i : j;
-		}
-	}
-	if ( isFull ) {
-		if ( selected != chunk ) {
-			worker->issueSealChunkRequest( selected, selected->lastDelPos );
-			this->reInsertedChunks[ index ] = chunk;
-		} else {
-			// Ignore the current chunk if it has least free space
-			if ( needsUnlock ) UNLOCK( &this->lock );
-			return true;
-		}
-	} else {
-		this->reInsertedChunks[ j ] = chunk;
-	}
-
-reInsertExit:
-#endif
-	if ( space > reInsertedChunkMaxSpace )
-		reInsertedChunkMaxSpace = space;
+	ret = this->reInsertedChunks.update( chunk, space );
+	this->reInsertedChunkMaxSpace = this->reInsertedChunks.getMaxSpace();
 
 	if ( needsUnlock ) UNLOCK( &this->lock );
 
-#ifdef REINSERTED_CHUNKS_IS_SET
-	return ret.second;
-#else
 	return ret;
-#endif
 }
 
 int DataChunkBuffer::lockChunk( Chunk *chunk, bool keepGlobalLock ) {
@@ -326,7 +313,7 @@ int DataChunkBuffer::lockChunk( Chunk *chunk, bool keepGlobalLock ) {
 	}
 	if ( index != -1 ) {
 		// Found
-		LOCK( this->locks + index );
+		WRITE_LOCK( this->locks + index );
 	} else {
 		if ( ! keepGlobalLock )
 			UNLOCK( &this->lock );
@@ -336,13 +323,13 @@ int DataChunkBuffer::lockChunk( Chunk *chunk, bool keepGlobalLock ) {
 
 void DataChunkBuffer::updateAndUnlockChunk( int index ) {
 	this->sizes[ index ] = ChunkUtil::getSize( this->chunks[ index ] );
-	UNLOCK( this->locks + index );
+	RW_UNLOCK( this->locks + index );
 	UNLOCK( &this->lock );
 }
 
 void DataChunkBuffer::unlock( int index ) {
 	if ( index != -1 )
-		UNLOCK( this->locks + index );
+		RW_UNLOCK( this->locks + index );
 	UNLOCK( &this->lock );
 }
 
@@ -364,12 +351,12 @@ uint32_t DataChunkBuffer::flush( ServerWorker *worker, bool lock, bool lockAtInd
 	}
 
 	if ( lock || lockAtIndex )
-		LOCK( this->locks + index );
+		WRITE_LOCK( this->locks + index );
 
 	this->flushAt( worker, index, false, sealed );
 
 	if ( lock || lockAtIndex )
-		UNLOCK( this->locks + index );
+		RW_UNLOCK( this->locks + index );
 
 	if ( lock )
 		UNLOCK( &this->lock );
@@ -380,7 +367,7 @@ uint32_t DataChunkBuffer::flush( ServerWorker *worker, bool lock, bool lockAtInd
 Chunk *DataChunkBuffer::flushAt( ServerWorker *worker, int index, bool lock, Metadata *sealed ) {
 	if ( lock ) {
 		LOCK( &this->lock );
-		LOCK( this->locks + index );
+		WRITE_LOCK( this->locks + index );
 	}
 
 	Chunk *chunk = this->chunks[ index ];
@@ -397,6 +384,7 @@ Chunk *DataChunkBuffer::flushAt( ServerWorker *worker, int index, bool lock, Met
 
 	// Get a new chunk
 	this->sizes[ index ] = 0;
+	this->openedAt[ index ] = 0;
 
 	metadata.set(
 		this->listId,
@@ -415,6 +403,10 @@ Chunk *DataChunkBuffer::flushAt( ServerWorker *worker, int index, bool lock, Met
 	this->chunks[ index ] = newChunk;
 	this->stripeId = metadata.stripeId + 1;
 
+	// The chunk is no longer reopened by replay
+	metadata = ChunkUtil::getMetadata( chunk );
+	ChunkBuffer::wal->append( WAL_OPCODE_SEAL, 0, 0, metadata, 0 );
+
 	// Notify the parity servers to seal the chunk
 	if ( worker->issueSealChunkRequest( chunk ) ) {
 		ChunkUtil::get( chunk, metadata.listId, metadata.stripeId, metadata.chunkId );
@@ -422,7 +414,7 @@ Chunk *DataChunkBuffer::flushAt( ServerWorker *worker, int index, bool lock, Met
 	}
 
 	if ( lock ) {
-		UNLOCK( this->locks + index );
+		RW_UNLOCK( this->locks + index );
 		UNLOCK( &this->lock );
 	}
 
@@ -462,4 +454,6 @@ DataChunkBuffer::~DataChunkBuffer() {
 	delete[] this->locks;
 	delete[] this->chunks;
 	delete[] this->sizes;
+	delete[] this->writers;
+	delete[] this->openedAt;
 }
@@ -1,13 +1,9 @@
 #ifndef __SERVER_BUFFER_DATA_CHUNK_BUFFER_HH__
 #define __SERVER_BUFFER_DATA_CHUNK_BUFFER_HH__
 
-#define REINSERTED_CHUNKS_IS_SET
-
-#ifdef REINSERTED_CHUNKS_IS_SET
-#include <unordered_set>
-#endif
-
+#include <atomic>
 #include "chunk_buffer.hh"
+#include "../ds/free_space_index.hh"
 
 class ServerWorker;
 
@@ -17,19 +13,55 @@ private:
 	uint32_t stripeId;                     // Current stripe ID
 	uint32_t chunkId;                      // Chunk ID of this buffer
 	uint32_t count;                        // Number of chunks
-	LOCK_T *locks;                         // Lock for each chunk
+	RW_LOCK_T *locks;                      // Lock for each chunk (shared by SETs, exclusive for sealing and modification)
 	Chunk **chunks;                        // Allocated chunk buffer
-#ifdef REINSERTED_CHUNKS_IS_SET
-	std::unordered_set<Chunk *> reInsertedChunks;    // Chunks that have free space after deletion
-#else
-	Chunk **reInsertedChunks;              // Chunks that have free space after deletion
-#endif
-	uint32_t *sizes;                       // Occupied space for each chunk
-	uint32_t reInsertedChunkMaxSpace;      // Maximum space avaiable in the re-inserted chunks
+	FreeSpaceIndex reInsertedChunks;       // Chunks that have free space after deletion
+	std::atomic<uint32_t> reInsertedChunkMaxSpace; // Maximum space available in the re-inserted chunks
+	std::atomic<uint32_t> *sizes;          // Occupied (allocated) space for each chunk
+	std::atomic<uint32_t> *writers;        // Number of ongoing SETs on each chunk
+	std::atomic<uint64_t> *openedAt;       // When the first object is appended to each chunk (in microseconds; 0 if empty)
+
+	/**
+	 * Choose an open chunk for a new object: the one with the fewest ongoing
+	 * SETs, and among them the one with the least free space that fits.
+	 *
+	 * @return -1 if no chunks can hold the object
+	 */
+	int findChunk( uint32_t size );
+
+	/**
+	 * Allocate space at the end of an open chunk. The lock of the chunk
+	 * should be held (either shared or exclusive).
+	 *
+	 * @param offset (output) offset of the allocated space
+	 * @return       false if the chunk does not have enough space
+	 */
+	inline bool reserve( int index, uint32_t size, uint32_t &offset ) {
+		offset = this->sizes[ index ];
+		do {
+			if ( offset + size > ChunkBuffer::capacity )
+				return false;
+		} while ( ! this->sizes[ index ].compare_exchange_weak( offset, offset + size ) );
+		return true;
+	}
+
+	// Metadata buffer for the next sealed chunk to be reported to the client
+	inline Metadata *nextSealed( uint8_t *sealedCount, Metadata *sealed1, Metadata *sealed2 ) {
+		if ( ! sealedCount || *sealedCount >= 2 )
+			return 0;
+		return ( ( *sealedCount )++ == 0 ) ? sealed1 : sealed2;
+	}
 
 public:
 	DataChunkBuffer( uint32_t count, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isReady );
 	void init();
+	/**
+	 * Take an unsealed chunk restored from a checkpoint as one of the open
+	 * chunks; called before init(), which allocates the remaining ones.
+	 *
+	 * @return false if all open chunks are taken
+	 */
+	bool restore( Chunk *chunk );
 
 	inline uint32_t getChunkId() { return this->chunkId; }
 
@@ -43,6 +75,29 @@ public:
 	);
 
 	size_t seal( ServerWorker *worker );
+	/**
+	 * Seal the partially filled chunks that have been open for at least
+	 * maxAge microseconds.
+	 *
+	 * @return number of chunks sealed
+	 */
+	uint32_t sealAged( ServerWorker *worker, uint64_t now, uint64_t maxAge );
+	/**
+	 * Find the chunk that has been open for the longest time.
+	 *
+	 * @param index (output) index of the chunk; -1 if all chunks are empty
+	 * @return      when the first object is appended to the chunk
+	 */
+	uint64_t getOldest( int &index );
+	/**
+	 * Seal the chunk at the index unless it is replaced after getOldest().
+	 *
+	 * @return number of bytes sealed
+	 */
+	uint32_t sealAt( ServerWorker *worker, int index, uint64_t openedAt );
+	// Number of bytes in the open chunks, which are replicated at the parity servers
+	uint32_t getUnsealedSize();
+	static uint64_t getTime();
 
 	// Re-insert into the buffer after a DELETE operation
 	bool reInsert( ServerWorker *worker, Chunk *chunk, uint32_t sizeToBeFreed, bool needsLock, bool needsUnlock );
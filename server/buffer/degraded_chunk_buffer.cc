@@ -625,8 +625,7 @@ bool DegradedChunkBuffer::deleteKey( uint8_t opcode, uint32_t &timestamp, uint8_
 
 bool DegradedChunkBuffer::update(
 	uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint32_t updatingChunkId,
-	uint32_t offset, uint32_t size, char *dataDelta,
-	Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk
+	uint32_t offset, uint32_t size, char *dataDelta
 ) {
 	Metadata metadata;
 	metadata.set( listId, stripeId, updatingChunkId );
@@ -637,24 +636,6 @@ bool DegradedChunkBuffer::update(
 	Chunk *chunk;
 	this->map.getCacheMap( cache, cacheLock );
 
-	// Prepare data delta
-	ChunkUtil::clear( dataChunk );
-	ChunkUtil::copy( dataChunk, offset, dataDelta, size );
-
-	// Prepare the stripe
-	for ( uint32_t i = 0; i < ChunkBuffer::dataChunkCount; i++ )
-		dataChunks[ i ] = Coding::zeros;
-	dataChunks[ chunkId ] = dataChunk;
-
-	ChunkUtil::clear( parityChunk );
-
-	// Compute parity delta
-	ChunkBuffer::coding->encode(
-		dataChunks, parityChunk, updatingChunkId - ChunkBuffer::dataChunkCount + 1,
-		offset + chunkId * ChunkBuffer::capacity,
-		offset + chunkId * ChunkBuffer::capacity + size
-	);
-
 	// Update the parity chunk
 	LOCK( cacheLock );
 	it = cache->find( metadata );
@@ -668,12 +649,11 @@ bool DegradedChunkBuffer::update(
 	} else {
 		chunk = it->second;
 	}
-	char *parity = ChunkUtil::getData( chunk );
-	Coding::bitwiseXOR(
-		parity,
-		parity,
-		ChunkUtil::getData( parityChunk ),
-		ChunkBuffer::capacity
+	// Apply the parity delta computed from the data delta
+	ChunkBuffer::coding->encodeDelta(
+		chunkId, dataDelta, offset, size,
+		updatingChunkId - ChunkBuffer::dataChunkCount + 1,
+		chunk
 	);
 	UNLOCK( cacheLock );
 
@@ -159,8 +159,7 @@ public:
 	// For reconstructed parity chunks
 	bool update(
 		uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint32_t updatingChunkId,
-		uint32_t offset, uint32_t size, char *dataDelta,
-		Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk
+		uint32_t offset, uint32_t size, char *dataDelta
 	);
 
 	~DegradedChunkBuffer();
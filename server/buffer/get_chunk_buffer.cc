@@ -4,6 +4,7 @@
 
 GetChunkBuffer::GetChunkBuffer() {
 	LOCK_INIT( &this->lock );
+	this->snapshots = 0;
 }
 
 GetChunkBuffer::~GetChunkBuffer() {
@@ -11,16 +12,88 @@ GetChunkBuffer::~GetChunkBuffer() {
 
 	LOCK( &this->lock );
 	for ( it = this->chunks.begin(); it != this->chunks.end(); it++ ) {
-		if ( it->second.chunk ) {
-			this->chunkPool.free( it->second.chunk );
-			if ( it->second.sealIndicator )
-				delete[] it->second.sealIndicator;
-		}
-		it = this->chunks.erase( it );
+		this->release( it->second );
+		if ( it->second.sealIndicator )
+			delete[] it->second.sealIndicator;
 	}
+	this->chunks.clear();
+	for ( size_t i = 0, size = this->freeSegments.size(); i < size; i++ )
+		::free( this->freeSegments[ i ] );
+	this->freeSegments.clear();
 	UNLOCK( &this->lock );
 }
 
+uint32_t GetChunkBuffer::getSegmentCount() {
+	return ( ChunkUtil::chunkSize + GET_CHUNK_BUFFER_SEGMENT_SIZE - 1 ) / GET_CHUNK_BUFFER_SEGMENT_SIZE;
+}
+
+void GetChunkBuffer::preserve( GetChunkWrapper &wrapper, uint32_t offset, uint32_t length ) {
+	uint32_t first, last, segmentSize;
+	char *data = ChunkUtil::getData( wrapper.source );
+
+	if ( ! length )
+		return;
+	if ( offset + length > ChunkUtil::chunkSize )
+		length = ( offset < ChunkUtil::chunkSize ) ? ChunkUtil::chunkSize - offset : 0;
+	if ( ! length )
+		return;
+
+	first = offset / GET_CHUNK_BUFFER_SEGMENT_SIZE;
+	last = ( offset + length - 1 ) / GET_CHUNK_BUFFER_SEGMENT_SIZE;
+	for ( uint32_t i = first; i <= last; i++ ) {
+		if ( wrapper.segments[ i ] )
+			continue;
+		if ( this->freeSegments.empty() ) {
+			wrapper.segments[ i ] = ( char * ) malloc( GET_CHUNK_BUFFER_SEGMENT_SIZE );
+		} else {
+			wrapper.segments[ i ] = this->freeSegments.back();
+			this->freeSegments.pop_back();
+		}
+		segmentSize = ChunkUtil::chunkSize - i * GET_CHUNK_BUFFER_SEGMENT_SIZE;
+		if ( segmentSize > GET_CHUNK_BUFFER_SEGMENT_SIZE )
+			segmentSize = GET_CHUNK_BUFFER_SEGMENT_SIZE;
+		memcpy( wrapper.segments[ i ], data + i * GET_CHUNK_BUFFER_SEGMENT_SIZE, segmentSize );
+	}
+}
+
+void GetChunkBuffer::assemble( GetChunkWrapper &wrapper ) {
+	uint32_t segmentCount = GetChunkBuffer::getSegmentCount(), segmentSize;
+	Chunk *chunk = this->chunkPool.alloc();
+	char *data = ChunkUtil::getData( chunk );
+
+	ChunkUtil::dup( chunk, wrapper.source );
+	for ( uint32_t i = 0; i < segmentCount; i++ ) {
+		if ( ! wrapper.segments[ i ] )
+			continue;
+		segmentSize = ChunkUtil::chunkSize - i * GET_CHUNK_BUFFER_SEGMENT_SIZE;
+		if ( segmentSize > GET_CHUNK_BUFFER_SEGMENT_SIZE )
+			segmentSize = GET_CHUNK_BUFFER_SEGMENT_SIZE;
+		memcpy( data + i * GET_CHUNK_BUFFER_SEGMENT_SIZE, wrapper.segments[ i ], segmentSize );
+	}
+	this->release( wrapper, false );
+	wrapper.chunk = chunk;
+}
+
+void GetChunkBuffer::release( GetChunkWrapper &wrapper, bool needsFree ) {
+	if ( needsFree && wrapper.chunk )
+		this->chunkPool.free( wrapper.chunk );
+	if ( wrapper.source ) {
+		uint32_t segmentCount = GetChunkBuffer::getSegmentCount();
+		for ( uint32_t i = 0; i < segmentCount; i++ ) {
+			if ( ! wrapper.segments[ i ] )
+				continue;
+			if ( this->freeSegments.size() < GET_CHUNK_BUFFER_MAX_FREE_SEGMENTS )
+				this->freeSegments.push_back( wrapper.segments[ i ] );
+			else
+				::free( wrapper.segments[ i ] );
+		}
+		delete[] wrapper.segments;
+		wrapper.segments = 0;
+		wrapper.source = 0;
+		this->snapshots--;
+	}
+}
+
 bool GetChunkBuffer::insert( Metadata metadata, Chunk *chunk, uint8_t sealIndicatorCount, bool *sealIndicator, bool needsLock, bool needsUnlock ) {
 	if ( ! chunk )
 		return false;
@@ -31,39 +104,88 @@ bool GetChunkBuffer::insert( Metadata metadata, Chunk *chunk, uint8_t sealIndica
 	it = this->chunks.find( metadata );
 	if ( it == this->chunks.end() ) {
 		// Copy the chunk
-		Chunk *newChunk;
 		GetChunkWrapper wrapper;
 
-		if ( chunk ) {
-			newChunk = this->chunkPool.alloc();
-			ChunkUtil::dup( newChunk, chunk );
-			wrapper.sealIndicatorCount = sealIndicatorCount;
-			wrapper.sealIndicator = sealIndicator;
-		} else {
-			newChunk = 0;
-		}
-
-		wrapper.chunk = newChunk;
+		wrapper.chunk = this->chunkPool.alloc();
+		ChunkUtil::dup( wrapper.chunk, chunk );
+		wrapper.source = 0;
+		wrapper.segments = 0;
+		wrapper.sealIndicatorCount = sealIndicatorCount;
+		wrapper.sealIndicator = sealIndicator;
 		wrapper.acked = false;
 
 		std::pair<Metadata, GetChunkWrapper> p( metadata, wrapper );
 		this->chunks.insert( p );
 	} else if ( ! it->second.acked ) {
-		if ( chunk ) {
-			if ( ! it->second.chunk ) {
-				it->second.chunk = this->chunkPool.alloc();
-				ChunkUtil::dup( it->second.chunk, chunk );
-				it->second.sealIndicatorCount = sealIndicatorCount;
-				it->second.sealIndicator = sealIndicator;
-			}
-		} else {
-			it->second.chunk = 0;
+		if ( it->second.source ) {
+			// The modified range is unknown
+			this->assemble( it->second );
+		} else if ( ! it->second.chunk ) {
+			it->second.chunk = this->chunkPool.alloc();
+			ChunkUtil::dup( it->second.chunk, chunk );
+			it->second.sealIndicatorCount = sealIndicatorCount;
+			it->second.sealIndicator = sealIndicator;
+		}
+	}
+	if ( needsUnlock ) UNLOCK( &this->lock );
+	return ret;
+}
+
+bool GetChunkBuffer::insert( Metadata metadata, Chunk *chunk, uint32_t offset, uint32_t length, uint8_t sealIndicatorCount, bool *sealIndicator, bool needsLock, bool needsUnlock ) {
+	if ( ! chunk )
+		return false;
+	bool ret = true;
+	std::unordered_map<Metadata, GetChunkWrapper>::iterator it;
+	GetChunkWrapper *wrapper = 0;
+
+	if ( needsLock ) LOCK( &this->lock );
+	it = this->chunks.find( metadata );
+	if ( it == this->chunks.end() ) {
+		GetChunkWrapper newWrapper;
+
+		newWrapper.chunk = 0;
+		newWrapper.source = 0;
+		newWrapper.segments = 0;
+		newWrapper.sealIndicatorCount = sealIndicatorCount;
+		newWrapper.sealIndicator = sealIndicator;
+		newWrapper.acked = false;
+
+		std::pair<Metadata, GetChunkWrapper> p( metadata, newWrapper );
+		wrapper = &this->chunks.insert( p ).first->second;
+	} else if ( ! it->second.acked && ! it->second.chunk ) {
+		wrapper = &it->second;
+		if ( ! wrapper->source ) {
+			wrapper->sealIndicatorCount = sealIndicatorCount;
+			wrapper->sealIndicator = sealIndicator;
+		}
+	}
+
+	if ( wrapper ) {
+		if ( ! wrapper->source ) {
+			// Take a snapshot without copying the chunk
+			wrapper->source = chunk;
+			wrapper->segments = new char*[ GetChunkBuffer::getSegmentCount() ]();
+			this->snapshots++;
 		}
+		this->preserve( *wrapper, offset, length );
 	}
 	if ( needsUnlock ) UNLOCK( &this->lock );
 	return ret;
 }
 
+void GetChunkBuffer::preserve( Chunk *chunk, uint32_t offset, uint32_t length ) {
+	std::unordered_map<Metadata, GetChunkWrapper>::iterator it;
+
+	if ( ! this->snapshots )
+		return;
+
+	LOCK( &this->lock );
+	it = this->chunks.find( ChunkUtil::getMetadata( chunk ) );
+	if ( it != this->chunks.end() && it->second.source == chunk )
+		this->preserve( it->second, offset, length );
+	UNLOCK( &this->lock );
+}
+
 Chunk *GetChunkBuffer::find( Metadata metadata, bool &exists, uint8_t &sealIndicatorCount, bool *&sealIndicator, bool needsLock, bool needsUnlock ) {
 	Chunk *ret;
 	std::unordered_map<Metadata, GetChunkWrapper>::iterator it;
@@ -74,6 +196,9 @@ Chunk *GetChunkBuffer::find( Metadata metadata, bool &exists, uint8_t &sealIndic
 		ret = 0;
 		exists = false;
 	} else {
+		// Pin the version of the snapshot
+		if ( it->second.source )
+			this->assemble( it->second );
 		ret = it->second.chunk;
 		sealIndicatorCount = it->second.sealIndicatorCount;
 		sealIndicator = it->second.sealIndicator;
@@ -92,18 +217,17 @@ bool GetChunkBuffer::ack( Metadata metadata, bool needsLock, bool needsUnlock, b
 	if ( it == this->chunks.end() ) {
 		GetChunkWrapper wrapper;
 		wrapper.chunk = 0;
+		wrapper.source = 0;
+		wrapper.segments = 0;
 		wrapper.sealIndicator = 0;
 		wrapper.sealIndicatorCount = 0;
 		wrapper.acked = true;
 		std::pair<Metadata, GetChunkWrapper> p( metadata, wrapper );
 		this->chunks.insert( p );
 	} else {
-		if ( needsFree ) {
-			if ( it->second.chunk )
-				this->chunkPool.free( it->second.chunk );
-			if ( it->second.sealIndicator )
-				delete[] it->second.sealIndicator;
-		}
+		this->release( it->second, needsFree );
+		if ( needsFree && it->second.sealIndicator )
+			delete[] it->second.sealIndicator;
 		it->second.chunk = 0;
 		it->second.sealIndicator = 0;
 		it->second.sealIndicatorCount = 0;
@@ -122,8 +246,7 @@ bool GetChunkBuffer::erase( Metadata metadata, bool needsLock, bool needsUnlock
 	if ( it == this->chunks.end() ) {
 		// Do nothing
 	} else {
-		if ( it->second.chunk )
-			this->chunkPool.free( it->second.chunk );
+		this->release( it->second );
 		if ( it->second.sealIndicator )
 			delete[] it->second.sealIndicator;
 		this->chunks.erase( it );
@@ -1,34 +1,69 @@
 #ifndef __SERVER_BUFFER_GET_CHUNK_BUFFER_HH__
 #define __SERVER_BUFFER_GET_CHUNK_BUFFER_HH__
 
+#include <atomic>
+#include <vector>
 #include <cstdio>
 #include <pthread.h>
 #include "../../common/ds/chunk.hh"
 #include "../../common/ds/chunk_pool.hh"
 #include "../../common/lock/lock.hh"
 
+#define GET_CHUNK_BUFFER_SEGMENT_SIZE       512
+#define GET_CHUNK_BUFFER_MAX_FREE_SEGMENTS  4096
+
 struct GetChunkWrapper {
 	bool acked;
-	Chunk *chunk;
+	Chunk *chunk;         // Unmodified copy of the chunk (built by the first reader for copy-on-write snapshots)
+	Chunk *source;        // Chunk being modified (copy-on-write snapshot only)
+	char **segments;      // Original contents of the modified segments of the source chunk
 	uint8_t sealIndicatorCount;
 	bool *sealIndicator;
 };
 
-// Buffer for storing unmodified chunks for serving GET_CHUNK requests
+/**
+ * Buffer for storing unmodified chunks for serving GET_CHUNK requests.
+ *
+ * When the modified range is known, the chunk is not copied when it is
+ * inserted: only the segments that the writers touch are copied before
+ * they are modified (see preserve()), and the whole chunk is assembled
+ * only if it is requested (see find()).
+ */
 class GetChunkBuffer {
 protected:
 	LOCK_T lock;
 	std::unordered_map<Metadata, GetChunkWrapper> chunks;
 	TempChunkPool chunkPool;
+	std::atomic<uint32_t> snapshots; // Number of copy-on-write snapshots not yet assembled
+	std::vector<char *> freeSegments;
+
+	static uint32_t getSegmentCount();
+	void preserve( GetChunkWrapper &wrapper, uint32_t offset, uint32_t length );
+	void assemble( GetChunkWrapper &wrapper );
+	void release( GetChunkWrapper &wrapper, bool needsFree = true );
 
 public:
 	GetChunkBuffer();
 	~GetChunkBuffer();
+	// Keep a full copy of the chunk
+	bool insert(
+		Metadata metadata, Chunk *chunk,
+		uint8_t sealIndicatorCount = 0, bool *sealIndicator = 0,
+		bool needsLock = true, bool needsUnlock = true
+	);
+	// Keep a copy-on-write snapshot of the chunk, which is about to be modified in [offset, offset + length)
 	bool insert(
 		Metadata metadata, Chunk *chunk,
+		uint32_t offset, uint32_t length,
 		uint8_t sealIndicatorCount = 0, bool *sealIndicator = 0,
 		bool needsLock = true, bool needsUnlock = true
 	);
+	/**
+	 * Copy the original contents of [offset, offset + length) of the chunk
+	 * before it is modified if it has a snapshot. Every writer of a sealed
+	 * chunk should call this.
+	 */
+	void preserve( Chunk *chunk, uint32_t offset, uint32_t length );
 	Chunk *find(
 		Metadata metadata, bool &exists,
 		uint8_t &sealIndicatorCount, bool *&sealIndicator,
@@ -19,11 +19,14 @@ bool MixedChunkBuffer::set(
 	uint32_t &stripeId, uint32_t chunkId, uint32_t splitOffset,
 	uint8_t *sealedCount, Metadata *sealed1, Metadata *sealed2,
 	Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk,
-	GetChunkBuffer *getChunkBuffer
+	GetChunkBuffer *getChunkBuffer,
+	KeyMetadata *keyMetadata
 ) {
+	KeyMetadata ret;
+
 	switch( this->role ) {
 		case CBR_DATA:
-			this->buffer.data->set(
+			ret = this->buffer.data->set(
 				worker,
 				key, keySize,
 				value, valueSize,
@@ -31,6 +34,8 @@ bool MixedChunkBuffer::set(
 				stripeId, splitOffset,
 				sealedCount, sealed1, sealed2
 			);
+			if ( keyMetadata )
+				*keyMetadata = ret;
 			return true;
 		case CBR_PARITY:
 			timestamp = 0;
@@ -62,6 +67,47 @@ size_t MixedChunkBuffer::seal( ServerWorker *worker ) {
 	}
 }
 
+uint32_t MixedChunkBuffer::sealAged( ServerWorker *worker, uint64_t now, uint64_t maxAge ) {
+	switch( this->role ) {
+		case CBR_DATA:
+			return this->buffer.data->sealAged( worker, now, maxAge );
+		case CBR_PARITY:
+		default:
+			return 0;
+	}
+}
+
+uint64_t MixedChunkBuffer::getOldest( int &index ) {
+	switch( this->role ) {
+		case CBR_DATA:
+			return this->buffer.data->getOldest( index );
+		case CBR_PARITY:
+		default:
+			index = -1;
+			return 0;
+	}
+}
+
+uint32_t MixedChunkBuffer::sealAt( ServerWorker *worker, int index, uint64_t openedAt ) {
+	switch( this->role ) {
+		case CBR_DATA:
+			return this->buffer.data->sealAt( worker, index, openedAt );
+		case CBR_PARITY:
+		default:
+			return 0;
+	}
+}
+
+uint32_t MixedChunkBuffer::getUnsealedSize() {
+	switch( this->role ) {
+		case CBR_DATA:
+			return this->buffer.data->getUnsealedSize();
+		case CBR_PARITY:
+		default:
+			return 0;
+	}
+}
+
 bool MixedChunkBuffer::reInsert( ServerWorker *worker, Chunk *chunk, uint32_t sizeToBeFreed, bool needsLock, bool needsUnlock ) {
 	switch( this->role ) {
 		case CBR_DATA:
@@ -72,10 +118,10 @@ bool MixedChunkBuffer::reInsert( ServerWorker *worker, Chunk *chunk, uint32_t si
 	}
 }
 
-bool MixedChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk ) {
+bool MixedChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk, bool needsLock, bool needsUnlock ) {
 	switch( this->role ) {
 		case CBR_PARITY:
-			return this->buffer.parity->seal( stripeId, chunkId, count, sealData, sealDataSize, dataChunks, dataChunk, parityChunk );
+			return this->buffer.parity->seal( stripeId, chunkId, count, sealData, sealDataSize, dataChunks, dataChunk, parityChunk, needsLock, needsUnlock );
 		case CBR_DATA:
 		default:
 			return false;
@@ -30,15 +30,20 @@ public:
 		uint32_t &stripeId, uint32_t chunkId, uint32_t splitOffset,
 		uint8_t *sealedCount, Metadata *sealed1, Metadata *sealed2,
 		Chunk **chunks, Chunk *dataChunk, Chunk *parityChunk,
-		GetChunkBuffer *getChunkBuffer
+		GetChunkBuffer *getChunkBuffer,
+		KeyMetadata *keyMetadata = 0 // Position of the object (data chunk buffers only)
 	);
 
 	// For DataChunkBuffer only
 	void init();
 	size_t seal( ServerWorker *worker );
+	uint32_t sealAged( ServerWorker *worker, uint64_t now, uint64_t maxAge );
+	uint64_t getOldest( int &index );
+	uint32_t sealAt( ServerWorker *worker, int index, uint64_t openedAt );
+	uint32_t getUnsealedSize();
 	bool reInsert( ServerWorker *worker, Chunk *chunk, uint32_t sizeToBeFreed, bool needsLock, bool needsUnlock );
 	// For ParityChunkBuffer only
-	bool seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk );
+	bool seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk, bool needsLock = true, bool needsUnlock = true );
 
 	inline uint32_t getChunkId() { return this->role == CBR_DATA ? this->buffer.data->getChunkId() : this->buffer.parity->getChunkId(); }
 
@@ -25,10 +25,19 @@ void ParityChunkWrapper::free() {
 ///////////////////////////////////////////////////////////////////////////////
 
 ParityChunkBuffer::ParityChunkBuffer( uint32_t count, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isReady ) : ChunkBuffer( isReady ) {
+	this->arenas = new StagingArena[ ChunkBuffer::dataChunkCount ];
+	for ( uint32_t i = 0; i < ChunkBuffer::dataChunkCount; i++ )
+		this->arenas[ i ].init( ChunkBuffer::capacity );
+	this->updates.init( ChunkBuffer::capacity );
+
 	if ( isReady )
 		this->init( listId, stripeId, chunkId );
 }
 
+ParityChunkBuffer::~ParityChunkBuffer() {
+	delete[] this->arenas;
+}
+
 void ParityChunkBuffer::init( uint32_t listId, uint32_t stripeId, uint32_t chunkId ) {
 	this->listId = listId;
 	this->stripeId = stripeId;
@@ -40,11 +49,15 @@ ParityChunkWrapper &ParityChunkBuffer::getWrapper( uint32_t stripeId, bool needs
 	std::unordered_map<uint32_t, ParityChunkWrapper>::iterator it = this->chunks.find( stripeId );
 	if ( it == this->chunks.end() ) {
 		ParityChunkWrapper wrapper;
-		wrapper.chunk = ChunkBuffer::chunkPool->alloc( this->listId, stripeId, this->chunkId );
-
-		ChunkBuffer::map->setChunk( this->listId, stripeId, this->chunkId, wrapper.chunk, true );
-		// Insert into the sealed map such that the coordinator knows the existence of the new parity chunk
-		ChunkBuffer::map->seal( this->listId, stripeId, this->chunkId );
+		// The parity chunk may be restored from a checkpoint
+		wrapper.chunk = ChunkBuffer::map->findChunkById( this->listId, stripeId, this->chunkId );
+		if ( ! wrapper.chunk ) {
+			wrapper.chunk = ChunkBuffer::chunkPool->alloc( this->listId, stripeId, this->chunkId );
+
+			ChunkBuffer::map->setChunk( this->listId, stripeId, this->chunkId, wrapper.chunk, true );
+			// Insert into the sealed map such that the coordinator knows the existence of the new parity chunk
+			ChunkBuffer::map->seal( this->listId, stripeId, this->chunkId );
+		}
 
 		this->chunks[ stripeId ] = wrapper;
 		it = this->chunks.find( stripeId );
@@ -63,8 +76,13 @@ bool ParityChunkBuffer::set(
 ) {
 	Key key;
 	std::unordered_map<Key, PendingRequest>::iterator it;
+	uint32_t splitSize = valueSize, objectSize;
 
-	bool isLarge = LargeObjectUtil::isLarge( keySize, valueSize );
+	bool isLarge = LargeObjectUtil::isLarge( keySize, valueSize, 0, &splitSize );
+	if ( isLarge && splitOffset + splitSize > valueSize )
+		splitSize = valueSize - splitOffset;
+	// Same size as the serialized object (see KeyValue::serialize())
+	objectSize = KEY_VALUE_METADATA_SIZE + keySize + ( isLarge ? SPLIT_OFFSET_SIZE : 0 ) + splitSize;
 	key.set( keySize, keyStr, 0, isLarge );
 
 	LOCK( &this->lock );
@@ -72,11 +90,23 @@ bool ParityChunkBuffer::set(
 	// Check whether the key is in a sealed chunk
 	it = this->pending.find( key );
 	if ( it == this->pending.end() ) {
-		// Store the key-value pair in a temporary buffer
+		// Store the key-value pair in the arena of the data chunk
 		KeyValue keyValue;
 		std::pair<std::unordered_map<Key, KeyValue>::iterator, bool> ret;
+		char *data;
 
-		keyValue.dup( keyStr, keySize, valueStr, valueSize, splitOffset );
+		if ( chunkId >= ChunkBuffer::dataChunkCount ) {
+			UNLOCK( &this->lock );
+			__ERROR__( "ParityChunkBuffer", "set", "Invalid data chunk ID: %u.", chunkId );
+			return false;
+		}
+		data = this->arenas[ chunkId ].alloc( objectSize );
+		if ( ! data ) {
+			UNLOCK( &this->lock );
+			return false;
+		}
+		keyValue.set( data, this->arenas + chunkId );
+		keyValue.serialize( keyStr, keySize, valueStr, valueSize, splitOffset );
 		keyValue.deserialize( keyStr, keySize, valueStr, valueSize, splitOffset );
 
 		key.set( keySize, keyStr, 0, isLarge );
@@ -85,14 +115,13 @@ bool ParityChunkBuffer::set(
 
 		ret = this->keys.insert( p );
 		if ( ! ret.second ) {
+			this->release( keyValue );
 			UNLOCK( &this->lock );
-			keyValue.free();
 			return false;
 		}
 	} else {
 		// Prepare data delta
 		char *data = ChunkUtil::getData( dataChunk );
-		ChunkUtil::clear( dataChunk );
 
 		key = it->first;
 		PendingRequest pendingRequest = it->second;
@@ -103,14 +132,18 @@ bool ParityChunkBuffer::set(
 		switch ( pendingRequest.type ) {
 			case PRT_SEAL:
 				// fprintf( stderr, "--- PRT_SEAL: Key = %.*s (%u, %u, %u) ---\n", keySize, keyStr, this->listId, pendingRequest.req.seal.stripeId, this->chunkId );
+				if ( pendingRequest.req.seal.offset + objectSize > ChunkUtil::chunkSize ) {
+					__ERROR__( "ParityChunkBuffer", "set", "The object (offset: %u, size: %u) does not fit into the chunk.", pendingRequest.req.seal.offset, objectSize );
+					break;
+				}
 				KeyValue::serialize( data + pendingRequest.req.seal.offset, keyStr, keySize, valueStr, valueSize, splitOffset );
 
 				// Update parity chunk
 				this->update(
 					pendingRequest.req.seal.stripeId, chunkId,
 					pendingRequest.req.seal.offset,
-					KEY_VALUE_METADATA_SIZE + keySize + valueSize,
-					dataChunks, dataChunk, parityChunk,
+					objectSize,
+					data + pendingRequest.req.seal.offset,
 					false, // needsLock
 					false, // needsUnlock
 					false, // isSeal
@@ -120,6 +153,8 @@ bool ParityChunkBuffer::set(
 				break;
 			case PRT_UPDATE:
 				fprintf( stderr, "--- TODO: PRT_UPDATE: Key = %.*s ---\n", keySize, keyStr );
+				if ( pendingRequest.req.update.buf )
+					this->updates.release( pendingRequest.req.update.buf );
 				break;
 			case PRT_DELETE:
 				fprintf( stderr, "--- TODO: PRT_DELETE: Key = %.*s ---\n", keySize, keyStr );
@@ -131,13 +166,15 @@ bool ParityChunkBuffer::set(
 	return true;
 }
 
-bool ParityChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk ) {
-	bool ret = true;
-	char *data = ChunkUtil::getData( dataChunk );
-	ChunkUtil::clear( dataChunk );
+void ParityChunkBuffer::release( KeyValue &keyValue ) {
+	( ( StagingArena * ) keyValue.ptr )->release( keyValue.data );
+	keyValue.clear();
+}
 
+bool ParityChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk, bool needsLock, bool needsUnlock ) {
+	bool ret = true;
 	uint8_t keySize;
-	uint32_t valueSize, offset, curPos = 0, numOfKeys = 0;
+	uint32_t valueSize, offset, numOfKeys = 0;
 	char *keyStr, *valueStr;
 	bool isLarge;
 	Key key;
@@ -145,7 +182,7 @@ bool ParityChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t coun
 	std::unordered_map<Key, KeyValue>::iterator it;
 	std::unordered_map<Key, PendingRequest>::iterator prtIt;
 
-	LOCK( &this->lock );
+	if ( needsLock ) LOCK( &this->lock );
 	while ( sealDataSize ) {
 		// Parse the (key, offset) record
 		keySize = sealData[ 0 ];
@@ -200,22 +237,26 @@ bool ParityChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t coun
 
 			bool isLarge = LargeObjectUtil::isLarge( keySize, valueSize, 0, &splitSize );
 
-			// Copy the key-value pair to the temporary data chunk
 			if ( isLarge ) {
 				if ( splitOffset + splitSize > valueSize )
 					splitSize = valueSize - splitOffset;
-				memcpy( data + offset, keyValue.data, KEY_VALUE_METADATA_SIZE + SPLIT_OFFSET_SIZE + keySize + splitSize );
-
-				curPos = offset + KEY_VALUE_METADATA_SIZE + SPLIT_OFFSET_SIZE + keySize + splitSize;
 			} else {
-				memcpy( data + offset, keyValue.data, KEY_VALUE_METADATA_SIZE + keySize + valueSize );
-
-				curPos = offset + KEY_VALUE_METADATA_SIZE + keySize + valueSize;
+				splitSize = valueSize;
 			}
 
+			// Fold the key-value pair into the parity chunk at its offset in the data chunk
+			this->update(
+				stripeId, chunkId,
+				offset,
+				KEY_VALUE_METADATA_SIZE + ( isLarge ? SPLIT_OFFSET_SIZE : 0 ) + keySize + splitSize,
+				keyValue.data,
+				false, false,
+				false, false
+			);
+
 			// Release memory
 			this->keys.erase( it );
-			keyValue.free();
+			this->release( keyValue );
 		}
 
 		// Update counter
@@ -224,14 +265,12 @@ bool ParityChunkBuffer::seal( uint32_t stripeId, uint32_t chunkId, uint32_t coun
 		numOfKeys++;
 	}
 	assert( numOfKeys == count );
-	this->update(
-		stripeId, chunkId,
-		0, curPos,
-		dataChunks, dataChunk, parityChunk,
-		false, false,
-		true, false
-	);
-	UNLOCK( &this->lock );
+
+	ParityChunkWrapper &wrapper = this->getWrapper( stripeId, false, false );
+	LOCK( &wrapper.lock );
+	wrapper.pending[ chunkId ] = false;
+	UNLOCK( &wrapper.lock );
+	if ( needsUnlock ) UNLOCK( &this->lock );
 
 	return ret;
 }
@@ -292,7 +331,7 @@ bool ParityChunkBuffer::deleteKey( char *keyStr, uint8_t keySize ) {
 	} else {
 		KeyValue keyValue = it->second;
 		this->keys.erase( it );
-		keyValue.free();
+		this->release( keyValue );
 	}
 
 	UNLOCK( &this->lock );
@@ -309,7 +348,11 @@ bool ParityChunkBuffer::updateKeyValue( char *keyStr, uint8_t keySize, bool isLa
 	it = this->keys.find( key );
 	if ( it == this->keys.end() ) {
 		PendingRequest pendingRequest;
-		pendingRequest.update( offset, length, valueUpdate );
+		char *buf = this->updates.alloc( length );
+
+		if ( buf )
+			memcpy( buf, valueUpdate, length );
+		pendingRequest.update( offset, length, buf );
 
 		key.dup( 0, 0, 0, isLarge );
 
@@ -319,6 +362,9 @@ bool ParityChunkBuffer::updateKeyValue( char *keyStr, uint8_t keySize, bool isLa
 		ret = this->pending.insert( p );
 		if ( ! ret.second ) {
 			// __ERROR__( "ParityChunkBuffer", "updateKeyValue", "Key: %.*s (size = %u) cannot be inserted into pending keys map.\n", keySize, keyStr, keySize );
+			if ( buf )
+				this->updates.release( buf );
+			key.free();
 		}
 		UNLOCK( &this->lock );
 		return false;
@@ -337,20 +383,8 @@ bool ParityChunkBuffer::updateKeyValue( char *keyStr, uint8_t keySize, bool isLa
 	return true;
 }
 
-bool ParityChunkBuffer::update( uint32_t stripeId, uint32_t chunkId, uint32_t offset, uint32_t size, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk, bool needsLock, bool needsUnlock, bool isSeal, bool isDelete, GetChunkBuffer *getChunkBuffer ) {
-	// Prepare the stripe
-	for ( uint32_t i = 0; i < ChunkBuffer::dataChunkCount; i++ )
-		dataChunks[ i ] = Coding::zeros;
-	dataChunks[ chunkId ] = dataChunk;
-
-	ChunkUtil::clear( parityChunk );
-
-	// Compute parity delta
-	ChunkBuffer::coding->encode(
-		dataChunks, parityChunk, this->chunkId - ChunkBuffer::dataChunkCount + 1,
-		offset + chunkId * ChunkBuffer::capacity,
-		offset + chunkId * ChunkBuffer::capacity + size
-	);
+bool ParityChunkBuffer::update( uint32_t stripeId, uint32_t chunkId, uint32_t offset, uint32_t size, char *dataDelta, bool needsLock, bool needsUnlock, bool isSeal, bool isDelete, GetChunkBuffer *getChunkBuffer ) {
+	uint32_t parityIndex = this->chunkId - ChunkBuffer::dataChunkCount + 1;
 
 	if ( needsLock ) LOCK( &this->lock );
 	ParityChunkWrapper &wrapper = this->getWrapper( stripeId, false, false );
@@ -369,12 +403,9 @@ bool ParityChunkBuffer::update( uint32_t stripeId, uint32_t chunkId, uint32_t of
 
 		if ( exists && backupChunk ) {
 			if ( sealIndicator[ chunkId ] ) {
-				char *parity = ChunkUtil::getData( backupChunk );
-				Coding::bitwiseXOR(
-					parity,
-					parity,
-					ChunkUtil::getData( backupChunk ),
-					ChunkBuffer::capacity
+				ChunkBuffer::coding->encodeDelta(
+					chunkId, dataDelta, offset, size,
+					parityIndex, backupChunk
 				);
 			}
 		}
@@ -383,14 +414,17 @@ bool ParityChunkBuffer::update( uint32_t stripeId, uint32_t chunkId, uint32_t of
 	}
 
 	LOCK( &wrapper.lock );
-	// Update the parity chunk
-	char *parity = ChunkUtil::getData( wrapper.chunk );
-	Coding::bitwiseXOR(
-		parity,
-		parity,
-		ChunkUtil::getData( parityChunk ),
-		ChunkBuffer::capacity
+	// Apply the parity delta on the parity chunk; the parity delta of some
+	// schemes is not aligned with the data delta
+	uint32_t parityOffset, parityLength;
+	ChunkBuffer::coding->getDeltaRange( chunkId, offset, size, parityIndex, parityOffset, parityLength );
+	ChunkBuffer::backup->preserve( wrapper.chunk, parityOffset, parityLength );
+	ChunkBuffer::snapshot->preserve( wrapper.chunk );
+	ChunkBuffer::coding->encodeDelta(
+		chunkId, dataDelta, offset, size,
+		parityIndex, wrapper.chunk
 	);
+	ChunkBuffer::chunkPool->setDirty( wrapper.chunk );
 	if ( isSeal )
 		wrapper.pending[ chunkId ] = false;
 	else if ( isDelete ) {
@@ -415,13 +449,9 @@ bool ParityChunkBuffer::update( uint32_t stripeId, uint32_t chunkId, uint32_t of
 }
 
 bool ParityChunkBuffer::update( uint32_t stripeId, uint32_t chunkId, uint32_t offset, uint32_t size, char *dataDelta, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk, bool isDelete ) {
-	// Prepare data delta
-	ChunkUtil::clear( dataChunk );
-	memcpy( ChunkUtil::getData( dataChunk ) + offset, dataDelta, size );
 	return this->update(
 		stripeId, chunkId,
-		offset, size,
-		dataChunks, dataChunk, parityChunk,
+		offset, size, dataDelta,
 		true,     // needsLock
 		true,     // needsUnlock
 		false,    // isSeal
@@ -451,14 +481,20 @@ void ParityChunkBuffer::print( FILE *f ) {
 	int width = 16;
 	int numPending = 0;
 	double occupied;
+	size_t staging = this->updates.getMemoryUsage();
+
+	for ( uint32_t i = 0; i < ChunkBuffer::dataChunkCount; i++ )
+		staging += this->arenas[ i ].getMemoryUsage();
 
 	fprintf(
 		f,
 		"- %-*s : %s\n"
 		"- %-*s : %u\n"
+		"- %-*s : %lu bytes (%lu keys)\n"
 		"- %-*s :\n",
 		width, "Role", "Dummy Data chunk buffer",
 		width, "Chunk size", ChunkBuffer::capacity,
+		width, "Unsealed", staging, this->keys.size(),
 		width, "Statistics (occupied / total)"
 	);
 	for (
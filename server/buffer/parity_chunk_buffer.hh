@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include "chunk_buffer.hh"
 #include "get_chunk_buffer.hh"
+#include "../ds/staging_arena.hh"
 #include "../../common/ds/bitmask_array.hh"
 
 class ParityChunkWrapper {
@@ -42,12 +43,12 @@ public:
 		this->req.seal.offset = offset;
 	}
 
+	// The update is not copied
 	void update( uint32_t offset, uint32_t length, char *update ) {
 		this->type = PRT_UPDATE;
 		this->req.update.offset = offset;
 		this->req.update.length = length;
-		this->req.update.buf = new char[ length ];
-		memcpy( this->req.update.buf, update, length );
+		this->req.update.buf = update;
 	}
 
 	void del() {
@@ -68,15 +69,22 @@ private:
 
 	// Map stripe ID to ParityChunk objects
 	std::unordered_map<uint32_t, ParityChunkWrapper> chunks;
-	// Temporary map that stores the not-yet-sealed key-value pairs
+	// Temporary map that stores the not-yet-sealed key-value pairs; both the
+	// key and the value point to the arena of the data chunk (KeyValue::ptr)
 	std::unordered_map<Key, KeyValue> keys;
+	// Not-yet-sealed key-value pairs, appended in the order that the data
+	// server appends them to its chunks (indexed by data chunk ID)
+	StagingArena *arenas;
 	// Store the request that update the not-yet-received keys
 	std::unordered_map<Key, PendingRequest> pending;
+	// Value updates in the pending requests
+	StagingArena updates;
+
+	void release( KeyValue &keyValue );
 
 	bool update(
 		uint32_t stripeId, uint32_t chunkId,
-		uint32_t offset, uint32_t size,
-		Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk,
+		uint32_t offset, uint32_t size, char *dataDelta,
 		bool needsLock = true, bool needsUnlock = true,
 		bool isSeal = false, bool isDelete = false,
 		GetChunkBuffer *getChunkBuffer = 0
@@ -84,10 +92,13 @@ private:
 
 public:
 	ParityChunkBuffer( uint32_t count, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isReady );
+	~ParityChunkBuffer();
 	void init( uint32_t listId, uint32_t stripeId, uint32_t chunkId );
 	ParityChunkWrapper &getWrapper( uint32_t stripeId, bool needsLock = true, bool needsUnlock = true );
 
 	inline uint32_t getChunkId() { return this->chunkId; }
+	// Data chunk ID of a not-yet-sealed key-value pair (see getKeyValueMap())
+	inline uint32_t getDataChunkId( KeyValue &keyValue ) { return ( StagingArena * ) keyValue.ptr - this->arenas; }
 
 	bool set(
 		char *key, uint8_t keySize,
@@ -97,7 +108,7 @@ public:
 		GetChunkBuffer *getChunkBuffer
 	);
 
-	bool seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk );
+	bool seal( uint32_t stripeId, uint32_t chunkId, uint32_t count, char *sealData, size_t sealDataSize, Chunk **dataChunks, Chunk *dataChunk, Chunk *parityChunk, bool needsLock = true, bool needsUnlock = true );
 
 	bool findValueByKey( char *data, uint8_t size, bool isLarge, KeyValue *keyValuePtr, Key *keyPtr = 0 );
 	void getKeyValueMap( std::unordered_map<Key, KeyValue> *&map, LOCK_T *&lock );
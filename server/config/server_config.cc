@@ -5,7 +5,32 @@
 ServerConfig::ServerConfig() {
 	this->pool.chunks = 1073741824; // 1 GB
 	this->buffer.chunksPerList = 5;
+	this->seal.batchCount = 0;
+	this->seal.batchSize = 0;
+	this->seal.batchTimeout = 1000;
+	this->seal.maxAge = 0;
+	this->seal.maxUnsealedSize = 0;
+	this->seal.checkInterval = 100;
+	this->delta.bufferSize = 0;
+	this->delta.flushInterval = 1000;
 	this->storage.type = STORAGE_TYPE_LOCAL;
+	this->storage.segmentSize = 268435456; // 256 MB
+	this->storage.writeBufferSize = 4194304; // 4 MB
+	this->storage.syncInterval = 1000;
+	this->storage.direct = false;
+	this->io.threads = 0;
+	this->io.queueDepth = 1024;
+	this->checkpoint.enabled = false;
+	this->checkpoint.threads = 4;
+	this->wal.enabled = false;
+	this->wal.batchSize = 1048576; // 1 MB
+	this->wal.commitInterval = 500;
+	this->wal.segmentSize = 67108864; // 64 MB
+	this->wal.maxSize = 1073741824; // 1 GB
+	this->repair.pipelined = false;
+	this->repair.sliceSize = 4096;
+	this->coding.threads = 0;
+	this->coding.splitSize = 0;
 }
 
 bool ServerConfig::parse( const char *path ) {
@@ -25,19 +50,92 @@ bool ServerConfig::set( const char *section, const char *name, const char *value
 			this->buffer.chunksPerList = atoi( value );
 		else
 			return false;
+	} else if ( match( section, "seal" ) ) {
+		if ( match( name, "batch_count" ) )
+			this->seal.batchCount = atoi( value );
+		else if ( match( name, "batch_size" ) )
+			this->seal.batchSize = atoi( value );
+		else if ( match( name, "batch_timeout" ) )
+			this->seal.batchTimeout = atoi( value );
+		else if ( match( name, "max_age" ) )
+			this->seal.maxAge = atoi( value );
+		else if ( match( name, "max_unsealed_size" ) )
+			this->seal.maxUnsealedSize = atoll( value );
+		else if ( match( name, "check_interval" ) )
+			this->seal.checkInterval = atoi( value );
+		else
+			return false;
+	} else if ( match( section, "delta" ) ) {
+		if ( match( name, "buffer_size" ) )
+			this->delta.bufferSize = atoi( value );
+		else if ( match( name, "flush_interval" ) )
+			this->delta.flushInterval = atoi( value );
+		else
+			return false;
 	} else if ( match( section, "storage" ) ) {
 		if ( match( name, "type" ) ) {
 			if ( match( value, "local" ) )
 				this->storage.type = STORAGE_TYPE_LOCAL;
+			else if ( match( value, "segment" ) )
+				this->storage.type = STORAGE_TYPE_SEGMENT;
 			else
 				this->storage.type = STORAGE_TYPE_UNDEFINED;
 		} else if ( match( name, "path" ) ) {
 			if ( strlen( value ) >= STORAGE_PATH_MAX )
 				return false;
 			strncpy( this->storage.path, value, STORAGE_PATH_MAX );
+		} else if ( match( name, "segment_size" ) ) {
+			this->storage.segmentSize = atoll( value );
+		} else if ( match( name, "write_buffer_size" ) ) {
+			this->storage.writeBufferSize = atoi( value );
+		} else if ( match( name, "sync_interval" ) ) {
+			this->storage.syncInterval = atoi( value );
+		} else if ( match( name, "direct" ) ) {
+			this->storage.direct = match( value, "true" );
 		} else {
 			return false;
 		}
+	} else if ( match( section, "io" ) ) {
+		if ( match( name, "threads" ) )
+			this->io.threads = atoi( value );
+		else if ( match( name, "queue_depth" ) )
+			this->io.queueDepth = atoi( value );
+		else
+			return false;
+	} else if ( match( section, "checkpoint" ) ) {
+		if ( match( name, "enabled" ) )
+			this->checkpoint.enabled = match( value, "true" );
+		else if ( match( name, "threads" ) )
+			this->checkpoint.threads = atoi( value );
+		else
+			return false;
+	} else if ( match( section, "wal" ) ) {
+		if ( match( name, "enabled" ) )
+			this->wal.enabled = match( value, "true" );
+		else if ( match( name, "batch_size" ) )
+			this->wal.batchSize = atoi( value );
+		else if ( match( name, "commit_interval" ) )
+			this->wal.commitInterval = atoi( value );
+		else if ( match( name, "segment_size" ) )
+			this->wal.segmentSize = atoll( value );
+		else if ( match( name, "max_size" ) )
+			this->wal.maxSize = atoll( value );
+		else
+			return false;
+	} else if ( match( section, "repair" ) ) {
+		if ( match( name, "pipelined" ) )
+			this->repair.pipelined = match( value, "true" );
+		else if ( match( name, "slice_size" ) )
+			this->repair.sliceSize = atoi( value );
+		else
+			return false;
+	} else if ( match( section, "coding" ) ) {
+		if ( match( name, "threads" ) )
+			this->coding.threads = atoi( value );
+		else if ( match( name, "split_size" ) )
+			this->coding.splitSize = atoi( value );
+		else
+			return false;
 	} else {
 		return false;
 	}
@@ -54,9 +152,33 @@ bool ServerConfig::validate() {
 	if ( this->buffer.chunksPerList < 1 )
 		CFG_PARSE_ERROR( "ServerConfig", "The number of temporary chunks per stripe list should be at least 1." );
 
+	if ( this->seal.batchCount && this->seal.batchTimeout < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The timeout for batching SEAL_CHUNK requests should be greater than 0." );
+
+	if ( ( this->seal.maxAge || this->seal.maxUnsealedSize ) && this->seal.checkInterval < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The interval for checking the chunks to be sealed in background should be greater than 0." );
+
+	if ( this->delta.bufferSize && this->delta.flushInterval < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The interval for flushing the buffered parity deltas should be greater than 0." );
+
+	if ( this->io.threads && this->io.queueDepth < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The queue depth of the I/O workers should be at least 1." );
+
+	if ( this->checkpoint.enabled && this->checkpoint.threads < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The number of threads for restoring checkpoints should be at least 1." );
+
+	if ( this->wal.enabled && this->wal.batchSize < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The batch size of the write-ahead log should be greater than 0." );
+
+	if ( this->wal.enabled && this->wal.segmentSize < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The segment size of the write-ahead log should be greater than 0." );
+
+	if ( this->repair.pipelined && this->repair.sliceSize < 1 )
+		CFG_PARSE_ERROR( "ServerConfig", "The slice size for pipelined repair should be greater than 0." );
+
 	if ( this->storage.type == STORAGE_TYPE_UNDEFINED ) {
 		CFG_PARSE_ERROR( "ServerConfig", "The specified storage type is invalid." );
-	} else if ( this->storage.type == STORAGE_TYPE_LOCAL ) {
+	} else if ( this->storage.type == STORAGE_TYPE_LOCAL || this->storage.type == STORAGE_TYPE_SEGMENT ) {
 		struct stat st;
 		while ( stat( this->storage.path, &st ) != 0 ) {
 			__INFO__( YELLOW, "ServerConfig", "validate", "The specified storage path does not exist. Creating the directory..." );
@@ -67,6 +189,9 @@ bool ServerConfig::validate() {
 
 		if ( ! S_ISDIR( st.st_mode ) )
 			CFG_PARSE_ERROR( "ServerConfig", "The specified storage path is not a directory." );
+
+		if ( this->storage.type == STORAGE_TYPE_SEGMENT && this->storage.segmentSize < 1 )
+			CFG_PARSE_ERROR( "ServerConfig", "The size of storage segments should be greater than 0." );
 	}
 
 	return true;
@@ -99,13 +224,72 @@ void ServerConfig::print( FILE *f ) {
 		"\t- %-*s : %lu\n"
 		"- Buffer\n"
 		"\t- %-*s : %u\n"
+		"- Seal\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u us\n"
+		"\t- %-*s : %u ms\n"
+		"\t- %-*s : %lu\n"
+		"\t- %-*s : %u ms\n"
+		"- Delta\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u us\n"
 		"- Storage\n"
 		"\t- %-*s : %s\n"
-		"\t- %-*s : %s\n",
+		"\t- %-*s : %s\n"
+		"\t- %-*s : %lu\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u ms\n"
+		"\t- %-*s : %s\n"
+		"- I/O\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u\n"
+		"- Checkpoint\n"
+		"\t- %-*s : %s\n"
+		"\t- %-*s : %u\n"
+		"- Write-ahead log\n"
+		"\t- %-*s : %s\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u us\n"
+		"\t- %-*s : %lu\n"
+		"\t- %-*s : %lu\n"
+		"- Repair\n"
+		"\t- %-*s : %s\n"
+		"\t- %-*s : %u\n"
+		"- Coding\n"
+		"\t- %-*s : %u\n"
+		"\t- %-*s : %u\n",
 		width, "Chunks", this->pool.chunks,
 		width, "Chunks per list", this->buffer.chunksPerList,
-		width, "Type", this->storage.type == STORAGE_TYPE_LOCAL ? "Local" : "Undefined",
-		width, "Path", this->storage.path
+		width, "Batch count", this->seal.batchCount,
+		width, "Batch size", this->seal.batchSize,
+		width, "Batch timeout", this->seal.batchTimeout,
+		width, "Max age", this->seal.maxAge,
+		width, "Max unsealed size", this->seal.maxUnsealedSize,
+		width, "Check interval", this->seal.checkInterval,
+		width, "Buffer size", this->delta.bufferSize,
+		width, "Flush interval", this->delta.flushInterval,
+		width, "Type", this->storage.type == STORAGE_TYPE_LOCAL ? "Local" : (
+			this->storage.type == STORAGE_TYPE_SEGMENT ? "Segment" : "Undefined"
+		),
+		width, "Path", this->storage.path,
+		width, "Segment size", this->storage.segmentSize,
+		width, "Write buffer size", this->storage.writeBufferSize,
+		width, "Sync interval", this->storage.syncInterval,
+		width, "Direct I/O", this->storage.direct ? "true" : "false",
+		width, "Threads", this->io.threads,
+		width, "Queue depth", this->io.queueDepth,
+		width, "Enabled", this->checkpoint.enabled ? "true" : "false",
+		width, "Threads", this->checkpoint.threads,
+		width, "Enabled", this->wal.enabled ? "true" : "false",
+		width, "Batch size", this->wal.batchSize,
+		width, "Commit interval", this->wal.commitInterval,
+		width, "Segment size", this->wal.segmentSize,
+		width, "Maximum size", this->wal.maxSize,
+		width, "Pipelined", this->repair.pipelined ? "true" : "false",
+		width, "Slice size", this->repair.sliceSize,
+		width, "Threads", this->coding.threads,
+		width, "Split size", this->coding.splitSize
 	);
 	fprintf( f, "\n" );
 }
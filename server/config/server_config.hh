@@ -19,10 +19,49 @@ public:
 	struct {
 		uint32_t chunksPerList;
 	} buffer;
+	struct {
+		uint32_t batchCount;
+		uint32_t batchSize;
+		uint32_t batchTimeout;
+		uint32_t maxAge;
+		uint64_t maxUnsealedSize;
+		uint32_t checkInterval;
+	} seal;
+	struct {
+		uint32_t bufferSize;
+		uint32_t flushInterval;
+	} delta;
 	struct {
 		StorageType type;
 		char path[ STORAGE_PATH_MAX ];
+		uint64_t segmentSize;
+		uint32_t writeBufferSize;
+		uint32_t syncInterval;
+		bool direct;
 	} storage;
+	struct {
+		uint32_t threads;
+		uint32_t queueDepth;
+	} io;
+	struct {
+		bool enabled;
+		uint32_t threads;
+	} checkpoint;
+	struct {
+		bool enabled;
+		uint32_t batchSize;
+		uint32_t commitInterval;
+		uint64_t segmentSize;
+		uint64_t maxSize;
+	} wal;
+	struct {
+		bool pipelined;
+		uint32_t sliceSize;
+	} repair;
+	struct {
+		uint32_t threads;
+		uint32_t splitSize;
+	} coding;
 
 	ServerConfig();
 	bool parse( const char *path );
@@ -0,0 +1,388 @@
+#include <cerrno>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "checkpoint.hh"
+#include "../../common/util/debug.hh"
+#include "../../common/util/time.hh"
+
+struct CheckpointLoader {
+	ChunkPool *chunkPool;
+	Map *map;
+	char *records;
+	uint32_t from;
+	uint32_t to;
+	uint32_t chunkCount;  // Records at or after chunkCount are unsealed
+	Chunk **unsealed;
+	bool success;
+	bool isThread;
+};
+
+Checkpoint::Checkpoint() {
+	this->path[ 0 ] = '\0';
+	this->threads = 1;
+	this->image = 0;
+	this->imageSize = 0;
+	this->isEnabled = false;
+}
+
+void Checkpoint::init( const char *dir, bool isEnabled, uint32_t threads ) {
+	snprintf( this->path, sizeof( this->path ), "%s/%s", dir, CHECKPOINT_FILE_NAME );
+	this->isEnabled = isEnabled;
+	this->threads = threads ? threads : 1;
+}
+
+bool Checkpoint::save( ChunkPool *chunkPool, Map *map, std::vector<MixedChunkBuffer *> &chunkBuffer ) {
+	char tmpPath[ sizeof( this->path ) + 4 ];
+	struct CheckpointHeader header;
+	std::vector<Chunk *> unsealed;
+	struct timespec startTime = start_timer();
+	uint32_t total, listId, stripeId, chunkId;
+	std::atomic<unsigned int> count;
+	char *startAddress;
+	Chunk *chunk;
+	FILE *f;
+	bool ret = true;
+
+	snprintf( tmpPath, sizeof( tmpPath ), "%s.tmp", this->path );
+	f = fopen( tmpPath, "wb" );
+	if ( ! f ) {
+		__ERROR__( "Checkpoint", "save", "fopen(): %s", strerror( errno ) );
+		return false;
+	}
+	setvbuf( f, 0, _IOFBF, 4 * ( CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize ) );
+
+	Checkpoint::initHeader( header );
+	// Written again after the counts are known
+	ret = fwrite( &header, CHECKPOINT_HEADER_SIZE, 1, f ) == 1;
+
+	/* Sealed chunks */
+	chunkPool->exportVars( &total, &count, &startAddress );
+	for ( uint32_t i = 0; ret && i < count && i < total; i++ ) {
+		chunk = ( Chunk * )( startAddress + ( uint64_t ) i * ( CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize ) );
+		ChunkUtil::get( chunk, listId, stripeId, chunkId );
+		// Skip the chunks that are not (or no longer) indexed
+		if ( map->findChunkById( listId, stripeId, chunkId ) != chunk )
+			continue;
+
+		if ( ! ChunkUtil::isParity( chunk ) && listId < chunkBuffer.size() && chunkBuffer[ listId ] ) {
+			int index = chunkBuffer[ listId ]->lockChunk( chunk );
+			if ( index != -1 ) {
+				chunkBuffer[ listId ]->unlock( index );
+				unsealed.push_back( chunk );
+				continue;
+			}
+		}
+
+		ret = fwrite( chunk, CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize, 1, f ) == 1;
+		header.chunkCount++;
+	}
+
+	/* Unsealed data chunks (with the objects replicated at the parity servers) */
+	for ( size_t i = 0, size = unsealed.size(); ret && i < size; i++ ) {
+		ret = fwrite( unsealed[ i ], CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize, 1, f ) == 1;
+		header.unsealedCount++;
+	}
+
+	/* Replicas of the unsealed objects of the data servers */
+	if ( ret )
+		ret = Checkpoint::saveStaged( f, chunkBuffer, header );
+
+	if ( ret ) {
+		ret = (
+			fseek( f, 0, SEEK_SET ) == 0 &&
+			fwrite( &header, CHECKPOINT_HEADER_SIZE, 1, f ) == 1 &&
+			fflush( f ) == 0 &&
+			fdatasync( fileno( f ) ) == 0
+		);
+	}
+	if ( ! ret )
+		__ERROR__( "Checkpoint", "save", "Cannot write to %s: %s", tmpPath, strerror( errno ) );
+	if ( fclose( f ) != 0 )
+		ret = false;
+
+	// Replace the previous image only if the new one is complete
+	if ( ret && rename( tmpPath, this->path ) != 0 ) {
+		__ERROR__( "Checkpoint", "save", "rename(): %s", strerror( errno ) );
+		ret = false;
+	}
+	if ( ! ret ) {
+		unlink( tmpPath );
+		return false;
+	}
+
+	__INFO__(
+		GREEN, "Checkpoint", "save",
+		"Saved %u sealed chunks, %u unsealed chunks and %u staged objects in %.3lf s.",
+		header.chunkCount, header.unsealedCount, header.stagedCount, get_elapsed_time( startTime )
+	);
+	return true;
+}
+
+void Checkpoint::initHeader( struct CheckpointHeader &header ) {
+	header.magic = CHECKPOINT_MAGIC;
+	header.version = CHECKPOINT_VERSION;
+	header.chunkSize = ChunkUtil::chunkSize;
+	header.dataChunkCount = ChunkUtil::dataChunkCount;
+	header.chunkCount = 0;
+	header.unsealedCount = 0;
+	header.stagedCount = 0;
+	header.stagedSize = 0;
+}
+
+bool Checkpoint::saveStaged( FILE *f, std::vector<MixedChunkBuffer *> &chunkBuffer, struct CheckpointHeader &header ) {
+	struct CheckpointStagedObject stagedObject;
+	std::unordered_map<Key, KeyValue> *keys;
+	std::unordered_map<Key, KeyValue>::iterator it;
+	ParityChunkBuffer *parityChunkBuffer;
+	uint32_t size;
+	LOCK_T *lock;
+	bool ret = true;
+
+	for ( uint32_t listId = 0; ret && listId < chunkBuffer.size(); listId++ ) {
+		if ( ! chunkBuffer[ listId ] || chunkBuffer[ listId ]->role != CBR_PARITY )
+			continue;
+		parityChunkBuffer = chunkBuffer[ listId ]->buffer.parity;
+
+		parityChunkBuffer->getKeyValueMap( keys, lock );
+		LOCK( lock );
+		for ( it = keys->begin(); ret && it != keys->end(); it++ ) {
+			stagedObject.listId = listId;
+			stagedObject.chunkId = parityChunkBuffer->getDataChunkId( it->second );
+			size = it->second.getSize();
+			ret = (
+				fwrite( &stagedObject, CHECKPOINT_STAGED_OBJECT_SIZE, 1, f ) == 1 &&
+				fwrite( it->second.data, size, 1, f ) == 1
+			);
+			header.stagedCount++;
+			header.stagedSize += CHECKPOINT_STAGED_OBJECT_SIZE + size;
+		}
+		UNLOCK( lock );
+	}
+	return ret;
+}
+
+void *Checkpoint::run( void *argv ) {
+	struct CheckpointLoader *loader = ( struct CheckpointLoader * ) argv;
+	uint32_t recordSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize;
+	uint32_t listId, stripeId, chunkId;
+	Chunk *record, *chunk;
+
+	for ( uint32_t i = loader->from; i < loader->to; i++ ) {
+		record = ( Chunk * )( loader->records + ( uint64_t ) i * recordSize );
+		ChunkUtil::get( record, listId, stripeId, chunkId );
+
+		chunk = loader->chunkPool->alloc( listId, stripeId, chunkId );
+		if ( ! chunk ) {
+			__ERROR__( "Checkpoint", "run", "The chunk pool is full." );
+			loader->success = false;
+			break;
+		}
+		memcpy( ChunkUtil::getData( chunk ), ChunkUtil::getData( record ), ChunkUtil::chunkSize );
+		// The storage may not have the restored contents
+		loader->chunkPool->setDirty( chunk );
+
+		// Rebuild the key and chunk indexes and the stripe ID set
+		loader->map->setChunk( listId, stripeId, chunkId, chunk, ChunkUtil::isParity( chunk ) );
+
+		if ( i >= loader->chunkCount )
+			loader->unsealed[ i - loader->chunkCount ] = chunk;
+	}
+
+	return 0;
+}
+
+bool Checkpoint::load( ChunkPool *chunkPool, Map *map ) {
+	struct CheckpointHeader *header;
+	struct CheckpointLoader *loaders;
+	struct CheckpointStagedObject *stagedObject;
+	struct timespec startTime = start_timer();
+	uint64_t recordSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize;
+	uint32_t threads, recordCount, chunksPerThread, listId, stripeId, chunkId;
+	Chunk **unsealed;
+	pthread_t *tids;
+	struct stat st;
+	char *image, *ptr, *end;
+	int fd;
+	bool ret = true;
+
+	fd = open( this->path, O_RDONLY );
+	if ( fd == -1 ) {
+		if ( errno != ENOENT )
+			__ERROR__( "Checkpoint", "load", "open(): %s", strerror( errno ) );
+		return false;
+	}
+	if ( fstat( fd, &st ) != 0 || ( size_t ) st.st_size < CHECKPOINT_HEADER_SIZE ) {
+		__ERROR__( "Checkpoint", "load", "The checkpoint image is truncated." );
+		close( fd );
+		return false;
+	}
+	image = ( char * ) mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0 );
+	close( fd );
+	if ( image == MAP_FAILED ) {
+		__ERROR__( "Checkpoint", "load", "mmap(): %s", strerror( errno ) );
+		return false;
+	}
+
+	header = ( struct CheckpointHeader * ) image;
+	recordCount = header->chunkCount + header->unsealedCount;
+	if (
+		header->magic != CHECKPOINT_MAGIC ||
+		header->version != CHECKPOINT_VERSION ||
+		header->chunkSize != ChunkUtil::chunkSize ||
+		header->dataChunkCount != ChunkUtil::dataChunkCount ||
+		( uint64_t ) st.st_size != CHECKPOINT_HEADER_SIZE + recordCount * recordSize + header->stagedSize
+	) {
+		__ERROR__( "Checkpoint", "load", "The checkpoint image does not match with the current configuration." );
+		munmap( image, st.st_size );
+		return false;
+	}
+
+	// Each thread restores a contiguous range of chunks
+	unsealed = new Chunk*[ header->unsealedCount ];
+	threads = recordCount < this->threads ? recordCount : this->threads;
+	chunksPerThread = threads ? ( recordCount + threads - 1 ) / threads : 0;
+	tids = new pthread_t[ threads ];
+	loaders = new struct CheckpointLoader[ threads ];
+	for ( uint32_t i = 0; i < threads; i++ ) {
+		loaders[ i ].chunkPool = chunkPool;
+		loaders[ i ].map = map;
+		loaders[ i ].records = image + CHECKPOINT_HEADER_SIZE;
+		loaders[ i ].from = i * chunksPerThread;
+		loaders[ i ].to = ( i + 1 ) * chunksPerThread;
+		if ( loaders[ i ].to > recordCount )
+			loaders[ i ].to = recordCount;
+		loaders[ i ].chunkCount = header->chunkCount;
+		loaders[ i ].unsealed = unsealed;
+		loaders[ i ].success = true;
+		loaders[ i ].isThread = pthread_create( tids + i, NULL, Checkpoint::run, ( void * ) ( loaders + i ) ) == 0;
+		if ( ! loaders[ i ].isThread ) {
+			__ERROR__( "Checkpoint", "load", "Cannot start loader thread. Restoring in the current thread..." );
+			Checkpoint::run( loaders + i );
+		}
+	}
+	for ( uint32_t i = 0; i < threads; i++ ) {
+		if ( loaders[ i ].isThread )
+			pthread_join( tids[ i ], 0 );
+		ret = ret && loaders[ i ].success;
+	}
+	delete[] tids;
+	delete[] loaders;
+
+	if ( ret ) {
+		// Hand the unsealed data chunks to the data chunk buffers
+		for ( uint32_t i = 0; i < header->unsealedCount; i++ ) {
+			ChunkUtil::get( unsealed[ i ], listId, stripeId, chunkId );
+			this->unsealed[ listId ].push_back( unsealed[ i ] );
+		}
+
+		// Index the staged objects for the parity chunk buffers
+		ptr = image + CHECKPOINT_HEADER_SIZE + recordCount * recordSize;
+		end = image + st.st_size;
+		for ( uint32_t i = 0; i < header->stagedCount; i++ ) {
+			stagedObject = ( struct CheckpointStagedObject * ) ptr;
+			ptr += CHECKPOINT_STAGED_OBJECT_SIZE;
+			if ( ptr + KEY_VALUE_METADATA_SIZE > end || ptr + KeyValue::getSize( ptr ) > end ) {
+				__ERROR__( "Checkpoint", "load", "The staged object #%u is truncated.", i );
+				ret = false;
+				break;
+			}
+			this->staged[ stagedObject->listId ].push_back( stagedObject );
+			ptr += KeyValue::getSize( ptr );
+		}
+	}
+	delete[] unsealed;
+
+	__INFO__(
+		GREEN, "Checkpoint", "load",
+		"Restored %u sealed chunks and %u unsealed chunks with %u threads in %.3lf s.",
+		header->chunkCount, header->unsealedCount, threads, get_elapsed_time( startTime )
+	);
+
+	this->image = image;
+	this->imageSize = st.st_size;
+	if ( ! ret )
+		this->release();
+	return ret;
+}
+
+uint32_t Checkpoint::getUnsealedCount( uint32_t listId ) {
+	std::unordered_map<uint32_t, std::vector<Chunk *>>::iterator it = this->unsealed.find( listId );
+	return it == this->unsealed.end() ? 0 : it->second.size();
+}
+
+uint32_t Checkpoint::restore( uint32_t listId, DataChunkBuffer *dataChunkBuffer ) {
+	std::unordered_map<uint32_t, std::vector<Chunk *>>::iterator it = this->unsealed.find( listId );
+	uint32_t count = 0;
+
+	if ( it == this->unsealed.end() )
+		return 0;
+	for ( size_t i = 0, size = it->second.size(); i < size; i++ ) {
+		if ( dataChunkBuffer->restore( it->second[ i ] ) )
+			count++;
+		else
+			__ERROR__( "Checkpoint", "restore", "The data chunk buffer of list #%u is full.", listId );
+	}
+	this->unsealed.erase( it );
+	return count;
+}
+
+uint32_t Checkpoint::restore( uint32_t listId, ParityChunkBuffer *parityChunkBuffer ) {
+	std::unordered_map<uint32_t, std::vector<struct CheckpointStagedObject *>>::iterator it = this->staged.find( listId );
+	char *keyStr, *valueStr;
+	uint8_t keySize;
+	uint32_t valueSize, splitOffset, count = 0;
+
+	if ( it == this->staged.end() )
+		return 0;
+	for ( size_t i = 0, size = it->second.size(); i < size; i++ ) {
+		KeyValue::deserialize(
+			( char * ) it->second[ i ] + CHECKPOINT_STAGED_OBJECT_SIZE,
+			keyStr, keySize, valueStr, valueSize, splitOffset
+		);
+		// There are no pending requests before the server starts
+		if ( parityChunkBuffer->set(
+			keyStr, keySize, valueStr, valueSize,
+			it->second[ i ]->chunkId, splitOffset,
+			0, 0, 0, 0
+		) )
+			count++;
+		else
+			__ERROR__( "Checkpoint", "restore", "Cannot stage the object (key: %.*s) of list #%u.", keySize, keyStr, listId );
+	}
+	this->staged.erase( it );
+	return count;
+}
+
+void Checkpoint::setUnsealed( Chunk *chunk, bool isUnsealed ) {
+	std::vector<Chunk *> &chunks = this->unsealed[ ChunkUtil::getListId( chunk ) ];
+	std::vector<Chunk *>::iterator it = std::find( chunks.begin(), chunks.end(), chunk );
+
+	if ( isUnsealed && it == chunks.end() )
+		chunks.push_back( chunk );
+	else if ( ! isUnsealed && it != chunks.end() )
+		chunks.erase( it );
+}
+
+void Checkpoint::release( bool keepImage ) {
+	if ( ! this->image )
+		return;
+
+	if ( ! this->unsealed.empty() || ! this->staged.empty() )
+		__ERROR__( "Checkpoint", "release", "The unsealed state of %lu lists is not restored.", this->unsealed.size() + this->staged.size() );
+	this->unsealed.clear();
+	this->staged.clear();
+
+	munmap( this->image, this->imageSize );
+	this->image = 0;
+	this->imageSize = 0;
+
+	// The image is stale once the server modifies the chunks
+	if ( ! keepImage && unlink( this->path ) != 0 )
+		__ERROR__( "Checkpoint", "release", "unlink(): %s", strerror( errno ) );
+}
@@ -0,0 +1,90 @@
+#ifndef __SERVER_DS_CHECKPOINT_HH__
+#define __SERVER_DS_CHECKPOINT_HH__
+
+#include <vector>
+#include <cstdio>
+#include <unordered_map>
+#include <stdint.h>
+#include "map.hh"
+#include "../buffer/mixed_chunk_buffer.hh"
+#include "../../common/config/config.hh"
+#include "../../common/ds/chunk_pool.hh"
+
+#define CHECKPOINT_MAGIC      0x4b504843 // "CHPK"
+#define CHECKPOINT_VERSION    2
+#define CHECKPOINT_FILE_NAME  "checkpoint"
+
+struct CheckpointHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t chunkSize;
+	uint32_t dataChunkCount;
+	uint32_t chunkCount;    // Number of sealed chunks
+	uint32_t unsealedCount; // Number of unsealed data chunks (after the sealed chunks)
+	uint32_t stagedCount;   // Number of unsealed objects replicated at this parity server
+	uint64_t stagedSize;    // Number of bytes of the staged object records
+} __attribute__((__packed__));
+
+#define CHECKPOINT_HEADER_SIZE sizeof( struct CheckpointHeader )
+
+// Followed by the serialized key-value pair (see KeyValue::serialize())
+struct CheckpointStagedObject {
+	uint8_t listId;
+	uint8_t chunkId; // Data chunk ID
+} __attribute__((__packed__));
+
+#define CHECKPOINT_STAGED_OBJECT_SIZE sizeof( struct CheckpointStagedObject )
+
+/**
+ * Image of the chunks of a server for restarting without reconstructing
+ * them from the peers. It is written when the server stops (after the
+ * workers exit, so the image is consistent) and consumed by the next
+ * start, which maps the image and rebuilds the key, chunk and stripe ID
+ * indexes of the map with multiple threads.
+ *
+ * The unsealed state is kept as well, as the parity servers only fold the
+ * objects of a data chunk into the parity when it is sealed: the open data
+ * chunks are handed back to the data chunk buffers, which seal them later
+ * as usual, and the replicas of the unsealed objects at a parity server
+ * are staged again for the SEAL_CHUNK requests that follow.
+ */
+class Checkpoint {
+private:
+	char path[ STORAGE_PATH_MAX + sizeof( CHECKPOINT_FILE_NAME ) + 1 ];
+	uint32_t threads;
+	// The loaded image is kept until the chunk buffers take the unsealed state
+	char *image;
+	size_t imageSize;
+	// List ID |-> Restored unsealed data chunks
+	std::unordered_map<uint32_t, std::vector<Chunk *>> unsealed;
+	// List ID |-> Staged object records in the image
+	std::unordered_map<uint32_t, std::vector<struct CheckpointStagedObject *>> staged;
+
+	static void *run( void *argv );
+
+public:
+	bool isEnabled;
+
+	Checkpoint();
+	void init( const char *dir, bool isEnabled, uint32_t threads );
+	bool save( ChunkPool *chunkPool, Map *map, std::vector<MixedChunkBuffer *> &chunkBuffer );
+	// Shared with the snapshot, which writes its image in the same format
+	static void initHeader( struct CheckpointHeader &header );
+	static bool saveStaged( FILE *f, std::vector<MixedChunkBuffer *> &chunkBuffer, struct CheckpointHeader &header );
+	/**
+	 * Restore the chunks and rebuild the indexes of the map. The unsealed
+	 * state is handed to the chunk buffers by restore() once they are
+	 * created, and release() drops the image afterwards.
+	 */
+	bool load( ChunkPool *chunkPool, Map *map );
+	uint32_t getUnsealedCount( uint32_t listId );
+	// Called before DataChunkBuffer::init() so that the restored chunks stay open
+	uint32_t restore( uint32_t listId, DataChunkBuffer *dataChunkBuffer );
+	uint32_t restore( uint32_t listId, ParityChunkBuffer *parityChunkBuffer );
+	// Called by WriteAheadLog::replay() for the data chunks that the log reopens or seals
+	void setUnsealed( Chunk *chunk, bool isUnsealed );
+	// The image is kept if it is the base of the write-ahead log
+	void release( bool keepImage = false );
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include <cstdio>
+#include <cstdlib>
+#include "delta_buffer.hh"
+#include "../../common/coding/coding.hh"
+#include "../../common/util/time.hh"
+
+DeltaBuffer::DeltaBuffer() {
+	this->chunkSize = 0;
+	this->size = 0;
+	this->maxSize = 0;
+	this->timeout = 0;
+	LOCK_INIT( &this->lock );
+	LOCK_INIT( &this->deferredLock );
+}
+
+void DeltaBuffer::init( uint32_t chunkSize, size_t maxSize, uint32_t timeout ) {
+	this->chunkSize = chunkSize;
+	// Hold at least one delta
+	this->maxSize = ( maxSize && maxSize < chunkSize ) ? chunkSize : maxSize;
+	this->timeout = timeout;
+}
+
+bool DeltaBuffer::append(
+	Metadata &metadata, uint32_t offset, uint32_t length, char *delta,
+	uint32_t timestamp, uint16_t instanceId, uint32_t requestId
+) {
+	std::map<Metadata, ParityDelta>::iterator it;
+	DeltaRequest request;
+	bool isFull;
+
+	request.instanceId = instanceId;
+	request.requestId = requestId;
+
+	LOCK( &this->lock );
+	it = this->deltas.find( metadata );
+	if ( it == this->deltas.end() ) {
+		ParityDelta parityDelta;
+		parityDelta.offset = offset;
+		parityDelta.length = length;
+		parityDelta.timestamp = timestamp;
+		// Zero-filled so that the gaps between the merged deltas do not change the parity
+		parityDelta.data = ( char * ) calloc( this->chunkSize, 1 );
+		parityDelta.since = start_timer();
+		it = this->deltas.insert( std::pair<Metadata, ParityDelta>( metadata, parityDelta ) ).first;
+		this->size += this->chunkSize;
+	} else {
+		ParityDelta &parityDelta = it->second;
+		uint32_t end = parityDelta.offset + parityDelta.length;
+		if ( offset + length > end )
+			end = offset + length;
+		if ( offset < parityDelta.offset )
+			parityDelta.offset = offset;
+		parityDelta.length = end - parityDelta.offset;
+	}
+
+	ParityDelta &parityDelta = it->second;
+	Coding::bitwiseXOR( parityDelta.data + offset, parityDelta.data + offset, delta, length );
+	parityDelta.timestamp = timestamp;
+	parityDelta.requests.push_back( request );
+
+	isFull = this->size >= this->maxSize;
+	UNLOCK( &this->lock );
+
+	return isFull;
+}
+
+void DeltaBuffer::extract( std::vector<std::pair<Metadata, ParityDelta>> &deltas, bool force ) {
+	std::map<Metadata, ParityDelta>::iterator it, tmp;
+
+	LOCK( &this->lock );
+	for ( it = this->deltas.begin(); it != this->deltas.end(); ) {
+		if ( force || get_elapsed_time( it->second.since ) * MILLION >= this->timeout ) {
+			deltas.push_back( *it );
+			this->size -= this->chunkSize;
+			tmp = it;
+			it++;
+			this->deltas.erase( tmp );
+		} else {
+			it++;
+		}
+	}
+	UNLOCK( &this->lock );
+}
+
+void DeltaBuffer::extract( std::vector<std::pair<Metadata, ParityDelta>> &deltas, uint32_t listId, uint32_t stripeId ) {
+	std::map<Metadata, ParityDelta>::iterator it, tmp;
+	Metadata metadata;
+
+	metadata.set( listId, stripeId, 0 );
+
+	LOCK( &this->lock );
+	for ( it = this->deltas.lower_bound( metadata ); it != this->deltas.end() && it->first.listId == listId && it->first.stripeId == stripeId; ) {
+		deltas.push_back( *it );
+		this->size -= this->chunkSize;
+		tmp = it;
+		it++;
+		this->deltas.erase( tmp );
+	}
+	UNLOCK( &this->lock );
+}
+
+void DeltaBuffer::release( ParityDelta &delta ) {
+	::free( delta.data );
+	delta.data = 0;
+}
+
+void DeltaBuffer::defer( uint32_t requestId, Metadata &metadata, ParityDelta &delta ) {
+	Metadata stripe;
+
+	stripe.set( metadata.listId, metadata.stripeId, 0 );
+
+	LOCK( &this->deferredLock );
+	if ( delta.requests.size() > 1 )
+		this->deferred[ requestId ].assign( delta.requests.begin() + 1, delta.requests.end() );
+	this->sent[ requestId ] = stripe;
+	this->stripes[ stripe ].first++;
+	UNLOCK( &this->deferredLock );
+}
+
+bool DeltaBuffer::take( uint32_t requestId, std::vector<DeltaRequest> &requests, std::vector<DeltaWaiter> &waiters ) {
+	std::unordered_map<uint32_t, std::vector<DeltaRequest>>::iterator it;
+	std::unordered_map<uint32_t, Metadata>::iterator sentIt;
+	std::map<Metadata, std::pair<uint32_t, std::vector<DeltaWaiter>>>::iterator stripeIt;
+
+	LOCK( &this->deferredLock );
+	sentIt = this->sent.find( requestId );
+	if ( sentIt == this->sent.end() ) {
+		UNLOCK( &this->deferredLock );
+		return false;
+	}
+
+	it = this->deferred.find( requestId );
+	if ( it != this->deferred.end() ) {
+		requests.swap( it->second );
+		this->deferred.erase( it );
+	}
+
+	stripeIt = this->stripes.find( sentIt->second );
+	if ( stripeIt != this->stripes.end() && --stripeIt->second.first == 0 ) {
+		waiters.swap( stripeIt->second.second );
+		this->stripes.erase( stripeIt );
+	}
+	this->sent.erase( sentIt );
+	UNLOCK( &this->deferredLock );
+
+	return true;
+}
+
+bool DeltaBuffer::wait( DeltaWaiter &waiter ) {
+	std::map<Metadata, std::pair<uint32_t, std::vector<DeltaWaiter>>>::iterator it;
+	Metadata stripe;
+	bool ret = false;
+
+	stripe.set( waiter.metadata.listId, waiter.metadata.stripeId, 0 );
+
+	LOCK( &this->deferredLock );
+	it = this->stripes.find( stripe );
+	if ( it != this->stripes.end() ) {
+		it->second.second.push_back( waiter );
+		ret = true;
+	}
+	UNLOCK( &this->deferredLock );
+
+	return ret;
+}
+
+bool DeltaBuffer::hasSentDeltas( uint32_t listId, uint32_t stripeId ) {
+	Metadata stripe;
+	bool ret;
+
+	stripe.set( listId, stripeId, 0 );
+
+	LOCK( &this->deferredLock );
+	ret = this->stripes.find( stripe ) != this->stripes.end();
+	UNLOCK( &this->deferredLock );
+
+	return ret;
+}
+
+bool DeltaBuffer::isDrained() {
+	bool ret;
+
+	LOCK( &this->lock );
+	ret = this->deltas.empty();
+	UNLOCK( &this->lock );
+
+	LOCK( &this->deferredLock );
+	ret = ret && this->sent.empty();
+	UNLOCK( &this->deferredLock );
+
+	return ret;
+}
+
+void DeltaBuffer::print( FILE *f ) {
+	size_t requestCount = 0;
+
+	LOCK( &this->lock );
+	for ( std::map<Metadata, ParityDelta>::iterator it = this->deltas.begin(); it != this->deltas.end(); it++ )
+		requestCount += it->second.requests.size();
+	fprintf(
+		f, "Buffered parity deltas: %lu chunks, %lu UPDATE requests (%lu / %lu bytes)\n",
+		this->deltas.size(), requestCount, this->size, this->maxSize
+	);
+	UNLOCK( &this->lock );
+
+	LOCK( &this->deferredLock );
+	fprintf(
+		f, "UPDATE_CHUNK requests with deferred acknowledgements: %lu (%lu unacknowledged, %lu stripes)\n",
+		this->deferred.size(), this->sent.size(), this->stripes.size()
+	);
+	UNLOCK( &this->deferredLock );
+}
+
+void DeltaBuffer::free() {
+	LOCK( &this->lock );
+	for ( std::map<Metadata, ParityDelta>::iterator it = this->deltas.begin(); it != this->deltas.end(); it++ )
+		::free( it->second.data );
+	this->deltas.clear();
+	this->size = 0;
+	UNLOCK( &this->lock );
+
+	LOCK( &this->deferredLock );
+	this->deferred.clear();
+	this->sent.clear();
+	this->stripes.clear();
+	UNLOCK( &this->deferredLock );
+}
@@ -0,0 +1,121 @@
+#ifndef __SERVER_DS_DELTA_BUFFER_HH__
+#define __SERVER_DS_DELTA_BUFFER_HH__
+
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <time.h>
+#include <stdint.h>
+#include "../../common/ds/metadata.hh"
+#include "../../common/lock/lock.hh"
+
+#define DELTA_BUFFER_DRAIN_TIMEOUT 5000 // Milliseconds to wait for the acknowledgements when the server stops
+
+// A client UPDATE request that waits for a coalesced parity delta
+struct DeltaRequest {
+	uint16_t instanceId;
+	uint32_t requestId;
+};
+
+// A GET_CHUNK request that waits for the parity deltas of its stripe
+struct DeltaWaiter {
+	void *socket;       // ServerPeerSocket
+	uint16_t instanceId;
+	uint32_t requestId;
+	Metadata metadata;
+	bool toSend;        // true: sent by this server; false: to be served by this server
+
+	inline void set( void *socket, uint16_t instanceId, uint32_t requestId, Metadata &metadata, bool toSend ) {
+		this->socket = socket;
+		this->instanceId = instanceId;
+		this->requestId = requestId;
+		this->metadata = metadata;
+		this->toSend = toSend;
+	}
+};
+
+/**
+ * Parity delta of a sealed data chunk that is not yet sent to the parity
+ * servers. Since parity deltas are XOR-ed into the parity chunks, the
+ * deltas of the same chunk are merged into one delta that spans them all.
+ */
+struct ParityDelta {
+	uint32_t offset;                    // Start of the merged range
+	uint32_t length;                    // Length of the merged range
+	uint32_t timestamp;                 // Timestamp of the latest delta
+	char *data;                         // Chunk-sized; only the merged range is valid
+	struct timespec since;              // When the first delta is merged
+	std::vector<DeltaRequest> requests; // Client UPDATE requests in arrival order
+};
+
+/**
+ * Buffers the UPDATE_CHUNK deltas of the data server and sends the merged
+ * deltas once they have waited for the flush interval or the buffer uses
+ * up its memory limit (see ServerWorker::flushParityDeltas()). The client
+ * UPDATE requests are acknowledged after the parity servers acknowledge
+ * the merged delta: the first one through the pending UPDATE_CHUNK request
+ * and the others through defer() and take().
+ *
+ * A chunk of a stripe is read (GET_CHUNK) only after the parity servers
+ * acknowledge all the deltas of the stripe, so that the chunks used for
+ * decoding are consistent: the deltas of the stripe are sent at once and
+ * the GET_CHUNK requests wait in wait() until take() returns them.
+ */
+class DeltaBuffer {
+private:
+	uint32_t chunkSize;
+	size_t size; // Memory used by the buffered deltas
+	std::map<Metadata, ParityDelta> deltas;
+	LOCK_T lock;
+	// Request ID of the UPDATE_CHUNK request -> client UPDATE requests (except the first)
+	std::unordered_map<uint32_t, std::vector<DeltaRequest>> deferred;
+	// Request ID of the UPDATE_CHUNK request -> stripe (chunk ID = 0)
+	std::unordered_map<uint32_t, Metadata> sent;
+	// Stripe (chunk ID = 0) -> number of unacknowledged deltas and the GET_CHUNK requests waiting for them
+	std::map<Metadata, std::pair<uint32_t, std::vector<DeltaWaiter>>> stripes;
+	LOCK_T deferredLock;
+
+public:
+	size_t maxSize;   // 0 if the deltas are not buffered
+	uint32_t timeout; // Flush interval in microseconds
+
+	DeltaBuffer();
+	void init( uint32_t chunkSize, size_t maxSize, uint32_t timeout );
+	inline bool isEnabled() { return this->maxSize > 0; }
+	inline bool isEmpty() { return this->deltas.empty(); }
+	/**
+	 * @return true if the buffered deltas reach the memory limit
+	 */
+	bool append(
+		Metadata &metadata, uint32_t offset, uint32_t length, char *delta,
+		uint32_t timestamp, uint16_t instanceId, uint32_t requestId
+	);
+	/**
+	 * Remove the deltas that have waited for the flush interval (or all
+	 * if force is true). The caller frees the data with release().
+	 */
+	void extract( std::vector<std::pair<Metadata, ParityDelta>> &deltas, bool force );
+	// Remove the deltas of one stripe regardless of the flush interval
+	void extract( std::vector<std::pair<Metadata, ParityDelta>> &deltas, uint32_t listId, uint32_t stripeId );
+	void release( ParityDelta &delta );
+	// Keep the client UPDATE requests (except the first) of a sent delta
+	void defer( uint32_t requestId, Metadata &metadata, ParityDelta &delta );
+	/**
+	 * Called when the parity servers acknowledge a sent delta.
+	 * @return false if the request ID does not belong to a sent delta;
+	 * waiters holds the GET_CHUNK requests that no longer wait
+	 */
+	bool take( uint32_t requestId, std::vector<DeltaRequest> &requests, std::vector<DeltaWaiter> &waiters );
+	/**
+	 * @return true if the GET_CHUNK request waits for the sent deltas of its stripe
+	 */
+	bool wait( DeltaWaiter &waiter );
+	// Whether the stripe has sent deltas that are not acknowledged yet
+	bool hasSentDeltas( uint32_t listId, uint32_t stripeId );
+	// Whether all deltas are sent and acknowledged
+	bool isDrained();
+	void print( FILE *f = stdout );
+	void free();
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef __SERVER_DS_FREE_SPACE_INDEX_HH__
+#define __SERVER_DS_FREE_SPACE_INDEX_HH__
+
+#include <map>
+#include <unordered_map>
+#include <stdint.h>
+#include "../../common/ds/chunk.hh"
+
+/**
+ * Chunks with free space ordered by the number of free bytes, so that the
+ * best-fit chunk and the maximum free space are found in O( log n ) and the
+ * free space of a chunk is updated in O( log n ). Not thread-safe.
+ */
+class FreeSpaceIndex {
+private:
+	typedef std::multimap<uint32_t, Chunk *> SpaceMap;
+
+	SpaceMap spaces;                                        // Free space |-> chunk
+	std::unordered_map<Chunk *, SpaceMap::iterator> chunks; // Chunk |-> its entry in spaces
+
+public:
+	/**
+	 * Insert a chunk or update its free space.
+	 *
+	 * @param chunk the chunk
+	 * @param space number of free bytes in the chunk
+	 * @return      true if the chunk is not indexed before
+	 */
+	bool update( Chunk *chunk, uint32_t space ) {
+		std::unordered_map<Chunk *, SpaceMap::iterator>::iterator it = this->chunks.find( chunk );
+		if ( it == this->chunks.end() ) {
+			this->chunks[ chunk ] = this->spaces.insert( std::make_pair( space, chunk ) );
+			return true;
+		}
+		if ( it->second->first != space ) {
+			this->spaces.erase( it->second );
+			it->second = this->spaces.insert( std::make_pair( space, chunk ) );
+		}
+		return false;
+	}
+
+	bool erase( Chunk *chunk ) {
+		std::unordered_map<Chunk *, SpaceMap::iterator>::iterator it = this->chunks.find( chunk );
+		if ( it == this->chunks.end() )
+			return false;
+		this->spaces.erase( it->second );
+		this->chunks.erase( it );
+		return true;
+	}
+
+	/**
+	 * Find the chunk with the least free space that is at least size.
+	 *
+	 * @param size  minimum free space
+	 * @param space (output) free space of the returned chunk
+	 * @return      the chunk; 0 if no chunks have enough free space
+	 */
+	Chunk *findBestFit( uint32_t size, uint32_t &space ) {
+		SpaceMap::iterator it = this->spaces.lower_bound( size );
+		if ( it == this->spaces.end() )
+			return 0;
+		space = it->first;
+		return it->second;
+	}
+
+	inline uint32_t getMaxSpace() {
+		return this->spaces.empty() ? 0 : this->spaces.rbegin()->first;
+	}
+
+	inline size_t size() {
+		return this->chunks.size();
+	}
+};
+
+#endif
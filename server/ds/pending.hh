@@ -46,6 +46,16 @@ public:
 	bool self;
 	uint8_t sealIndicatorCount;
 	bool *sealIndicator;
+	// Only the repair set (e.g., the local group) of the repaired chunk is requested
+	bool isLocalRepair;
+	uint32_t repairedChunkId;
+	// The chunk is repaired along a chain of helpers (see PROTO_OPCODE_REPAIR_CHUNK):
+	// "chunk" accumulates the received slices and the seal status reported
+	// with the first slice is kept to check the subsequent ones against
+	bool isPipelined;
+	uint32_t repairedSize;
+	bool *repairSealIndicators;
+	bool isRepairConsistent;
 
 	void set( uint32_t listId, uint32_t stripeId, uint32_t chunkId, ServerPeerSocket *socket, Chunk *chunk = 0, bool isDegraded = true, bool self = false ) {
 		this->listId = listId;
@@ -58,6 +68,24 @@ public:
 		this->sealIndicatorCount = 0;
 		this->sealIndicator = 0;
 		this->self = self;
+		this->isLocalRepair = false;
+		this->repairedChunkId = 0;
+		this->isPipelined = false;
+		this->repairedSize = 0;
+		this->repairSealIndicators = 0;
+		this->isRepairConsistent = true;
+	}
+
+	void setLocalRepair( uint32_t repairedChunkId ) {
+		this->isLocalRepair = true;
+		this->repairedChunkId = repairedChunkId;
+	}
+
+	void setPipelined( uint32_t sealIndicatorsSize ) {
+		this->isPipelined = true;
+		this->repairedSize = 0;
+		this->repairSealIndicators = new bool[ sealIndicatorsSize ];
+		this->isRepairConsistent = true;
 	}
 
 	void setSealStatus( bool isSealed, uint8_t sealIndicatorCount, bool *sealIndicator ) {
@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <cstring>
+#include "seal_batch.hh"
+#include "../../common/protocol/protocol.hh"
+#include "../../common/util/time.hh"
+
+uint32_t SealBatch::maxCount;
+size_t SealBatch::maxSize;
+uint32_t SealBatch::timeout;
+
+void SealBatch::init( uint32_t maxCount, size_t maxSize, uint32_t timeout ) {
+	SealBatch::maxCount = maxCount;
+	SealBatch::maxSize = maxSize;
+	SealBatch::timeout = timeout;
+}
+
+size_t SealBatch::getHeaderSize() {
+	return PROTO_HEADER_SIZE + PROTO_BATCH_CHUNK_SEAL_SIZE;
+}
+
+SealBatch::SealBatch() {
+	LOCK_INIT( &this->lock );
+	this->buffer = 0;
+	this->size = SealBatch::getHeaderSize();
+	this->count = 0;
+}
+
+bool SealBatch::append( char *seal, uint32_t sealSize ) {
+	char *ptr;
+
+	if ( this->size + PROTO_BATCH_CHUNK_SEAL_DATA_SIZE + sealSize > SealBatch::maxSize )
+		return false;
+
+	if ( ! this->buffer )
+		this->buffer = ( char * ) malloc( SealBatch::maxSize );
+	if ( this->count == 0 )
+		this->since = start_timer();
+
+	ptr = this->buffer + this->size;
+	this->size += ProtocolUtil::write4Bytes( ptr, sealSize );
+	this->size += ProtocolUtil::write( ptr, seal, sealSize );
+	this->count++;
+	return true;
+}
+
+bool SealBatch::isFull() {
+	return (
+		this->count >= SealBatch::maxCount ||
+		this->size + PROTO_BATCH_CHUNK_SEAL_DATA_SIZE + PROTO_CHUNK_SEAL_SIZE >= SealBatch::maxSize
+	);
+}
+
+bool SealBatch::isExpired() {
+	return this->count && get_elapsed_time( this->since ) * MILLION >= SealBatch::timeout;
+}
+
+void SealBatch::clear() {
+	this->size = SealBatch::getHeaderSize();
+	this->count = 0;
+}
+
+void SealBatch::free() {
+	::free( this->buffer );
+	this->buffer = 0;
+	this->clear();
+}
@@ -0,0 +1,57 @@
+#ifndef __SERVER_DS_SEAL_BATCH_HH__
+#define __SERVER_DS_SEAL_BATCH_HH__
+
+#include <time.h>
+#include <stdint.h>
+#include "../../common/lock/lock.hh"
+
+#define SEAL_BATCH_DRAIN_TIMEOUT 5000 // Milliseconds to wait for the batches to be sent when the server stops
+
+/**
+ * SEAL_CHUNK requests to a parity server that are not sent yet. The
+ * requests (without their protocol headers) are appended to a
+ * BATCH_SEAL_CHUNK message, which is sent once it holds enough requests or
+ * bytes, or its oldest request has waited for the timeout (see
+ * ServerWorker::flushSealChunkRequests()). A message that is not fully sent
+ * stays in the batch for the next flush. Callers hold the lock.
+ */
+class SealBatch {
+private:
+	char *buffer;          // Message; the headers are written when it is sent
+	size_t size;           // Number of bytes in the buffer, including the headers
+	uint32_t count;        // Number of SEAL_CHUNK requests
+	struct timespec since; // When the first request is appended
+
+public:
+	LOCK_T lock;
+
+	static uint32_t maxCount;  // 0 if SEAL_CHUNK requests are not batched
+	static size_t maxSize;     // Including the headers
+	static uint32_t timeout;   // In microseconds
+
+	static void init( uint32_t maxCount, size_t maxSize, uint32_t timeout );
+
+	SealBatch();
+	/**
+	 * @return false if the request does not fit in the remaining space
+	 */
+	bool append( char *seal, uint32_t sealSize );
+	bool isFull();
+	bool isExpired();
+	void clear();
+	void free();
+
+	inline bool isEmpty() { return this->count == 0; }
+	inline uint32_t getCount() { return this->count; }
+	/**
+	 * @param  dataLength (output) number of bytes of the requests
+	 * @return            the message starting with space for the headers
+	 */
+	inline char *getBuffer( uint32_t &dataLength ) {
+		dataLength = this->size - SealBatch::getHeaderSize();
+		return this->buffer;
+	}
+	static size_t getHeaderSize();
+};
+
+#endif
@@ -0,0 +1,337 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "snapshot.hh"
+#include "checkpoint.hh"
+#include "write_ahead_log.hh"
+#include "../buffer/mixed_chunk_buffer.hh"
+#include "../../common/util/debug.hh"
+#include "../../common/util/time.hh"
+
+Snapshot::Snapshot() {
+	this->dir[ 0 ] = '\0';
+	this->chunkPool = 0;
+	this->map = 0;
+	this->chunkBuffer = 0;
+	this->wal = 0;
+	this->isActive = false;
+	this->isRunning = false;
+	this->epoch = 0;
+	this->total = 0;
+	this->capacity = 0;
+	this->startAddress = 0;
+	this->states = 0;
+	this->processed = 0;
+	this->saved = 0;
+	this->unsealed = 0;
+	this->staged = 0;
+	this->memory = 0;
+	this->peakMemory = 0;
+	this->elapsedTime = 0;
+	this->segmentId = 0;
+	LOCK_INIT( &this->lock );
+	LOCK_INIT( &this->startLock );
+}
+
+Snapshot::~Snapshot() {
+	delete[] this->states;
+}
+
+void Snapshot::init( const char *dir, ChunkPool *chunkPool, Map *map, std::vector<MixedChunkBuffer *> *chunkBuffer, WriteAheadLog *wal ) {
+	strncpy( this->dir, dir, sizeof( this->dir ) - 1 );
+	this->dir[ sizeof( this->dir ) - 1 ] = '\0';
+	this->chunkPool = chunkPool;
+	this->map = map;
+	this->chunkBuffer = chunkBuffer;
+	this->wal = wal;
+}
+
+int64_t Snapshot::getIndex( Chunk *chunk ) {
+	uint64_t recordSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize, index;
+	if ( ( char * ) chunk < this->startAddress )
+		return -1;
+	index = ( uint64_t )( ( char * ) chunk - this->startAddress ) / recordSize;
+	// Chunks allocated after the epoch (or outside the pool) are not in the image
+	return index < this->total ? ( int64_t ) index : -1;
+}
+
+void Snapshot::copy( uint32_t index ) {
+	uint32_t recordSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize;
+	uint8_t state = SNAPSHOT_CHUNK_PENDING;
+	uint64_t memory;
+	Chunk *copy;
+
+	if ( ! this->states[ index ].compare_exchange_strong( state, SNAPSHOT_CHUNK_COPYING ) ) {
+		// Wait for the streaming thread that is copying the same chunk
+		while ( this->states[ index ].load() == SNAPSHOT_CHUNK_COPYING );
+		return;
+	}
+
+	copy = ( Chunk * ) malloc( recordSize );
+	memcpy( copy, this->startAddress + ( uint64_t ) index * recordSize, recordSize );
+	memory = this->memory.fetch_add( recordSize ) + recordSize;
+
+	LOCK( &this->lock );
+	this->copies[ index ] = copy;
+	if ( memory > this->peakMemory )
+		this->peakMemory = memory;
+	UNLOCK( &this->lock );
+
+	this->states[ index ].store( SNAPSHOT_CHUNK_PRESERVED );
+}
+
+bool Snapshot::start() {
+	uint32_t total;
+	std::atomic<unsigned int> count;
+	char *startAddress;
+
+	LOCK( &this->startLock );
+	if ( this->isRunning ) {
+		if ( this->isActive ) {
+			UNLOCK( &this->startLock );
+			return false;
+		}
+		// Reap the thread of the previous snapshot
+		this->stop();
+	}
+
+	// The records appended from now on may not be covered by the image
+	this->segmentId = this->wal && this->wal->isEnabled ? this->wal->rotate() : 0;
+
+	this->chunkPool->exportVars( &total, &count, &startAddress );
+	if ( ! this->states ) {
+		// Sized by the pool capacity so that a late writer of the previous epoch never sees a freed array
+		this->capacity = total;
+		this->states = new std::atomic<uint8_t>[ this->capacity ];
+	}
+	this->startAddress = startAddress;
+	this->total = ( uint32_t ) count < total ? ( uint32_t ) count : total;
+	for ( uint32_t i = 0; i < this->total; i++ )
+		this->states[ i ] = SNAPSHOT_CHUNK_PENDING;
+
+	this->epoch++;
+	this->processed = 0;
+	this->saved = 0;
+	this->unsealed = 0;
+	this->staged = 0;
+	this->memory = this->capacity;
+	this->peakMemory = this->capacity;
+	this->elapsedTime = 0;
+	this->startTime = start_timer();
+
+	this->isRunning = true;
+	this->isActive.store( true, std::memory_order_release );
+	if ( pthread_create( &this->tid, NULL, Snapshot::run, ( void * ) this ) != 0 ) {
+		__ERROR__( "Snapshot", "start", "Cannot start the thread for streaming the snapshot." );
+		this->isActive = false;
+		this->isRunning = false;
+		UNLOCK( &this->startLock );
+		return false;
+	}
+	UNLOCK( &this->startLock );
+	return true;
+}
+
+void Snapshot::stop() {
+	if ( ! this->isRunning )
+		return;
+	pthread_join( this->tid, 0 );
+	this->isRunning = false;
+}
+
+bool Snapshot::stream() {
+	char path[ sizeof( this->dir ) + sizeof( SNAPSHOT_FILE_NAME ) + 16 ], tmpPath[ sizeof( path ) + 4 ];
+	uint32_t recordSize = CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize;
+	uint32_t listId, stripeId, chunkId;
+	struct CheckpointHeader header;
+	std::vector<Chunk *> unsealed, copies;
+	std::unordered_map<uint32_t, Chunk *>::iterator it;
+	Chunk *chunk, *source, *buffer;
+	uint8_t state;
+	FILE *f;
+	bool ret, isUnsealed;
+
+	snprintf( path, sizeof( path ), "%s/%s.%u", this->dir, SNAPSHOT_FILE_NAME, this->epoch );
+	snprintf( tmpPath, sizeof( tmpPath ), "%s.tmp", path );
+	f = fopen( tmpPath, "wb" );
+	if ( ! f ) {
+		__ERROR__( "Snapshot", "stream", "fopen(): %s", strerror( errno ) );
+		return false;
+	}
+	setvbuf( f, 0, _IOFBF, 4 * recordSize );
+	buffer = ( Chunk * ) malloc( recordSize );
+
+	Checkpoint::initHeader( header );
+	// Written again after the counts are known
+	ret = fwrite( &header, CHECKPOINT_HEADER_SIZE, 1, f ) == 1;
+
+	for ( uint32_t i = 0; ret && i < this->total; i++, this->processed++ ) {
+		chunk = ( Chunk * )( this->startAddress + ( uint64_t ) i * recordSize );
+		source = 0;
+		isUnsealed = false;
+
+		state = SNAPSHOT_CHUNK_PENDING;
+		if ( this->states[ i ].compare_exchange_strong( state, SNAPSHOT_CHUNK_COPYING ) ) {
+			// Not modified in this epoch: copy it so that the writers are only blocked for the memcpy()
+			memcpy( buffer, chunk, recordSize );
+			this->states[ i ].store( SNAPSHOT_CHUNK_DONE );
+			source = buffer;
+		} else {
+			while ( ( state = this->states[ i ].load() ) == SNAPSHOT_CHUNK_COPYING );
+			if ( state == SNAPSHOT_CHUNK_PRESERVED ) {
+				LOCK( &this->lock );
+				it = this->copies.find( i );
+				source = it->second;
+				this->copies.erase( it );
+				UNLOCK( &this->lock );
+			} else {
+				isUnsealed = true;
+			}
+			this->states[ i ].store( SNAPSHOT_CHUNK_DONE );
+		}
+
+		ChunkUtil::get( chunk, listId, stripeId, chunkId );
+		// Skip the chunks that are not (or no longer) indexed
+		if ( this->map->findChunkById( listId, stripeId, chunkId ) == chunk ) {
+			if ( ! isUnsealed && ! ChunkUtil::isParity( chunk ) && listId < this->chunkBuffer->size() && this->chunkBuffer->at( listId ) ) {
+				int index = this->chunkBuffer->at( listId )->lockChunk( chunk );
+				if ( index != -1 ) {
+					this->chunkBuffer->at( listId )->unlock( index );
+					isUnsealed = true;
+				}
+			}
+
+			if ( isUnsealed ) {
+				unsealed.push_back( chunk );
+			} else {
+				ret = fwrite( source, recordSize, 1, f ) == 1;
+				header.chunkCount++;
+			}
+		}
+
+		if ( source && source != buffer ) {
+			::free( source );
+			this->memory -= recordSize;
+		}
+	}
+
+	// The writers no longer copy the chunks
+	this->isActive.store( false, std::memory_order_release );
+	LOCK( &this->lock );
+	for ( it = this->copies.begin(); it != this->copies.end(); it++ ) {
+		::free( it->second );
+		this->memory -= recordSize;
+	}
+	this->copies.clear();
+	UNLOCK( &this->lock );
+
+	// The open chunks are copied with their locks held so that no object is
+	// half-written; a chunk sealed since the epoch is kept as a sealed chunk
+	for ( size_t i = 0, size = unsealed.size(); ret && i < size; i++ ) {
+		chunk = unsealed[ i ];
+		ChunkUtil::get( chunk, listId, stripeId, chunkId );
+		int index = ( listId < this->chunkBuffer->size() && this->chunkBuffer->at( listId ) ) ? this->chunkBuffer->at( listId )->lockChunk( chunk ) : -1;
+		if ( index != -1 ) {
+			source = ( Chunk * ) malloc( recordSize );
+			memcpy( source, chunk, recordSize );
+			this->chunkBuffer->at( listId )->unlock( index );
+			copies.push_back( source );
+		} else {
+			memcpy( buffer, chunk, recordSize );
+			ret = fwrite( buffer, recordSize, 1, f ) == 1;
+			header.chunkCount++;
+		}
+	}
+	for ( size_t i = 0, size = copies.size(); i < size; i++ ) {
+		if ( ret ) {
+			ret = fwrite( copies[ i ], recordSize, 1, f ) == 1;
+			header.unsealedCount++;
+		}
+		::free( copies[ i ] );
+	}
+	::free( buffer );
+
+	if ( ret )
+		ret = Checkpoint::saveStaged( f, *this->chunkBuffer, header );
+
+	if ( ret ) {
+		ret = (
+			fseek( f, 0, SEEK_SET ) == 0 &&
+			fwrite( &header, CHECKPOINT_HEADER_SIZE, 1, f ) == 1 &&
+			fflush( f ) == 0 &&
+			fdatasync( fileno( f ) ) == 0
+		);
+	}
+	if ( ! ret )
+		__ERROR__( "Snapshot", "stream", "Cannot write to %s: %s", tmpPath, strerror( errno ) );
+	if ( fclose( f ) != 0 )
+		ret = false;
+
+	if ( ret && rename( tmpPath, path ) != 0 ) {
+		__ERROR__( "Snapshot", "stream", "rename(): %s", strerror( errno ) );
+		ret = false;
+	}
+	if ( ! ret ) {
+		unlink( tmpPath );
+		return false;
+	}
+
+	if ( this->segmentId ) {
+		// The image replaces the checkpoint as the base of the log
+		char checkpointPath[ sizeof( this->dir ) + sizeof( CHECKPOINT_FILE_NAME ) + 1 ];
+		snprintf( checkpointPath, sizeof( checkpointPath ), "%s/%s", this->dir, CHECKPOINT_FILE_NAME );
+		if ( rename( path, checkpointPath ) == 0 ) {
+			this->wal->truncate( this->segmentId );
+			strcpy( path, checkpointPath );
+		} else {
+			__ERROR__( "Snapshot", "stream", "rename(): %s", strerror( errno ) );
+		}
+	}
+
+	this->saved = header.chunkCount;
+	this->unsealed = header.unsealedCount;
+	this->staged = header.stagedCount;
+	this->elapsedTime = get_elapsed_time( this->startTime );
+	__INFO__(
+		GREEN, "Snapshot", "stream",
+		"Saved snapshot #%u to %s: %u sealed chunks, %u unsealed chunks and %u staged objects in %.3lf s; peak extra memory: %lu bytes.",
+		this->epoch, path, this->saved, this->unsealed, this->staged, this->elapsedTime, this->peakMemory
+	);
+	return true;
+}
+
+void *Snapshot::run( void *argv ) {
+	Snapshot *snapshot = ( Snapshot * ) argv;
+	snapshot->stream();
+	snapshot->isActive = false;
+	return 0;
+}
+
+void Snapshot::print( FILE *f ) {
+	uint32_t processed = this->processed;
+
+	if ( this->epoch == 0 ) {
+		fprintf( f, "No snapshots are taken.\n" );
+		return;
+	}
+
+	fprintf(
+		f,
+		"Snapshot #%u: %s\n"
+		"- Progress          : %u / %u chunks (%6.2lf%%)\n"
+		"- Extra memory      : %lu bytes (peak: %lu bytes)\n",
+		this->epoch, this->isActive ? "running" : "finished",
+		processed, this->total, this->total ? ( double ) processed / this->total * 100.0 : 100.0,
+		( uint64_t ) this->memory, this->peakMemory
+	);
+	if ( ! this->isActive ) {
+		fprintf(
+			f,
+			"- Chunks            : %u sealed, %u unsealed\n"
+			"- Staged objects    : %u\n"
+			"- Elapsed time      : %.3lf s\n",
+			this->saved, this->unsealed, this->staged, this->elapsedTime
+		);
+	}
+}
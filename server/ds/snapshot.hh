@@ -0,0 +1,112 @@
+#ifndef __SERVER_DS_SNAPSHOT_HH__
+#define __SERVER_DS_SNAPSHOT_HH__
+
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <cstdio>
+#include <stdint.h>
+#include <pthread.h>
+#include "map.hh"
+#include "../../common/config/config.hh"
+#include "../../common/ds/chunk_pool.hh"
+#include "../../common/lock/lock.hh"
+
+#define SNAPSHOT_FILE_NAME "snapshot"
+
+class MixedChunkBuffer;
+class WriteAheadLog;
+
+enum SnapshotChunkState {
+	SNAPSHOT_CHUNK_PENDING,   // Not yet streamed
+	SNAPSHOT_CHUNK_COPYING,   // Being copied by a writer or the streaming thread
+	SNAPSHOT_CHUNK_PRESERVED, // Copied before its first modification in this epoch
+	SNAPSHOT_CHUNK_SKIPPED,   // Unsealed data chunk that received new objects in this epoch
+	SNAPSHOT_CHUNK_DONE
+};
+
+/**
+ * Online snapshot of the chunks of a running server. start() marks a new
+ * epoch covering the chunks allocated so far, and a background thread
+ * streams them to <storage path>/snapshot.<epoch> in the checkpoint format
+ * (so that the image can be restored as a checkpoint). Writers call
+ * preserve() before modifying a chunk in place: the first modification in
+ * the epoch copies the chunk if it is not yet streamed, so the image holds
+ * the contents at the epoch without stalling the writers. The extra memory
+ * is the chunk copies not yet streamed and one state byte per chunk.
+ *
+ * As in the checkpoint, the unsealed data chunks and the staged replicas
+ * are kept as well; they are taken once all other chunks are streamed. A
+ * chunk is treated as unsealed if it receives new objects in the epoch
+ * (see skip()) or is unsealed when it is streamed.
+ *
+ * With the write-ahead log, start() moves the log to a new segment before
+ * the epoch, so the older segments only hold modifications that the image
+ * covers. The image then becomes the checkpoint that the log is replayed
+ * on, and the older segments are dropped.
+ */
+class Snapshot {
+private:
+	char dir[ STORAGE_PATH_MAX ];
+	ChunkPool *chunkPool;
+	Map *map;
+	std::vector<MixedChunkBuffer *> *chunkBuffer;
+	WriteAheadLog *wal;
+
+	std::atomic<bool> isActive;
+	bool isRunning;
+	pthread_t tid;
+	uint32_t epoch;
+	uint32_t total;     // Number of chunks in the current epoch
+	uint32_t capacity;  // Number of states allocated (never shrinks)
+	char *startAddress;
+	std::atomic<uint8_t> *states;
+	std::unordered_map<uint32_t, Chunk *> copies;
+	uint32_t segmentId; // First segment of the log not covered by the image
+	LOCK_T lock;
+	LOCK_T startLock;   // start() is called by the console and the log truncator
+
+	std::atomic<uint32_t> processed;
+	uint32_t saved, unsealed, staged;
+	std::atomic<uint64_t> memory;
+	uint64_t peakMemory;
+	struct timespec startTime;
+	double elapsedTime;
+
+	int64_t getIndex( Chunk *chunk );
+	void copy( uint32_t index );
+	bool stream();
+	static void *run( void *argv );
+
+public:
+	Snapshot();
+	~Snapshot();
+	void init( const char *dir, ChunkPool *chunkPool, Map *map, std::vector<MixedChunkBuffer *> *chunkBuffer, WriteAheadLog *wal );
+	/**
+	 * Start a new epoch and stream the image in background.
+	 *
+	 * @return false if a snapshot is already running
+	 */
+	bool start();
+	// Wait for the running snapshot
+	void stop();
+	// Called before a chunk is modified in place
+	inline void preserve( Chunk *chunk ) {
+		int64_t index;
+		if ( this->isActive.load( std::memory_order_acquire ) && ( index = this->getIndex( chunk ) ) != -1 )
+			this->copy( index );
+	}
+	// Called before an object is appended to an unsealed data chunk
+	inline void skip( Chunk *chunk ) {
+		int64_t index;
+		uint8_t state = SNAPSHOT_CHUNK_PENDING;
+		if ( this->isActive.load( std::memory_order_acquire ) && ( index = this->getIndex( chunk ) ) != -1 ) {
+			// Wait for the streaming thread that is copying the same chunk
+			while ( ! this->states[ index ].compare_exchange_strong( state, SNAPSHOT_CHUNK_SKIPPED ) && state == SNAPSHOT_CHUNK_COPYING )
+				state = SNAPSHOT_CHUNK_PENDING;
+		}
+	}
+	void print( FILE *f = stdout );
+};
+
+#endif
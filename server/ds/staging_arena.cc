@@ -0,0 +1,101 @@
+#include <cstdlib>
+#include "staging_arena.hh"
+#include "../../common/util/debug.hh"
+
+StagingArena::StagingArena() {
+	this->segmentSize = 0;
+	this->head = 0;
+	this->tail = 0;
+	this->spare = 0;
+	this->segmentCount = 0;
+}
+
+StagingArena::~StagingArena() {
+	Segment *segment = this->head, *next;
+	while ( segment ) {
+		next = segment->next;
+		::free( segment );
+		segment = next;
+	}
+	if ( this->spare )
+		::free( this->spare );
+}
+
+void StagingArena::init( uint32_t maxRecordSize ) {
+	// Round up to a power of two for the alignment
+	this->segmentSize = 1;
+	while ( this->segmentSize < maxRecordSize + sizeof( Segment ) )
+		this->segmentSize <<= 1;
+}
+
+StagingArena::Segment *StagingArena::allocSegment() {
+	Segment *segment;
+
+	if ( this->spare ) {
+		segment = this->spare;
+		this->spare = 0;
+	} else if ( posix_memalign( ( void ** ) &segment, this->segmentSize, this->segmentSize ) != 0 ) {
+		__ERROR__( "StagingArena", "allocSegment", "Cannot allocate a segment of %u bytes.", this->segmentSize );
+		return 0;
+	}
+
+	segment->size = sizeof( Segment );
+	segment->live = 0;
+	segment->prev = this->tail;
+	segment->next = 0;
+	if ( this->tail )
+		this->tail->next = segment;
+	else
+		this->head = segment;
+	this->tail = segment;
+	this->segmentCount++;
+	return segment;
+}
+
+void StagingArena::freeSegment( Segment *segment ) {
+	if ( segment->prev )
+		segment->prev->next = segment->next;
+	else
+		this->head = segment->next;
+	if ( segment->next )
+		segment->next->prev = segment->prev;
+	else
+		this->tail = segment->prev;
+	this->segmentCount--;
+
+	if ( this->spare )
+		::free( segment );
+	else
+		this->spare = segment;
+}
+
+char *StagingArena::alloc( uint32_t size ) {
+	Segment *segment = this->tail;
+	char *ptr;
+
+	if ( size > this->segmentSize - sizeof( Segment ) )
+		return 0;
+
+	if ( ! segment || segment->size + size > this->segmentSize ) {
+		segment = this->allocSegment();
+		if ( ! segment )
+			return 0;
+	}
+
+	ptr = ( char * ) segment + segment->size;
+	segment->size += size;
+	segment->live++;
+	return ptr;
+}
+
+void StagingArena::release( char *ptr ) {
+	Segment *segment = this->getSegment( ptr );
+
+	if ( --segment->live )
+		return;
+
+	if ( segment == this->tail )
+		segment->size = sizeof( Segment ); // Rewind
+	else
+		this->freeSegment( segment );
+}
@@ -0,0 +1,55 @@
+#ifndef __SERVER_DS_STAGING_ARENA_HH__
+#define __SERVER_DS_STAGING_ARENA_HH__
+
+#include <stdint.h>
+#include <cstdio>
+
+/**
+ * Append-only memory for records that are released in roughly the order
+ * they are appended, e.g., the unsealed key-value pairs that a data server
+ * appends to its chunk. Records are bump-allocated from fixed-size segments
+ * that are aligned to their size, so the segment of a record is found from
+ * the record address alone; a segment is returned in one step once all of
+ * its records are released. Not thread-safe.
+ */
+class StagingArena {
+private:
+	struct Segment {
+		Segment *prev, *next;
+		uint32_t size; // Number of bytes allocated, including this header
+		uint32_t live; // Number of records not yet released
+	};
+
+	uint32_t segmentSize;
+	Segment *head;  // All segments; the tail is the one being appended
+	Segment *tail;
+	Segment *spare; // An empty segment kept to avoid allocation when the tail fills up
+	uint32_t segmentCount;
+
+	Segment *allocSegment();
+	void freeSegment( Segment *segment );
+	inline Segment *getSegment( char *ptr ) {
+		return ( Segment * )( ( uintptr_t ) ptr & ~( ( uintptr_t ) this->segmentSize - 1 ) );
+	}
+
+public:
+	StagingArena();
+	~StagingArena();
+
+	/**
+	 * @param maxRecordSize size of the largest record to be allocated
+	 */
+	void init( uint32_t maxRecordSize );
+
+	/**
+	 * @param size number of bytes
+	 * @return     0 if size exceeds the maximum record size
+	 */
+	char *alloc( uint32_t size );
+	void release( char *ptr );
+
+	inline uint32_t getSegmentCount() { return this->segmentCount; }
+	inline size_t getMemoryUsage() { return ( size_t ) this->segmentCount * this->segmentSize; }
+};
+
+#endif
@@ -0,0 +1,685 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <unordered_set>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "write_ahead_log.hh"
+#include "checkpoint.hh"
+#include "map.hh"
+#include "../event/event_queue.hh"
+#include "../../common/ds/chunk_pool.hh"
+#include "../../common/ds/chunk_util.hh"
+#include "../../common/ds/key_value.hh"
+#include "../../common/protocol/protocol.hh"
+#include "../../common/util/debug.hh"
+
+WriteAheadLog::WriteAheadLog() {
+	this->dir[ 0 ] = '\0';
+	this->fd = -1;
+	this->batchSize = 0;
+	this->commitInterval = 0;
+	this->segmentSize = 0;
+	this->maxSize = 0;
+	for ( int i = 0; i < 2; i++ ) {
+		this->buffers[ i ].data = 0;
+		this->buffers[ i ].size = 0;
+		this->buffers[ i ].capacity = 0;
+	}
+	this->active = 0;
+	this->appended = 0;
+	this->durable = 0;
+	this->commits = 0;
+	this->segments.first = 0;
+	this->segments.current = 0;
+	this->segments.size = 0;
+	this->segments.retained = 0;
+	this->segments.needsRotation = false;
+	this->segments.rotations = 0;
+	this->segments.rotated = 0;
+	this->eventQueue = 0;
+	this->isRunning = false;
+	this->isEnabled = false;
+	pthread_mutex_init( &this->lock, 0 );
+	pthread_cond_init( &this->hasBatch, 0 );
+	pthread_cond_init( &this->committed, 0 );
+}
+
+void WriteAheadLog::init(
+	const char *dir, bool isEnabled,
+	uint32_t batchSize, uint32_t commitInterval,
+	uint64_t segmentSize, uint64_t maxSize
+) {
+	strncpy( this->dir, dir, sizeof( this->dir ) - 1 );
+	this->dir[ sizeof( this->dir ) - 1 ] = '\0';
+	this->isEnabled = isEnabled;
+	this->batchSize = batchSize;
+	this->commitInterval = commitInterval;
+	this->segmentSize = segmentSize;
+	this->maxSize = maxSize;
+	if ( ! isEnabled )
+		return;
+	for ( int i = 0; i < 2; i++ ) {
+		this->buffers[ i ].capacity = batchSize;
+		this->buffers[ i ].data = ( char * ) malloc( batchSize );
+	}
+}
+
+void WriteAheadLog::getPath( char *path, size_t len, uint32_t segmentId ) {
+	snprintf( path, len, "%s/%s.%u", this->dir, WAL_FILE_NAME, segmentId );
+}
+
+bool WriteAheadLog::scan( uint32_t &first, uint32_t &last ) {
+	char prefix[] = WAL_FILE_NAME ".", *end;
+	size_t prefixSize = sizeof( prefix ) - 1;
+	struct dirent *ent;
+	uint32_t segmentId;
+	bool ret = false;
+	DIR *d;
+
+	first = last = 0;
+	if ( ! ( d = opendir( this->dir ) ) )
+		return false;
+	while ( ( ent = readdir( d ) ) ) {
+		if ( strncmp( ent->d_name, prefix, prefixSize ) != 0 )
+			continue;
+		segmentId = strtoul( ent->d_name + prefixSize, &end, 10 );
+		if ( end == ent->d_name + prefixSize || *end != '\0' )
+			continue;
+		if ( ! ret || segmentId < first ) first = segmentId;
+		if ( ! ret || segmentId > last ) last = segmentId;
+		ret = true;
+	}
+	closedir( d );
+	return ret;
+}
+
+bool WriteAheadLog::replay( ChunkPool *chunkPool, Map *map, Checkpoint &checkpoint ) {
+	char path[ STORAGE_PATH_MAX + sizeof( WAL_FILE_NAME ) + 16 ];
+	struct WriteAheadLogRecordHeader *header;
+	std::unordered_set<Chunk *> created, sealed;
+	std::unordered_set<Chunk *>::iterator it;
+	uint32_t first, last, records = 0, skipped = 0, timestamp;
+	KeyMetadata keyMetadata;
+	KeyValue keyValue;
+	Key key;
+	Chunk *chunk;
+	char *image, *ptr, *end, *data, *obj, *keyStr, *valueStr;
+	char *delta = ( char * ) malloc( ChunkUtil::chunkSize );
+	uint8_t keySize;
+	uint32_t valueSize, splitOffset;
+	struct stat st;
+	int fd;
+	bool ret = true;
+
+	if ( ! this->isEnabled || ! this->scan( first, last ) ) {
+		::free( delta );
+		return true;
+	}
+
+	for ( uint32_t segmentId = first; ret && segmentId <= last; segmentId++ ) {
+		this->getPath( path, sizeof( path ), segmentId );
+		if ( ( fd = open( path, O_RDONLY ) ) == -1 ) {
+			if ( errno != ENOENT )
+				__ERROR__( "WriteAheadLog", "replay", "open(): %s", strerror( errno ) );
+			continue;
+		}
+		if ( fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+			close( fd );
+			continue;
+		}
+		image = ( char * ) mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0 );
+		close( fd );
+		if ( image == MAP_FAILED ) {
+			__ERROR__( "WriteAheadLog", "replay", "mmap(): %s", strerror( errno ) );
+			ret = false;
+			break;
+		}
+
+		for ( ptr = image, end = image + st.st_size; ptr < end; ptr = data + header->keySize + header->length ) {
+			header = ( struct WriteAheadLogRecordHeader * ) ptr;
+			data = ptr + WAL_RECORD_HEADER_SIZE;
+			if (
+				data > end ||
+				header->magic != WAL_MAGIC ||
+				data + header->keySize + header->length > end
+			)
+				break;
+			records++;
+
+			if ( header->opcode == PROTO_OPCODE_SET && header->isReplica ) {
+				skipped++;
+				continue;
+			}
+			chunk = map->findChunkById( header->listId, header->stripeId, header->chunkId );
+			if ( ! chunk && header->opcode == PROTO_OPCODE_SET ) {
+				// The chunk was opened after the image was taken
+				chunk = chunkPool->alloc( header->listId, header->stripeId, header->chunkId );
+				if ( ! chunk ) {
+					__ERROR__( "WriteAheadLog", "replay", "The chunk pool is full." );
+					ret = false;
+					break;
+				}
+				map->setChunk( header->listId, header->stripeId, header->chunkId, chunk, false );
+				created.insert( chunk );
+			}
+			if ( ! chunk || header->objectOffset + KEY_VALUE_METADATA_SIZE + header->keySize > ChunkUtil::chunkSize ) {
+				skipped++;
+				continue;
+			}
+			obj = ChunkUtil::getData( chunk ) + header->objectOffset;
+
+			switch( header->opcode ) {
+				case PROTO_OPCODE_SET:
+					if ( header->objectOffset + header->length > ChunkUtil::chunkSize ) {
+						skipped++;
+						break;
+					}
+					memcpy( obj, data + header->keySize, header->length );
+					chunkPool->setDirty( chunk );
+
+					// Index the key in the chunk unless it is already indexed
+					KeyValue::deserialize( obj, keyStr, keySize, valueStr, valueSize, splitOffset );
+					key.set( keySize, keyStr, 0, LargeObjectUtil::isLarge( keySize, valueSize ) );
+					keyMetadata.set( header->listId, header->stripeId, header->chunkId );
+					keyMetadata.offset = header->objectOffset;
+					keyMetadata.length = header->length;
+					keyMetadata.obj = obj;
+					map->insertKey( key, PROTO_OPCODE_SET, timestamp, keyMetadata, true, true, false, key.isLarge );
+					break;
+				case PROTO_OPCODE_UPDATE:
+					// Skip if the object is deleted afterwards
+					if (
+						memcmp( obj + KEY_VALUE_METADATA_SIZE, data, header->keySize ) != 0 ||
+						header->objectOffset + KEY_VALUE_METADATA_SIZE + header->keySize + header->offset + header->length > ChunkUtil::chunkSize
+					) {
+						skipped++;
+						break;
+					}
+					// The record holds the new bytes, so applying it again is harmless
+					memcpy( obj + KEY_VALUE_METADATA_SIZE + header->keySize + header->offset, data + header->keySize, header->length );
+					chunkPool->setDirty( chunk );
+					break;
+				case PROTO_OPCODE_DELETE:
+					if ( ( uint8_t ) obj[ 0 ] != header->keySize || memcmp( obj + KEY_VALUE_METADATA_SIZE, data, header->keySize ) != 0 ) {
+						skipped++;
+						break;
+					}
+					// The key may refer to a newer object
+					if ( map->findObject( data, header->keySize, &keyValue, &key ) == obj )
+						map->deleteKey( key, PROTO_OPCODE_DELETE, timestamp, keyMetadata, true, true, false );
+					// Keep the following objects reachable as in ServerWorker::handleDeleteRequest()
+					ChunkUtil::deleteObject( chunk, header->objectOffset, delta );
+					chunkPool->setDirty( chunk );
+					break;
+				case WAL_OPCODE_SEAL:
+					sealed.insert( chunk );
+					break;
+				default:
+					skipped++;
+					break;
+			}
+		}
+
+		if ( ret && ptr < end ) {
+			// Cut off the torn record so that it does not hide the records appended afterwards
+			__ERROR__(
+				"WriteAheadLog", "replay", "Discarded the torn record at offset %lu of %s.",
+				( uint64_t )( ptr - image ), path
+			);
+			if ( ::truncate( path, ptr - image ) != 0 )
+				__ERROR__( "WriteAheadLog", "replay", "truncate(): %s", strerror( errno ) );
+		}
+		munmap( image, st.st_size );
+	}
+	::free( delta );
+
+	// The chunks opened after the image are handed to the data chunk buffers unless they are sealed
+	for ( it = created.begin(); it != created.end(); it++ ) {
+		if ( sealed.find( *it ) == sealed.end() )
+			checkpoint.setUnsealed( *it, true );
+	}
+	for ( it = sealed.begin(); it != sealed.end(); it++ )
+		checkpoint.setUnsealed( *it, false );
+
+	__INFO__(
+		GREEN, "WriteAheadLog", "replay",
+		"Replayed %u records (%u skipped) from segments #%u to #%u; %lu new chunks.",
+		records, skipped, first, last, created.size()
+	);
+	return ret;
+}
+
+bool WriteAheadLog::openSegment( uint32_t segmentId ) {
+	char path[ STORAGE_PATH_MAX + sizeof( WAL_FILE_NAME ) + 16 ];
+
+	this->getPath( path, sizeof( path ), segmentId );
+	this->fd = open( path, O_WRONLY | O_CREAT | O_APPEND, 0644 );
+	if ( this->fd == -1 ) {
+		__ERROR__( "WriteAheadLog", "openSegment", "open(): %s", strerror( errno ) );
+		return false;
+	}
+	this->segments.current = segmentId;
+	this->segments.size = 0;
+	return true;
+}
+
+bool WriteAheadLog::start( ServerEventQueue *eventQueue ) {
+	uint32_t first, last;
+	char path[ STORAGE_PATH_MAX + sizeof( WAL_FILE_NAME ) + 16 ];
+	struct stat st;
+
+	if ( ! this->isEnabled )
+		return false;
+
+	// The records before the restart are kept until an image covers them
+	this->segments.retained = 0;
+	if ( this->scan( first, last ) ) {
+		for ( uint32_t segmentId = first; segmentId <= last; segmentId++ ) {
+			this->getPath( path, sizeof( path ), segmentId );
+			if ( stat( path, &st ) == 0 )
+				this->segments.retained += st.st_size;
+		}
+		this->segments.first = first;
+		last++;
+	} else {
+		this->segments.first = last = 0;
+	}
+
+	this->eventQueue = eventQueue;
+	if ( ! this->openSegment( last ) ) {
+		this->isEnabled = false;
+		return false;
+	}
+
+	this->isRunning = true;
+	if ( pthread_create( &this->tid, NULL, WriteAheadLog::run, ( void * ) this ) != 0 ) {
+		__ERROR__( "WriteAheadLog", "start", "Cannot start the group-commit thread." );
+		this->isRunning = false;
+		this->isEnabled = false;
+		close( this->fd );
+		this->fd = -1;
+		return false;
+	}
+	return true;
+}
+
+void WriteAheadLog::stop() {
+	if ( ! this->isRunning )
+		return;
+
+	pthread_mutex_lock( &this->lock );
+	this->isRunning = false;
+	pthread_cond_signal( &this->hasBatch );
+	pthread_mutex_unlock( &this->lock );
+
+	pthread_join( this->tid, 0 );
+	close( this->fd );
+	this->fd = -1;
+
+	// The event queue is stopped; the clients retry the requests that are not acknowledged
+	for ( size_t i = 0, size = this->parked.size(); i < size; i++ ) {
+		ClientEvent &event = this->parked[ i ].second;
+		switch( event.type ) {
+			case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_DATA:
+			case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_PARITY:
+				event.message.set.key.free();
+				break;
+			case CLIENT_EVENT_TYPE_UPDATE_RESPONSE_SUCCESS:
+				event.message.keyValueUpdate.key.free();
+				break;
+			case CLIENT_EVENT_TYPE_DELETE_RESPONSE_SUCCESS:
+				event.message.del.key.free();
+				break;
+			default:
+				break;
+		}
+	}
+	this->parked.clear();
+}
+
+char *WriteAheadLog::reserve( uint32_t size ) {
+	char *ret;
+
+	// Called with the lock held
+	if ( this->buffers[ this->active ].size + size > this->buffers[ this->active ].capacity ) {
+		uint32_t capacity = this->buffers[ this->active ].capacity * 2;
+		if ( capacity < this->buffers[ this->active ].size + size )
+			capacity = this->buffers[ this->active ].size + size;
+		this->buffers[ this->active ].data = ( char * ) realloc( this->buffers[ this->active ].data, capacity );
+		this->buffers[ this->active ].capacity = capacity;
+	}
+	ret = this->buffers[ this->active ].data + this->buffers[ this->active ].size;
+	this->buffers[ this->active ].size += size;
+	this->appended += size;
+
+	// Start the commit interval at the first record and commit early once a batch is full
+	if (
+		this->buffers[ this->active ].size == size ||
+		( this->buffers[ this->active ].size >= this->batchSize && this->buffers[ this->active ].size - size < this->batchSize )
+	)
+		pthread_cond_signal( &this->hasBatch );
+
+	return ret;
+}
+
+void WriteAheadLog::append(
+	uint8_t opcode, char *key, uint8_t keySize,
+	Metadata &metadata, uint32_t objectOffset,
+	char *data, uint32_t length, uint32_t offset
+) {
+	struct WriteAheadLogRecordHeader header;
+	char *ptr;
+
+	if ( ! this->isEnabled )
+		return;
+
+	header.magic = WAL_MAGIC;
+	header.opcode = opcode;
+	header.keySize = keySize;
+	header.isReplica = 0;
+	header.listId = metadata.listId;
+	header.stripeId = metadata.stripeId;
+	header.chunkId = metadata.chunkId;
+	header.objectOffset = objectOffset;
+	header.offset = offset;
+	header.length = length;
+
+	pthread_mutex_lock( &this->lock );
+	ptr = this->reserve( WAL_RECORD_HEADER_SIZE + keySize + length );
+	memcpy( ptr, &header, WAL_RECORD_HEADER_SIZE );
+	ptr += WAL_RECORD_HEADER_SIZE;
+	if ( keySize )
+		memcpy( ptr, key, keySize );
+	ptr += keySize;
+	if ( length )
+		memcpy( ptr, data, length );
+	pthread_mutex_unlock( &this->lock );
+}
+
+void WriteAheadLog::appendObject(
+	char *key, uint8_t keySize, char *value, uint32_t valueSize, uint32_t splitOffset,
+	uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint32_t objectOffset,
+	bool isReplica
+) {
+	struct WriteAheadLogRecordHeader header;
+	uint32_t splitSize;
+	char *ptr;
+
+	if ( ! this->isEnabled )
+		return;
+
+	// Same size as the object stored in the chunk (see KeyValue::dup())
+	if ( LargeObjectUtil::isLarge( keySize, valueSize, 0, &splitSize ) ) {
+		if ( splitOffset + splitSize > valueSize )
+			splitSize = valueSize - splitOffset;
+		splitSize += SPLIT_OFFSET_SIZE;
+	} else {
+		splitSize = valueSize;
+	}
+
+	header.magic = WAL_MAGIC;
+	header.opcode = PROTO_OPCODE_SET;
+	header.keySize = 0;
+	header.isReplica = isReplica;
+	header.listId = listId;
+	header.stripeId = stripeId;
+	header.chunkId = chunkId;
+	header.objectOffset = objectOffset;
+	header.offset = 0;
+	header.length = KEY_VALUE_METADATA_SIZE + keySize + splitSize;
+
+	pthread_mutex_lock( &this->lock );
+	ptr = this->reserve( WAL_RECORD_HEADER_SIZE + header.length );
+	memcpy( ptr, &header, WAL_RECORD_HEADER_SIZE );
+	KeyValue::serialize( ptr + WAL_RECORD_HEADER_SIZE, key, keySize, value, valueSize, splitOffset );
+	pthread_mutex_unlock( &this->lock );
+}
+
+bool WriteAheadLog::park( ClientEvent &event ) {
+	Key *key;
+
+	if ( ! this->isEnabled )
+		return false;
+
+	switch( event.type ) {
+		case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_DATA:
+		case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_PARITY:
+			key = &event.message.set.key;
+			break;
+		case CLIENT_EVENT_TYPE_UPDATE_RESPONSE_SUCCESS:
+			key = &event.message.keyValueUpdate.key;
+			break;
+		case CLIENT_EVENT_TYPE_DELETE_RESPONSE_SUCCESS:
+			key = &event.message.del.key;
+			break;
+		default:
+			return false;
+	}
+
+	pthread_mutex_lock( &this->lock );
+	if ( ! this->isRunning || this->durable >= this->appended ) {
+		pthread_mutex_unlock( &this->lock );
+		return false;
+	}
+	// The key may point to the receive buffer of the worker
+	if ( ! event.needsFree ) {
+		key->dup( 0, 0, key->ptr, key->isLarge );
+		event.needsFree = true;
+	}
+	this->parked.push_back( std::pair<uint64_t, ClientEvent>( this->appended, event ) );
+	pthread_mutex_unlock( &this->lock );
+	return true;
+}
+
+bool WriteAheadLog::write( char *data, uint32_t size ) {
+	ssize_t ret;
+
+	for ( uint32_t written = 0; written < size; ) {
+		ret = ::write( this->fd, data + written, size - written );
+		if ( ret > 0 )
+			written += ret;
+		else if ( ret == -1 && errno != EINTR )
+			return false;
+	}
+	this->segments.size += size;
+	return fdatasync( this->fd ) == 0;
+}
+
+void *WriteAheadLog::run( void *argv ) {
+	WriteAheadLog *wal = ( WriteAheadLog * ) argv;
+	std::vector<ClientEvent> released;
+	struct timespec deadline;
+	uint32_t committing, size;
+	uint64_t target;
+	bool success, needsRotation;
+
+	pthread_mutex_lock( &wal->lock );
+	while ( true ) {
+		while ( wal->isRunning && wal->buffers[ wal->active ].size == 0 && ! wal->segments.needsRotation )
+			pthread_cond_wait( &wal->hasBatch, &wal->lock );
+		if ( wal->buffers[ wal->active ].size == 0 && ! wal->segments.needsRotation )
+			break; // Stopped with nothing left to commit
+
+		// Gather more records until the batch is full or the commit interval expires
+		if ( wal->isRunning && wal->buffers[ wal->active ].size < wal->batchSize && ! wal->segments.needsRotation ) {
+			clock_gettime( CLOCK_REALTIME, &deadline );
+			deadline.tv_nsec += ( long )( wal->commitInterval % 1000000 ) * 1000;
+			deadline.tv_sec += wal->commitInterval / 1000000 + deadline.tv_nsec / 1000000000;
+			deadline.tv_nsec %= 1000000000;
+			while (
+				wal->isRunning &&
+				wal->buffers[ wal->active ].size < wal->batchSize &&
+				! wal->segments.needsRotation &&
+				pthread_cond_timedwait( &wal->hasBatch, &wal->lock, &deadline ) != ETIMEDOUT
+			);
+		}
+
+		// Let the workers fill the other buffer during the commit; the
+		// records appended from now on go to the next segment if requested
+		committing = wal->active;
+		wal->active ^= 1;
+		target = wal->appended;
+		needsRotation = wal->segments.needsRotation;
+		wal->segments.needsRotation = false;
+		pthread_mutex_unlock( &wal->lock );
+
+		size = wal->buffers[ committing ].size;
+		success = size == 0 || wal->write( wal->buffers[ committing ].data, size );
+		// The responses are released anyway so that the clients do not wait forever
+		if ( ! success )
+			__ERROR__( "WriteAheadLog", "run", "Cannot commit %u bytes to segment #%u: %s", size, wal->segments.current, strerror( errno ) );
+
+		if ( needsRotation || wal->segments.size >= wal->segmentSize ) {
+			close( wal->fd );
+			if ( ! wal->openSegment( wal->segments.current + 1 ) )
+				__ERROR__( "WriteAheadLog", "run", "Cannot open segment #%u.", wal->segments.current + 1 );
+		}
+
+		pthread_mutex_lock( &wal->lock );
+		wal->buffers[ committing ].size = 0;
+		wal->durable = target;
+		wal->commits++;
+		wal->segments.retained += size;
+		if ( needsRotation ) {
+			wal->segments.rotations++;
+			wal->segments.rotated = wal->segments.current;
+		}
+		while ( ! wal->parked.empty() && wal->parked.front().first <= target ) {
+			released.push_back( wal->parked.front().second );
+			wal->parked.pop_front();
+		}
+		pthread_cond_broadcast( &wal->committed );
+
+		if ( ! released.empty() && wal->isRunning ) {
+			// Insert without the lock as the event queue may be full
+			pthread_mutex_unlock( &wal->lock );
+			for ( size_t i = 0, len = released.size(); i < len; i++ ) {
+				released[ i ].isDurable = true;
+				wal->eventQueue->insert( released[ i ] );
+			}
+			released.clear();
+			pthread_mutex_lock( &wal->lock );
+		} else if ( ! released.empty() ) {
+			// Freed by stop()
+			for ( size_t i = 0, len = released.size(); i < len; i++ )
+				wal->parked.push_back( std::pair<uint64_t, ClientEvent>( target, released[ i ] ) );
+			released.clear();
+		}
+	}
+	pthread_cond_broadcast( &wal->committed );
+	pthread_mutex_unlock( &wal->lock );
+
+	return 0;
+}
+
+uint32_t WriteAheadLog::rotate() {
+	uint64_t rotations;
+	uint32_t ret;
+
+	pthread_mutex_lock( &this->lock );
+	if ( ! this->isRunning ) {
+		pthread_mutex_unlock( &this->lock );
+		return 0;
+	}
+	rotations = this->segments.rotations;
+	this->segments.needsRotation = true;
+	pthread_cond_signal( &this->hasBatch );
+	// The commit thread opens the next segment after committing the current buffer
+	while ( this->isRunning && this->segments.rotations == rotations )
+		pthread_cond_wait( &this->committed, &this->lock );
+	ret = this->segments.rotations == rotations ? 0 : this->segments.rotated;
+	pthread_mutex_unlock( &this->lock );
+	return ret;
+}
+
+void WriteAheadLog::truncate( uint32_t segmentId ) {
+	char path[ STORAGE_PATH_MAX + sizeof( WAL_FILE_NAME ) + 16 ];
+	struct stat st;
+	uint32_t first;
+
+	if ( ! this->isEnabled )
+		return;
+
+	pthread_mutex_lock( &this->lock );
+	first = this->segments.first;
+	if ( segmentId > this->segments.current )
+		segmentId = this->segments.current;
+	if ( segmentId > first )
+		this->segments.first = segmentId;
+	pthread_mutex_unlock( &this->lock );
+
+	for ( ; first < segmentId; first++ ) {
+		this->getPath( path, sizeof( path ), first );
+		if ( stat( path, &st ) != 0 )
+			continue;
+		if ( unlink( path ) != 0 ) {
+			__ERROR__( "WriteAheadLog", "truncate", "unlink(): %s", strerror( errno ) );
+			continue;
+		}
+		pthread_mutex_lock( &this->lock );
+		this->segments.retained -= st.st_size < ( off_t ) this->segments.retained ? st.st_size : this->segments.retained;
+		pthread_mutex_unlock( &this->lock );
+	}
+}
+
+bool WriteAheadLog::needsTruncation() {
+	bool ret;
+	pthread_mutex_lock( &this->lock );
+	ret = this->isRunning && this->maxSize && this->segments.retained >= this->maxSize;
+	pthread_mutex_unlock( &this->lock );
+	return ret;
+}
+
+bool WriteAheadLog::clear() {
+	char path[ STORAGE_PATH_MAX + sizeof( WAL_FILE_NAME ) + 16 ];
+	uint32_t first, last;
+	bool ret = true;
+
+	if ( ! this->isEnabled )
+		return false;
+	if ( ! this->scan( first, last ) )
+		return true;
+	for ( uint32_t segmentId = first; segmentId <= last; segmentId++ ) {
+		this->getPath( path, sizeof( path ), segmentId );
+		if ( unlink( path ) != 0 && errno != ENOENT ) {
+			__ERROR__( "WriteAheadLog", "clear", "unlink(): %s", strerror( errno ) );
+			ret = false;
+		}
+	}
+	this->segments.retained = 0;
+	return ret;
+}
+
+void WriteAheadLog::print( FILE *f ) {
+	pthread_mutex_lock( &this->lock );
+	fprintf(
+		f,
+		"Write-ahead log:\n"
+		"- Enabled    : %s\n"
+		"- Appended   : %lu bytes\n"
+		"- Durable    : %lu bytes\n"
+		"- Commits    : %lu\n"
+		"- Parked     : %lu responses\n"
+		"- Segments   : #%u to #%u (%lu bytes)\n",
+		this->isEnabled ? "true" : "false",
+		this->appended, this->durable, this->commits,
+		this->parked.size(),
+		this->segments.first, this->segments.current, this->segments.retained
+	);
+	pthread_mutex_unlock( &this->lock );
+}
+
+void WriteAheadLog::free() {
+	for ( int i = 0; i < 2; i++ ) {
+		::free( this->buffers[ i ].data );
+		this->buffers[ i ].data = 0;
+		this->buffers[ i ].size = 0;
+		this->buffers[ i ].capacity = 0;
+	}
+}
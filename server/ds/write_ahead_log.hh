@@ -0,0 +1,157 @@
+#ifndef __SERVER_DS_WRITE_AHEAD_LOG_HH__
+#define __SERVER_DS_WRITE_AHEAD_LOG_HH__
+
+#include <deque>
+#include <cstdio>
+#include <stdint.h>
+#include <pthread.h>
+#include "../event/client_event.hh"
+#include "../../common/config/config.hh"
+#include "../../common/ds/chunk.hh"
+
+#define WAL_MAGIC         0x4c415757 // "WWAL"
+#define WAL_FILE_NAME     "wal"
+#define WAL_OPCODE_SEAL   0xff       // The data chunk is sealed
+
+struct WriteAheadLogRecordHeader {
+	uint32_t magic;
+	uint8_t opcode;    // PROTO_OPCODE_SET, PROTO_OPCODE_UPDATE, PROTO_OPCODE_DELETE or WAL_OPCODE_SEAL
+	uint8_t keySize;   // Including the split offset of large objects; 0 for SET and SEAL
+	uint8_t isReplica; // The SET is staged at this parity server (not replayed)
+	uint32_t listId;
+	uint32_t stripeId;
+	uint32_t chunkId;
+	uint32_t objectOffset; // Offset of the object in the data chunk
+	uint32_t offset;       // Value update offset (UPDATE only)
+	uint32_t length;       // Size of the serialized object (SET) or the new value bytes (UPDATE; not the delta)
+} __attribute__((__packed__));
+
+#define WAL_RECORD_HEADER_SIZE sizeof( struct WriteAheadLogRecordHeader )
+
+class ServerEventQueue;
+class ChunkPool;
+class Map;
+class Checkpoint;
+
+/**
+ * Write-ahead log of the SET, UPDATE and DELETE requests from the clients.
+ * The workers append records to a shared buffer and a group-commit thread
+ * writes and fsyncs the buffer once it holds a batch or the commit
+ * interval expires; meanwhile the next batch is collected in a second
+ * buffer. The response of a request is parked by park() until the batch
+ * containing its record is durable, and the commit thread then hands it
+ * back to the event queue, so the workers never wait for the disk.
+ *
+ * Each record is the header followed by the key and the data. A SET record
+ * carries the object in the same format as in the chunks, and all records
+ * carry the position of the object, so that replay() can apply them again
+ * on top of the checkpoint image that the server starts with.
+ *
+ * The log is split into segments (<storage path>/wal.<segment ID>). The
+ * commit thread moves to a new segment once the current one reaches the
+ * segment size or rotate() is called; truncate() drops the segments that a
+ * newer image covers.
+ */
+class WriteAheadLog {
+private:
+	char dir[ STORAGE_PATH_MAX ];
+	int fd;
+	uint32_t batchSize;      // Commit once the buffer holds this number of bytes
+	uint32_t commitInterval; // Maximum time (in microseconds) to wait for a batch
+	uint64_t segmentSize;    // Move to a new segment once the current one holds this number of bytes
+	uint64_t maxSize;        // Ask for a new image once the segments hold this number of bytes (0: never)
+	struct {
+		char *data;
+		uint32_t size;
+		uint32_t capacity;
+	} buffers[ 2 ];
+	uint32_t active;   // Buffer receiving new records
+	uint64_t appended; // Number of bytes appended
+	uint64_t durable;  // Number of bytes written and fsynced
+	uint64_t commits;
+	struct {
+		uint32_t first;    // Oldest segment that is kept
+		uint32_t current;  // Segment being written
+		uint64_t size;     // Number of bytes in the current segment
+		uint64_t retained; // Number of bytes in all kept segments
+		bool needsRotation;
+		uint64_t rotations;
+		uint32_t rotated;  // Segment opened by the last rotate()
+	} segments;
+	// Responses waiting for their records to be durable: (log position, event)
+	std::deque<std::pair<uint64_t, ClientEvent>> parked;
+	ServerEventQueue *eventQueue;
+	bool isRunning;
+	pthread_t tid;
+	pthread_mutex_t lock;
+	pthread_cond_t hasBatch;  // Signals the group-commit thread
+	pthread_cond_t committed; // Signals rotate()
+
+	char *reserve( uint32_t size );
+	void getPath( char *path, size_t len, uint32_t segmentId );
+	bool openSegment( uint32_t segmentId );
+	bool write( char *data, uint32_t size );
+	// Find the kept segments; returns false if there are none
+	bool scan( uint32_t &first, uint32_t &last );
+	static void *run( void *argv );
+
+public:
+	bool isEnabled;
+
+	WriteAheadLog();
+	void init(
+		const char *dir, bool isEnabled,
+		uint32_t batchSize, uint32_t commitInterval,
+		uint64_t segmentSize, uint64_t maxSize
+	);
+	/**
+	 * Apply the records of the data chunks held by this server to the
+	 * chunks restored from the checkpoint image (if any). The chunks that
+	 * the records leave unsealed are added to the unsealed chunks of the
+	 * checkpoint for the data chunk buffers. A torn record at the end of a
+	 * segment is cut off.
+	 *
+	 * The replicas at the parity servers are not replayed: the parity
+	 * chunks are not logged, so the objects staged before a crash cannot
+	 * be told apart from those already folded into the parity.
+	 */
+	bool replay( ChunkPool *chunkPool, Map *map, Checkpoint &checkpoint );
+	// The parked responses are inserted into the event queue once they are durable
+	bool start( ServerEventQueue *eventQueue );
+	// Commit the remaining records and close the log
+	void stop();
+	void append(
+		uint8_t opcode, char *key, uint8_t keySize,
+		Metadata &metadata, uint32_t objectOffset,
+		char *data = 0, uint32_t length = 0, uint32_t offset = 0
+	);
+	void appendObject(
+		char *key, uint8_t keySize, char *value, uint32_t valueSize, uint32_t splitOffset,
+		uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint32_t objectOffset,
+		bool isReplica
+	);
+	/**
+	 * Hold the response until all records appended so far (by any worker)
+	 * are durable. The key of the response is copied.
+	 *
+	 * @return false if the records are already durable (or the log is
+	 *         disabled or stopped) so that the response can be sent now
+	 */
+	bool park( ClientEvent &event );
+	/**
+	 * Let the records appended from now on go to a new segment.
+	 *
+	 * @return ID of the new segment; 0 if the log is not running
+	 */
+	uint32_t rotate();
+	// Drop the segments before the segment ID (e.g., after they are covered by a snapshot)
+	void truncate( uint32_t segmentId );
+	// Whether the kept segments exceed the maximum size
+	bool needsTruncation();
+	// Discard all records (e.g., after they are covered by a checkpoint)
+	bool clear();
+	void print( FILE *f = stdout );
+	void free();
+};
+
+#endif
@@ -43,6 +43,7 @@ public:
 	ClientEventType type;
 	bool needsFree;
 	bool isDegraded;
+	bool isDurable; // The log records of the modification are durable (see WriteAheadLog::park())
 	uint32_t timestamp;
 	union {
 		Key key;
@@ -124,6 +125,8 @@ public:
 	) {
 		this->type = CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_DATA;
 		this->set( instanceId, requestId, socket );
+		this->needsFree = false;
+		this->isDurable = false;
 		this->message.set.timestamp = timestamp;
 		this->message.set.listId = listId;
 		this->message.set.stripeId = stripeId;
@@ -143,6 +146,8 @@ public:
 	) {
 		this->type = success ? CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_PARITY : CLIENT_EVENT_TYPE_SET_RESPONSE_FAILURE;
 		this->set( instanceId, requestId, socket );
+		this->needsFree = false;
+		this->isDurable = false;
 		this->message.set.key = key;
 	}
 
@@ -171,6 +176,7 @@ public:
 		this->type = success ? CLIENT_EVENT_TYPE_UPDATE_RESPONSE_SUCCESS : CLIENT_EVENT_TYPE_UPDATE_RESPONSE_FAILURE;
 		this->set( instanceId, requestId, socket );
 		this->needsFree = needsFree;
+		this->isDurable = false;
 		this->isDegraded = isDegraded;
 		this->message.keyValueUpdate = {
 			.key = key,
@@ -184,6 +190,7 @@ public:
 		this->type = CLIENT_EVENT_TYPE_DELETE_RESPONSE_SUCCESS;
 		this->set( instanceId, requestId, socket );
 		this->needsFree = needsFree;
+		this->isDurable = false;
 		this->isDegraded = isDegraded;
 		this->message.del = {
 			.timestamp = timestamp,
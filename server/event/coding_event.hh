@@ -5,9 +5,17 @@
 #include "../../common/ds/chunk.hh"
 #include "../../common/event/event.hh"
 
+// Defined in server/worker/coding_worker.hh
+struct DecodeTask;
+
 enum CodingEventType {
 	CODING_EVENT_TYPE_UNDEFINED,
-	CODING_EVENT_TYPE_DECODE
+	// Decode in the calling worker
+	CODING_EVENT_TYPE_DECODE,
+	// Decode (a part of) a stripe in a coding worker
+	CODING_EVENT_TYPE_DECODE_PART,
+	// Continue with a decoded stripe in a server worker
+	CODING_EVENT_TYPE_DECODE_COMPLETED
 };
 
 class CodingEvent : public Event<void> {
@@ -18,6 +26,10 @@ public:
 			Chunk **chunks;
 			BitmaskArray *status;
 		} decode;
+		struct {
+			DecodeTask *task;
+			uint32_t part;
+		} task;
 	} message;
 
 	inline void decode( Chunk **chunks, BitmaskArray *status ) {
@@ -27,6 +39,22 @@ public:
 			.status = status
 		};
 	}
+
+	inline void decodePart( DecodeTask *task, uint32_t part ) {
+		this->type = CODING_EVENT_TYPE_DECODE_PART;
+		this->message.task = {
+			.task = task,
+			.part = part
+		};
+	}
+
+	inline void decodeCompleted( DecodeTask *task ) {
+		this->type = CODING_EVENT_TYPE_DECODE_COMPLETED;
+		this->message.task = {
+			.task = task,
+			.part = 0
+		};
+	}
 };
 
 #endif
@@ -70,6 +70,12 @@ enum ServerPeerEventType {
 	SERVER_PEER_EVENT_TYPE_SEAL_CHUNK_RESPONSE_FAILURE,
 	// Seal chunk buffer
 	SERVER_PEER_EVENT_TYPE_SEAL_CHUNKS,
+	// Seal the chunks that are open for too long or hold too many replicas
+	SERVER_PEER_EVENT_TYPE_SEAL_AGED_CHUNKS,
+	// Send the batched SEAL_CHUNK requests that are due
+	SERVER_PEER_EVENT_TYPE_FLUSH_SEAL_CHUNKS,
+	// Send the buffered parity deltas that are due
+	SERVER_PEER_EVENT_TYPE_FLUSH_PARITY_DELTAS,
 	// Reconstructed unsealed keys
 	SERVER_PEER_EVENT_TYPE_UNSEALED_KEYS_RESPONSE_SUCCESS,
 	SERVER_PEER_EVENT_TYPE_UNSEALED_KEYS_RESPONSE_FAILURE,
@@ -156,6 +162,9 @@ public:
 			char *buf;
 			size_t size;
 		} defer;
+		struct {
+			bool force;
+		} flush;
 	} message;
 
 	// Register
@@ -473,6 +482,20 @@ public:
 		this->message.chunkBuffer = chunkBuffer;
 	}
 
+	inline void reqSealAgedChunks() {
+		this->type = SERVER_PEER_EVENT_TYPE_SEAL_AGED_CHUNKS;
+	}
+
+	inline void flushSealChunks( bool force = false ) {
+		this->type = SERVER_PEER_EVENT_TYPE_FLUSH_SEAL_CHUNKS;
+		this->message.flush.force = force;
+	}
+
+	inline void flushParityDeltas( bool force = false ) {
+		this->type = SERVER_PEER_EVENT_TYPE_FLUSH_PARITY_DELTAS;
+		this->message.flush.force = force;
+	}
+
 	// Reconstructed unsealed keys
 	inline void resUnsealedKeys(
 		ServerPeerSocket *socket, uint16_t instanceId, uint32_t requestId,
@@ -7,6 +7,10 @@ uint16_t Server::instanceId;
 
 Server::Server() {
 	this->isRunning = false;
+	this->sealBatchFlusher.isRunning = false;
+	this->deltaFlusher.isRunning = false;
+	this->backgroundSealer.isRunning = false;
+	this->logTruncator.isRunning = false;
 	Server::instanceId = 0;
 }
 
@@ -16,6 +20,8 @@ void Server::free() {
 	/* Event queue */
 	this->eventQueue.free();
 	/* Coding */
+	CodingWorker::destroy();
+	IOWorker::destroy();
 	Coding::destroy( this->coding );
 	/* Stripe list */
 	delete this->stripeList;
@@ -24,6 +30,10 @@ void Server::free() {
 		if ( this->chunkBuffer[ i ] )
 			delete this->chunkBuffer[ i ];
 	}
+	/* Parity deltas */
+	this->deltaBuffer.free();
+	/* Write-ahead log */
+	this->wal.free();
 }
 
 void Server::sync( uint32_t requestId ) {
@@ -130,6 +140,32 @@ bool Server::init( char *path, OptionList &globalOptions, OptionList &serverOpti
 		this->config.server.pool.chunks // capacity
 	);
 	LargeObjectUtil::init( this->config.global.size.chunk );
+	/* Checkpoint (restored before the chunk buffers take new stripe IDs) */
+	this->checkpoint.init(
+		this->config.server.storage.path,
+		this->config.server.checkpoint.enabled,
+		this->config.server.checkpoint.threads
+	);
+	/* Write-ahead log */
+	this->wal.init(
+		this->config.server.storage.path,
+		this->config.server.wal.enabled && myServerIndex != -1,
+		this->config.server.wal.batchSize,
+		this->config.server.wal.commitInterval,
+		this->config.server.wal.segmentSize,
+		this->config.server.wal.maxSize
+	);
+	// The log is replayed on top of the last image
+	if ( ( this->checkpoint.isEnabled || this->wal.isEnabled ) && myServerIndex != -1 )
+		this->checkpoint.load( &this->chunkPool, &this->map );
+	if ( ! this->wal.replay( &this->chunkPool, &this->map, this->checkpoint ) )
+		__ERROR__( "Server", "init", "Cannot replay the write-ahead log." );
+	/* Snapshot */
+	this->snapshot.init(
+		this->config.server.storage.path,
+		&this->chunkPool, &this->map, &this->chunkBuffer,
+		&this->wal
+	);
 	/* Chunk buffer */
 	ChunkBuffer::init();
 	this->chunkBuffer.reserve( this->config.global.stripeLists.count );
@@ -142,22 +178,27 @@ bool Server::init( char *path, OptionList &globalOptions, OptionList &serverOpti
 			         stripeId = this->stripeListIndex[ i ].stripeId,
 			         chunkId = this->stripeListIndex[ i ].chunkId;
 			if ( this->stripeListIndex[ i ].isParity ) {
-				this->chunkBuffer[ listId ] = new MixedChunkBuffer(
-					new ParityChunkBuffer(
-						this->config.server.buffer.chunksPerList,
-						listId, stripeId, chunkId, true
-					)
+				ParityChunkBuffer *parityChunkBuffer = new ParityChunkBuffer(
+					this->config.server.buffer.chunksPerList,
+					listId, stripeId, chunkId, true
 				);
+				// Stage the unsealed objects of the data servers again
+				this->checkpoint.restore( listId, parityChunkBuffer );
+				this->chunkBuffer[ listId ] = new MixedChunkBuffer( parityChunkBuffer );
 			} else {
-				this->chunkBuffer[ listId ] = new MixedChunkBuffer(
-					new DataChunkBuffer(
-						this->config.server.buffer.chunksPerList,
-						listId, stripeId, chunkId, true
-					)
+				uint32_t count = this->checkpoint.getUnsealedCount( listId );
+				DataChunkBuffer *dataChunkBuffer = new DataChunkBuffer(
+					count > this->config.server.buffer.chunksPerList ? count : this->config.server.buffer.chunksPerList,
+					listId, stripeId, chunkId, false
 				);
+				// Keep the restored unsealed chunks open
+				this->checkpoint.restore( listId, dataChunkBuffer );
+				dataChunkBuffer->init();
+				this->chunkBuffer[ listId ] = new MixedChunkBuffer( dataChunkBuffer );
 			}
 		}
 	}
+	this->checkpoint.release( this->wal.isEnabled );
 	// Map //
 	this->map.setTimestamp( &this->timestamp );
 	this->degradedChunkBuffer.map.init( &this->map );
@@ -186,6 +227,22 @@ bool Server::init( char *path, OptionList &globalOptions, OptionList &serverOpti
 			i // worker ID
 		);
 	}
+	/* Coding workers */
+	if ( CodingWorker::init( this->config.server, this->config.global.eventQueue.size ) ) {
+		this->codingWorkers.reserve( this->config.server.coding.threads );
+		for ( uint32_t i = 0; i < this->config.server.coding.threads; i++ ) {
+			this->codingWorkers.push_back( CodingWorker() );
+			this->codingWorkers[ i ].init( i );
+		}
+	}
+	/* I/O workers */
+	if ( IOWorker::init( this->config.server ) ) {
+		this->ioWorkers.reserve( this->config.server.io.threads );
+		for ( uint32_t i = 0; i < this->config.server.io.threads; i++ ) {
+			this->ioWorkers.push_back( IOWorker() );
+			this->ioWorkers[ i ].init( i, this->config.server );
+		}
+	}
 	/* Remapping message handler; Remapping scheme */
 	if ( ! this->config.global.states.disabled ) {
 		char serverName[ 11 ];
@@ -265,11 +322,21 @@ bool Server::initChunkBuffer() {
 }
 
 bool Server::start() {
+	/* Write-ahead log (before the workers accept requests) */
+	if ( this->wal.isEnabled && ! this->wal.start( &this->eventQueue ) )
+		__ERROR__( "Server", "start", "Cannot start the write-ahead log. Requests are acknowledged without being logged." );
+
 	/* Workers and event queues */
 	this->eventQueue.start();
 	for ( int i = 0, len = this->config.global.workers.count; i < len; i++ ) {
 		this->workers[ i ].start();
 	}
+	for ( int i = 0, len = this->codingWorkers.size(); i < len; i++ ) {
+		this->codingWorkers[ i ].start();
+	}
+	for ( int i = 0, len = this->ioWorkers.size(); i < len; i++ ) {
+		this->ioWorkers[ i ].start();
+	}
 
 	/* Sockets */
 	// Connect to coordinators
@@ -294,21 +361,187 @@ bool Server::start() {
 	this->startTime = start_timer();
 	this->isRunning = true;
 
+	/* Background sealing */
+	this->backgroundSealer.isRunning = ( this->config.server.seal.maxAge || this->config.server.seal.maxUnsealedSize );
+	if ( this->backgroundSealer.isRunning && pthread_create( &this->backgroundSealer.tid, NULL, Server::runBackgroundSealer, ( void * ) this ) != 0 ) {
+		__ERROR__( "Server", "start", "Cannot start the thread for sealing chunks in background." );
+		this->backgroundSealer.isRunning = false;
+	}
+
+	/* SEAL_CHUNK batches */
+	this->sealBatchFlusher.isRunning = ( SealBatch::maxCount > 0 );
+	if ( this->sealBatchFlusher.isRunning && pthread_create( &this->sealBatchFlusher.tid, NULL, Server::runSealBatchFlusher, ( void * ) this ) != 0 ) {
+		__ERROR__( "Server", "start", "Cannot start the thread for sending batched SEAL_CHUNK requests." );
+		this->sealBatchFlusher.isRunning = false;
+	}
+
+	/* Parity deltas */
+	this->deltaFlusher.isRunning = this->deltaBuffer.isEnabled();
+	if ( this->deltaFlusher.isRunning && pthread_create( &this->deltaFlusher.tid, NULL, Server::runDeltaFlusher, ( void * ) this ) != 0 ) {
+		__ERROR__( "Server", "start", "Cannot start the thread for sending buffered parity deltas." );
+		this->deltaFlusher.isRunning = false;
+	}
+
+	/* Write-ahead log truncation */
+	this->logTruncator.isRunning = this->wal.isEnabled && this->config.server.wal.maxSize;
+	if ( this->logTruncator.isRunning && pthread_create( &this->logTruncator.tid, NULL, Server::runLogTruncator, ( void * ) this ) != 0 ) {
+		__ERROR__( "Server", "start", "Cannot start the thread for truncating the write-ahead log." );
+		this->logTruncator.isRunning = false;
+	}
+
 	/* Alarm */
 	this->alarm();
 
 	return true;
 }
 
+void *Server::runBackgroundSealer( void *argv ) {
+	Server *server = ( Server * ) argv;
+	uint32_t interval = server->config.server.seal.checkInterval;
+	struct timespec ts = { interval / 1000, ( long )( interval % 1000 ) * MILLION };
+	ServerPeerEvent event;
+
+	while ( server->backgroundSealer.isRunning ) {
+		nanosleep( &ts, 0 );
+		event.reqSealAgedChunks();
+		server->eventQueue.insert( event );
+	}
+
+	pthread_exit( 0 );
+	return 0;
+}
+
+void *Server::runSealBatchFlusher( void *argv ) {
+	Server *server = ( Server * ) argv;
+	// Check twice per timeout
+	uint32_t interval = SealBatch::timeout / 2 + 1;
+	struct timespec ts = { interval / MILLION, ( long )( interval % MILLION ) * 1000 };
+	ServerPeerEvent event;
+
+	while ( server->sealBatchFlusher.isRunning ) {
+		nanosleep( &ts, 0 );
+		if ( ! server->isSealBatchDrained() ) {
+			event.flushSealChunks();
+			server->eventQueue.insert( event );
+		}
+	}
+
+	pthread_exit( 0 );
+	return 0;
+}
+
+bool Server::isSealBatchDrained() {
+	bool isEmpty;
+
+	for ( uint32_t i = 0, size = this->sockets.serverPeers.size(); i < size; i++ ) {
+		SealBatch &batch = this->sockets.serverPeers.values[ i ]->sealBatch;
+		LOCK( &batch.lock );
+		isEmpty = batch.isEmpty();
+		UNLOCK( &batch.lock );
+		if ( ! isEmpty )
+			return false;
+	}
+	return true;
+}
+
+void *Server::runDeltaFlusher( void *argv ) {
+	Server *server = ( Server * ) argv;
+	// Check twice per flush interval
+	uint32_t interval = server->deltaBuffer.timeout / 2 + 1;
+	struct timespec ts = { interval / MILLION, ( long )( interval % MILLION ) * 1000 };
+	ServerPeerEvent event;
+
+	while ( server->deltaFlusher.isRunning ) {
+		nanosleep( &ts, 0 );
+		if ( ! server->deltaBuffer.isEmpty() ) {
+			event.flushParityDeltas();
+			server->eventQueue.insert( event );
+		}
+	}
+
+	pthread_exit( 0 );
+	return 0;
+}
+
+void *Server::runLogTruncator( void *argv ) {
+	Server *server = ( Server * ) argv;
+	struct timespec ts = { 1, 0 };
+
+	while ( server->logTruncator.isRunning ) {
+		nanosleep( &ts, 0 );
+		// The segments covered by the snapshot are dropped when it completes
+		if ( server->wal.needsTruncation() )
+			server->snapshot.start();
+	}
+
+	pthread_exit( 0 );
+	return 0;
+}
+
 bool Server::stop() {
 	if ( ! this->isRunning )
 		return false;
 
 	int i, len;
 
+	/* Parity deltas (sent and acknowledged while the sockets and the workers are running) */
+	if ( this->deltaFlusher.isRunning ) {
+		this->deltaFlusher.isRunning = false;
+		pthread_join( this->deltaFlusher.tid, 0 );
+	}
+	if ( this->deltaBuffer.isEnabled() ) {
+		struct timespec ts = { 0, 1000000 }; // 1 ms
+		ServerPeerEvent event;
+		event.flushParityDeltas( true );
+		this->eventQueue.insert( event );
+		for ( i = 0; i < DELTA_BUFFER_DRAIN_TIMEOUT && ! this->deltaBuffer.isDrained(); i++ )
+			nanosleep( &ts, 0 );
+		if ( ! this->deltaBuffer.isDrained() )
+			__ERROR__( "Server", "stop", "Some parity deltas are not acknowledged in %d ms.", DELTA_BUFFER_DRAIN_TIMEOUT );
+	}
+
+	/* Background sealing (no more SEAL_CHUNK requests are batched) */
+	if ( this->backgroundSealer.isRunning ) {
+		this->backgroundSealer.isRunning = false;
+		pthread_join( this->backgroundSealer.tid, 0 );
+	}
+
+	/* SEAL_CHUNK batches (sent while the sockets and the workers are running) */
+	if ( this->sealBatchFlusher.isRunning ) {
+		this->sealBatchFlusher.isRunning = false;
+		pthread_join( this->sealBatchFlusher.tid, 0 );
+	}
+	if ( SealBatch::maxCount ) {
+		struct timespec ts = { 0, 1000000 }; // 1 ms
+		ServerPeerEvent event;
+		for ( i = 0; i < SEAL_BATCH_DRAIN_TIMEOUT && ! this->isSealBatchDrained(); i++ ) {
+			// Retry the batches that are not fully sent every 100 ms
+			if ( i % 100 == 0 ) {
+				event.flushSealChunks( true );
+				this->eventQueue.insert( event );
+			}
+			nanosleep( &ts, 0 );
+		}
+		if ( ! this->isSealBatchDrained() )
+			__ERROR__( "Server", "stop", "Some batched SEAL_CHUNK requests are not sent in %d ms.", SEAL_BATCH_DRAIN_TIMEOUT );
+	}
+
 	/* Sockets */
 	this->sockets.self.stop();
 
+	/* Write-ahead log truncation */
+	if ( this->logTruncator.isRunning ) {
+		this->logTruncator.isRunning = false;
+		pthread_join( this->logTruncator.tid, 0 );
+	}
+
+	/* Coding workers (before the server workers that continue with the decoded stripes) */
+	len = this->codingWorkers.size();
+	for ( i = len - 1; i >= 0; i-- )
+		this->codingWorkers[ i ].stop();
+	for ( i = len - 1; i >= 0; i-- )
+		this->codingWorkers[ i ].join();
+
 	/* Workers */
 	len = this->workers.size();
 	for ( i = len - 1; i >= 0; i-- )
@@ -321,6 +554,13 @@ bool Server::stop() {
 	for ( i = len - 1; i >= 0; i-- )
 		this->workers[ i ].join();
 
+	/* I/O workers (after the server workers that may still queue I/O requests) */
+	len = this->ioWorkers.size();
+	for ( i = len - 1; i >= 0; i-- )
+		this->ioWorkers[ i ].stop();
+	for ( i = len - 1; i >= 0; i-- )
+		this->ioWorkers[ i ].join();
+
 	/* Sockets */
 	for ( i = 0, len = this->sockets.coordinators.size(); i < len; i++ )
 		this->sockets.coordinators[ i ]->stop();
@@ -340,6 +580,19 @@ bool Server::stop() {
 		this->stateTransitHandler.quit();
 	}
 
+	/* Write-ahead log (after the workers that wait for the commits exit) */
+	this->wal.stop();
+
+	/* Snapshot (before the chunk buffers are released) */
+	this->snapshot.stop();
+
+	/* Checkpoint (after the workers exit) */
+	if ( this->checkpoint.isEnabled && this->myServerIndex != -1 ) {
+		// The log is no longer needed once the checkpoint holds the chunks
+		if ( this->checkpoint.save( &this->chunkPool, &this->map, this->chunkBuffer ) )
+			this->wal.clear();
+	}
+
 	/* Chunk buffer */
 	for ( size_t i = 0, size = this->chunkBuffer.size(); i < size; i++ ) {
 		if ( this->chunkBuffer[ i ] )
@@ -375,20 +628,22 @@ void Server::flush( bool parityOnly ) {
 
 	this->chunkPool.exportVars( &total, &count, &startAddress );
 
-	for ( unsigned int i = 0; i < total; i++ ) {
-		chunk = ( Chunk * )( startAddress + i * ( CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize ) );
+	// Only the chunks modified since the last flush are written
+	for ( uint32_t i = this->chunkPool.nextDirty( 0 ); i < total; i = this->chunkPool.nextDirty( i + 1 ) ) {
+		chunk = ( Chunk * )( startAddress + ( uint64_t ) i * ( CHUNK_IDENTIFIER_SIZE + ChunkUtil::chunkSize ) );
 		if ( parityOnly && ! ChunkUtil::isParity( chunk ) )
 			continue;
 
-		if ( ChunkUtil::getSize( chunk ) == 0 )
+		// Cleared before writing so that a concurrent modification marks the chunk again
+		if ( ! this->chunkPool.clearDirty( i ) )
 			continue;
 
 		ioEvent.flush( chunk );
-		this->eventQueue.insert( ioEvent );
+		// Keep the server workers off the disk if there are I/O workers
+		if ( ! IOWorker::submit( ioEvent ) )
+			this->eventQueue.insert( ioEvent );
 
 		numFlushed++;
-		if ( numFlushed == count )
-			break;
 	}
 
 	printf( "Flushing %u chunks...\n", numFlushed );
@@ -447,6 +702,16 @@ void Server::memory( FILE *f ) {
 		width, "Total size (bytes)", allocated,
 		width, "Utilization", ( double ) occupied / allocated * 100.0
 	);
+	this->snapshot.print( f );
+}
+
+void Server::takeSnapshot() {
+	if ( this->snapshot.start() ) {
+		printf( "Taking snapshot in background...\n" );
+	} else {
+		printf( "A snapshot is already running.\n" );
+		this->snapshot.print();
+	}
 }
 
 void Server::setDelay() {
@@ -526,6 +791,14 @@ void Server::debug( FILE *f ) {
 		fprintf( f, "%d. ", i + 1 );
 		this->workers[ i ].print( f );
 	}
+	for ( i = 0, len = this->codingWorkers.size(); i < len; i++ ) {
+		fprintf( f, "%d. ", ( int ) this->workers.size() + i + 1 );
+		this->codingWorkers[ i ].print( f );
+	}
+	for ( i = 0, len = this->ioWorkers.size(); i < len; i++ ) {
+		fprintf( f, "%d. ", ( int ) ( this->workers.size() + this->codingWorkers.size() ) + i + 1 );
+		this->ioWorkers[ i ].print( f );
+	}
 
 	fprintf( f, "\nOther threads\n--------------\n" );
 	this->sockets.self.printThread();
@@ -597,6 +870,9 @@ void Server::interactive() {
 		} else if ( strcmp( command, "p2disk" ) == 0 ) {
 			valid = true;
 			this->flush( true );
+		} else if ( strcmp( command, "snapshot" ) == 0 ) {
+			valid = true;
+			this->takeSnapshot();
 		} else if ( strcmp( command, "memory" ) == 0 ) {
 			valid = true;
 			this->memory();
@@ -645,6 +921,8 @@ void Server::printPending( FILE *f ) {
 	};
 	for ( int i = 0; i < 8; i++ )
 		this->pending.print( types[ i ], f );
+	this->deltaBuffer.print( f );
+	this->wal.print( f );
 }
 
 void Server::printChunk() {
@@ -683,7 +961,8 @@ void Server::help() {
 		"- chunk: Print the debug message for a chunk\n"
 		"- pending: Print all pending requests\n"
 		"- remapping: Show remapping info\n"
-		"- memory: Print memory usage\n"
+		"- snapshot: Take an online snapshot (or show the progress of the running one)\n"
+		"- memory: Print memory usage (including the snapshot)\n"
 		"- backup : Show the backup stats\n"
 		"- time: Show elapsed time\n"
 		"- exit: Terminate this client\n"
@@ -11,14 +11,19 @@
 #include "../buffer/get_chunk_buffer.hh"
 #include "../buffer/remapped_buffer.hh"
 #include "../config/server_config.hh"
+#include "../ds/checkpoint.hh"
+#include "../ds/delta_buffer.hh"
 #include "../ds/map.hh"
 #include "../ds/pending.hh"
+#include "../ds/snapshot.hh"
+#include "../ds/write_ahead_log.hh"
 #include "../event/event_queue.hh"
 #include "../state_transit/state_transit_handler.hh"
 #include "../socket/coordinator_socket.hh"
 #include "../socket/client_socket.hh"
 #include "../socket/server_socket.hh"
 #include "../socket/server_peer_socket.hh"
+#include "../worker/io_worker.hh"
 #include "../worker/worker.hh"
 #include "../../common/coding/coding.hh"
 #include "../../common/config/global_config.hh"
@@ -40,6 +45,24 @@ private:
 	bool isRunning;
 	struct timespec startTime;
 	std::vector<ServerWorker> workers;
+	std::vector<CodingWorker> codingWorkers;
+	std::vector<IOWorker> ioWorkers;
+	struct {
+		pthread_t tid;
+		volatile bool isRunning;
+	} sealBatchFlusher;
+	struct {
+		pthread_t tid;
+		volatile bool isRunning;
+	} deltaFlusher;
+	struct {
+		pthread_t tid;
+		volatile bool isRunning;
+	} backgroundSealer;
+	struct {
+		pthread_t tid;
+		volatile bool isRunning;
+	} logTruncator;
 	int myServerIndex;
 
 	Server();
@@ -48,6 +71,16 @@ private:
 	void operator=( Server const& );
 
 	void free();
+	// Wake up the workers to seal the chunks that are open for too long or hold too many replicas
+	static void *runBackgroundSealer( void *argv );
+	// Wake up the workers to send the batched SEAL_CHUNK requests that are due
+	static void *runSealBatchFlusher( void *argv );
+	// Whether no SEAL_CHUNK request is waiting in the batch of any server peer
+	bool isSealBatchDrained();
+	// Wake up the workers to send the buffered parity deltas that are due
+	static void *runDeltaFlusher( void *argv );
+	// Take a snapshot to truncate the write-ahead log once it holds too many bytes
+	static void *runLogTruncator( void *argv );
 	// Commands
 	void help();
 
@@ -81,6 +114,10 @@ public:
 	GetChunkBuffer getChunkBuffer;
 	RemappedBuffer remappedBuffer;
 	DegradedChunkBuffer degradedChunkBuffer;
+	DeltaBuffer deltaBuffer;
+	Checkpoint checkpoint;
+	WriteAheadLog wal;
+	Snapshot snapshot;
 	Timestamp timestamp;
 	LOCK_T lock;
 	struct {
@@ -109,6 +146,7 @@ public:
 	void flush( bool parityOnly = false );
 	void sync( uint32_t requestId = 0 );
 	void memory( FILE *f = stdout );
+	void takeSnapshot();
 	void setDelay();
 
 	void info( FILE *f = stdout );
@@ -86,6 +86,7 @@ void ServerPeerSocket::free() {
 		::free( this->identifier );
 		this->identifier = 0;
 	}
+	this->sealBatch.free();
 }
 
 bool ServerPeerSocket::setRecvFd( int fd, struct sockaddr_in *addr ) {
@@ -1,6 +1,7 @@
 #ifndef __SERVER_SOCKET_SERVER_PEER_SOCKET_HH__
 #define __SERVER_SOCKET_SERVER_PEER_SOCKET_HH__
 
+#include "../ds/seal_batch.hh"
 #include "../../common/ds/array_map.hh"
 #include "../../common/socket/socket.hh"
 
@@ -19,6 +20,7 @@ public:
 	char *identifier;
 	bool self;
 	uint16_t instanceId;
+	SealBatch sealBatch; // SEAL_CHUNK requests to be sent to this server
 
 	ServerPeerSocket();
 	static void setArrayMap( ArrayMap<int, ServerPeerSocket> *serverPeers );
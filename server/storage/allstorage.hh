@@ -2,5 +2,6 @@
 #define __SERVER_STORAGE_ALLSTORAGE_HH__
 
 #include "local_storage.hh"
+#include "segment_storage.hh"
 
 #endif
@@ -19,9 +19,31 @@ void LocalStorage::generatePath( uint32_t listId, uint32_t stripeId, uint32_t ch
 	);
 }
 
+LocalStorage::LocalStorage() {
+	this->pathLength = 0;
+	this->direct = false;
+	this->alignedBuffer = 0;
+	this->alignedSize = 0;
+}
+
+LocalStorage::~LocalStorage() {
+	if ( this->alignedBuffer )
+		::free( this->alignedBuffer );
+}
+
 void LocalStorage::init( ServerConfig &config ) {
 	strcpy( this->path, config.storage.path );
 	this->pathLength = strlen( this->path );
+
+	this->direct = config.storage.direct;
+	if ( this->direct ) {
+		this->alignedSize = ( ChunkUtil::chunkSize + STORAGE_DIRECT_ALIGNMENT - 1 ) / STORAGE_DIRECT_ALIGNMENT * STORAGE_DIRECT_ALIGNMENT;
+		if ( posix_memalign( ( void ** ) &this->alignedBuffer, STORAGE_DIRECT_ALIGNMENT, this->alignedSize ) != 0 ) {
+			__ERROR__( "LocalStorage", "init", "Cannot allocate aligned buffer. O_DIRECT is disabled." );
+			this->alignedBuffer = 0;
+			this->direct = false;
+		}
+	}
 }
 
 bool LocalStorage::start() {
@@ -49,6 +71,9 @@ bool LocalStorage::read( Chunk *chunk, uint32_t listId, uint32_t stripeId, uint3
 	// Determine the number of bytes to be read
 	offset = offset > 0 ? offset : 0;
 	length = length == 0 ? st.st_size : ( st.st_size - offset < ( off_t ) length ? st.st_size - offset : length );
+	// Files written with O_DIRECT are padded to the alignment
+	if ( offset + length > ChunkUtil::chunkSize )
+		length = ( size_t ) offset < ChunkUtil::chunkSize ? ChunkUtil::chunkSize - offset : 0;
 
 	fd = ::open( this->path, O_RDONLY );
 	if ( fd == -1 ) {
@@ -99,6 +124,9 @@ ssize_t LocalStorage::write( Chunk *chunk, bool sync, long offset, size_t length
 	size = ChunkUtil::chunkSize;
 	length = length == 0 ? size : ( size - offset < ( off_t ) length ? size - offset : length );
 
+	if ( this->direct && offset % STORAGE_DIRECT_ALIGNMENT == 0 )
+		return this->writeDirect( chunk, sync, offset, length );
+
 	fd = ::open( this->path, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR );
 	if ( fd == -1 ) {
 		__ERROR__( "LocalStorage", "write", "open(): %s", strerror( errno ) );
@@ -133,6 +161,47 @@ ssize_t LocalStorage::write( Chunk *chunk, bool sync, long offset, size_t length
 	return ret;
 }
 
+ssize_t LocalStorage::writeDirect( Chunk *chunk, bool sync, long offset, size_t length ) {
+	int fd;
+	ssize_t ret;
+	size_t alignedLength = ( length + STORAGE_DIRECT_ALIGNMENT - 1 ) / STORAGE_DIRECT_ALIGNMENT * STORAGE_DIRECT_ALIGNMENT;
+
+	fd = ::open( this->path, O_WRONLY | O_CREAT | O_DIRECT, S_IRUSR | S_IWUSR );
+	if ( fd == -1 ) {
+		if ( errno == EINVAL ) {
+			// The file system does not support O_DIRECT
+			__ERROR__( "LocalStorage", "writeDirect", "O_DIRECT is not supported by the file system at %s. O_DIRECT is disabled.", this->path );
+			this->direct = false;
+			return this->write( chunk, sync, offset, length );
+		}
+		__ERROR__( "LocalStorage", "writeDirect", "open(): %s", strerror( errno ) );
+		return -1;
+	}
+
+	// Copy to the aligned buffer with zero padding
+	memcpy( this->alignedBuffer, ChunkUtil::getData( chunk ) + offset, length );
+	memset( this->alignedBuffer + length, 0, alignedLength - length );
+
+	ret = ::pwrite( fd, this->alignedBuffer, alignedLength, offset );
+	if ( ret == -1 ) {
+		__ERROR__( "LocalStorage", "writeDirect", "pwrite(): %s (offset = %ld)", strerror( errno ), offset );
+	} else {
+		if ( ret < ( ssize_t ) alignedLength )
+			__ERROR__( "LocalStorage", "writeDirect", "pwrite(): Number of bytes written is fewer than the specified size." );
+		ret = ret < ( ssize_t ) length ? ret : ( ssize_t ) length;
+
+		// The data bypasses the page cache, but the file metadata may not be persisted
+		if ( sync && ::fdatasync( fd ) == -1 )
+			__ERROR__( "LocalStorage", "writeDirect", "fdatasync(): %s", strerror( errno ) );
+	}
+
+	if ( ::close( fd ) == -1 ) {
+		__ERROR__( "LocalStorage", "writeDirect", "close(): %s", strerror( errno ) );
+	}
+
+	return ret;
+}
+
 void LocalStorage::sync() {
 	::sync();
 }
@@ -3,14 +3,24 @@
 
 #include "storage.hh"
 
+// Alignment of the buffer, offset and length of O_DIRECT writes
+#define STORAGE_DIRECT_ALIGNMENT 4096
+
 class LocalStorage : public Storage {
 private:
 	size_t pathLength;
 	char path[ STORAGE_PATH_MAX ];
+	// Bypass the page cache with O_DIRECT; the chunk is copied to an aligned buffer
+	bool direct;
+	char *alignedBuffer;
+	size_t alignedSize;
 
 	void generatePath( uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isParity );
+	ssize_t writeDirect( Chunk *chunk, bool sync, long offset, size_t length );
 
 public:
+	LocalStorage();
+	~LocalStorage();
 	void init( ServerConfig &config );
 	bool start();
 	bool read( Chunk *chunk, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isParity, long offset = 0, size_t length = 0 );
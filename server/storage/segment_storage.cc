@@ -0,0 +1,475 @@
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "segment_storage.hh"
+#include "../../common/util/debug.hh"
+#include "../../common/util/time.hh"
+#include "../../common/ds/chunk_pool.hh"
+
+std::unordered_map<Metadata, SegmentLocation> SegmentStorage::index;
+std::unordered_map<uint32_t, SegmentFile> SegmentStorage::segments;
+std::vector<SegmentWriter *> SegmentStorage::writers;
+LOCK_T SegmentStorage::lock;
+uint32_t SegmentStorage::nextSegmentId;
+std::atomic<uint64_t> SegmentStorage::sequence;
+uint32_t SegmentStorage::instances;
+bool SegmentStorage::isInitialized;
+pthread_t SegmentStorage::syncer;
+volatile bool SegmentStorage::isSyncing;
+
+SegmentStorage::SegmentStorage() {
+	this->pathLength = 0;
+	this->segmentSize = 0;
+	this->writer = 0;
+}
+
+SegmentStorage::~SegmentStorage() {}
+
+void SegmentStorage::generatePath( uint32_t segmentId ) {
+	snprintf(
+		this->path + this->pathLength,
+		STORAGE_PATH_MAX - this->pathLength,
+		"/%u.seg",
+		segmentId
+	);
+}
+
+void SegmentStorage::init( ServerConfig &config ) {
+	// The workers are initialized one by one
+	if ( ! SegmentStorage::isInitialized ) {
+		LOCK_INIT( &SegmentStorage::lock );
+		SegmentStorage::nextSegmentId = 0;
+		SegmentStorage::sequence = 0;
+		SegmentStorage::instances = 0;
+		SegmentStorage::isSyncing = false;
+		SegmentStorage::isInitialized = true;
+	}
+
+	strcpy( this->path, config.storage.path );
+	this->pathLength = strlen( this->path );
+	this->segmentSize = config.storage.segmentSize;
+
+	this->writer = new SegmentWriter();
+	this->writer->fd = -1;
+	this->writer->segmentId = 0;
+	this->writer->segmentOffset = 0;
+	this->writer->syncInterval = config.storage.syncInterval;
+	this->writer->isDirty = false;
+	// Hold at least one full chunk
+	this->writer->buffer.capacity = SEGMENT_RECORD_HEADER_SIZE + ChunkUtil::chunkSize;
+	if ( this->writer->buffer.capacity < config.storage.writeBufferSize )
+		this->writer->buffer.capacity = config.storage.writeBufferSize;
+	this->writer->buffer.data = ( char * ) malloc( this->writer->buffer.capacity );
+	this->writer->buffer.size = 0;
+	this->writer->buffer.offset = 0;
+	LOCK_INIT( &this->writer->lock );
+}
+
+bool SegmentStorage::start() {
+	bool ret = true;
+
+	this->writer->lastSync = start_timer();
+
+	LOCK( &SegmentStorage::lock );
+	if ( SegmentStorage::instances == 0 ) {
+		ret = this->load();
+		// Without a sync interval, every write is synchronized
+		SegmentStorage::isSyncing = ( this->writer->syncInterval > 0 );
+		if ( SegmentStorage::isSyncing && pthread_create( &SegmentStorage::syncer, NULL, SegmentStorage::runSyncer, ( void * ) this->writer ) != 0 ) {
+			__ERROR__( "SegmentStorage", "start", "Cannot start the thread for synchronizing the segments in background." );
+			SegmentStorage::isSyncing = false;
+		}
+	}
+	SegmentStorage::instances++;
+	SegmentStorage::writers.push_back( this->writer );
+	UNLOCK( &SegmentStorage::lock );
+
+	return ret;
+}
+
+void *SegmentStorage::runSyncer( void *argv ) {
+	uint32_t interval = ( ( SegmentWriter * ) argv )->syncInterval;
+	struct timespec ts = { interval / 1000, ( long )( interval % 1000 ) * MILLION };
+	std::vector<SegmentWriter *> writers;
+
+	while ( SegmentStorage::isSyncing ) {
+		nanosleep( &ts, 0 );
+
+		LOCK( &SegmentStorage::lock );
+		writers = SegmentStorage::writers;
+		UNLOCK( &SegmentStorage::lock );
+
+		for ( size_t i = 0, size = writers.size(); i < size; i++ ) {
+			LOCK( &writers[ i ]->lock );
+			if ( writers[ i ]->fd != -1 )
+				SegmentStorage::sync( writers[ i ], false );
+			UNLOCK( &writers[ i ]->lock );
+		}
+	}
+
+	pthread_exit( 0 );
+	return 0;
+}
+
+bool SegmentStorage::load() {
+	DIR *dir;
+	struct dirent *ent;
+	std::vector<uint32_t> segmentIds;
+	char *end;
+	uint32_t segmentId;
+	int fd;
+
+	this->path[ this->pathLength ] = '\0';
+	dir = ::opendir( this->path );
+	if ( ! dir ) {
+		__ERROR__( "SegmentStorage", "load", "opendir(): %s", strerror( errno ) );
+		return false;
+	}
+	while ( ( ent = ::readdir( dir ) ) ) {
+		segmentId = strtoul( ent->d_name, &end, 10 );
+		if ( end != ent->d_name && strcmp( end, ".seg" ) == 0 )
+			segmentIds.push_back( segmentId );
+	}
+	::closedir( dir );
+
+	std::sort( segmentIds.begin(), segmentIds.end() );
+	for ( size_t i = 0, size = segmentIds.size(); i < size; i++ ) {
+		this->generatePath( segmentIds[ i ] );
+		fd = ::open( this->path, O_RDONLY );
+		if ( fd == -1 ) {
+			__ERROR__( "SegmentStorage", "load", "open(): %s", strerror( errno ) );
+			continue;
+		}
+		this->load( segmentIds[ i ], fd );
+		SegmentStorage::segments[ segmentIds[ i ] ] = { .fd = fd, .writer = 0 };
+		SegmentStorage::nextSegmentId = segmentIds[ i ] + 1;
+	}
+
+	if ( ! SegmentStorage::index.empty() ) {
+		__INFO__(
+			GREEN, "SegmentStorage", "load",
+			"Loaded %lu chunks from %lu segments.",
+			SegmentStorage::index.size(), segmentIds.size()
+		);
+	}
+	return true;
+}
+
+bool SegmentStorage::load( uint32_t segmentId, int fd ) {
+	struct SegmentRecordHeader header;
+	SegmentLocation location;
+	Metadata metadata;
+	struct stat st;
+	uint64_t offset = 0;
+	ssize_t ret;
+
+	if ( ::fstat( fd, &st ) != 0 ) {
+		__ERROR__( "SegmentStorage", "load", "fstat(): %s", strerror( errno ) );
+		return false;
+	}
+
+	while ( offset + SEGMENT_RECORD_HEADER_SIZE <= ( uint64_t ) st.st_size ) {
+		ret = ::pread( fd, &header, SEGMENT_RECORD_HEADER_SIZE, offset );
+		if ( ret != ( ssize_t ) SEGMENT_RECORD_HEADER_SIZE ) {
+			__ERROR__( "SegmentStorage", "load", "pread(): %s", ret == -1 ? strerror( errno ) : "Truncated record header." );
+			return false;
+		}
+		offset += SEGMENT_RECORD_HEADER_SIZE;
+		if (
+			header.magic != SEGMENT_STORAGE_MAGIC ||
+			header.length > ChunkUtil::chunkSize ||
+			offset + header.length > ( uint64_t ) st.st_size
+		) {
+			// Ignore the partially written tail
+			__ERROR__( "SegmentStorage", "load", "Invalid record at offset %lu of segment #%u.", offset - SEGMENT_RECORD_HEADER_SIZE, segmentId );
+			return false;
+		}
+
+		metadata.set( header.listId, header.stripeId, header.chunkId );
+		location.segmentId = segmentId;
+		location.offset = offset;
+		location.length = header.length;
+		location.sequence = header.sequence;
+
+		std::unordered_map<Metadata, SegmentLocation>::iterator it = SegmentStorage::index.find( metadata );
+		if ( it == SegmentStorage::index.end() )
+			SegmentStorage::index[ metadata ] = location;
+		else if ( it->second.sequence < location.sequence )
+			it->second = location;
+
+		if ( header.sequence >= SegmentStorage::sequence )
+			SegmentStorage::sequence = header.sequence + 1;
+
+		offset += header.length;
+	}
+	return true;
+}
+
+bool SegmentStorage::open() {
+	SegmentWriter *writer = this->writer;
+	int fd;
+
+	LOCK( &SegmentStorage::lock );
+	// The previous segment (if any) is written out already
+	if ( writer->fd != -1 )
+		SegmentStorage::segments[ writer->segmentId ].writer = 0;
+	writer->fd = -1;
+
+	this->generatePath( SegmentStorage::nextSegmentId );
+	fd = ::open( this->path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
+	if ( fd == -1 ) {
+		UNLOCK( &SegmentStorage::lock );
+		__ERROR__( "SegmentStorage", "open", "open(): %s", strerror( errno ) );
+		return false;
+	}
+	writer->fd = fd;
+	writer->segmentId = SegmentStorage::nextSegmentId++;
+	writer->segmentOffset = 0;
+	writer->buffer.offset = 0;
+	SegmentStorage::segments[ writer->segmentId ] = { .fd = fd, .writer = writer };
+	UNLOCK( &SegmentStorage::lock );
+
+	return true;
+}
+
+bool SegmentStorage::flush( SegmentWriter *writer ) {
+	size_t written = 0;
+	ssize_t ret;
+
+	if ( ! writer->buffer.size )
+		return true;
+
+	while ( written < writer->buffer.size ) {
+		ret = ::pwrite(
+			writer->fd,
+			writer->buffer.data + written,
+			writer->buffer.size - written,
+			writer->buffer.offset + written
+		);
+		if ( ret == -1 ) {
+			if ( errno == EINTR )
+				continue;
+			__ERROR__( "SegmentStorage", "flush", "pwrite(): %s", strerror( errno ) );
+			return false;
+		}
+		written += ret;
+	}
+
+	writer->buffer.offset += writer->buffer.size;
+	writer->buffer.size = 0;
+	writer->isDirty = true;
+	return true;
+}
+
+bool SegmentStorage::sync( SegmentWriter *writer, bool force ) {
+	if ( ! force && get_elapsed_time( writer->lastSync ) * 1000 < writer->syncInterval )
+		return true;
+
+	bool ret = SegmentStorage::flush( writer );
+	if ( writer->isDirty ) {
+		if ( ::fdatasync( writer->fd ) == -1 ) {
+			__ERROR__( "SegmentStorage", "sync", "fdatasync(): %s", strerror( errno ) );
+			ret = false;
+		}
+		writer->isDirty = false;
+	}
+	writer->lastSync = start_timer();
+	return ret;
+}
+
+bool SegmentStorage::readBuffer( SegmentWriter *writer, uint32_t segmentId, uint64_t offset, char *data, size_t length ) {
+	bool ret = false;
+
+	LOCK( &writer->lock );
+	if ( writer->fd != -1 && writer->segmentId == segmentId && offset >= writer->buffer.offset ) {
+		memcpy( data, writer->buffer.data + ( offset - writer->buffer.offset ), length );
+		ret = true;
+	}
+	UNLOCK( &writer->lock );
+
+	return ret;
+}
+
+bool SegmentStorage::read( Chunk *chunk, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isParity, long offset, size_t length ) {
+	std::unordered_map<Metadata, SegmentLocation>::iterator it;
+	std::unordered_map<uint32_t, SegmentFile>::iterator segmentsIt;
+	SegmentLocation location;
+	SegmentFile segment;
+	Metadata metadata;
+	size_t stored;
+	ssize_t ret = 0;
+
+	metadata.set( listId, stripeId, chunkId );
+
+	LOCK( &SegmentStorage::lock );
+	it = SegmentStorage::index.find( metadata );
+	if ( it == SegmentStorage::index.end() ) {
+		UNLOCK( &SegmentStorage::lock );
+		__ERROR__( "SegmentStorage", "read", "Chunk (%u, %u, %u) is not found.", listId, stripeId, chunkId );
+		return false;
+	}
+	location = it->second;
+	segmentsIt = SegmentStorage::segments.find( location.segmentId );
+	if ( segmentsIt == SegmentStorage::segments.end() )
+		segment = { .fd = -1, .writer = 0 };
+	else
+		segment = segmentsIt->second;
+	UNLOCK( &SegmentStorage::lock );
+
+	if ( segment.fd == -1 ) {
+		__ERROR__( "SegmentStorage", "read", "Segment #%u is not opened.", location.segmentId );
+		return false;
+	}
+
+	// Determine the number of bytes to be read
+	offset = offset > 0 ? offset : 0;
+	if ( ( size_t ) offset >= ChunkUtil::chunkSize )
+		return false;
+	length = ( length == 0 || offset + length > ChunkUtil::chunkSize ) ? ChunkUtil::chunkSize - offset : length;
+	stored = ( size_t ) offset < location.length ? location.length - offset : 0;
+	if ( stored > length )
+		stored = length;
+
+	// Read data to chunk; the trailing zeros are not stored
+	if ( stored && segment.writer && SegmentStorage::readBuffer( segment.writer, location.segmentId, location.offset + offset, ChunkUtil::getData( chunk ) + offset, stored ) ) {
+		ret = stored;
+	} else if ( stored ) {
+		ret = ::pread( segment.fd, ChunkUtil::getData( chunk ) + offset, stored, location.offset + offset );
+		if ( ret == -1 ) {
+			__ERROR__( "SegmentStorage", "read", "pread(): %s", strerror( errno ) );
+			return false;
+		} else if ( ret < ( ssize_t ) stored ) {
+			__ERROR__( "SegmentStorage", "read", "pread(): Number of bytes read is fewer than the specified size." );
+		}
+	}
+	memset( ChunkUtil::getData( chunk ) + offset + ret, 0, length - ret );
+
+	ChunkUtil::set( chunk, listId, stripeId, chunkId );
+
+	return true;
+}
+
+ssize_t SegmentStorage::write( Chunk *chunk, bool sync, long offset, size_t length ) {
+	struct SegmentRecordHeader header;
+	SegmentLocation location;
+	SegmentWriter *writer = this->writer;
+	Metadata metadata = ChunkUtil::getMetadata( chunk );
+	char *data = ChunkUtil::getData( chunk );
+	std::unordered_map<Metadata, SegmentLocation>::iterator it;
+	uint32_t size;
+
+	// Records cannot be updated in place: the whole chunk is appended
+	// regardless of the range, without the trailing zeros
+	for ( size = ChunkUtil::chunkSize; size > 0 && ! data[ size - 1 ]; size-- );
+
+	LOCK( &writer->lock );
+	if ( writer->fd == -1 || (
+		writer->segmentOffset > 0 &&
+		writer->segmentOffset + SEGMENT_RECORD_HEADER_SIZE + size > this->segmentSize
+	) ) {
+		// Seal the current segment and start a new one
+		if ( ( writer->fd != -1 && ! SegmentStorage::sync( writer, true ) ) || ! this->open() ) {
+			UNLOCK( &writer->lock );
+			return -1;
+		}
+	}
+
+	if ( writer->buffer.size + SEGMENT_RECORD_HEADER_SIZE + size > writer->buffer.capacity ) {
+		if ( ! SegmentStorage::flush( writer ) ) {
+			UNLOCK( &writer->lock );
+			return -1;
+		}
+	}
+
+	header.magic = SEGMENT_STORAGE_MAGIC;
+	header.listId = metadata.listId;
+	header.stripeId = metadata.stripeId;
+	header.chunkId = metadata.chunkId;
+	header.length = size;
+	header.sequence = SegmentStorage::sequence++;
+
+	memcpy( writer->buffer.data + writer->buffer.size, &header, SEGMENT_RECORD_HEADER_SIZE );
+	memcpy( writer->buffer.data + writer->buffer.size + SEGMENT_RECORD_HEADER_SIZE, data, size );
+	writer->buffer.size += SEGMENT_RECORD_HEADER_SIZE + size;
+
+	location.segmentId = writer->segmentId;
+	location.offset = writer->segmentOffset + SEGMENT_RECORD_HEADER_SIZE;
+	location.length = size;
+	location.sequence = header.sequence;
+
+	// The buffered record can be read now
+	LOCK( &SegmentStorage::lock );
+	it = SegmentStorage::index.find( metadata );
+	if ( it == SegmentStorage::index.end() )
+		SegmentStorage::index[ metadata ] = location;
+	else if ( it->second.sequence < location.sequence )
+		it->second = location;
+	UNLOCK( &SegmentStorage::lock );
+
+	writer->segmentOffset += SEGMENT_RECORD_HEADER_SIZE + size;
+
+	if ( ! SegmentStorage::sync( writer, sync ) ) {
+		UNLOCK( &writer->lock );
+		return -1;
+	}
+	UNLOCK( &writer->lock );
+
+	return size;
+}
+
+void SegmentStorage::sync() {
+	LOCK( &this->writer->lock );
+	if ( this->writer->fd != -1 )
+		SegmentStorage::sync( this->writer, true );
+	UNLOCK( &this->writer->lock );
+}
+
+void SegmentStorage::stop() {
+	bool isLast;
+
+	LOCK( &this->writer->lock );
+	if ( this->writer->fd != -1 ) {
+		SegmentStorage::sync( this->writer, true );
+		LOCK( &SegmentStorage::lock );
+		SegmentStorage::segments[ this->writer->segmentId ].writer = 0;
+		UNLOCK( &SegmentStorage::lock );
+		this->writer->fd = -1;
+	}
+	UNLOCK( &this->writer->lock );
+
+	LOCK( &SegmentStorage::lock );
+	SegmentStorage::instances--;
+	isLast = ( SegmentStorage::instances == 0 );
+	if ( isLast ) {
+		for (
+			std::unordered_map<uint32_t, SegmentFile>::iterator it = SegmentStorage::segments.begin();
+			it != SegmentStorage::segments.end();
+			it++
+		) {
+			if ( ::close( it->second.fd ) == -1 )
+				__ERROR__( "SegmentStorage", "stop", "close(): %s", strerror( errno ) );
+		}
+		SegmentStorage::segments.clear();
+		SegmentStorage::index.clear();
+	}
+	UNLOCK( &SegmentStorage::lock );
+
+	if ( ! isLast )
+		return;
+
+	// No readers or writers remain
+	if ( SegmentStorage::isSyncing ) {
+		SegmentStorage::isSyncing = false;
+		pthread_join( SegmentStorage::syncer, 0 );
+	}
+	for ( size_t i = 0, size = SegmentStorage::writers.size(); i < size; i++ ) {
+		::free( SegmentStorage::writers[ i ]->buffer.data );
+		delete SegmentStorage::writers[ i ];
+	}
+	SegmentStorage::writers.clear();
+}
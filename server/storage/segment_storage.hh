@@ -0,0 +1,113 @@
+#ifndef __SERVER_STORAGE_SEGMENT_STORAGE_HH__
+#define __SERVER_STORAGE_SEGMENT_STORAGE_HH__
+
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <pthread.h>
+#include <time.h>
+#include "storage.hh"
+#include "../../common/ds/metadata.hh"
+#include "../../common/lock/lock.hh"
+
+#define SEGMENT_STORAGE_MAGIC   0x5345474d // "SEGM"
+
+// Header of each chunk record in a segment file
+struct SegmentRecordHeader {
+	uint32_t magic;
+	uint32_t listId;
+	uint32_t stripeId;
+	uint32_t chunkId;
+	uint32_t length;   // Number of bytes of the chunk data that follow the header
+	uint64_t sequence; // Orders the records of the same chunk across segments
+} __attribute__((__packed__));
+
+#define SEGMENT_RECORD_HEADER_SIZE sizeof( struct SegmentRecordHeader )
+
+struct SegmentLocation {
+	uint32_t segmentId;
+	uint64_t offset;   // Offset of the chunk data in the segment file
+	uint32_t length;
+	uint64_t sequence;
+};
+
+// Segment being appended to by a storage instance
+struct SegmentWriter {
+	int fd;
+	uint32_t segmentId;
+	uint64_t segmentOffset; // Including the buffered records
+	uint32_t syncInterval;  // in milliseconds
+	bool isDirty;           // Whether there are written but unsynchronized records
+	struct timespec lastSync;
+	struct {
+		char *data;
+		size_t capacity;
+		size_t size;
+		uint64_t offset;    // Offset of the buffer in the segment file
+	} buffer;
+	LOCK_T lock;            // Shared with the readers and the background syncer
+};
+
+struct SegmentFile {
+	int fd;
+	SegmentWriter *writer;  // 0 if no instance appends to the segment
+};
+
+/**
+ * Stores the flushed chunks as records appended to large segment files
+ * ("<segment ID>.seg") instead of one file per chunk. Each worker appends
+ * to its own segment through a write buffer, which is written with one
+ * system call when it fills up. A background thread writes out the
+ * buffers and synchronizes them with fdatasync() every sync interval, so
+ * that the records of idle workers are not held back. The latest record
+ * of each chunk is located by an in-memory index shared by all workers,
+ * which is rebuilt by scanning the segments when the server starts. The
+ * buffered records are indexed as well and read from the write buffers.
+ *
+ * Records are never overwritten; the space of outdated records is not
+ * reclaimed.
+ */
+class SegmentStorage : public Storage {
+private:
+	// Shared by the storage instances of all workers
+	static std::unordered_map<Metadata, SegmentLocation> index;
+	static std::unordered_map<uint32_t, SegmentFile> segments; // Segment ID -> segment file
+	// Released when the last instance stops so that the readers never see a freed writer
+	static std::vector<SegmentWriter *> writers;
+	static LOCK_T lock;
+	static uint32_t nextSegmentId;
+	static std::atomic<uint64_t> sequence;
+	static uint32_t instances;
+	static bool isInitialized;
+	static pthread_t syncer;
+	static volatile bool isSyncing;
+
+	size_t pathLength;
+	char path[ STORAGE_PATH_MAX ];
+	uint64_t segmentSize;
+	SegmentWriter *writer;
+
+	void generatePath( uint32_t segmentId );
+	// Rebuild the index from the existing segments
+	bool load();
+	bool load( uint32_t segmentId, int fd );
+	// The writer is locked when these functions are called
+	bool open();
+	static bool flush( SegmentWriter *writer );
+	static bool sync( SegmentWriter *writer, bool force );
+	// Copy the record data from the write buffer; false if it is written out already
+	static bool readBuffer( SegmentWriter *writer, uint32_t segmentId, uint64_t offset, char *data, size_t length );
+	static void *runSyncer( void *argv );
+
+public:
+	SegmentStorage();
+	~SegmentStorage();
+	void init( ServerConfig &config );
+	bool start();
+	bool read( Chunk *chunk, uint32_t listId, uint32_t stripeId, uint32_t chunkId, bool isParity, long offset = 0, size_t length = 0 );
+	ssize_t write( Chunk *chunk, bool sync, long offset = 0, size_t length = 0 );
+	void sync();
+	void stop();
+};
+
+#endif
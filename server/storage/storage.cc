@@ -12,6 +12,9 @@ Storage *Storage::instantiate( ServerConfig &config ) {
 		case STORAGE_TYPE_LOCAL:
 			ret = new LocalStorage();
 			break;
+		case STORAGE_TYPE_SEGMENT:
+			ret = new SegmentStorage();
+			break;
 		default:
 			return 0;
 	}
@@ -24,6 +27,9 @@ void Storage::destroy( Storage *storage ) {
 		case STORAGE_TYPE_LOCAL:
 			delete static_cast<LocalStorage *>( storage );
 			break;
+		case STORAGE_TYPE_SEGMENT:
+			delete static_cast<SegmentStorage *>( storage );
+			break;
 		default:
 			return;
 	}
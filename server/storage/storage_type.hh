@@ -3,7 +3,8 @@
 
 enum StorageType {
 	STORAGE_TYPE_UNDEFINED,
-	STORAGE_TYPE_LOCAL
+	STORAGE_TYPE_LOCAL,
+	STORAGE_TYPE_SEGMENT
 };
 
 #endif
@@ -39,6 +39,20 @@ void ServerWorker::dispatch( ClientEvent event ) {
 			break;
 	}
 
+	switch( event.type ) {
+		case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_DATA:
+		case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_PARITY:
+		case CLIENT_EVENT_TYPE_UPDATE_RESPONSE_SUCCESS:
+		case CLIENT_EVENT_TYPE_DELETE_RESPONSE_SUCCESS:
+			// Acknowledge the modifications only after they are durable; the
+			// log inserts the response into the event queue again after the commit
+			if ( ! event.isDurable && ServerWorker::wal->park( event ) )
+				return;
+			break;
+		default:
+			break;
+	}
+
 	buffer.data = this->protocol.buffer.send;
 	buffer.size = 0;
 
@@ -126,6 +140,9 @@ void ServerWorker::dispatch( ClientEvent event ) {
 					event.message.set.key.isLarge
 				);
 			}
+
+			if ( event.needsFree )
+				event.message.set.key.free();
 			break;
 		case CLIENT_EVENT_TYPE_SET_RESPONSE_SUCCESS_PARITY:
 		case CLIENT_EVENT_TYPE_SET_RESPONSE_FAILURE:
@@ -138,6 +155,9 @@ void ServerWorker::dispatch( ClientEvent event ) {
 				event.message.set.key.data,
 				event.message.set.key.isLarge
 			);
+
+			if ( event.needsFree )
+				event.message.set.key.free();
 			break;
 		case CLIENT_EVENT_TYPE_DEGRADED_SET_RESPONSE_SUCCESS:
 		case CLIENT_EVENT_TYPE_DEGRADED_SET_RESPONSE_FAILURE:
@@ -406,6 +426,7 @@ bool ServerWorker::handleSetRequest( ClientEvent event, char *buf, size_t size,
 bool ServerWorker::handleSetRequest( ClientEvent event, struct KeyValueHeader &header, bool needResSet ) {
 	uint8_t sealedCount;
 	Metadata sealed[ 2 ];
+	KeyMetadata keyMetadata;
 	uint32_t timestamp, listId, stripeId, chunkId, splitIndex;
 	ServerPeerSocket *dataServerSocket;
 	bool exist = false, isLarge;
@@ -439,7 +460,13 @@ bool ServerWorker::handleSetRequest( ClientEvent event, struct KeyValueHeader &h
 			stripeId, chunkId, header.splitOffset,
 			&sealedCount, &sealed[ 0 ], &sealed[ 1 ],
 			this->chunks, this->dataChunk, this->parityChunk,
-			ServerWorker::getChunkBuffer
+			ServerWorker::getChunkBuffer,
+			&keyMetadata
+		);
+		ServerWorker::wal->appendObject(
+			header.key, header.keySize, header.value, header.valueSize, header.splitOffset,
+			listId, stripeId, chunkId, keyMetadata.offset,
+			! dataServerSocket->self // isReplica
 		);
 	}
 
@@ -585,9 +612,13 @@ bool ServerWorker::handleUpdateRequest(
 		if ( checkGetChunk ) {
 			ServerWorker::getChunkBuffer->insert(
 				metadata,
-				chunkBufferIndex == -1 /* isSealed */ ? chunk : 0
+				chunkBufferIndex == -1 /* isSealed */ ? chunk : 0,
+				offset, header.valueUpdateSize
 			);
+		} else if ( chunkBufferIndex == -1 ) {
+			ServerWorker::getChunkBuffer->preserve( chunk, offset, header.valueUpdateSize );
 		}
+		ServerWorker::snapshot->preserve( chunk );
 
 		ChunkUtil::computeDelta(
 			chunk,
@@ -596,6 +627,16 @@ bool ServerWorker::handleUpdateRequest(
 			offset, header.valueUpdateSize,
 			true // perform update
 		);
+		ServerWorker::chunkPool->setDirty( chunk );
+		// The value update is replaced by the delta; log the new value from
+		// the chunk before the locks are released so that the records of the
+		// same object are in the order they are applied
+		ServerWorker::wal->append(
+			PROTO_OPCODE_UPDATE,
+			header.key, header.keySize + ( isLarge ? SPLIT_OFFSET_SIZE : 0 ),
+			metadata, keyMetadata.offset,
+			ChunkUtil::getData( chunk ) + offset, header.valueUpdateSize, header.valueUpdateOffset
+		);
 		// Release the locks
 		UNLOCK( chunksLock );
 		UNLOCK( keysLock );
@@ -817,7 +858,14 @@ bool ServerWorker::handleDeleteRequest(
 			}
 		}
 		ServerWorker::map->deleteKey( key, PROTO_OPCODE_DELETE, timestamp, keyMetadata, false, false );
+		ServerWorker::getChunkBuffer->preserve( chunk, keyMetadata.offset, keyMetadata.length );
+		ServerWorker::snapshot->preserve( chunk );
 		deltaSize = ChunkUtil::deleteObject( chunk, keyMetadata.offset, delta );
+		ServerWorker::chunkPool->setDirty( chunk );
+		ServerWorker::wal->append(
+			PROTO_OPCODE_DELETE, header.key, header.keySize,
+			metadata, ( uint32_t )( keyValue.data - ChunkUtil::getData( chunk ) )
+		);
 		// Release the locks
 		UNLOCK( chunksLock );
 		UNLOCK( keysLock );
@@ -1044,6 +1092,8 @@ bool ServerWorker::handleRevertDelta( ClientEvent event, char *buf, size_t size
 					true, true, false \
 				); \
 				this->dispatch( clientEvent ); \
+				if ( _PT_TYPE_ == PT_SERVER_PEER_UPDATE_CHUNK && ServerWorker::deltaBuffer->isEnabled() ) \
+					this->respondCoalescedUpdates( it->first.requestId, true ); \
 				/*__INFO__( YELLOW, "ServerWorker", "handleRevertDelta", "Skip waiting for key %.*s for failed server id=%u", keyValueUpdate.size, keyValueUpdate.data, header.targetId ); */\
 			} else if ( strcmp( #_OP_TYPE_, "delete" ) == 0 || strcmp( #_OP_TYPE_, "deleteChunk" ) == 0 ) { \
 				if ( ! ServerWorker::pending->eraseKey( _PT_CLIENT_TYPE_, it->first.parentInstanceId, it->first.parentRequestId, 0, &pid, &key ) ) { \
@@ -0,0 +1,338 @@
+#include "coding_worker.hh"
+#include "../main/server.hh"
+
+// Byte ranges are aligned for the vectorized kernels
+#define CODING_WORKER_ALIGNMENT 64
+// Maximum number of queued stripes decoded in one call
+#define CODING_WORKER_BATCH_SIZE 16
+
+uint32_t CodingWorker::dataChunkCount;
+uint32_t CodingWorker::parityChunkCount;
+uint32_t CodingWorker::chunkCount;
+uint32_t CodingWorker::workerCount;
+uint32_t CodingWorker::splitSize;
+BasicEventQueueT<CodingEvent> *CodingWorker::eventQueue;
+std::vector<DecodeTask *> CodingWorker::idleTasks;
+LOCK_T CodingWorker::idleTasksLock;
+
+DecodeTask::DecodeTask( uint32_t dataChunkCount, uint32_t parityChunkCount ) {
+	TempChunkPool tempChunkPool;
+	uint32_t chunkCount = dataChunkCount + parityChunkCount;
+
+	this->dataChunkCount = dataChunkCount;
+	this->parityChunkCount = parityChunkCount;
+	this->chunks = new Chunk*[ chunkCount ];
+	this->freeChunks = new Chunk*[ dataChunkCount ];
+	for ( uint32_t i = 0; i < dataChunkCount; i++ )
+		this->freeChunks[ i ] = tempChunkPool.alloc();
+	this->chunkStatus = new BitmaskArray( chunkCount, 1 );
+	this->chunkStatusBackup = new BitmaskArray( chunkCount, 1 );
+	this->sealIndicators = new bool*[ parityChunkCount + 2 ];
+	this->sealIndicators[ parityChunkCount ] = new bool[ dataChunkCount ];
+	this->sealIndicators[ parityChunkCount + 1 ] = new bool[ dataChunkCount ];
+
+	this->toBeFreed = 0;
+	this->isLocalRepair = false;
+	this->repairedChunkId = 0;
+
+	this->parts = 1;
+	this->remaining = 0;
+	LOCK_INIT( &this->lock );
+	this->lostCount = 0;
+	this->lostIds = new uint32_t[ chunkCount ];
+	this->helperCount = 0;
+	this->helperIds = new uint32_t[ chunkCount ];
+	this->coefficients = new uint8_t[ chunkCount * chunkCount ];
+}
+
+DecodeTask::~DecodeTask() {
+	TempChunkPool tempChunkPool;
+
+	delete[] this->chunks;
+	for ( uint32_t i = 0; i < this->dataChunkCount; i++ )
+		tempChunkPool.free( this->freeChunks[ i ] );
+	delete[] this->freeChunks;
+	delete this->chunkStatus;
+	delete this->chunkStatusBackup;
+	delete[] this->sealIndicators[ this->parityChunkCount ];
+	delete[] this->sealIndicators[ this->parityChunkCount + 1 ];
+	delete[] this->sealIndicators;
+
+	delete[] this->lostIds;
+	delete[] this->helperIds;
+	delete[] this->coefficients;
+}
+
+void CodingWorker::dispatch( CodingEvent event ) {
+	switch( event.type ) {
+		case CODING_EVENT_TYPE_DECODE_PART:
+			if ( ! CodingWorker::execute( event.message.task.task, event.message.task.part ) )
+				CodingWorker::notify( event.message.task.task );
+			break;
+		default:
+			__ERROR__( "CodingWorker", "dispatch", "Unsupported event type." );
+			break;
+	}
+}
+
+void CodingWorker::decodeBatch( DecodeTask **tasks, uint32_t count ) {
+	Chunk **stripes[ CODING_WORKER_BATCH_SIZE ];
+
+	for ( uint32_t i = 0; i < count; i++ )
+		stripes[ i ] = tasks[ i ]->chunks;
+	Server::getInstance()->coding->decodeBatch( stripes, count, tasks[ 0 ]->chunkStatus );
+
+	for ( uint32_t i = 0; i < count; i++ ) {
+		if ( ! CodingWorker::complete( tasks[ i ] ) )
+			CodingWorker::notify( tasks[ i ] );
+	}
+}
+
+bool CodingWorker::isWholeStripe( CodingEvent &event ) {
+	return event.type == CODING_EVENT_TYPE_DECODE_PART && event.message.task.task->parts == 1;
+}
+
+bool CodingWorker::isSameErasure( DecodeTask *a, DecodeTask *b ) {
+	for ( uint32_t i = 0; i < CodingWorker::chunkCount; i++ ) {
+		if ( a->chunkStatus->check( i ) != b->chunkStatus->check( i ) )
+			return false;
+	}
+	return true;
+}
+
+void CodingWorker::plan( DecodeTask *task ) {
+	Coding *coding = Server::getInstance()->coding;
+	uint32_t parts = CodingWorker::splitSize ? ChunkUtil::chunkSize / CodingWorker::splitSize : 1;
+
+	task->parts = 1;
+	task->lostCount = 0;
+	for ( uint32_t i = 0; i < CodingWorker::chunkCount; i++ ) {
+		if ( ! task->chunkStatus->check( i ) )
+			task->lostIds[ task->lostCount++ ] = i;
+	}
+
+	if ( parts > CodingWorker::workerCount )
+		parts = CodingWorker::workerCount;
+	if ( parts < 2 || task->lostCount == 0 )
+		return;
+
+	// Helpers
+	if ( task->isLocalRepair ) {
+		if ( task->lostCount != 1 || task->lostIds[ 0 ] != task->repairedChunkId )
+			return;
+		task->helperCount = coding->getRepairSet( task->repairedChunkId, task->helperIds );
+	} else {
+		task->helperCount = 0;
+		for ( uint32_t i = 0; i < CodingWorker::chunkCount && task->helperCount < CodingWorker::dataChunkCount; i++ ) {
+			if ( task->chunkStatus->check( i ) )
+				task->helperIds[ task->helperCount++ ] = i;
+		}
+		if ( task->helperCount < CodingWorker::dataChunkCount )
+			return;
+	}
+	if ( task->helperCount == 0 )
+		return;
+
+	for ( uint32_t i = 0; i < task->lostCount; i++ ) {
+		if ( ! coding->getRepairCoefficients(
+			task->lostIds[ i ],
+			task->helperIds, task->helperCount,
+			task->coefficients + i * task->helperCount
+		) )
+			return;
+	}
+	task->parts = parts;
+}
+
+bool CodingWorker::execute( DecodeTask *task, uint32_t part ) {
+	if ( task->parts == 1 ) {
+		Server::getInstance()->coding->decode( task->chunks, task->chunkStatus );
+	} else {
+		uint32_t from = ( uint64_t ) ChunkUtil::chunkSize * part / task->parts;
+		uint32_t to = ( part == task->parts - 1 ) ? ChunkUtil::chunkSize : ( uint64_t ) ChunkUtil::chunkSize * ( part + 1 ) / task->parts;
+
+		from -= from % CODING_WORKER_ALIGNMENT;
+		if ( part != task->parts - 1 )
+			to -= to % CODING_WORKER_ALIGNMENT;
+
+		for ( uint32_t i = 0; i < task->lostCount; i++ ) {
+			char *dst = ChunkUtil::getData( task->chunks[ task->lostIds[ i ] ] ) + from;
+			uint8_t *coefficients = task->coefficients + i * task->helperCount;
+
+			memset( dst, 0, to - from );
+			for ( uint32_t j = 0; j < task->helperCount; j++ ) {
+				Chunk *helper = task->chunks[ task->helperIds[ j ] ];
+				if ( helper == Coding::zeros )
+					continue;
+				Coding::multiplyXOR( dst, ChunkUtil::getData( helper ) + from, coefficients[ j ], to - from );
+			}
+		}
+	}
+
+	return CodingWorker::complete( task );
+}
+
+bool CodingWorker::complete( DecodeTask *task ) {
+	bool isCompleted;
+	LOCK( &task->lock );
+	isCompleted = ( --task->remaining == 0 );
+	UNLOCK( &task->lock );
+
+	if ( isCompleted ) {
+		CodingEvent event;
+		event.decodeCompleted( task );
+		return Server::getInstance()->eventQueue.insert( event );
+	}
+	return true;
+}
+
+void CodingWorker::notify( DecodeTask *task ) {
+	// The coding workers are stopped before the event queue of the server
+	// workers (see Server::stop()), so the stripe is never dropped
+	struct timespec ts = { 0, 1000000 }; // 1 ms
+	CodingEvent event;
+	event.decodeCompleted( task );
+	while ( ! Server::getInstance()->eventQueue.insert( event ) )
+		nanosleep( &ts, 0 );
+}
+
+void CodingWorker::free() {}
+
+void *CodingWorker::run( void *argv ) {
+	CodingWorker *worker = ( CodingWorker * ) argv;
+	BasicEventQueueT<CodingEvent> *eventQueue = CodingWorker::eventQueue;
+
+	DecodeTask *tasks[ CODING_WORKER_BATCH_SIZE ];
+	CodingEvent event;
+	uint32_t count;
+	bool ret, isPending;
+	while( worker->getIsRunning() | ( ret = eventQueue->extract( event ) ) ) {
+		if ( ! ret )
+			continue;
+		if ( ! CodingWorker::isWholeStripe( event ) ) {
+			worker->dispatch( event );
+			continue;
+		}
+
+		// Take the queued stripes that have lost the same chunks as this one
+		// (e.g., those of a failed server during recovery) without waiting
+		tasks[ 0 ] = event.message.task.task;
+		count = 1;
+		isPending = false;
+		while ( count < CODING_WORKER_BATCH_SIZE && eventQueue->tryExtract( event ) ) {
+			if ( ! CodingWorker::isWholeStripe( event ) || ! CodingWorker::isSameErasure( tasks[ 0 ], event.message.task.task ) ) {
+				isPending = true;
+				break;
+			}
+			tasks[ count++ ] = event.message.task.task;
+		}
+		worker->decodeBatch( tasks, count );
+		if ( isPending )
+			worker->dispatch( event );
+	}
+
+	worker->free();
+	pthread_exit( 0 );
+	return 0;
+}
+
+bool CodingWorker::init( ServerConfig &config, uint32_t queueSize ) {
+	Server *server = Server::getInstance();
+
+	CodingWorker::dataChunkCount = server->config.global.coding.params.getDataChunkCount();
+	CodingWorker::parityChunkCount = server->config.global.coding.params.getParityChunkCount();
+	CodingWorker::chunkCount = CodingWorker::dataChunkCount + CodingWorker::parityChunkCount;
+	CodingWorker::workerCount = config.coding.threads;
+	CodingWorker::splitSize = config.coding.splitSize;
+	CodingWorker::eventQueue = 0;
+	LOCK_INIT( &CodingWorker::idleTasksLock );
+
+	if ( CodingWorker::workerCount == 0 )
+		return false;
+
+	CodingWorker::eventQueue = new BasicEventQueueT<CodingEvent>( queueSize, true );
+	CodingWorker::eventQueue->start();
+	return true;
+}
+
+void CodingWorker::destroy() {
+	delete CodingWorker::eventQueue;
+	CodingWorker::eventQueue = 0;
+
+	LOCK( &CodingWorker::idleTasksLock );
+	for ( size_t i = 0, size = CodingWorker::idleTasks.size(); i < size; i++ )
+		delete CodingWorker::idleTasks[ i ];
+	CodingWorker::idleTasks.clear();
+	UNLOCK( &CodingWorker::idleTasksLock );
+}
+
+bool CodingWorker::init( uint32_t workerId ) {
+	this->workerId = workerId;
+	return true;
+}
+
+bool CodingWorker::start() {
+	this->isRunning = true;
+	if ( pthread_create( &this->tid, NULL, CodingWorker::run, ( void * ) this ) != 0 ) {
+		__ERROR__( "CodingWorker", "start", "Cannot start worker thread." );
+		return false;
+	}
+	return true;
+}
+
+void CodingWorker::stop() {
+	this->isRunning = false;
+	// New tasks are decoded by the server workers from now on
+	if ( CodingWorker::eventQueue )
+		CodingWorker::eventQueue->stop();
+}
+
+void CodingWorker::print( FILE *f ) {
+	fprintf( f, "Coding worker (Thread ID = %lu): %srunning\n", this->tid, this->isRunning ? "" : "not " );
+}
+
+DecodeTask *CodingWorker::createTask() {
+	DecodeTask *task = 0;
+
+	if ( ! CodingWorker::eventQueue )
+		return 0;
+
+	LOCK( &CodingWorker::idleTasksLock );
+	if ( ! CodingWorker::idleTasks.empty() ) {
+		task = CodingWorker::idleTasks.back();
+		CodingWorker::idleTasks.pop_back();
+	}
+	UNLOCK( &CodingWorker::idleTasksLock );
+
+	if ( ! task )
+		task = new DecodeTask( CodingWorker::dataChunkCount, CodingWorker::parityChunkCount );
+	return task;
+}
+
+void CodingWorker::releaseTask( DecodeTask *task ) {
+	task->toBeFreed = 0;
+	LOCK( &CodingWorker::idleTasksLock );
+	CodingWorker::idleTasks.push_back( task );
+	UNLOCK( &CodingWorker::idleTasksLock );
+}
+
+bool CodingWorker::submit( DecodeTask *task ) {
+	CodingEvent event;
+
+	CodingWorker::plan( task );
+	task->remaining = task->parts;
+
+	event.decodePart( task, 0 );
+	if ( ! CodingWorker::eventQueue->insert( event ) )
+		return false;
+
+	for ( uint32_t i = 1; i < task->parts; i++ ) {
+		event.decodePart( task, i );
+		if ( ! CodingWorker::eventQueue->insert( event ) ) {
+			// Stopped in the middle; no coding worker holds the task once the last part is done
+			if ( ! CodingWorker::execute( task, i ) )
+				return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,142 @@
+#ifndef __SERVER_WORKER_CODING_WORKER_HH__
+#define __SERVER_WORKER_CODING_WORKER_HH__
+
+#include <vector>
+#include <cstdio>
+#include "../config/server_config.hh"
+#include "../ds/pending.hh"
+#include "../event/coding_event.hh"
+#include "../event/server_peer_event.hh"
+#include "../../common/ds/bitmask_array.hh"
+#include "../../common/ds/chunk.hh"
+#include "../../common/event/event_queue.hh"
+#include "../../common/lock/lock.hh"
+#include "../../common/worker/worker.hh"
+
+/**
+ * A stripe to be decoded by the coding workers and the state of the
+ * GET_CHUNK response that continues with it. The stripe buffer has the same
+ * layout as the one of ServerWorker, which hands over its own buffer by
+ * swapping the pointers (see ServerWorker::swapStripeBuffer()).
+ */
+struct DecodeTask {
+	uint32_t dataChunkCount;
+	uint32_t parityChunkCount;
+
+	// Stripe buffer
+	Chunk **chunks;
+	Chunk **freeChunks;
+	BitmaskArray *chunkStatus;
+	BitmaskArray *chunkStatusBackup;
+	bool **sealIndicators;
+
+	// GET_CHUNK response
+	ServerPeerEvent event;
+	PendingIdentifier pid;
+	ChunkRequest chunkRequest;
+	uint32_t listId, stripeId, chunkId;
+	Chunk *toBeFreed;
+	bool isLocalRepair;
+	uint32_t repairedChunkId;
+
+	// Decoding plan; with more than one part, the i-th part reconstructs the
+	// i-th byte range of every lost chunk as a linear combination of the helpers
+	uint32_t parts;
+	uint32_t remaining;
+	LOCK_T lock;
+	uint32_t lostCount;
+	uint32_t *lostIds;
+	uint32_t helperCount;
+	uint32_t *helperIds;
+	uint8_t *coefficients; // lostCount x helperCount
+
+	DecodeTask( uint32_t dataChunkCount, uint32_t parityChunkCount );
+	~DecodeTask();
+};
+
+class CodingWorker : public Worker {
+private:
+	uint32_t workerId;
+
+	static uint32_t dataChunkCount;
+	static uint32_t parityChunkCount;
+	static uint32_t chunkCount;
+	static uint32_t workerCount;
+	static uint32_t splitSize;
+	static BasicEventQueueT<CodingEvent> *eventQueue;
+	static std::vector<DecodeTask *> idleTasks;
+	static LOCK_T idleTasksLock;
+
+	void dispatch( CodingEvent event );
+	/**
+	 * Decode whole stripes that have lost the same chunks in one call (see
+	 * Coding::decodeBatch()) and notify the server workers.
+	 */
+	void decodeBatch( DecodeTask **tasks, uint32_t count );
+	void free();
+	static void *run( void *argv );
+	// Whether the event decodes a stripe that is not split into parts
+	static bool isWholeStripe( CodingEvent &event );
+	static bool isSameErasure( DecodeTask *a, DecodeTask *b );
+
+	/**
+	 * Decide whether the lost chunks can be reconstructed by byte range and
+	 * into how many parts. Only schemes that express a lost chunk as a
+	 * linear combination of other chunks (see Coding::getRepairCoefficients())
+	 * are split; the others are decoded as a whole.
+	 */
+	static void plan( DecodeTask *task );
+	/**
+	 * Decode a part of the stripe and notify the server workers after the
+	 * last part.
+	 *
+	 * @return false if the stripe is decoded but the event queue of the
+	 *         server workers does not accept the notification
+	 */
+	static bool execute( DecodeTask *task, uint32_t part );
+	/**
+	 * Count a decoded part and notify the server workers after the last one.
+	 *
+	 * @return false if the event queue of the server workers does not
+	 *         accept the notification
+	 */
+	static bool complete( DecodeTask *task );
+	// Notify the server workers of a decoded stripe, waiting until they accept it
+	static void notify( DecodeTask *task );
+
+public:
+	/**
+	 * Create the queue shared by all coding workers.
+	 *
+	 * @param  config    [coding] section of server.ini
+	 * @param  queueSize capacity of the queue
+	 * @return           false if no coding workers are configured
+	 */
+	static bool init( ServerConfig &config, uint32_t queueSize );
+	static void destroy();
+	bool init( uint32_t workerId );
+	bool start();
+	void stop();
+	void print( FILE *f = stdout );
+
+	/**
+	 * Get an unused task with its own stripe buffer.
+	 *
+	 * @return 0 if the coding workers are disabled
+	 */
+	static DecodeTask *createTask();
+	static void releaseTask( DecodeTask *task );
+
+	/**
+	 * Queue the decoding of a stripe. Once it completes, a
+	 * CODING_EVENT_TYPE_DECODE_COMPLETED event is inserted into the event
+	 * queue of the server workers.
+	 *
+	 * @return false if the coding workers are stopped; the task is not
+	 *         queued (or completed without the notification), so the caller
+	 *         takes the stripe buffer back and decodes the stripe itself
+	 */
+	static bool submit( DecodeTask *task );
+};
+
+#endif
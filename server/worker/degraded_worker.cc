@@ -1020,6 +1020,10 @@ bool ServerWorker::performDegradedRead(
 	ServerPeerSocket *socket = 0;
 	uint32_t selected = 0;
 
+	// Send the buffered parity deltas of the stripe before its chunks are read
+	if ( isSealed )
+		this->flushParityDeltas( listId, stripeId );
+
 	ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
 
 	// Determine the list of surviving nodes
@@ -1125,6 +1129,27 @@ bool ServerWorker::performDegradedRead(
 		}
 
 force_reconstruct_chunks:
+		// Read only the repair set (e.g., the local group) if the requested chunk is the only lost one that can be repaired in this way
+		uint32_t numRequired = ServerWorker::dataChunkCount;
+		bool isLocalRepair = false;
+		if ( reconstructedCount == 1 && original[ 1 ] == chunkId ) {
+			uint32_t numRepairChunkIds = this->getRepairSet( chunkId, this->repairChunkIds );
+			for ( uint32_t x = 0; x < numRepairChunkIds; x++ ) {
+				uint32_t i = this->repairChunkIds[ x ];
+				if ( i >= ServerWorker::dataChunkCount && this->parityServerSockets[ i - ServerWorker::dataChunkCount ]->self ) {
+					// Only the local data chunk can be used directly
+					numRepairChunkIds = 0;
+					break;
+				}
+			}
+			if ( numRepairChunkIds ) {
+				numRequired = numRepairChunkIds;
+				numSurvivingChunkIds = numRepairChunkIds;
+				survivingChunkIds = this->repairChunkIds;
+				isLocalRepair = true;
+			}
+		}
+
 		// Send GET_CHUNK requests to surviving nodes
 		Metadata metadata;
 		metadata.set( listId, stripeId, 0 );
@@ -1133,7 +1158,7 @@ force_reconstruct_chunks:
 		for ( uint32_t x = 0; x < numSurvivingChunkIds; x++ ) {
 			uint32_t i = survivingChunkIds[ x ];
 
-			if ( selected >= ServerWorker::dataChunkCount )
+			if ( selected >= numRequired )
 				break;
 
 			socket = ( i < ServerWorker::dataChunkCount ) ?
@@ -1154,6 +1179,8 @@ force_reconstruct_chunks:
 			} else {
 				continue;
 			}
+			if ( isLocalRepair )
+				chunkRequest.setLocalRepair( chunkId );
 			if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, parentInstanceId, requestId, parentRequestId, socket, chunkRequest ) ) {
 				__ERROR__( "ServerWorker", "performDegradedRead", "Cannot insert into server CHUNK_REQUEST pending map." );
 			}
@@ -1164,7 +1191,7 @@ force_reconstruct_chunks:
 		for ( uint32_t x = 0; x < numSurvivingChunkIds; x++ ) {
 			uint32_t i = survivingChunkIds[ x ];
 
-			if ( selected >= ServerWorker::dataChunkCount )
+			if ( selected >= numRequired )
 				break;
 
 			socket = ( i < ServerWorker::dataChunkCount ) ?
@@ -1178,13 +1205,15 @@ force_reconstruct_chunks:
 				selected++;
 			} else if ( socket->ready() ) {
 				metadata.chunkId = i;
-				event.reqGetChunk( socket, instanceId, requestId, metadata );
-				ServerWorker::eventQueue->insert( event );
+				if ( ! this->waitParityDeltas( socket, instanceId, requestId, metadata, true ) ) {
+					event.reqGetChunk( socket, instanceId, requestId, metadata );
+					ServerWorker::eventQueue->insert( event );
+				}
 				selected++;
 			}
 		}
 
-		return ( selected >= ServerWorker::dataChunkCount );
+		return ( selected >= numRequired );
 	} else {
 		if ( opcode == PROTO_OPCODE_DEGRADED_UPDATE )
 			k.set( keyValueUpdate->size, keyValueUpdate->data, 0, keyValueUpdate->isLarge );
@@ -1443,8 +1472,11 @@ bool ServerWorker::sendModifyChunkRequest(
 		);
 		chunkUpdate.setKeyValueUpdate( key.size, key.data, offset );
 
+		// Merge the delta with the subsequent ones to the same chunk before sending it to the parity servers
+		bool isBuffered = isUpdate && ! isDegraded && ! checkGetChunk && ServerWorker::deltaBuffer->isEnabled();
+
 		for ( uint32_t i = 0; i < ServerWorker::parityChunkCount; i++ ) {
-			if ( ! this->parityServerSockets[ i ] || this->parityServerSockets[ i ]->self ) {
+			if ( isBuffered || ! this->parityServerSockets[ i ] || this->parityServerSockets[ i ]->self ) {
 				continue;
 			}
 
@@ -1473,32 +1505,11 @@ bool ServerWorker::sendModifyChunkRequest(
 					continue;
 				}
 
-				// Prepare the data delta
-				ChunkUtil::clear( this->forward.dataChunk );
-				ChunkUtil::copy( this->forward.dataChunk, offset, delta, deltaSize );
-
-				// Prepare the stripe
-				for ( uint32_t j = 0; j < ServerWorker::dataChunkCount; j++ ) {
-					this->forward.chunks[ j ] = Coding::zeros;
-				}
-				this->forward.chunks[ metadata.chunkId ] = this->forward.dataChunk;
-
-				ChunkUtil::clear( this->forward.parityChunk );
-
-				// Compute parity delta
-				Server::getInstance()->coding->encode(
-					this->forward.chunks, this->forward.parityChunk,
+				// Apply the parity delta computed from the data delta
+				Server::getInstance()->coding->encodeDelta(
+					metadata.chunkId, delta, offset, deltaSize,
 					i + 1, // Parity chunk index
-					offset + metadata.chunkId * ChunkUtil::chunkSize,
-					offset + metadata.chunkId * ChunkUtil::chunkSize + deltaSize
-				);
-
-				char *parity = ChunkUtil::getData( this->forward.chunks[ i + ServerWorker::dataChunkCount ] );
-				Coding::bitwiseXOR(
-					parity,
-					parity,
-					ChunkUtil::getData( this->forward.parityChunk ),
-					ChunkUtil::chunkSize
+					this->forward.chunks[ i + ServerWorker::dataChunkCount ]
 				);
 				/////////////////////////////////////////////////////
 			} else if ( this->parityServerSockets[ i ]->self ) {
@@ -1530,6 +1541,9 @@ bool ServerWorker::sendModifyChunkRequest(
 						! isUpdate /* isDelete */
 					);
 				}
+			} else if ( isBuffered ) {
+				// Sent in flushParityDeltas()
+				numSurvivingParity++;
 			} else {
 				// Prepare DELETE_CHUNK request
 				size_t size;
@@ -1581,6 +1595,11 @@ bool ServerWorker::sendModifyChunkRequest(
 			}
 		}
 
+		if ( isBuffered && numSurvivingParity ) {
+			if ( ServerWorker::deltaBuffer->append( metadata, offset, deltaSize, delta, timestamp, parentInstanceId, parentRequestId ) )
+				this->flushParityDeltas( true );
+		}
+
 		if ( ! numSurvivingParity ) {
 			// No UPDATE_CHUNK / DELETE_CHUNK requests
 			if ( isUpdate ) {
@@ -0,0 +1,101 @@
+#include "io_worker.hh"
+#include "../../common/util/debug.hh"
+
+uint32_t IOWorker::workerCount;
+BasicEventQueueT<IOEvent> *IOWorker::eventQueue;
+
+IOWorker::IOWorker() {
+	this->workerId = 0;
+	this->storage = 0;
+}
+
+void IOWorker::dispatch( IOEvent event ) {
+	switch( event.type ) {
+		case IO_EVENT_TYPE_FLUSH_CHUNK:
+			this->storage->write(
+				event.chunk,
+				false
+			);
+			break;
+		default:
+			__ERROR__( "IOWorker", "dispatch", "Unsupported event type." );
+			break;
+	}
+}
+
+void IOWorker::free() {
+	if ( this->storage ) {
+		this->storage->stop();
+		Storage::destroy( this->storage );
+		this->storage = 0;
+	}
+}
+
+void *IOWorker::run( void *argv ) {
+	IOWorker *worker = ( IOWorker * ) argv;
+	BasicEventQueueT<IOEvent> *eventQueue = IOWorker::eventQueue;
+
+	IOEvent event;
+	bool ret;
+	while( worker->getIsRunning() | ( ret = eventQueue->extract( event ) ) ) {
+		if ( ret )
+			worker->dispatch( event );
+	}
+
+	worker->free();
+	pthread_exit( 0 );
+	return 0;
+}
+
+bool IOWorker::init( ServerConfig &config ) {
+	IOWorker::workerCount = config.io.threads;
+	IOWorker::eventQueue = 0;
+
+	if ( IOWorker::workerCount == 0 )
+		return false;
+
+	IOWorker::eventQueue = new BasicEventQueueT<IOEvent>( config.io.queueDepth, true );
+	IOWorker::eventQueue->start();
+	return true;
+}
+
+void IOWorker::destroy() {
+	delete IOWorker::eventQueue;
+	IOWorker::eventQueue = 0;
+}
+
+bool IOWorker::init( uint32_t workerId, ServerConfig &config ) {
+	this->workerId = workerId;
+	this->storage = Storage::instantiate( config );
+	if ( ! this->storage || ! this->storage->start() ) {
+		__ERROR__( "IOWorker", "init", "Cannot start the storage of I/O worker #%u.", workerId );
+		return false;
+	}
+	return true;
+}
+
+bool IOWorker::start() {
+	this->isRunning = true;
+	if ( pthread_create( &this->tid, NULL, IOWorker::run, ( void * ) this ) != 0 ) {
+		__ERROR__( "IOWorker", "start", "Cannot start worker thread." );
+		return false;
+	}
+	return true;
+}
+
+void IOWorker::stop() {
+	this->isRunning = false;
+	// The queued requests are still written before the workers exit
+	if ( IOWorker::eventQueue )
+		IOWorker::eventQueue->stop();
+}
+
+void IOWorker::print( FILE *f ) {
+	fprintf( f, "I/O worker (Thread ID = %lu): %srunning\n", this->tid, this->isRunning ? "" : "not " );
+}
+
+bool IOWorker::submit( IOEvent event ) {
+	if ( ! IOWorker::eventQueue )
+		return false;
+	return IOWorker::eventQueue->insert( event );
+}
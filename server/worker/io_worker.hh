@@ -0,0 +1,53 @@
+#ifndef __SERVER_WORKER_IO_WORKER_HH__
+#define __SERVER_WORKER_IO_WORKER_HH__
+
+#include <cstdio>
+#include "../config/server_config.hh"
+#include "../event/io_event.hh"
+#include "../storage/allstorage.hh"
+#include "../../common/event/event_queue.hh"
+#include "../../common/worker/worker.hh"
+
+/**
+ * Workers dedicated to disk I/O so that flushing chunks does not block the
+ * server workers that serve the network. Each worker owns a storage
+ * instance and takes IOEvents from a bounded queue shared by all I/O
+ * workers; the queue depth bounds the number of chunks waiting to be
+ * written.
+ */
+class IOWorker : public Worker {
+private:
+	uint32_t workerId;
+	Storage *storage;
+
+	static uint32_t workerCount;
+	static BasicEventQueueT<IOEvent> *eventQueue;
+
+	void dispatch( IOEvent event );
+	void free();
+	static void *run( void *argv );
+
+public:
+	IOWorker();
+	/**
+	 * Create the queue shared by all I/O workers.
+	 *
+	 * @param  config [io] section of server.ini
+	 * @return        false if no I/O workers are configured
+	 */
+	static bool init( ServerConfig &config );
+	static void destroy();
+	bool init( uint32_t workerId, ServerConfig &config );
+	bool start();
+	void stop();
+	void print( FILE *f = stdout );
+
+	/**
+	 * Queue an I/O request; blocks while the queue is full.
+	 *
+	 * @return false if the I/O workers are disabled or stopped
+	 */
+	static bool submit( IOEvent event );
+};
+
+#endif
@@ -188,6 +188,10 @@ bool ServerWorker::handleReconstructionRequest( CoordinatorEvent event, char *bu
 	Chunk *chunk;
 	ServerPeerSocket *socket = 0;
 
+	// Send the buffered parity deltas of the stripes before their chunks are read
+	for ( uint32_t i = 0; i < header.numStripes; i++ )
+		this->flushParityDeltas( header.listId, header.stripeIds[ i ] );
+
 	// Check whether the number of surviving nodes >= k
 	ServerWorker::stripeList->get( header.listId, this->parityServerSockets, this->dataServerSockets );
 	chunkCount = 0;
@@ -228,13 +232,72 @@ bool ServerWorker::handleReconstructionRequest( CoordinatorEvent event, char *bu
 		requestIds[ i ] = new std::vector<uint32_t>();
 		metadataList[ i ] = new std::vector<Metadata>();
 	}
+	// Read only the repair set (e.g., the local group) if all of its chunks are available
+	uint32_t numRepairChunkIds = this->getRepairSet( header.chunkId, this->repairChunkIds );
+	bool useOwnChunk = ( numRepairChunkIds == 0 );
+	for ( uint32_t x = 0; x < numRepairChunkIds; x++ ) {
+		if ( this->repairChunkIds[ x ] == myChunkId )
+			useOwnChunk = true;
+	}
+
+	bool isPipelined = Server::getInstance()->config.server.repair.pipelined;
+	std::vector<uint32_t> helperIds;
+
 	chunkId = 0;
 	for ( it = stripeIds.begin(); it != stripeIds.end(); it++ ) {
 		chunkCount = 0;
-		requestId = ServerWorker::idGenerator->nextVal( this->workerId );
 		metadata.listId = header.listId;
 		metadata.stripeId = *it;
-		while( chunkCount < ServerWorker::dataChunkCount - 1 ) {
+		// The stripes with unacknowledged parity deltas are not pipelined as their GET_CHUNK requests wait for the acknowledgements
+		if ( isPipelined && ! ServerWorker::deltaBuffer->hasSentDeltas( metadata.listId, metadata.stripeId ) ) {
+			// Chain the remote helpers (the repair set or k - 1 chunks in turn) and then the local server
+			helperIds.clear();
+			for ( uint32_t x = 0; x < numRepairChunkIds; x++ ) {
+				if ( this->repairChunkIds[ x ] != myChunkId )
+					helperIds.push_back( this->repairChunkIds[ x ] );
+			}
+			for ( uint32_t x = 0; ! numRepairChunkIds && x < ServerWorker::chunkCount && helperIds.size() < ServerWorker::dataChunkCount - 1; x++ ) {
+				if ( chunkId != header.chunkId && chunkId != myChunkId ) {
+					socket = ( chunkId < ServerWorker::dataChunkCount ) ?
+							 ( this->dataServerSockets[ chunkId ] ) :
+							 ( this->parityServerSockets[ chunkId - ServerWorker::dataChunkCount ] );
+					if ( socket->ready() && ! socket->self )
+						helperIds.push_back( chunkId );
+				}
+				chunkId++;
+				if ( chunkId >= ServerWorker::chunkCount )
+					chunkId = 0;
+			}
+			if ( useOwnChunk )
+				helperIds.push_back( myChunkId );
+			if ( this->sendRepairChunkRequest(
+				event.instanceId, event.requestId,
+				metadata.listId, metadata.stripeId, header.chunkId, myChunkId,
+				helperIds.data(), helperIds.size()
+			) )
+				continue;
+		}
+		requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+		for ( uint32_t x = 0; x < numRepairChunkIds; x++ ) {
+			if ( this->repairChunkIds[ x ] == myChunkId )
+				continue;
+			metadata.chunkId = this->repairChunkIds[ x ];
+			socket = ( metadata.chunkId < ServerWorker::dataChunkCount ) ?
+					 ( this->dataServerSockets[ metadata.chunkId ] ) :
+					 ( this->parityServerSockets[ metadata.chunkId - ServerWorker::dataChunkCount ] );
+			chunkRequest.set(
+				metadata.listId, metadata.stripeId, metadata.chunkId,
+				socket, 0, false
+			);
+			chunkRequest.setLocalRepair( header.chunkId );
+			if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, event.instanceId, requestId, event.requestId, socket, chunkRequest ) ) {
+				__ERROR__( "ServerWorker", "handleReconstructionRequest", "Cannot insert into server CHUNK_REQUEST pending map." );
+			} else if ( ! this->waitParityDeltas( socket, instanceId, requestId, metadata, true ) ) {
+				requestIds[ metadata.chunkId ]->push_back( requestId );
+				metadataList[ metadata.chunkId ]->push_back( metadata );
+			}
+		}
+		while( ! numRepairChunkIds && chunkCount < ServerWorker::dataChunkCount - 1 ) {
 			if ( chunkId != header.chunkId ) { // skip the chunk to be reconstructed
 				socket = ( chunkId < ServerWorker::dataChunkCount ) ?
 						 ( this->dataServerSockets[ chunkId ] ) :
@@ -248,8 +311,10 @@ bool ServerWorker::handleReconstructionRequest( CoordinatorEvent event, char *bu
 					if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, event.instanceId, requestId, event.requestId, socket, chunkRequest ) ) {
 						__ERROR__( "ServerWorker", "handleReconstructionRequest", "Cannot insert into server CHUNK_REQUEST pending map." );
 					} else {
-						requestIds[ chunkId ]->push_back( requestId );
-						metadataList[ chunkId ]->push_back( metadata );
+						if ( ! this->waitParityDeltas( socket, instanceId, requestId, metadata, true ) ) {
+							requestIds[ chunkId ]->push_back( requestId );
+							metadataList[ chunkId ]->push_back( metadata );
+						}
 						chunkCount++;
 					}
 				}
@@ -259,6 +324,8 @@ bool ServerWorker::handleReconstructionRequest( CoordinatorEvent event, char *bu
 				chunkId = 0;
 		}
 		// Use own chunk
+		if ( ! useOwnChunk )
+			continue;
 		chunk = ServerWorker::map->findChunkById( metadata.listId, metadata.stripeId, myChunkId );
 		if ( ! chunk ) {
 			chunk = Coding::zeros;
@@ -275,6 +342,8 @@ bool ServerWorker::handleReconstructionRequest( CoordinatorEvent event, char *bu
 			metadata.listId, metadata.stripeId, myChunkId,
 			0, chunk, false
 		);
+		if ( numRepairChunkIds )
+			chunkRequest.setLocalRepair( header.chunkId );
 		if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, event.instanceId, requestId, event.requestId, 0, chunkRequest ) ) {
 			__ERROR__( "ServerWorker", "handleReconstructionRequest", "Cannot insert into server CHUNK_REQUEST pending map." );
 		}
@@ -398,6 +467,437 @@ bool ServerWorker::handleReconstructionUnsealedRequest( CoordinatorEvent event,
 	return true;
 }
 
+bool ServerWorker::sendRepairChunkRequest( uint16_t parentInstanceId, uint32_t parentRequestId, uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint32_t myChunkId, uint32_t *helperIds, uint32_t count ) {
+	uint8_t ids[ UINT8_MAX ], coefficients[ UINT8_MAX ];
+
+	if ( count == 0 || count >= UINT8_MAX )
+		return false;
+	if ( ! Server::getInstance()->coding->getRepairCoefficients( chunkId, helperIds, count, coefficients ) )
+		return false;
+
+	for ( uint32_t i = 0; i < count; i++ )
+		ids[ i ] = helperIds[ i ];
+	if ( helperIds[ count - 1 ] != myChunkId ) {
+		// The local chunk is not needed but the result is still collected here
+		ids[ count ] = myChunkId;
+		coefficients[ count ] = 0;
+		count++;
+	}
+	if ( count < 2 )
+		return false; // No remote helpers
+
+	ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
+	ServerPeerSocket *first = ( ids[ 0 ] < ServerWorker::dataChunkCount ) ?
+	                          ( this->dataServerSockets[ ids[ 0 ] ] ) :
+	                          ( this->parityServerSockets[ ids[ 0 ] - ServerWorker::dataChunkCount ] );
+	ServerPeerSocket *last = ( ids[ count - 2 ] < ServerWorker::dataChunkCount ) ?
+	                         ( this->dataServerSockets[ ids[ count - 2 ] ] ) :
+	                         ( this->parityServerSockets[ ids[ count - 2 ] - ServerWorker::dataChunkCount ] );
+	uint32_t sliceSize = Server::getInstance()->config.server.repair.sliceSize;
+	if ( sliceSize > ChunkUtil::chunkSize )
+		sliceSize = ChunkUtil::chunkSize;
+
+	// The combined result arrives from the last remote helper
+	uint16_t instanceId = Server::instanceId;
+	uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+	ChunkRequest chunkRequest;
+	chunkRequest.set(
+		listId, stripeId, chunkId, last,
+		this->tempChunkPool.alloc( listId, stripeId, chunkId ), false
+	);
+	chunkRequest.setPipelined( count * ServerWorker::dataChunkCount );
+	if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, parentInstanceId, requestId, parentRequestId, last, chunkRequest ) ) {
+		__ERROR__( "ServerWorker", "sendRepairChunkRequest", "Cannot insert into server CHUNK_REQUEST pending map." );
+		this->tempChunkPool.free( chunkRequest.chunk );
+		delete[] chunkRequest.repairSealIndicators;
+		return false;
+	}
+
+	bool *sealIndicators;
+	char *data;
+	bool connected;
+	ssize_t ret;
+	size_t size = this->protocol.generateRepairChunkHeader(
+		PROTO_MAGIC_REQUEST, PROTO_MAGIC_TO_SERVER,
+		PROTO_OPCODE_REPAIR_CHUNK,
+		instanceId, requestId,
+		listId, stripeId, chunkId,
+		0, count, ids, coefficients,
+		ServerWorker::dataChunkCount, 0,
+		0, sliceSize, 0,
+		sealIndicators, data
+	);
+	ret = first->send( this->protocol.buffer.send, size, connected );
+	if ( ret != ( ssize_t ) size )
+		__ERROR__( "ServerWorker", "sendRepairChunkRequest", "The number of bytes sent (%ld bytes) is not equal to the message size (%lu bytes).", ret, size );
+
+	return true;
+}
+
+bool ServerWorker::addRepairContribution( uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint8_t coefficient, uint32_t offset, uint32_t size, bool isLastSlice, char *data, uint8_t rowSize, bool *row ) {
+	if ( coefficient == 0 )
+		return true; // Neither the data nor the seal status matters
+
+	Metadata metadata;
+	metadata.set( listId, stripeId, chunkId );
+
+	Chunk *chunk = map->findChunkById( listId, stripeId, chunkId, &metadata );
+
+	// Same as GET_CHUNK: read from the backup if the chunk is modified after the first slice
+	uint8_t sealIndicatorCount = 0, _sealIndicatorCount = 0;
+	bool *sealIndicator = 0, *_sealIndicator, exists;
+	LOCK_T *parityChunkBufferLock = 0;
+
+	MixedChunkBuffer *chunkBuffer = ServerWorker::chunkBuffer->at( listId );
+	int chunkBufferIndex = chunkBuffer->lockChunk( chunk, true );
+	bool isSealed = ( chunkBufferIndex == -1 );
+
+	sealIndicator = chunkBuffer->getSealIndicator( stripeId, sealIndicatorCount, true, false, &parityChunkBufferLock );
+
+	Chunk *backupChunk = ServerWorker::getChunkBuffer->find( metadata, exists, _sealIndicatorCount, _sealIndicator, true, false );
+	bool useBackup = ( exists && backupChunk );
+	if ( useBackup ) {
+		delete[] sealIndicator;
+		sealIndicator = _sealIndicator;
+		sealIndicatorCount = _sealIndicatorCount;
+		chunk = backupChunk;
+	}
+
+	bool ret = true;
+	if ( chunkId < ServerWorker::dataChunkCount ) {
+		// A missing or unsealed data chunk is not encoded yet
+		row[ chunkId ] = ( isSealed && chunk );
+		if ( isSealed && chunk )
+			Coding::multiplyXOR( data, ChunkUtil::getData( chunk ) + offset, coefficient, size );
+	} else if ( chunk && sealIndicator ) {
+		for ( uint8_t i = 0; i < rowSize && i < sealIndicatorCount; i++ )
+			row[ i ] = sealIndicator[ i ];
+		Coding::multiplyXOR( data, ChunkUtil::getData( chunk ) + offset, coefficient, size );
+	} else {
+		ret = false;
+	}
+
+	if ( ! useBackup )
+		delete[] sealIndicator;
+
+	// ACK GET_CHUNK after the last slice
+	if ( isSealed && isLastSlice )
+		ServerWorker::getChunkBuffer->ack( metadata, false, true );
+	else
+		ServerWorker::getChunkBuffer->unlock();
+	if ( parityChunkBufferLock )
+		UNLOCK( parityChunkBufferLock );
+
+	chunkBuffer->unlock( chunkBufferIndex );
+
+	return ret;
+}
+
+bool ServerWorker::handleRepairChunkRequest( ServerPeerEvent event, char *buf, size_t size ) {
+	struct RepairChunkHeader header;
+	if ( ! this->protocol.parseRepairChunkHeader( header, buf, size ) ) {
+		__ERROR__( "ServerWorker", "handleRepairChunkRequest", "Invalid REPAIR_CHUNK request." );
+		return false;
+	}
+	__DEBUG__(
+		BLUE, "ServerWorker", "handleRepairChunkRequest",
+		"[REPAIR_CHUNK] List ID: %u; stripe ID: %u; chunk ID: %u; position: %u / %u; offset: %u; size: %u.",
+		header.listId, header.stripeId, header.chunkId,
+		header.position, header.count, header.offset, header.size
+	);
+	if ( header.position + 1 >= header.count || header.size == 0 ) {
+		__ERROR__( "ServerWorker", "handleRepairChunkRequest", "Invalid position (%u) in a chain of %u helpers.", header.position, header.count );
+		return false;
+	}
+
+	uint32_t myChunkId = header.helperIds[ header.position ];
+	uint32_t nextChunkId = header.helperIds[ header.position + 1 ];
+	uint32_t originChunkId = header.helperIds[ header.count - 1 ];
+	bool isLastHop = ( header.position + 2 == header.count );
+
+	ServerWorker::stripeList->get( header.listId, this->parityServerSockets, this->dataServerSockets );
+	ServerPeerSocket *next = ( nextChunkId < ServerWorker::dataChunkCount ) ?
+	                         ( this->dataServerSockets[ nextChunkId ] ) :
+	                         ( this->parityServerSockets[ nextChunkId - ServerWorker::dataChunkCount ] );
+	ServerPeerSocket *origin = ( originChunkId < ServerWorker::dataChunkCount ) ?
+	                           ( this->dataServerSockets[ originChunkId ] ) :
+	                           ( this->parityServerSockets[ originChunkId - ServerWorker::dataChunkCount ] );
+
+	// The first helper starts every slice from zeros; the others forward the received slice
+	uint32_t offset = header.data ? header.offset : 0;
+	uint32_t end = header.data ? header.offset + header.size : ChunkUtil::chunkSize;
+	bool *sealIndicators;
+	char *data;
+	bool connected, success = true;
+	ssize_t ret;
+	size_t bytes;
+
+	for ( uint32_t n; offset < end && success; offset += n ) {
+		n = end - offset;
+		if ( n > header.size )
+			n = header.size;
+
+		bytes = this->protocol.generateRepairChunkHeader(
+			isLastHop ? PROTO_MAGIC_RESPONSE_SUCCESS : PROTO_MAGIC_REQUEST,
+			PROTO_MAGIC_TO_SERVER,
+			PROTO_OPCODE_REPAIR_CHUNK,
+			event.instanceId, event.requestId,
+			header.listId, header.stripeId, header.chunkId,
+			header.position + 1, header.count,
+			header.helperIds, header.coefficients,
+			header.sealIndicatorCount, header.sealIndicators,
+			offset, n,
+			header.data ? header.data : ChunkUtil::getData( Coding::zeros ) + offset,
+			sealIndicators, data
+		);
+
+		success = this->addRepairContribution(
+			header.listId, header.stripeId, myChunkId,
+			header.coefficients[ header.position ],
+			offset, n, offset + n >= ChunkUtil::chunkSize, data,
+			header.sealIndicatorCount,
+			sealIndicators + header.position * header.sealIndicatorCount
+		) && next->ready();
+		if ( ! success )
+			break;
+
+		ret = next->send( this->protocol.buffer.send, bytes, connected );
+		if ( ret != ( ssize_t ) bytes )
+			__ERROR__( "ServerWorker", "handleRepairChunkRequest", "The number of bytes sent (%ld bytes) is not equal to the message size (%lu bytes).", ret, bytes );
+	}
+
+	if ( ! success && origin->ready() ) {
+		// Let the server that repairs the chunk retrieve the chunks instead
+		bytes = this->protocol.generateRepairChunkHeader(
+			PROTO_MAGIC_RESPONSE_FAILURE, PROTO_MAGIC_TO_SERVER,
+			PROTO_OPCODE_REPAIR_CHUNK,
+			event.instanceId, event.requestId,
+			header.listId, header.stripeId, header.chunkId,
+			0, 0, 0, 0, 0, 0, 0, 0, 0,
+			sealIndicators, data
+		);
+		ret = origin->send( this->protocol.buffer.send, bytes, connected );
+		if ( ret != ( ssize_t ) bytes )
+			__ERROR__( "ServerWorker", "handleRepairChunkRequest", "The number of bytes sent (%ld bytes) is not equal to the message size (%lu bytes).", ret, bytes );
+	}
+
+	return success;
+}
+
+bool ServerWorker::handleRepairChunkResponse( ServerPeerEvent event, bool success, char *buf, size_t size ) {
+	struct RepairChunkHeader header;
+	if ( ! this->protocol.parseRepairChunkHeader( header, buf, size ) ) {
+		__ERROR__( "ServerWorker", "handleRepairChunkResponse", "Invalid REPAIR_CHUNK response." );
+		return false;
+	}
+	__DEBUG__(
+		YELLOW, "ServerWorker", "handleRepairChunkResponse",
+		"[REPAIR_CHUNK (%s)] List ID: %u; stripe ID: %u; chunk ID: %u; offset: %u; size: %u.",
+		success ? "success" : "failure",
+		header.listId, header.stripeId, header.chunkId, header.offset, header.size
+	);
+
+	uint32_t rowsSize = header.count * header.sealIndicatorCount;
+	if ( success ) {
+		if ( ! header.data || header.count < 2 ) {
+			__ERROR__( "ServerWorker", "handleRepairChunkResponse", "Invalid REPAIR_CHUNK response." );
+			return false;
+		}
+		// Add the local share, which is the last one in the chain
+		uint8_t position = header.count - 1;
+		success = this->addRepairContribution(
+			header.listId, header.stripeId, header.helperIds[ position ],
+			header.coefficients[ position ],
+			header.offset, header.size, header.offset + header.size >= ChunkUtil::chunkSize,
+			header.data,
+			header.sealIndicatorCount,
+			header.sealIndicators + position * header.sealIndicatorCount
+		);
+	}
+
+	std::unordered_multimap<PendingIdentifier, ChunkRequest>::iterator it;
+	if ( ! ServerWorker::pending->findChunkRequest( PT_SERVER_PEER_GET_CHUNK, event.instanceId, event.requestId, event.socket, it, true, false ) ) {
+		UNLOCK( &ServerWorker::pending->serverPeers.getChunkLock );
+		__ERROR__( "ServerWorker", "handleRepairChunkResponse", "Cannot find a pending server REPAIR_CHUNK request that matches the response. This message will be discarded." );
+		return false;
+	}
+
+	PendingIdentifier pid = it->first;
+	ChunkRequest &pendingRequest = it->second;
+	if ( ! pendingRequest.isPipelined ) {
+		UNLOCK( &ServerWorker::pending->serverPeers.getChunkLock );
+		__ERROR__( "ServerWorker", "handleRepairChunkResponse", "The pending server GET_CHUNK request is not a pipelined repair. This message will be discarded." );
+		return false;
+	}
+	if ( success ) {
+		ChunkUtil::copy( pendingRequest.chunk, header.offset, header.data, header.size );
+		// The seal status should not change across slices
+		if ( pendingRequest.repairedSize == 0 )
+			memcpy( pendingRequest.repairSealIndicators, header.sealIndicators, rowsSize );
+		else if ( memcmp( pendingRequest.repairSealIndicators, header.sealIndicators, rowsSize ) != 0 )
+			pendingRequest.isRepairConsistent = false;
+		pendingRequest.repairedSize += header.size;
+		if ( pendingRequest.repairedSize < ChunkUtil::chunkSize ) {
+			UNLOCK( &ServerWorker::pending->serverPeers.getChunkLock );
+			return true;
+		}
+	}
+	ChunkRequest chunkRequest = pendingRequest;
+	ServerWorker::pending->serverPeers.getChunk.erase( it );
+	UNLOCK( &ServerWorker::pending->serverPeers.getChunkLock );
+
+	// The partial results are combined correctly only if all parity helpers
+	// encoded the same set of data chunks, which matches the sealed data helpers
+	bool valid = success && chunkRequest.isRepairConsistent;
+	bool *reference = 0;
+	for ( uint32_t i = 0; i < header.count && valid; i++ ) {
+		bool *row = chunkRequest.repairSealIndicators + i * header.sealIndicatorCount;
+		if ( header.coefficients[ i ] == 0 || header.helperIds[ i ] < ServerWorker::dataChunkCount )
+			continue;
+		if ( ! reference )
+			reference = row;
+		else if ( memcmp( reference, row, header.sealIndicatorCount ) != 0 )
+			valid = false;
+	}
+	for ( uint32_t i = 0; i < header.count && valid && reference; i++ ) {
+		uint32_t id = header.helperIds[ i ];
+		if ( header.coefficients[ i ] && id < ServerWorker::dataChunkCount )
+			valid = ( chunkRequest.repairSealIndicators[ i * header.sealIndicatorCount + id ] == reference[ id ] );
+	}
+	if ( valid && reference && chunkRequest.chunkId < ServerWorker::dataChunkCount )
+		valid = reference[ chunkRequest.chunkId ];
+	delete[] chunkRequest.repairSealIndicators;
+
+	if ( ! valid ) {
+		this->tempChunkPool.free( chunkRequest.chunk );
+		this->sendReconstructionGetChunks(
+			pid.parentInstanceId, pid.parentRequestId,
+			chunkRequest.listId, chunkRequest.stripeId, chunkRequest.chunkId
+		);
+		return false;
+	}
+
+	// Send SET_CHUNK request
+	uint32_t listId, stripeId = chunkRequest.stripeId, chunkId;
+	if ( ! ServerWorker::pending->findReconstruction( pid.parentInstanceId, pid.parentRequestId, stripeId, listId, chunkId ) ) {
+		__ERROR__( "ServerWorker", "handleRepairChunkResponse", "Cannot found a pending reconstruction request for (%u, %u).\n", chunkRequest.listId, stripeId );
+		this->tempChunkPool.free( chunkRequest.chunk );
+		return false;
+	}
+
+	ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
+	ServerPeerSocket *target = ( chunkId < ServerWorker::dataChunkCount ) ?
+		( this->dataServerSockets[ chunkId ] ) :
+		( this->parityServerSockets[ chunkId - ServerWorker::dataChunkCount ] );
+
+	uint16_t instanceId = Server::instanceId;
+	uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+	Chunk *chunk = chunkRequest.chunk;
+	Metadata metadata;
+	ServerPeerEvent serverPeerEvent;
+
+	chunkRequest.set(
+		listId, stripeId, chunkId, target,
+		0 /* chunk */, false /* isDegraded */
+	);
+	if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_SET_CHUNK, instanceId, pid.parentInstanceId, requestId, pid.parentRequestId, target, chunkRequest ) ) {
+		__ERROR__( "ServerWorker", "handleRepairChunkResponse", "Cannot insert into server CHUNK_REQUEST pending map." );
+	}
+
+	metadata.set( listId, stripeId, chunkId );
+	serverPeerEvent.reqSetChunk( target, instanceId, requestId, metadata, chunk, true /* needsFree */ );
+	this->dispatch( serverPeerEvent );
+
+	return true;
+}
+
+void ServerWorker::sendReconstructionGetChunks( uint16_t parentInstanceId, uint32_t parentRequestId, uint32_t listId, uint32_t stripeId, uint32_t chunkId ) {
+	uint16_t instanceId = Server::instanceId;
+	uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+	uint32_t myChunkId = ServerWorker::chunkCount;
+	std::vector<uint32_t> chunkIds;
+	ChunkRequest chunkRequest;
+	Metadata metadata;
+	ServerPeerSocket *socket;
+	Chunk *chunk;
+
+	// Send the buffered parity deltas of the stripe before its chunks are read
+	this->flushParityDeltas( listId, stripeId );
+
+	ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
+	for ( uint32_t i = 0; i < ServerWorker::chunkCount; i++ ) {
+		socket = ( i < ServerWorker::dataChunkCount ) ?
+				 ( this->dataServerSockets[ i ] ) :
+				 ( this->parityServerSockets[ i - ServerWorker::dataChunkCount ] );
+		if ( socket->self ) myChunkId = i;
+	}
+
+	// Same as the requests sent by handleReconstructionRequest() for a stripe
+	uint32_t numRepairChunkIds = this->getRepairSet( chunkId, this->repairChunkIds );
+	bool useOwnChunk = ( numRepairChunkIds == 0 );
+	for ( uint32_t x = 0; x < numRepairChunkIds; x++ ) {
+		if ( this->repairChunkIds[ x ] == myChunkId )
+			useOwnChunk = true;
+		else
+			chunkIds.push_back( this->repairChunkIds[ x ] );
+	}
+	for ( uint32_t x = 0, i = stripeId % ServerWorker::chunkCount; ! numRepairChunkIds && x < ServerWorker::chunkCount && chunkIds.size() < ServerWorker::dataChunkCount - 1; x++ ) {
+		if ( i != chunkId && i != myChunkId ) {
+			socket = ( i < ServerWorker::dataChunkCount ) ?
+					 ( this->dataServerSockets[ i ] ) :
+					 ( this->parityServerSockets[ i - ServerWorker::dataChunkCount ] );
+			if ( socket->ready() && ! socket->self )
+				chunkIds.push_back( i );
+		}
+		i = ( i + 1 ) % ServerWorker::chunkCount;
+	}
+
+	// Insert all requests before sending any of them
+	for ( uint32_t x = 0; x < chunkIds.size(); x++ ) {
+		socket = ( chunkIds[ x ] < ServerWorker::dataChunkCount ) ?
+				 ( this->dataServerSockets[ chunkIds[ x ] ] ) :
+				 ( this->parityServerSockets[ chunkIds[ x ] - ServerWorker::dataChunkCount ] );
+		chunkRequest.set( listId, stripeId, chunkIds[ x ], socket, 0, false );
+		if ( numRepairChunkIds )
+			chunkRequest.setLocalRepair( chunkId );
+		if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, parentInstanceId, requestId, parentRequestId, socket, chunkRequest ) )
+			__ERROR__( "ServerWorker", "sendReconstructionGetChunks", "Cannot insert into server CHUNK_REQUEST pending map." );
+	}
+	if ( useOwnChunk && myChunkId < ServerWorker::chunkCount ) {
+		chunk = ServerWorker::map->findChunkById( listId, stripeId, myChunkId );
+		if ( ! chunk ) {
+			chunk = Coding::zeros;
+		} else {
+			// Check whether the chunk is sealed or not
+			MixedChunkBuffer *chunkBuffer = ServerWorker::chunkBuffer->at( listId );
+			int chunkBufferIndex = chunkBuffer->lockChunk( chunk, true );
+			bool isSealed = ( chunkBufferIndex == -1 );
+			if ( ! isSealed )
+				chunk = Coding::zeros;
+			chunkBuffer->unlock( chunkBufferIndex );
+		}
+		chunkRequest.set( listId, stripeId, myChunkId, 0, chunk, false );
+		if ( numRepairChunkIds )
+			chunkRequest.setLocalRepair( chunkId );
+		if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_GET_CHUNK, instanceId, parentInstanceId, requestId, parentRequestId, 0, chunkRequest ) )
+			__ERROR__( "ServerWorker", "sendReconstructionGetChunks", "Cannot insert into server CHUNK_REQUEST pending map." );
+	}
+
+	metadata.listId = listId;
+	metadata.stripeId = stripeId;
+	for ( uint32_t x = 0; x < chunkIds.size(); x++ ) {
+		ServerPeerEvent serverPeerEvent;
+		metadata.chunkId = chunkIds[ x ];
+		socket = ( metadata.chunkId < ServerWorker::dataChunkCount ) ?
+				 ( this->dataServerSockets[ metadata.chunkId ] ) :
+				 ( this->parityServerSockets[ metadata.chunkId - ServerWorker::dataChunkCount ] );
+		if ( this->waitParityDeltas( socket, instanceId, requestId, metadata, true ) )
+			continue;
+		serverPeerEvent.reqGetChunk( socket, instanceId, requestId, metadata );
+		ServerWorker::eventQueue->insert( serverPeerEvent );
+	}
+}
+
 bool ServerWorker::handleCompletedReconstructionAck() {
 	return Server::getInstance()->initChunkBuffer();
 }
@@ -237,8 +237,20 @@ bool ServerWorker::handleUpdateRequest( ServerPeerEvent event, char *buf, size_t
 
 				sealIndicator = chunkBuffer->getSealIndicator( header.stripeId, sealIndicatorCount, true, false, &parityChunkBufferLock );
 
+				// Range of the parity chunk modified by the parity delta
+				uint32_t parityOffset, parityLength;
+				Server::getInstance()->coding->getDeltaRange(
+					header.chunkId, header.chunkUpdateOffset, header.valueUpdateSize,
+					myChunkId - ServerWorker::dataChunkCount + 1,
+					parityOffset, parityLength
+				);
+
 				metadata.chunkId = myChunkId;
-				ServerWorker::getChunkBuffer->insert( metadata, chunk, sealIndicatorCount, sealIndicator );
+				ServerWorker::getChunkBuffer->insert(
+					metadata, chunk,
+					parityOffset, parityLength,
+					sealIndicatorCount, sealIndicator
+				);
 				metadata.chunkId = header.chunkId;
 
 				if ( parityChunkBufferLock )
@@ -359,6 +371,11 @@ bool ServerWorker::handleGetChunkRequest( ServerPeerEvent event, struct ChunkHea
 	Metadata metadata;
 	metadata.set( header.listId, header.stripeId, header.chunkId );
 
+	// The parity chunks of the stripe should include the buffered deltas of this server
+	this->flushParityDeltas( header.listId, header.stripeId );
+	if ( this->waitParityDeltas( event.socket, event.instanceId, event.requestId, metadata, false ) )
+		return true;
+
 	Chunk *chunk = map->findChunkById( header.listId, header.stripeId, header.chunkId, &metadata );
 
 	ret = chunk;
@@ -504,6 +521,7 @@ bool ServerWorker::handleSetChunkRequest( ServerPeerEvent event, bool isSealed,
 			}
 		}
 	}
+	ServerWorker::snapshot->preserve( chunk );
 
 	if ( metadata.chunkId < ServerWorker::dataChunkCount ) {
 		if ( isSealed ) {
@@ -583,6 +601,7 @@ bool ServerWorker::handleSetChunkRequest( ServerPeerEvent event, bool isSealed,
 
 				// Update key map and chunk
 				if ( ServerWorker::map->deleteKey( key, PROTO_OPCODE_DELETE, timestamp, keyMetadata, false, false, false ) ) {
+					ServerWorker::getChunkBuffer->preserve( chunk, keyMetadata.offset, keyMetadata.length );
 					ChunkUtil::deleteObject( chunk, keyMetadata.offset );
 				} else {
 					__ERROR__( "ServerWorker", "handleSetChunkRequest", "The deleted key does not exist." );
@@ -621,6 +640,7 @@ bool ServerWorker::handleSetChunkRequest( ServerPeerEvent event, bool isSealed,
 			header.chunkData.size
 		);
 	}
+	ServerWorker::chunkPool->setDirty( chunk );
 
 	UNLOCK( chunksLock );
 	UNLOCK( keysLock );
@@ -684,11 +704,22 @@ bool ServerWorker::handleUpdateChunkRequest( ServerPeerEvent event, char *buf, s
 			uint8_t sealIndicatorCount = 0;
 			bool *sealIndicator = 0;
 			LOCK_T *parityChunkBufferLock = 0;
+			uint32_t offset = header.offset, length = header.length;
 			if ( metadata.chunkId >= ServerWorker::dataChunkCount ) {
 				sealIndicator = chunkBuffer->getSealIndicator( header.stripeId, sealIndicatorCount, true, false, &parityChunkBufferLock );
+				// Range of the parity chunk modified by the parity delta
+				Server::getInstance()->coding->getDeltaRange(
+					header.chunkId, header.offset, header.length,
+					metadata.chunkId - ServerWorker::dataChunkCount + 1,
+					offset, length
+				);
 			}
 
-			ServerWorker::getChunkBuffer->insert( metadata, chunk, sealIndicatorCount, sealIndicator );
+			ServerWorker::getChunkBuffer->insert(
+				metadata, chunk,
+				offset, length,
+				sealIndicatorCount, sealIndicator
+			);
 
 			if ( parityChunkBufferLock )
 				UNLOCK( parityChunkBufferLock );
@@ -728,8 +759,7 @@ bool ServerWorker::handleUpdateChunkRequest( ServerPeerEvent event, char *buf, s
 		ret = ServerWorker::degradedChunkBuffer->update(
 			header.listId, header.stripeId, header.chunkId,
 			header.updatingChunkId, // For verifying the reconstructed chunk exists
-			header.offset, header.length, header.delta,
-			this->chunks, this->dataChunk, this->parityChunk
+			header.offset, header.length, header.delta
 		);
 
 		if ( ! ret ) {
@@ -796,8 +826,7 @@ bool ServerWorker::handleDeleteChunkRequest( ServerPeerEvent event, char *buf, s
 		ret = ServerWorker::degradedChunkBuffer->update(
 			header.listId, header.stripeId, header.chunkId,
 			header.updatingChunkId, // For verifying the reconstructed chunk exists
-			header.offset, header.length, header.delta,
-			this->chunks, this->dataChunk, this->parityChunk
+			header.offset, header.length, header.delta
 		);
 
 		if ( ! ret ) {
@@ -871,6 +900,30 @@ bool ServerWorker::issueSealChunkRequest( Chunk *chunk, uint32_t startPos ) {
 			return true;
 		}
 
+		if ( SealBatch::maxCount ) {
+			uint32_t sent = 0;
+			for ( uint32_t i = 0; i < ServerWorker::parityChunkCount; i++ ) {
+				ServerPeerSocket *socket = this->parityServerSockets[ i ];
+				bool isBatched;
+
+				LOCK( &socket->sealBatch.lock );
+				isBatched = this->appendSealChunkRequest( socket, packet->data + PROTO_HEADER_SIZE, packet->size - PROTO_HEADER_SIZE );
+				UNLOCK( &socket->sealBatch.lock );
+
+				if ( ! isBatched ) {
+					// Too large for a batch, or the batch cannot be sent
+					ServerPeerEvent serverPeerEvent;
+					serverPeerEvent.send( socket, packet );
+					this->dispatch( serverPeerEvent );
+					sent++;
+				}
+			}
+			// Release the references of the batched requests
+			for ( uint32_t i = sent; i < ServerWorker::parityChunkCount; i++ )
+				ServerWorker::packetPool->free( packet );
+			return true;
+		}
+
 		for ( uint32_t i = 0; i < ServerWorker::parityChunkCount; i++ ) {
 			ServerPeerEvent serverPeerEvent;
 			serverPeerEvent.send( this->parityServerSockets[ i ], packet );
@@ -888,6 +941,314 @@ bool ServerWorker::issueSealChunkRequest( Chunk *chunk, uint32_t startPos ) {
 	return true;
 }
 
+void ServerWorker::sealAgedChunks() {
+	ServerConfig &config = Server::getInstance()->config.server;
+	std::vector<MixedChunkBuffer *> &chunkBuffers = *ServerWorker::chunkBuffer;
+	size_t size = chunkBuffers.size();
+	uint32_t count = 0;
+
+	if ( config.seal.maxAge ) {
+		uint64_t now = DataChunkBuffer::getTime();
+		for ( size_t i = 0; i < size; i++ ) {
+			if ( chunkBuffers[ i ] )
+				count += chunkBuffers[ i ]->sealAged( this, now, ( uint64_t ) config.seal.maxAge * 1000 );
+		}
+	}
+
+	if ( config.seal.maxUnsealedSize ) {
+		uint64_t unsealedSize = 0;
+		for ( size_t i = 0; i < size; i++ ) {
+			if ( chunkBuffers[ i ] )
+				unsealedSize += chunkBuffers[ i ]->getUnsealedSize();
+		}
+
+		while ( unsealedSize > config.seal.maxUnsealedSize ) {
+			MixedChunkBuffer *oldestChunkBuffer = 0;
+			uint64_t oldest = 0, openedAt;
+			int oldestIndex = -1, index;
+			uint32_t sealedSize;
+
+			for ( size_t i = 0; i < size; i++ ) {
+				if ( ! chunkBuffers[ i ] )
+					continue;
+				openedAt = chunkBuffers[ i ]->getOldest( index );
+				if ( index != -1 && ( ! oldestChunkBuffer || openedAt < oldest ) ) {
+					oldestChunkBuffer = chunkBuffers[ i ];
+					oldestIndex = index;
+					oldest = openedAt;
+				}
+			}
+			if ( ! oldestChunkBuffer )
+				break;
+
+			sealedSize = oldestChunkBuffer->sealAt( this, oldestIndex, oldest );
+			unsealedSize = ( sealedSize < unsealedSize ) ? unsealedSize - sealedSize : 0;
+			count++;
+		}
+	}
+
+	if ( count ) {
+		__DEBUG__( YELLOW, "ServerWorker", "sealAgedChunks", "Sealed %u partially filled chunks.", count );
+	}
+}
+
+bool ServerWorker::appendSealChunkRequest( ServerPeerSocket *socket, char *seal, uint32_t sealSize ) {
+	SealBatch &batch = socket->sealBatch;
+
+	if ( ! batch.append( seal, sealSize ) ) {
+		if ( batch.isEmpty() )
+			return false;
+		this->sendSealChunkRequests( socket );
+		if ( ! batch.append( seal, sealSize ) )
+			return false;
+	}
+	if ( batch.isFull() )
+		this->sendSealChunkRequests( socket );
+	return true;
+}
+
+bool ServerWorker::sendSealChunkRequests( ServerPeerSocket *socket ) {
+	SealBatch &batch = socket->sealBatch;
+	uint32_t dataLength;
+	char *buf = batch.getBuffer( dataLength );
+	size_t size;
+	ssize_t ret;
+	bool connected;
+
+	if ( batch.isEmpty() )
+		return true;
+
+	size = this->protocol.generateBatchChunkSealHeader(
+		PROTO_MAGIC_REQUEST, PROTO_MAGIC_TO_SERVER,
+		PROTO_OPCODE_BATCH_SEAL_CHUNK,
+		Server::instanceId,
+		ServerWorker::idGenerator->nextVal( this->workerId ),
+		batch.getCount(), dataLength,
+		buf
+	);
+	ret = socket->send( buf, size, connected );
+	if ( ret != ( ssize_t ) size ) {
+		// Keep the requests for the next flush
+		__ERROR__( "ServerWorker", "sendSealChunkRequests", "The number of bytes sent (%ld bytes) is not equal to the message size (%lu bytes); %u SEAL_CHUNK requests are kept for retry.", ret, size, batch.getCount() );
+		return false;
+	}
+	batch.clear();
+	return true;
+}
+
+void ServerWorker::flushSealChunkRequests( bool force ) {
+	ArrayMap<int, ServerPeerSocket> &serverPeers = *ServerWorker::serverPeers;
+
+	for ( uint32_t i = 0, size = serverPeers.size(); i < size; i++ ) {
+		ServerPeerSocket *socket = serverPeers.values[ i ];
+
+		LOCK( &socket->sealBatch.lock );
+		if ( ! socket->sealBatch.isEmpty() && ( force || socket->sealBatch.isExpired() ) )
+			this->sendSealChunkRequests( socket );
+		UNLOCK( &socket->sealBatch.lock );
+	}
+}
+
+void ServerWorker::flushParityDeltas( bool force ) {
+	std::vector<std::pair<Metadata, ParityDelta>> deltas;
+
+	ServerWorker::deltaBuffer->extract( deltas, force );
+	for ( size_t i = 0, size = deltas.size(); i < size; i++ ) {
+		this->sendParityDelta( deltas[ i ].first, deltas[ i ].second );
+		ServerWorker::deltaBuffer->release( deltas[ i ].second );
+	}
+}
+
+void ServerWorker::flushParityDeltas( uint32_t listId, uint32_t stripeId ) {
+	std::vector<std::pair<Metadata, ParityDelta>> deltas;
+
+	if ( ! ServerWorker::deltaBuffer->isEnabled() )
+		return;
+
+	ServerWorker::deltaBuffer->extract( deltas, listId, stripeId );
+	for ( size_t i = 0, size = deltas.size(); i < size; i++ ) {
+		this->sendParityDelta( deltas[ i ].first, deltas[ i ].second );
+		ServerWorker::deltaBuffer->release( deltas[ i ].second );
+	}
+}
+
+bool ServerWorker::waitParityDeltas( ServerPeerSocket *socket, uint16_t instanceId, uint32_t requestId, Metadata &metadata, bool toSend ) {
+	DeltaWaiter waiter;
+
+	if ( ! ServerWorker::deltaBuffer->isEnabled() )
+		return false;
+
+	waiter.set( ( void * ) socket, instanceId, requestId, metadata, toSend );
+	return ServerWorker::deltaBuffer->wait( waiter );
+}
+
+void ServerWorker::sendParityDelta( Metadata &metadata, ParityDelta &delta ) {
+	uint16_t instanceId = Server::instanceId;
+	uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+	// The first client UPDATE request is the parent of the UPDATE_CHUNK requests
+	DeltaRequest &parent = delta.requests[ 0 ];
+	ChunkUpdate chunkUpdate;
+
+	this->getServers( metadata.listId );
+
+	chunkUpdate.set(
+		metadata.listId, metadata.stripeId, metadata.chunkId,
+		delta.offset, delta.length
+	);
+	chunkUpdate.setKeyValueUpdate( 0, 0, 0 );
+
+	// Keep the other client UPDATE requests before any response arrives
+	ServerWorker::deltaBuffer->defer( requestId, metadata, delta );
+
+	for ( uint32_t i = 0; i < ServerWorker::parityChunkCount; i++ ) {
+		if ( ! this->parityServerSockets[ i ] || this->parityServerSockets[ i ]->self )
+			continue;
+
+		chunkUpdate.chunkId = ServerWorker::dataChunkCount + i; // updatingChunkId
+		chunkUpdate.ptr = ( void * ) this->parityServerSockets[ i ];
+		if ( ! ServerWorker::pending->insertChunkUpdate(
+			PT_SERVER_PEER_UPDATE_CHUNK,
+			instanceId, parent.instanceId, requestId, parent.requestId,
+			( void * ) this->parityServerSockets[ i ],
+			chunkUpdate
+		) ) {
+			__ERROR__( "ServerWorker", "sendParityDelta", "Cannot insert into server UPDATE_CHUNK pending map." );
+		}
+	}
+
+	// Start sending packets only after all the insertion to the server peer UPDATE_CHUNK pending set is completed
+	for ( uint32_t i = 0; i < ServerWorker::parityChunkCount; i++ ) {
+		if ( ! this->parityServerSockets[ i ] || this->parityServerSockets[ i ]->self )
+			continue;
+
+		size_t size;
+		Packet *packet = ServerWorker::packetPool->malloc();
+		packet->setReferenceCount( 1 );
+		size = this->protocol.generateChunkUpdateHeader(
+			PROTO_MAGIC_REQUEST, PROTO_MAGIC_TO_SERVER,
+			PROTO_OPCODE_UPDATE_CHUNK,
+			parent.instanceId, requestId,
+			metadata.listId, metadata.stripeId, metadata.chunkId,
+			delta.offset,
+			delta.length,                     // length
+			ServerWorker::dataChunkCount + i, // updatingChunkId
+			delta.data + delta.offset,
+			packet->data,
+			delta.timestamp
+		);
+		packet->size = ( uint32_t ) size;
+
+		ServerPeerEvent serverPeerEvent;
+		serverPeerEvent.send( this->parityServerSockets[ i ], packet );
+		this->dispatch( serverPeerEvent );
+	}
+}
+
+void ServerWorker::respondCoalescedUpdates( uint32_t requestId, bool success ) {
+	std::vector<DeltaRequest> requests;
+	std::vector<DeltaWaiter> waiters;
+
+	if ( ! ServerWorker::deltaBuffer->take( requestId, requests, waiters ) )
+		return;
+
+	for ( size_t i = 0, size = requests.size(); i < size; i++ ) {
+		Key key;
+		KeyValueUpdate keyValueUpdate;
+		ClientEvent clientEvent;
+		PendingIdentifier pid;
+
+		if ( ! ServerWorker::pending->eraseKeyValueUpdate( PT_CLIENT_UPDATE, requests[ i ].instanceId, requests[ i ].requestId, 0, &pid, &keyValueUpdate ) ) {
+			__ERROR__( "ServerWorker", "respondCoalescedUpdates", "Cannot find a pending client UPDATE request (ID = (%u, %u)) that is merged into the parity delta.", requests[ i ].instanceId, requests[ i ].requestId );
+			continue;
+		}
+
+		key.set( keyValueUpdate.size, keyValueUpdate.data, keyValueUpdate.ptr );
+		clientEvent.resUpdate(
+			( ClientSocket * ) pid.ptr, pid.instanceId, pid.requestId, key,
+			keyValueUpdate.offset, keyValueUpdate.length,
+			success, true,
+			keyValueUpdate.isDegraded // isDegraded
+		);
+		this->dispatch( clientEvent );
+	}
+
+	// The parity chunks of the stripe are up-to-date
+	for ( size_t i = 0, size = waiters.size(); i < size; i++ ) {
+		ServerPeerEvent serverPeerEvent;
+		ServerPeerSocket *socket = ( ServerPeerSocket * ) waiters[ i ].socket;
+
+		if ( waiters[ i ].toSend ) {
+			serverPeerEvent.reqGetChunk( socket, waiters[ i ].instanceId, waiters[ i ].requestId, waiters[ i ].metadata );
+			ServerWorker::eventQueue->insert( serverPeerEvent );
+		} else {
+			struct ChunkHeader header;
+			header.listId = waiters[ i ].metadata.listId;
+			header.stripeId = waiters[ i ].metadata.stripeId;
+			header.chunkId = waiters[ i ].metadata.chunkId;
+			serverPeerEvent.set( waiters[ i ].instanceId, waiters[ i ].requestId, socket );
+			this->handleGetChunkRequest( serverPeerEvent, header );
+		}
+	}
+}
+
+bool ServerWorker::handleBatchSealChunkRequest( ServerPeerEvent event, char *buf, size_t size ) {
+	struct BatchChunkSealHeader header;
+	if ( ! this->protocol.parseBatchChunkSealHeader( header, buf, size ) ) {
+		__ERROR__( "ServerWorker", "handleBatchSealChunkRequest", "Invalid BATCH_SEAL_CHUNK request." );
+		return false;
+	}
+
+	struct SealRequest {
+		struct ChunkSealHeader header;
+		char *data;
+		uint32_t size;
+	};
+	std::vector<SealRequest> requests( header.count );
+
+	for ( uint32_t i = 0, offset = 0; i < header.count; i++ ) {
+		char *seal;
+		uint32_t sealSize;
+
+		this->protocol.nextChunkSealInBatchChunkSealHeader( header, seal, sealSize, offset );
+		if ( ! this->protocol.parseChunkSealHeader( requests[ i ].header, seal, sealSize ) ) {
+			__ERROR__( "ServerWorker", "handleBatchSealChunkRequest", "Invalid SEAL_CHUNK request in the batch." );
+			return false;
+		}
+		requests[ i ].data = seal + PROTO_CHUNK_SEAL_SIZE;
+		requests[ i ].size = sealSize - PROTO_CHUNK_SEAL_SIZE;
+	}
+
+	// Seal the chunks of the same stripe list under one acquisition of the buffer lock
+	std::stable_sort(
+		requests.begin(), requests.end(),
+		[]( const SealRequest &a, const SealRequest &b ) {
+			return a.header.listId < b.header.listId;
+		}
+	);
+	for ( uint32_t i = 0; i < header.count; i++ ) {
+		struct ChunkSealHeader &h = requests[ i ].header;
+		bool needsLock = ( i == 0 || requests[ i - 1 ].header.listId != h.listId );
+		bool needsUnlock = ( i == header.count - 1 || requests[ i + 1 ].header.listId != h.listId );
+
+		__DEBUG__(
+			BLUE, "ServerWorker", "handleBatchSealChunkRequest",
+			"[SEAL_CHUNK] List ID: %u, stripe ID: %u, chunk ID: %u; count = %u.",
+			h.listId, h.stripeId, h.chunkId, h.count
+		);
+
+		if ( ! ServerWorker::chunkBuffer->at( h.listId )->seal(
+			h.stripeId, h.chunkId, h.count,
+			requests[ i ].data, requests[ i ].size,
+			this->chunks, this->dataChunk, this->parityChunk,
+			needsLock, needsUnlock
+		) ) {
+			__ERROR__( "ServerWorker", "handleBatchSealChunkRequest", "[%u, %u] Cannot update parity chunk (%u, %u, %u).", event.instanceId, event.requestId, h.listId, h.stripeId, h.chunkId );
+		}
+	}
+
+	return true;
+}
+
 bool ServerWorker::handleBatchKeyValueRequest( ServerPeerEvent event, char *buf, size_t size ) {
 	struct BatchKeyValueHeader header;
 	if ( ! this->protocol.parseBatchKeyValueHeader( header, buf, size ) ) {
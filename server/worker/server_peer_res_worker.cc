@@ -521,7 +521,6 @@ bool ServerWorker::handleGetChunkResponse( ServerPeerEvent event, bool success,
 	ChunkRequest chunkRequest;
 	PendingIdentifier pid;
 	Chunk *toBeFreed = 0;
-	DegradedMap *dmap = &ServerWorker::degradedChunkBuffer->map;
 	union {
 		struct ChunkDataHeader chunkData;
 		struct ChunkHeader chunk;
@@ -583,7 +582,13 @@ bool ServerWorker::handleGetChunkResponse( ServerPeerEvent event, bool success,
 	tmp = it;
 	end = ServerWorker::pending->serverPeers.getChunk.end();
 	selfIt = ServerWorker::pending->serverPeers.getChunk.end();
+	bool isLocalRepair = false;
+	uint32_t repairedChunkId = 0;
 	while( tmp != end && tmp->first.instanceId == event.instanceId && tmp->first.requestId == event.requestId ) {
+		if ( tmp->second.isLocalRepair ) {
+			isLocalRepair = true;
+			repairedChunkId = tmp->second.repairedChunkId;
+		}
 		if ( tmp->second.chunkId == chunkId ) {
 			// Store the chunk into the buffer
 			if ( success ) {
@@ -667,12 +672,19 @@ bool ServerWorker::handleGetChunkResponse( ServerPeerEvent event, bool success,
 				}
 			}
 		}
+		if ( isLocalRepair ) {
+			// Data chunks outside the repair set are neither retrieved nor reconstructed
+			for ( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
+				if ( ! this->chunks[ i ] && i != repairedChunkId )
+					this->sealIndicators[ ServerWorker::parityChunkCount ][ i ] = this->sealIndicators[ ServerWorker::parityChunkCount + 1 ][ i ];
+			}
+		}
 
 		bool getChunkAgain = false;
 		ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
 		// Only check if there are at least one surviving parity chunks
 		for ( uint32_t i = 0; i < ServerWorker::dataChunkCount && numSurvivingParityChunks; i++ ) {
-			if ( i == selfIt->second.chunkId ) // Skip self
+			if ( selfIt != end && i == selfIt->second.chunkId ) // Skip self
 				continue;
 
 			if ( ! this->chunks[ i ] ) // To be reconstructed
@@ -812,11 +824,15 @@ bool ServerWorker::handleGetChunkResponse( ServerPeerEvent event, bool success,
 		UNLOCK( &ServerWorker::pending->serverPeers.getChunkLock );
 	}
 
-	std::unordered_set<uint32_t> invalidChunks;
 	if ( pending == 0 ) {
 		// Set up chunk buffer for storing reconstructed chunks
 		for ( uint32_t i = 0, j = 0; i < ServerWorker::chunkCount; i++ ) {
-			if ( ! this->chunks[ i ] ) {
+			if ( ! this->chunks[ i ] && isLocalRepair && i != repairedChunkId ) {
+				// Not in the repair set: the decoder does not need it
+				this->chunks[ i ] = Coding::zeros;
+				this->chunkStatus->set( i );
+				this->chunkStatusBackup->set( i );
+			} else if ( ! this->chunks[ i ] ) {
 				ChunkUtil::clear( this->freeChunks[ j ] );
 				ChunkUtil::set(
 					this->freeChunks[ j ],
@@ -833,383 +849,354 @@ bool ServerWorker::handleGetChunkResponse( ServerPeerEvent event, bool success,
 		}
 
 		// Decode to reconstruct the lost chunk
+		DecodeTask *task = CodingWorker::createTask();
+		if ( task ) {
+			// Hand over the stripe buffer to the coding workers
+			task->event = event;
+			task->pid = pid;
+			task->chunkRequest = chunkRequest;
+			task->listId = listId;
+			task->stripeId = stripeId;
+			task->chunkId = chunkId;
+			task->toBeFreed = toBeFreed;
+			task->isLocalRepair = isLocalRepair;
+			task->repairedChunkId = repairedChunkId;
+			this->swapStripeBuffer( task );
+			if ( CodingWorker::submit( task ) )
+				return true;
+			this->swapStripeBuffer( task );
+			CodingWorker::releaseTask( task );
+		}
+
 		CodingEvent codingEvent;
 		codingEvent.decode( this->chunks, this->chunkStatus );
 		this->dispatch( codingEvent );
 
-		uint32_t maxChunkSize = 0, chunkSize;
-		for ( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
-			chunkSize = ChunkUtil::getSize( this->chunks[ i ] );
-			maxChunkSize = ( chunkSize > maxChunkSize ) ? chunkSize : maxChunkSize;
-			if ( chunkSize > ChunkUtil::chunkSize ) {
-				__ERROR__(
-					"ServerWorker", "handleGetChunkResponse",
-					"[%s] Invalid chunk size (%u, %u, %u): %u",
-					this->chunkStatusBackup->check( i ) ? "Normal" : "Reconstructed",
-					chunkRequest.listId, chunkRequest.stripeId, i,
-					chunkSize
-				);
-				for ( uint32_t x = 0; x < ServerWorker::chunkCount; x++ )
-					ChunkUtil::print( this->chunks[ x ], stderr );
-				fprintf( stderr, "\n" );
-
-				fprintf( stderr, "Seal indicator for (%u, %u):\n", listId, stripeId );
-				for ( uint32_t j = 0; j < ServerWorker::parityChunkCount + 1; j++ ) {
-					if ( j == ServerWorker::parityChunkCount || this->chunkStatusBackup->check( j ) ) {
-						fprintf( stderr, "\t#%u:", j );
-						for ( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
-							fprintf( stderr, " %d", this->sealIndicators[ j ][ i ] ? 1 : 0 );
-						}
-						fprintf( stderr, "\n" );
+		return this->handleDecodedStripe( event, pid, chunkRequest, listId, stripeId, chunkId, toBeFreed );
+	}
+	return true;
+}
+
+bool ServerWorker::handleDecodedStripe( ServerPeerEvent event, PendingIdentifier pid, ChunkRequest chunkRequest, uint32_t listId, uint32_t stripeId, uint32_t chunkId, Chunk *toBeFreed ) {
+	DegradedMap *dmap = &ServerWorker::degradedChunkBuffer->map;
+	std::unordered_set<uint32_t> invalidChunks;
+
+	uint32_t maxChunkSize = 0, chunkSize;
+	for ( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
+		chunkSize = ChunkUtil::getSize( this->chunks[ i ] );
+		maxChunkSize = ( chunkSize > maxChunkSize ) ? chunkSize : maxChunkSize;
+		if ( chunkSize > ChunkUtil::chunkSize ) {
+			__ERROR__(
+				"ServerWorker", "handleGetChunkResponse",
+				"[%s] Invalid chunk size (%u, %u, %u): %u",
+				this->chunkStatusBackup->check( i ) ? "Normal" : "Reconstructed",
+				chunkRequest.listId, chunkRequest.stripeId, i,
+				chunkSize
+			);
+			for ( uint32_t x = 0; x < ServerWorker::chunkCount; x++ )
+				ChunkUtil::print( this->chunks[ x ], stderr );
+			fprintf( stderr, "\n" );
+
+			fprintf( stderr, "Seal indicator for (%u, %u):\n", listId, stripeId );
+			for ( uint32_t j = 0; j < ServerWorker::parityChunkCount + 1; j++ ) {
+				if ( j == ServerWorker::parityChunkCount || this->chunkStatusBackup->check( j ) ) {
+					fprintf( stderr, "\t#%u:", j );
+					for ( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
+						fprintf( stderr, " %d", this->sealIndicators[ j ][ i ] ? 1 : 0 );
 					}
+					fprintf( stderr, "\n" );
 				}
+			}
 
-				fprintf( stderr, "Chunk status: " );
-				this->chunkStatus->print( stderr );
+			fprintf( stderr, "Chunk status: " );
+			this->chunkStatus->print( stderr );
 
-				ChunkUtil::clear( this->chunks[ i ] );
-				invalidChunks.insert( i );
-				// return true;
-			}
+			ChunkUtil::clear( this->chunks[ i ] );
+			invalidChunks.insert( i );
+			// return true;
 		}
+	}
 
 
-		if ( chunkRequest.isDegraded ) {
-			// Respond the original GET/UPDATE/DELETE operation using the reconstructed data
-			PendingIdentifier pid;
-			DegradedOp op;
+	if ( chunkRequest.isDegraded ) {
+		// Respond the original GET/UPDATE/DELETE operation using the reconstructed data
+		PendingIdentifier pid;
+		DegradedOp op;
 
-			if ( ! ServerWorker::pending->eraseDegradedOp( PT_SERVER_PEER_DEGRADED_OPS, event.instanceId, event.requestId, event.socket, &pid, &op ) ) {
-				__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot find a pending server DEGRADED_OPS request that matches the response. This message will be discarded." );
-			} else {
-				bool reconstructParity, reconstructData;
-				int index = this->findInRedirectedList(
-					op.original, op.reconstructed, op.reconstructedCount,
-					op.ongoingAtChunk, reconstructParity, reconstructData,
-					op.chunkId, op.isSealed
-				);
+		if ( ! ServerWorker::pending->eraseDegradedOp( PT_SERVER_PEER_DEGRADED_OPS, event.instanceId, event.requestId, event.socket, &pid, &op ) ) {
+			__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot find a pending server DEGRADED_OPS request that matches the response. This message will be discarded." );
+		} else {
+			bool reconstructParity, reconstructData;
+			int index = this->findInRedirectedList(
+				op.original, op.reconstructed, op.reconstructedCount,
+				op.ongoingAtChunk, reconstructParity, reconstructData,
+				op.chunkId, op.isSealed
+			);
 
-				// Check whether the reconstructed parity chunks need to be forwarded
-				bool isKeyValueFound, isSealed;
-				Key key;
-				KeyValue keyValue;
-				KeyMetadata keyMetadata;
-				Metadata metadata;
-				std::vector<struct pid_s> pids;
+			// Check whether the reconstructed parity chunks need to be forwarded
+			bool isKeyValueFound, isSealed;
+			Key key;
+			KeyValue keyValue;
+			KeyMetadata keyMetadata;
+			Metadata metadata;
+			std::vector<struct pid_s> pids;
 
-				keyMetadata.offset = 0;
+			keyMetadata.offset = 0;
 
-				if ( ! dmap->deleteDegradedChunk( op.listId, op.stripeId, op.chunkId, pids, true /* force */, true /* ignoreChunkId */ ) ) {
-					// __ERROR__( "ServerWorker", "handleGetChunkResponse", "dmap->deleteDegradedChunk() failed (%u, %u, %u).", op.listId, op.stripeId, op.chunkId );
-				}
-				metadata.set( op.listId, op.stripeId, op.chunkId );
+			if ( ! dmap->deleteDegradedChunk( op.listId, op.stripeId, op.chunkId, pids, true /* force */, true /* ignoreChunkId */ ) ) {
+				// __ERROR__( "ServerWorker", "handleGetChunkResponse", "dmap->deleteDegradedChunk() failed (%u, %u, %u).", op.listId, op.stripeId, op.chunkId );
+			}
+			metadata.set( op.listId, op.stripeId, op.chunkId );
 
-				// Forward chunk locally
-				for ( uint32_t i = 0; i < op.reconstructedCount; i++ ) {
-					ServerPeerSocket *s = ServerWorker::stripeList->get( op.reconstructed[ i * 2 ], op.reconstructed[ i * 2 + 1 ] );
+			// Forward chunk locally
+			for ( uint32_t i = 0; i < op.reconstructedCount; i++ ) {
+				ServerPeerSocket *s = ServerWorker::stripeList->get( op.reconstructed[ i * 2 ], op.reconstructed[ i * 2 + 1 ] );
 
-					if ( invalidChunks.count( op.original[ i * 2 + 1 ] ) ) {
-						// Do nothing
-					} else if ( ! ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] ) ) {
-						continue; // No need to send
-					}
+				if ( invalidChunks.count( op.original[ i * 2 + 1 ] ) ) {
+					// Do nothing
+				} else if ( ! ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] ) ) {
+					continue; // No need to send
+				}
 
-					if ( s->self ) {
-						struct ChunkDataHeader chunkDataHeader;
-						chunkDataHeader.listId = metadata.listId;
-						chunkDataHeader.stripeId = metadata.stripeId;
-						chunkDataHeader.chunkId = op.original[ i * 2 + 1 ];
-						chunkDataHeader.size = ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] );
-						chunkDataHeader.offset = 0;
-						chunkDataHeader.data = ChunkUtil::getData( this->chunks[ op.original[ i * 2 + 1 ] ] );
-						chunkDataHeader.sealIndicatorCount = 0;
-						chunkDataHeader.sealIndicator = 0;
-						this->handleForwardChunkRequest( chunkDataHeader, false );
-					}
+				if ( s->self ) {
+					struct ChunkDataHeader chunkDataHeader;
+					chunkDataHeader.listId = metadata.listId;
+					chunkDataHeader.stripeId = metadata.stripeId;
+					chunkDataHeader.chunkId = op.original[ i * 2 + 1 ];
+					chunkDataHeader.size = ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] );
+					chunkDataHeader.offset = 0;
+					chunkDataHeader.data = ChunkUtil::getData( this->chunks[ op.original[ i * 2 + 1 ] ] );
+					chunkDataHeader.sealIndicatorCount = 0;
+					chunkDataHeader.sealIndicator = 0;
+					this->handleForwardChunkRequest( chunkDataHeader, false );
 				}
+			}
 
-				for ( int pidsIndex = 0, len = pids.size(); pidsIndex < len; pidsIndex++ ) {
-					if ( pidsIndex == 0 ) {
-						if ( ! ( pids[ pidsIndex ].instanceId == pid.instanceId && pids[ pidsIndex ].requestId == pid.requestId ) ) {
-							fprintf(
-								stderr,
-								"[%u, %u, %u] instanceId: %u vs. %u; "
-								"requestId:  %u vs. %u\n",
-								op.listId, op.stripeId, op.chunkId,
-								pids[ pidsIndex ].instanceId,
-								pid.instanceId,
-								pids[ pidsIndex ].requestId,
-								pid.requestId
-							);
-						}
-					} else {
-						if ( ! ServerWorker::pending->eraseDegradedOp( PT_SERVER_PEER_DEGRADED_OPS, pids[ pidsIndex ].instanceId, pids[ pidsIndex ].requestId, 0, &pid, &op ) ) {
-							__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot find a pending server DEGRADED_OPS request that matches the response. This message will be discarded." );
-							continue;
-						}
+			for ( int pidsIndex = 0, len = pids.size(); pidsIndex < len; pidsIndex++ ) {
+				if ( pidsIndex == 0 ) {
+					if ( ! ( pids[ pidsIndex ].instanceId == pid.instanceId && pids[ pidsIndex ].requestId == pid.requestId ) ) {
+						fprintf(
+							stderr,
+							"[%u, %u, %u] instanceId: %u vs. %u; "
+							"requestId:  %u vs. %u\n",
+							op.listId, op.stripeId, op.chunkId,
+							pids[ pidsIndex ].instanceId,
+							pid.instanceId,
+							pids[ pidsIndex ].requestId,
+							pid.requestId
+						);
 					}
-
-					switch( op.opcode ) {
-						case PROTO_OPCODE_DEGRADED_GET:
-						case PROTO_OPCODE_DEGRADED_DELETE:
-							key.set( op.data.key.size, op.data.key.data, 0, op.data.key.isLarge );
-							break;
-						case PROTO_OPCODE_DEGRADED_UPDATE:
-							key.set( op.data.keyValueUpdate.size, op.data.keyValueUpdate.data, 0, op.data.keyValueUpdate.isLarge );
-							break;
-						default:
-							continue;
+				} else {
+					if ( ! ServerWorker::pending->eraseDegradedOp( PT_SERVER_PEER_DEGRADED_OPS, pids[ pidsIndex ].instanceId, pids[ pidsIndex ].requestId, 0, &pid, &op ) ) {
+						__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot find a pending server DEGRADED_OPS request that matches the response. This message will be discarded." );
+						continue;
 					}
+				}
 
-					// Find the chunk from the map
-					if ( index == -1 ) {
-						ClientEvent clientEvent;
-						clientEvent.instanceId = pid.parentInstanceId;
-						clientEvent.requestId = pid.parentRequestId;
-						clientEvent.socket = op.socket;
-
-						if ( op.opcode == PROTO_OPCODE_DEGRADED_GET ) {
-							struct KeyHeader header;
-							header.keySize = op.data.key.size;
-							header.key = op.data.key.data;
-							this->handleGetRequest( clientEvent, header, true );
-						} else if ( op.opcode == PROTO_OPCODE_DEGRADED_UPDATE ) {
-							struct KeyValueUpdateHeader header;
-							header.keySize = op.data.keyValueUpdate.size;
-							header.valueUpdateSize = op.data.keyValueUpdate.length;
-							header.valueUpdateOffset = op.data.keyValueUpdate.offset;
-							header.key = op.data.keyValueUpdate.data;
-							header.valueUpdate = ( char * ) op.data.keyValueUpdate.ptr;
-
-							if ( op.data.keyValueUpdate.isLarge )
-								header.keySize += SPLIT_OFFSET_SIZE;
-
-							this->handleUpdateRequest(
-								clientEvent, header,
-								op.original, op.reconstructed, op.reconstructedCount,
-								reconstructParity,
-								this->chunks,
-								pidsIndex == len - 1,
-								true
-							);
-						} else if ( op.opcode == PROTO_OPCODE_DEGRADED_DELETE ) {
-							struct KeyHeader header;
-							header.keySize = op.data.key.size;
-							header.key = op.data.key.data;
-							this->handleDeleteRequest(
-								clientEvent, header,
-								op.original, op.reconstructed, op.reconstructedCount,
-								reconstructParity,
-								this->chunks,
-								pidsIndex == len - 1
-							);
-						}
+				switch( op.opcode ) {
+					case PROTO_OPCODE_DEGRADED_GET:
+					case PROTO_OPCODE_DEGRADED_DELETE:
+						key.set( op.data.key.size, op.data.key.data, 0, op.data.key.isLarge );
+						break;
+					case PROTO_OPCODE_DEGRADED_UPDATE:
+						key.set( op.data.keyValueUpdate.size, op.data.keyValueUpdate.data, 0, op.data.keyValueUpdate.isLarge );
+						break;
+					default:
 						continue;
+				}
+
+				// Find the chunk from the map
+				if ( index == -1 ) {
+					ClientEvent clientEvent;
+					clientEvent.instanceId = pid.parentInstanceId;
+					clientEvent.requestId = pid.parentRequestId;
+					clientEvent.socket = op.socket;
+
+					if ( op.opcode == PROTO_OPCODE_DEGRADED_GET ) {
+						struct KeyHeader header;
+						header.keySize = op.data.key.size;
+						header.key = op.data.key.data;
+						this->handleGetRequest( clientEvent, header, true );
+					} else if ( op.opcode == PROTO_OPCODE_DEGRADED_UPDATE ) {
+						struct KeyValueUpdateHeader header;
+						header.keySize = op.data.keyValueUpdate.size;
+						header.valueUpdateSize = op.data.keyValueUpdate.length;
+						header.valueUpdateOffset = op.data.keyValueUpdate.offset;
+						header.key = op.data.keyValueUpdate.data;
+						header.valueUpdate = ( char * ) op.data.keyValueUpdate.ptr;
+
+						if ( op.data.keyValueUpdate.isLarge )
+							header.keySize += SPLIT_OFFSET_SIZE;
+
+						this->handleUpdateRequest(
+							clientEvent, header,
+							op.original, op.reconstructed, op.reconstructedCount,
+							reconstructParity,
+							this->chunks,
+							pidsIndex == len - 1,
+							true
+						);
+					} else if ( op.opcode == PROTO_OPCODE_DEGRADED_DELETE ) {
+						struct KeyHeader header;
+						header.keySize = op.data.key.size;
+						header.key = op.data.key.data;
+						this->handleDeleteRequest(
+							clientEvent, header,
+							op.original, op.reconstructed, op.reconstructedCount,
+							reconstructParity,
+							this->chunks,
+							pidsIndex == len - 1
+						);
 					}
+					continue;
+				}
 
-					Chunk *chunk = 0;
-					KeyMetadata keyMetadata;
-					bool dataChunkReconstructed = ( op.chunkId != ServerWorker::chunkBuffer->at( op.listId )->getChunkId() );
-
-					if ( dataChunkReconstructed ) {
-						chunk = dmap->findChunkById( op.listId, op.stripeId, op.chunkId );
-
-						if ( ! chunk ) {
-							chunk = ServerWorker::tempChunkPool.alloc();
-							ChunkUtil::dup( chunk, this->chunks[ op.chunkId ] );
-							if ( ! dmap->insertChunk(
-								op.listId, op.stripeId, op.chunkId, chunk,
-								op.chunkId >= ServerWorker::dataChunkCount
-							) ) {
-								__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into degraded chunk buffer's chunk map." );
-							}
+				Chunk *chunk = 0;
+				KeyMetadata keyMetadata;
+				bool dataChunkReconstructed = ( op.chunkId != ServerWorker::chunkBuffer->at( op.listId )->getChunkId() );
+
+				if ( dataChunkReconstructed ) {
+					chunk = dmap->findChunkById( op.listId, op.stripeId, op.chunkId );
+
+					if ( ! chunk ) {
+						chunk = ServerWorker::tempChunkPool.alloc();
+						ChunkUtil::dup( chunk, this->chunks[ op.chunkId ] );
+						if ( ! dmap->insertChunk(
+							op.listId, op.stripeId, op.chunkId, chunk,
+							op.chunkId >= ServerWorker::dataChunkCount
+						) ) {
+							__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into degraded chunk buffer's chunk map." );
 						}
-					} else {
-						Metadata tmp;
+					}
+				} else {
+					Metadata tmp;
 
-						tmp.set( 0, 0, 0 );
+					tmp.set( 0, 0, 0 );
 
-						// map->findValueByKey( key.data, key.size, 0, 0, &keyMetadata, 0, &chunk );
-						char *obj;
+					// map->findValueByKey( key.data, key.size, 0, 0, &keyMetadata, 0, &chunk );
+					char *obj;
 
-						if ( key.isLarge ) {
-							obj = map->findLargeObject( key.data, key.size );
-						} else {
-							obj = map->findObject( key.data, key.size );
-						}
+					if ( key.isLarge ) {
+						obj = map->findLargeObject( key.data, key.size );
+					} else {
+						obj = map->findObject( key.data, key.size );
+					}
 
-						if ( ! obj ) {
-							char *_key = new char[ key.size + SPLIT_OFFSET_SIZE ];
-							memcpy( _key, key.data, key.size );
-							memset( _key + key.size, 0, SPLIT_OFFSET_SIZE );
-							obj = map->findLargeObject( _key, key.size );
-							delete[] _key;
-						}
+					if ( ! obj ) {
+						char *_key = new char[ key.size + SPLIT_OFFSET_SIZE ];
+						memcpy( _key, key.data, key.size );
+						memset( _key + key.size, 0, SPLIT_OFFSET_SIZE );
+						obj = map->findLargeObject( _key, key.size );
+						delete[] _key;
+					}
 
-						if ( obj ) {
-							uint32_t offset;
-							chunk = ServerWorker::chunkPool->getChunk( obj, offset );
-						} else {
-							chunk = 0;
-						}
+					if ( obj ) {
+						uint32_t offset;
+						chunk = ServerWorker::chunkPool->getChunk( obj, offset );
+					} else {
+						chunk = 0;
+					}
 
-						if ( chunk ) {
-							ChunkUtil::get( chunk, tmp.listId, tmp.stripeId, tmp.chunkId );
-						}
+					if ( chunk ) {
+						ChunkUtil::get( chunk, tmp.listId, tmp.stripeId, tmp.chunkId );
+					}
 
-						if ( ! (
-							chunk &&
-							tmp.listId == op.listId &&
-							tmp.stripeId == op.stripeId &&
-							tmp.chunkId == op.chunkId
-						) ) {
+					if ( ! (
+						chunk &&
+						tmp.listId == op.listId &&
+						tmp.stripeId == op.stripeId &&
+						tmp.chunkId == op.chunkId
+					) ) {
+						fprintf(
+							stderr,
+							"Key: %.*s (size = %u) (%u, %u, %u); ",
+							key.size,
+							key.data,
+							key.size,
+							op.listId,
+							op.stripeId,
+							op.chunkId
+						);
+						if ( ! chunk )
+							fprintf( stderr, "chunk = (nil)" );
+						else
 							fprintf(
 								stderr,
-								"Key: %.*s (size = %u) (%u, %u, %u); ",
-								key.size,
-								key.data,
-								key.size,
-								op.listId,
-								op.stripeId,
-								op.chunkId
+								"chunk = %p (%u, %u, %u)",
+								chunk,
+								tmp.listId,
+								tmp.stripeId,
+								tmp.chunkId
 							);
-							if ( ! chunk )
-								fprintf( stderr, "chunk = (nil)" );
-							else
-								fprintf(
-									stderr,
-									"chunk = %p (%u, %u, %u)",
-									chunk,
-									tmp.listId,
-									tmp.stripeId,
-									tmp.chunkId
-								);
-
-							fprintf( stderr, "; obj = %p\n", obj );
-						}
-						assert(
-							chunk &&
-							tmp.listId == op.listId &&
-							tmp.stripeId == op.stripeId &&
-							tmp.chunkId == op.chunkId
-						);
-					}
 
-					switch( op.opcode ) {
-						case PROTO_OPCODE_DEGRADED_UPDATE:
-							key.set( op.data.keyValueUpdate.size, op.data.keyValueUpdate.data, 0, op.data.keyValueUpdate.isLarge );
-							break;
-						case PROTO_OPCODE_DEGRADED_GET:
-						case PROTO_OPCODE_DEGRADED_DELETE:
-							key.set( op.data.key.size, op.data.key.data, 0, op.data.key.isLarge );
-							break;
-						default:
-							continue;
+						fprintf( stderr, "; obj = %p\n", obj );
 					}
+					assert(
+						chunk &&
+						tmp.listId == op.listId &&
+						tmp.stripeId == op.stripeId &&
+						tmp.chunkId == op.chunkId
+					);
+				}
 
-					isKeyValueFound = dmap->findValueByKey( key.data, key.size, key.isLarge, isSealed, &keyValue, &key, &keyMetadata );
+				switch( op.opcode ) {
+					case PROTO_OPCODE_DEGRADED_UPDATE:
+						key.set( op.data.keyValueUpdate.size, op.data.keyValueUpdate.data, 0, op.data.keyValueUpdate.isLarge );
+						break;
+					case PROTO_OPCODE_DEGRADED_GET:
+					case PROTO_OPCODE_DEGRADED_DELETE:
+						key.set( op.data.key.size, op.data.key.data, 0, op.data.key.isLarge );
+						break;
+					default:
+						continue;
+				}
 
-					// Send response
-					if ( op.opcode == PROTO_OPCODE_DEGRADED_GET ) {
-						ClientEvent event;
+				isKeyValueFound = dmap->findValueByKey( key.data, key.size, key.isLarge, isSealed, &keyValue, &key, &keyMetadata );
 
-						if ( isKeyValueFound ) {
-							event.resGet( op.socket, pid.parentInstanceId, pid.parentRequestId, keyValue, true );
-							this->dispatch( event );
-						} else {
-							fprintf( stderr, "KEY NOT FOUND: %.*s.%u (is large? %s)\n", key.size, key.data, key.isLarge ? LargeObjectUtil::readSplitOffset( key.data + key.size ) : 0,  key.isLarge ? "true" : "false" );
-							// ChunkUtil::print( chunk, stderr );
-							event.instanceId = pid.parentInstanceId;
-							event.requestId = pid.parentRequestId;
-							event.socket = op.socket;
-							struct KeyHeader header;
-							header.key = key.data;
-							header.keySize = key.size;
-							this->handleGetRequest( event, header, true );
-						}
-						op.data.key.free();
-					} else if ( op.opcode == PROTO_OPCODE_DEGRADED_UPDATE ) {
-						uint32_t chunkUpdateOffset = KeyValue::getChunkUpdateOffset(
-							keyMetadata.offset, // chunkOffset
-							key.size, // keySize
-							op.data.keyValueUpdate.offset, // valueUpdateOffset
-							key.isLarge
-						);
-						char *valueUpdate = ( char * ) op.data.keyValueUpdate.ptr;
-						op.data.keyValueUpdate.ptr = op.socket;
-						// Insert into client UPDATE pending set
-						if ( ! ServerWorker::pending->insertKeyValueUpdate( PT_CLIENT_UPDATE, pid.parentInstanceId, pid.parentRequestId, op.socket, op.data.keyValueUpdate ) ) {
-							__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into client UPDATE pending map." );
-						}
+				// Send response
+				if ( op.opcode == PROTO_OPCODE_DEGRADED_GET ) {
+					ClientEvent event;
 
-						if ( isKeyValueFound ) {
-							if ( dataChunkReconstructed ) {
-								ServerWorker::degradedChunkBuffer->updateKeyValue(
-									key.size, key.data,
-									op.data.keyValueUpdate.length,
-									op.data.keyValueUpdate.offset,
-									chunkUpdateOffset,
-									valueUpdate,
-									chunk,
-									true /* isSealed */
-								);
-
-								this->sendModifyChunkRequest(
-								   pid.parentInstanceId, pid.parentRequestId,
-								   key.size, false, key.data,
-								   metadata,
-								   chunkUpdateOffset,
-								   op.data.keyValueUpdate.length /* deltaSize */,
-								   op.data.keyValueUpdate.offset,
-								   valueUpdate,
-								   true /* isSealed */,
-								   true /* isUpdate */,
-								   op.timestamp,
-								   op.socket,
-								   op.original, op.reconstructed, op.reconstructedCount,
-								   reconstructParity,
-								   this->chunks,
-								   pidsIndex == len - 1,
-								   true
-								);
-
-								delete[] valueUpdate;
-							} else {
-								__ERROR__( "ServerWorker", "handleGetChunkResponse", "Undefined case." );
-							}
-						} else if ( ! dataChunkReconstructed ) {
-							char *obj = map->findObject( key.data, key.size, &keyValue, &key );
-							if ( ! obj )
-								obj = map->findLargeObject( key.data, key.size, &keyValue, &key );
-							assert( obj );
-
-							keyMetadata.length = keyValue.getSize();
-							keyMetadata.obj = keyValue.data;
-							chunk = ServerWorker::chunkPool->getChunk( obj, keyMetadata.offset );
-
-							///// vvvvv Copied from handleUpdateRequest() vvvvv /////
-						    uint32_t offset = keyMetadata.offset + PROTO_KEY_VALUE_SIZE + key.size + ( key.isLarge ? SPLIT_OFFSET_SIZE : 0 ) + op.data.keyValueUpdate.offset;
-
-						    LOCK_T *keysLock, *chunksLock;
-						    ServerWorker::map->getKeysMap( 0, &keysLock );
-						    ServerWorker::map->getChunksMap( 0, &chunksLock );
-
-						    // Lock the data chunk buffer
-						    MixedChunkBuffer *chunkBuffer = ServerWorker::chunkBuffer->at( metadata.listId );
-						    int chunkBufferIndex = chunkBuffer->lockChunk( chunk, true );
-
-						    LOCK( keysLock );
-						    LOCK( chunksLock );
-						    // Compute delta and perform update
-							ChunkUtil::computeDelta(
+					if ( isKeyValueFound ) {
+						event.resGet( op.socket, pid.parentInstanceId, pid.parentRequestId, keyValue, true );
+						this->dispatch( event );
+					} else {
+						fprintf( stderr, "KEY NOT FOUND: %.*s.%u (is large? %s)\n", key.size, key.data, key.isLarge ? LargeObjectUtil::readSplitOffset( key.data + key.size ) : 0,  key.isLarge ? "true" : "false" );
+						// ChunkUtil::print( chunk, stderr );
+						event.instanceId = pid.parentInstanceId;
+						event.requestId = pid.parentRequestId;
+						event.socket = op.socket;
+						struct KeyHeader header;
+						header.key = key.data;
+						header.keySize = key.size;
+						this->handleGetRequest( event, header, true );
+					}
+					op.data.key.free();
+				} else if ( op.opcode == PROTO_OPCODE_DEGRADED_UPDATE ) {
+					uint32_t chunkUpdateOffset = KeyValue::getChunkUpdateOffset(
+						keyMetadata.offset, // chunkOffset
+						key.size, // keySize
+						op.data.keyValueUpdate.offset, // valueUpdateOffset
+						key.isLarge
+					);
+					char *valueUpdate = ( char * ) op.data.keyValueUpdate.ptr;
+					op.data.keyValueUpdate.ptr = op.socket;
+					// Insert into client UPDATE pending set
+					if ( ! ServerWorker::pending->insertKeyValueUpdate( PT_CLIENT_UPDATE, pid.parentInstanceId, pid.parentRequestId, op.socket, op.data.keyValueUpdate ) ) {
+						__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into client UPDATE pending map." );
+					}
+
+					if ( isKeyValueFound ) {
+						if ( dataChunkReconstructed ) {
+							ServerWorker::degradedChunkBuffer->updateKeyValue(
+								key.size, key.data,
+								op.data.keyValueUpdate.length,
+								op.data.keyValueUpdate.offset,
+								chunkUpdateOffset,
+								valueUpdate,
 								chunk,
-								valueUpdate, // delta
-								valueUpdate, // new data
-								offset, op.data.keyValueUpdate.length,
-								true // perform update
+								true /* isSealed */
 							);
-							chunkUpdateOffset = offset;
-						    ///// ^^^^^ Copied from handleUpdateRequest() ^^^^^ /////
 
 							this->sendModifyChunkRequest(
 							   pid.parentInstanceId, pid.parentRequestId,
@@ -1230,187 +1217,247 @@ bool ServerWorker::handleGetChunkResponse( ServerPeerEvent event, bool success,
 							   true
 							);
 
-							// Release the locks
-						    UNLOCK( chunksLock );
-						    UNLOCK( keysLock );
-							if ( chunkBufferIndex == -1 )
-						 		chunkBuffer->unlock();
-							else
-								chunkBuffer->updateAndUnlockChunk( chunkBufferIndex );
-
 							delete[] valueUpdate;
 						} else {
-							ClientEvent event;
-							struct KeyValueUpdateHeader header;
-
-							event.instanceId = pid.parentInstanceId;
-							event.requestId = pid.parentRequestId;
-							event.socket = op.socket;
-
-							header.keySize = op.data.keyValueUpdate.size;
-							header.valueUpdateSize = op.data.keyValueUpdate.length;
-							header.valueUpdateOffset = op.data.keyValueUpdate.offset;
-							header.key = op.data.keyValueUpdate.data;
-							header.valueUpdate = ( char * ) op.data.keyValueUpdate.ptr;
-
-							this->handleUpdateRequest(
-								event,
-								header,
-								op.original, op.reconstructed, op.reconstructedCount,
-								reconstructParity,
-								this->chunks,
-								pidsIndex == len - 1,
+							__ERROR__( "ServerWorker", "handleGetChunkResponse", "Undefined case." );
+						}
+					} else if ( ! dataChunkReconstructed ) {
+						char *obj = map->findObject( key.data, key.size, &keyValue, &key );
+						if ( ! obj )
+							obj = map->findLargeObject( key.data, key.size, &keyValue, &key );
+						assert( obj );
+
+						keyMetadata.length = keyValue.getSize();
+						keyMetadata.obj = keyValue.data;
+						chunk = ServerWorker::chunkPool->getChunk( obj, keyMetadata.offset );
+
+						///// vvvvv Copied from handleUpdateRequest() vvvvv /////
+					    uint32_t offset = keyMetadata.offset + PROTO_KEY_VALUE_SIZE + key.size + ( key.isLarge ? SPLIT_OFFSET_SIZE : 0 ) + op.data.keyValueUpdate.offset;
+
+					    LOCK_T *keysLock, *chunksLock;
+					    ServerWorker::map->getKeysMap( 0, &keysLock );
+					    ServerWorker::map->getChunksMap( 0, &chunksLock );
+
+					    // Lock the data chunk buffer
+					    MixedChunkBuffer *chunkBuffer = ServerWorker::chunkBuffer->at( metadata.listId );
+					    int chunkBufferIndex = chunkBuffer->lockChunk( chunk, true );
+
+					    LOCK( keysLock );
+					    LOCK( chunksLock );
+					    // Compute delta and perform update
+						ServerWorker::getChunkBuffer->preserve( chunk, offset, op.data.keyValueUpdate.length );
+						ServerWorker::snapshot->preserve( chunk );
+						ChunkUtil::computeDelta(
+							chunk,
+							valueUpdate, // delta
+							valueUpdate, // new data
+							offset, op.data.keyValueUpdate.length,
+							true // perform update
+						);
+						ServerWorker::chunkPool->setDirty( chunk );
+						chunkUpdateOffset = offset;
+					    ///// ^^^^^ Copied from handleUpdateRequest() ^^^^^ /////
+
+						this->sendModifyChunkRequest(
+						   pid.parentInstanceId, pid.parentRequestId,
+						   key.size, false, key.data,
+						   metadata,
+						   chunkUpdateOffset,
+						   op.data.keyValueUpdate.length /* deltaSize */,
+						   op.data.keyValueUpdate.offset,
+						   valueUpdate,
+						   true /* isSealed */,
+						   true /* isUpdate */,
+						   op.timestamp,
+						   op.socket,
+						   op.original, op.reconstructed, op.reconstructedCount,
+						   reconstructParity,
+						   this->chunks,
+						   pidsIndex == len - 1,
+						   true
+						);
+
+						// Release the locks
+					    UNLOCK( chunksLock );
+					    UNLOCK( keysLock );
+						if ( chunkBufferIndex == -1 )
+					 		chunkBuffer->unlock();
+						else
+							chunkBuffer->updateAndUnlockChunk( chunkBufferIndex );
+
+						delete[] valueUpdate;
+					} else {
+						ClientEvent event;
+						struct KeyValueUpdateHeader header;
+
+						event.instanceId = pid.parentInstanceId;
+						event.requestId = pid.parentRequestId;
+						event.socket = op.socket;
+
+						header.keySize = op.data.keyValueUpdate.size;
+						header.valueUpdateSize = op.data.keyValueUpdate.length;
+						header.valueUpdateOffset = op.data.keyValueUpdate.offset;
+						header.key = op.data.keyValueUpdate.data;
+						header.valueUpdate = ( char * ) op.data.keyValueUpdate.ptr;
+
+						this->handleUpdateRequest(
+							event,
+							header,
+							op.original, op.reconstructed, op.reconstructedCount,
+							reconstructParity,
+							this->chunks,
+							pidsIndex == len - 1,
  								true
-							);
+						);
+
+						op.data.keyValueUpdate.free();
+						// delete[] ( ( char * ) op.data.keyValueUpdate.ptr );
+					}
+				} else if ( op.opcode == PROTO_OPCODE_DEGRADED_DELETE ) {
+					uint32_t deltaSize = this->buffer.size;
+					char *delta = this->buffer.data;
+
+					if ( isKeyValueFound ) {
+						uint32_t timestamp;
 
-							op.data.keyValueUpdate.free();
-							// delete[] ( ( char * ) op.data.keyValueUpdate.ptr );
+						// Insert into client DELETE pending set
+						op.data.key.ptr = op.socket;
+						if ( ! ServerWorker::pending->insertKey( PT_CLIENT_DEL, pid.parentInstanceId, pid.parentRequestId, op.socket, op.data.key ) ) {
+							__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into client DELETE pending map." );
 						}
-					} else if ( op.opcode == PROTO_OPCODE_DEGRADED_DELETE ) {
-						uint32_t deltaSize = this->buffer.size;
-						char *delta = this->buffer.data;
-
-						if ( isKeyValueFound ) {
-							uint32_t timestamp;
-
-							// Insert into client DELETE pending set
-							op.data.key.ptr = op.socket;
-							if ( ! ServerWorker::pending->insertKey( PT_CLIENT_DEL, pid.parentInstanceId, pid.parentRequestId, op.socket, op.data.key ) ) {
-								__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into client DELETE pending map." );
-							}
-
-							if ( dataChunkReconstructed ) {
-								ServerWorker::degradedChunkBuffer->deleteKey(
-									PROTO_OPCODE_DELETE, timestamp,
-									key.size, key.data,
-									metadata,
-									true /* isSealed */,
-									deltaSize, delta, chunk
-								);
-							} else {
-								__ERROR__( "ServerWorker", "handleGetChunkResponse", "Degraded DELETE (data chunk not reconstructed) is not implemented." );
-							}
 
-							this->sendModifyChunkRequest(
-								pid.parentInstanceId, pid.parentRequestId, key.size, false, key.data,
-								metadata, keyMetadata.offset, deltaSize, 0, delta,
+						if ( dataChunkReconstructed ) {
+							ServerWorker::degradedChunkBuffer->deleteKey(
+								PROTO_OPCODE_DELETE, timestamp,
+								key.size, key.data,
+								metadata,
 								true /* isSealed */,
-								false /* isUpdate */,
-								op.timestamp,
-								op.socket,
-								op.original, op.reconstructed, op.reconstructedCount,
-								reconstructParity,
-								this->chunks,
-								pidsIndex == len - 1,
-								true
+								deltaSize, delta, chunk
 							);
 						} else {
-							ClientEvent event;
-
-							event.resDelete( op.socket, pid.parentInstanceId, pid.parentRequestId, key, false, true );
-							this->dispatch( event );
-							op.data.key.free();
+							__ERROR__( "ServerWorker", "handleGetChunkResponse", "Degraded DELETE (data chunk not reconstructed) is not implemented." );
 						}
-					}
-				}
 
-				////////////////////////////////////////
-				// Forward the modified parity chunks //
-				////////////////////////////////////////
-				ServerPeerEvent event;
-				uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
-				for ( uint32_t i = 0; i < op.reconstructedCount; i++ ) {
-					ServerPeerSocket *s = ServerWorker::stripeList->get( op.reconstructed[ i * 2 ], op.reconstructed[ i * 2 + 1 ] );
-					ChunkUtil::set( this->chunks[ op.original[ i * 2 + 1 ] ], metadata.listId, metadata.stripeId, op.original[ i * 2 + 1 ] );
-
-					if ( invalidChunks.count( op.original[ i * 2 + 1 ] ) ) {
-						// Do nothing
-					} else if ( ! ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] ) ) {
-						continue; // No need to send
-					}
-
-					if ( s->self ) {
-						continue;
-						struct ChunkDataHeader chunkDataHeader;
-						chunkDataHeader.listId = metadata.listId;
-						chunkDataHeader.stripeId = metadata.stripeId;
-						chunkDataHeader.chunkId = op.original[ i * 2 + 1 ];
-						chunkDataHeader.size = ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] );
-						chunkDataHeader.offset = 0;
-						chunkDataHeader.data = ChunkUtil::getData( this->chunks[ op.original[ i * 2 + 1 ] ] );
-						chunkDataHeader.sealIndicatorCount = 0;
-						chunkDataHeader.sealIndicator = 0;
-						this->handleForwardChunkRequest( chunkDataHeader, false );
-					} else {
-						metadata.chunkId = op.original[ i * 2 + 1 ];
-						event.reqForwardChunk(
-							s, Server::instanceId, requestId,
-							metadata, this->chunks[ op.original[ i * 2 + 1 ] ], false
+						this->sendModifyChunkRequest(
+							pid.parentInstanceId, pid.parentRequestId, key.size, false, key.data,
+							metadata, keyMetadata.offset, deltaSize, 0, delta,
+							true /* isSealed */,
+							false /* isUpdate */,
+							op.timestamp,
+							op.socket,
+							op.original, op.reconstructed, op.reconstructedCount,
+							reconstructParity,
+							this->chunks,
+							pidsIndex == len - 1,
+							true
 						);
+					} else {
+						ClientEvent event;
+
+						event.resDelete( op.socket, pid.parentInstanceId, pid.parentRequestId, key, false, true );
 						this->dispatch( event );
+						op.data.key.free();
 					}
 				}
 			}
-		} else {
-			Metadata metadata;
 
-			bool hasStripe = ServerWorker::pending->findReconstruction( pid.parentInstanceId, pid.parentRequestId, stripeId, listId, chunkId );
+			////////////////////////////////////////
+			// Forward the modified parity chunks //
+			////////////////////////////////////////
+			ServerPeerEvent event;
+			uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+			for ( uint32_t i = 0; i < op.reconstructedCount; i++ ) {
+				ServerPeerSocket *s = ServerWorker::stripeList->get( op.reconstructed[ i * 2 ], op.reconstructed[ i * 2 + 1 ] );
+				ChunkUtil::set( this->chunks[ op.original[ i * 2 + 1 ] ], metadata.listId, metadata.stripeId, op.original[ i * 2 + 1 ] );
+
+				if ( invalidChunks.count( op.original[ i * 2 + 1 ] ) ) {
+					// Do nothing
+				} else if ( ! ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] ) ) {
+					continue; // No need to send
+				}
 
-			ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
-			ServerPeerSocket *target = ( chunkId < ServerWorker::dataChunkCount ) ?
-				( this->dataServerSockets[ chunkId ] ) :
-				( this->parityServerSockets[ chunkId - ServerWorker::dataChunkCount ] );
-
-			if ( hasStripe ) {
-				// Send SET_CHUNK request
-				uint16_t instanceId = Server::instanceId;
-				uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
-				chunkRequest.set(
-					listId, stripeId, chunkId, target,
-					0 /* chunk */, false /* isDegraded */
-				);
-				if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_SET_CHUNK, instanceId, pid.parentInstanceId, requestId, pid.parentRequestId, target, chunkRequest ) ) {
-					__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into server CHUNK_REQUEST pending map." );
+				if ( s->self ) {
+					continue;
+					struct ChunkDataHeader chunkDataHeader;
+					chunkDataHeader.listId = metadata.listId;
+					chunkDataHeader.stripeId = metadata.stripeId;
+					chunkDataHeader.chunkId = op.original[ i * 2 + 1 ];
+					chunkDataHeader.size = ChunkUtil::getSize( this->chunks[ op.original[ i * 2 + 1 ] ] );
+					chunkDataHeader.offset = 0;
+					chunkDataHeader.data = ChunkUtil::getData( this->chunks[ op.original[ i * 2 + 1 ] ] );
+					chunkDataHeader.sealIndicatorCount = 0;
+					chunkDataHeader.sealIndicator = 0;
+					this->handleForwardChunkRequest( chunkDataHeader, false );
+				} else {
+					metadata.chunkId = op.original[ i * 2 + 1 ];
+					event.reqForwardChunk(
+						s, Server::instanceId, requestId,
+						metadata, this->chunks[ op.original[ i * 2 + 1 ] ], false
+					);
+					this->dispatch( event );
 				}
+			}
+		}
+	} else {
+		Metadata metadata;
 
-				metadata.set( listId, stripeId, chunkId );
+		bool hasStripe = ServerWorker::pending->findReconstruction( pid.parentInstanceId, pid.parentRequestId, stripeId, listId, chunkId );
 
-				event.reqSetChunk( target, instanceId, requestId, metadata, this->chunks[ chunkId ], false );
-				this->dispatch( event );
-			} else {
-				__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot found a pending reconstruction request for (%u, %u).\n", listId, stripeId );
+		ServerWorker::stripeList->get( listId, this->parityServerSockets, this->dataServerSockets );
+		ServerPeerSocket *target = ( chunkId < ServerWorker::dataChunkCount ) ?
+			( this->dataServerSockets[ chunkId ] ) :
+			( this->parityServerSockets[ chunkId - ServerWorker::dataChunkCount ] );
+
+		if ( hasStripe ) {
+			// Send SET_CHUNK request
+			uint16_t instanceId = Server::instanceId;
+			uint32_t requestId = ServerWorker::idGenerator->nextVal( this->workerId );
+			chunkRequest.set(
+				listId, stripeId, chunkId, target,
+				0 /* chunk */, false /* isDegraded */
+			);
+			if ( ! ServerWorker::pending->insertChunkRequest( PT_SERVER_PEER_SET_CHUNK, instanceId, pid.parentInstanceId, requestId, pid.parentRequestId, target, chunkRequest ) ) {
+				__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot insert into server CHUNK_REQUEST pending map." );
 			}
+
+			metadata.set( listId, stripeId, chunkId );
+
+			event.reqSetChunk( target, instanceId, requestId, metadata, this->chunks[ chunkId ], false );
+			this->dispatch( event );
+		} else {
+			__ERROR__( "ServerWorker", "handleGetChunkResponse", "Cannot found a pending reconstruction request for (%u, %u).\n", listId, stripeId );
 		}
+	}
 
-		// Return chunks to chunk pool
-		for ( uint32_t i = 0; i < ServerWorker::chunkCount; i++ ) {
-			if ( this->chunks[ i ] == toBeFreed || this->chunks[ i ] == Coding::zeros )
-				continue;
+	// Return chunks to chunk pool
+	for ( uint32_t i = 0; i < ServerWorker::chunkCount; i++ ) {
+		if ( this->chunks[ i ] == toBeFreed || this->chunks[ i ] == Coding::zeros )
+			continue;
 
-			bool isFreeChunks = false;
-			for ( uint32_t j = 0; j < ServerWorker::chunkCount; j++ ) {
-				if ( this->chunks[ i ] == this->freeChunks[ j ] ) {
-					isFreeChunks = true;
-					break;
-				}
+		bool isFreeChunks = false;
+		for ( uint32_t j = 0; j < ServerWorker::chunkCount; j++ ) {
+			if ( this->chunks[ i ] == this->freeChunks[ j ] ) {
+				isFreeChunks = true;
+				break;
 			}
+		}
 
-			if ( isFreeChunks )
-				continue;
+		if ( isFreeChunks )
+			continue;
 
-			// Check whether the chunk is reconstructed, forwarded, or from GET_CHUNK requests
-			if ( ! ServerWorker::chunkPool->isInChunkPool( this->chunks[ i ] ) ) {
-				Metadata m;
-				ChunkUtil::get( this->chunks[ i ], m.listId, m.stripeId, m.chunkId );
-				if ( dmap->findChunkById( m.listId, m.stripeId, m.chunkId ) == this->chunks[ i ] ) {
-					// Reconstructed - need to keep the chunk
-				} else {
-					// Forwarded or from GET_CHUNK requests
-					this->tempChunkPool.free( this->chunks[ i ] );
-				}
+		// Check whether the chunk is reconstructed, forwarded, or from GET_CHUNK requests
+		if ( ! ServerWorker::chunkPool->isInChunkPool( this->chunks[ i ] ) ) {
+			Metadata m;
+			ChunkUtil::get( this->chunks[ i ], m.listId, m.stripeId, m.chunkId );
+			if ( dmap->findChunkById( m.listId, m.stripeId, m.chunkId ) == this->chunks[ i ] ) {
+				// Reconstructed - need to keep the chunk
+			} else {
+				// Forwarded or from GET_CHUNK requests
+				this->tempChunkPool.free( this->chunks[ i ] );
 			}
 		}
 	}
+
 	if ( toBeFreed )
 		this->tempChunkPool.free( toBeFreed );
 	return true;
@@ -1519,6 +1566,9 @@ bool ServerWorker::handleUpdateChunkResponse( ServerPeerEvent event, bool succes
 		KeyValueUpdate keyValueUpdate;
 		ClientEvent clientEvent;
 
+		if ( ServerWorker::deltaBuffer->isEnabled() )
+			this->respondCoalescedUpdates( pid.requestId, success );
+
 		if ( ! ServerWorker::pending->eraseKeyValueUpdate( PT_CLIENT_UPDATE, pid.parentInstanceId, pid.parentRequestId, 0, &pid, &keyValueUpdate ) ) {
 			__ERROR__( "ServerWorker", "handleUpdateChunkResponse", "Cannot find a pending client UPDATE request that matches the response. This message will be discarded." );
 			return false;
@@ -422,6 +422,16 @@ void ServerWorker::dispatch( ServerPeerEvent event ) {
 		/////////////////////////////////////
 		case SERVER_PEER_EVENT_TYPE_SEAL_CHUNKS:
 			printf( "\tSealing %lu chunks...\n", event.message.chunkBuffer->seal( this ) );
+			this->flushSealChunkRequests( true );
+			return;
+		case SERVER_PEER_EVENT_TYPE_SEAL_AGED_CHUNKS:
+			this->sealAgedChunks();
+			return;
+		case SERVER_PEER_EVENT_TYPE_FLUSH_SEAL_CHUNKS:
+			this->flushSealChunkRequests( event.message.flush.force );
+			return;
+		case SERVER_PEER_EVENT_TYPE_FLUSH_PARITY_DELTAS:
+			this->flushParityDeltas( event.message.flush.force );
 			return;
 		/////////////////////////////////
 		// Reconstructed unsealed keys //
@@ -563,6 +573,16 @@ void ServerWorker::dispatch( ServerPeerEvent event ) {
 							break;
 					}
 					break;
+				case PROTO_OPCODE_BATCH_SEAL_CHUNK:
+					switch( header.magic ) {
+						case PROTO_MAGIC_REQUEST:
+							this->handleBatchSealChunkRequest( event, buffer.data, header.length );
+							break;
+						default:
+							__ERROR__( "ServerWorker", "dispatch", "Invalid magic code from server: 0x%x.", header.magic );
+							break;
+					}
+					break;
 				case PROTO_OPCODE_FORWARD_KEY:
 					switch ( header.magic ) {
 						case PROTO_MAGIC_REQUEST:
@@ -725,6 +745,22 @@ void ServerWorker::dispatch( ServerPeerEvent event ) {
 							break;
 					}
 					break;
+				case PROTO_OPCODE_REPAIR_CHUNK:
+					switch( header.magic ) {
+						case PROTO_MAGIC_REQUEST:
+							this->handleRepairChunkRequest( event, buffer.data, buffer.size );
+							break;
+						case PROTO_MAGIC_RESPONSE_SUCCESS:
+							this->handleRepairChunkResponse( event, true, buffer.data, buffer.size );
+							break;
+						case PROTO_MAGIC_RESPONSE_FAILURE:
+							this->handleRepairChunkResponse( event, false, buffer.data, buffer.size );
+							break;
+						default:
+							__ERROR__( "ServerWorker", "dispatch", "Invalid magic code from server: 0x%x.", header.magic );
+							break;
+					}
+					break;
 				case PROTO_OPCODE_SET_CHUNK:
 				case PROTO_OPCODE_SET_CHUNK_UNSEALED:
 					switch( header.magic ) {
@@ -15,8 +15,11 @@ std::vector<MixedChunkBuffer *> *ServerWorker::chunkBuffer;
 GetChunkBuffer *ServerWorker::getChunkBuffer;
 DegradedChunkBuffer *ServerWorker::degradedChunkBuffer;
 RemappedBuffer *ServerWorker::remappedBuffer;
+DeltaBuffer *ServerWorker::deltaBuffer;
 PacketPool *ServerWorker::packetPool;
 ChunkPool *ServerWorker::chunkPool;
+WriteAheadLog *ServerWorker::wal;
+Snapshot *ServerWorker::snapshot;
 
 void ServerWorker::dispatch( MixedEvent event ) {
 	switch( event.type ) {
@@ -48,11 +51,32 @@ void ServerWorker::dispatch( CodingEvent event ) {
 		case CODING_EVENT_TYPE_DECODE:
 			Server::getInstance()->coding->decode( event.message.decode.chunks, event.message.decode.status );
 			break;
+		case CODING_EVENT_TYPE_DECODE_COMPLETED:
+		{
+			DecodeTask *task = event.message.task.task;
+			this->swapStripeBuffer( task );
+			this->handleDecodedStripe(
+				task->event, task->pid, task->chunkRequest,
+				task->listId, task->stripeId, task->chunkId,
+				task->toBeFreed
+			);
+			// The task keeps the previous stripe buffer of this worker
+			CodingWorker::releaseTask( task );
+		}
+			break;
 		default:
 			return;
 	}
 }
 
+void ServerWorker::swapStripeBuffer( DecodeTask *task ) {
+	std::swap( this->chunks, task->chunks );
+	std::swap( this->freeChunks, task->freeChunks );
+	std::swap( this->chunkStatus, task->chunkStatus );
+	std::swap( this->chunkStatusBackup, task->chunkStatusBackup );
+	std::swap( this->sealIndicators, task->sealIndicators );
+}
+
 void ServerWorker::dispatch( IOEvent event ) {
 	switch( event.type ) {
 		case IO_EVENT_TYPE_FLUSH_CHUNK:
@@ -92,6 +116,20 @@ bool ServerWorker::getServers( uint32_t listId ) {
 	return true;
 }
 
+uint32_t ServerWorker::getRepairSet( uint32_t chunkId, uint32_t *chunkIds ) {
+	uint32_t count = Server::getInstance()->coding->getRepairSet( chunkId, chunkIds );
+
+	// All chunks in the repair set should be available
+	for ( uint32_t i = 0; i < count; i++ ) {
+		ServerPeerSocket *socket = ( chunkIds[ i ] < ServerWorker::dataChunkCount ) ?
+		                           ( this->dataServerSockets[ chunkIds[ i ] ] ) :
+		                           ( this->parityServerSockets[ chunkIds[ i ] - ServerWorker::dataChunkCount ] );
+		if ( ! socket || ! ( socket->self || socket->ready() ) )
+			return 0;
+	}
+	return count;
+}
+
 void ServerWorker::free() {
 	if ( this->storage ) {
 		this->storage->stop();
@@ -112,14 +150,13 @@ void ServerWorker::free() {
 	delete[] this->sealIndicators[ ServerWorker::parityChunkCount + 1 ];
 	delete[] this->sealIndicators;
 
-	this->tempChunkPool.free( this->forward.dataChunk );
-	this->tempChunkPool.free( this->forward.parityChunk );
 	delete[] this->forward.chunks;
 
 	for( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
 		this->tempChunkPool.free( this->freeChunks[ i ] );
 	}
 	delete[] this->freeChunks;
+	delete[] this->repairChunkIds;
 
 	delete[] this->dataServerSockets;
 	delete[] this->parityServerSockets;
@@ -158,8 +195,26 @@ bool ServerWorker::init() {
 	ServerWorker::getChunkBuffer = &server->getChunkBuffer;
 	ServerWorker::degradedChunkBuffer = &server->degradedChunkBuffer;
 	ServerWorker::remappedBuffer = &server->remappedBuffer;
+	ServerWorker::deltaBuffer = &server->deltaBuffer;
 	ServerWorker::packetPool = &server->packetPool;
 	ServerWorker::chunkPool = &server->chunkPool;
+	ServerWorker::wal = &server->wal;
+	ServerWorker::snapshot = &server->snapshot;
+
+	size_t bufferSize = Protocol::getSuggestedBufferSize(
+		server->config.global.size.key,
+		server->config.global.size.chunk
+	);
+	SealBatch::init(
+		server->config.server.seal.batchCount,
+		( server->config.server.seal.batchSize && server->config.server.seal.batchSize < bufferSize ) ? server->config.server.seal.batchSize : bufferSize,
+		server->config.server.seal.batchTimeout
+	);
+	server->deltaBuffer.init(
+		server->config.global.size.chunk,
+		server->config.server.delta.bufferSize,
+		server->config.server.delta.flushInterval
+	);
 	return true;
 }
 
@@ -180,14 +235,13 @@ bool ServerWorker::init( GlobalConfig &globalConfig, ServerConfig &serverConfig,
 	this->parityChunk = this->tempChunkPool.alloc();
 	this->chunks = new Chunk*[ ServerWorker::chunkCount ];
 
-	this->forward.dataChunk = this->tempChunkPool.alloc();
-	this->forward.parityChunk = this->tempChunkPool.alloc();
 	this->forward.chunks = new Chunk*[ ServerWorker::chunkCount ];
 
 	this->freeChunks = new Chunk*[ ServerWorker::dataChunkCount ];
 	for( uint32_t i = 0; i < ServerWorker::dataChunkCount; i++ ) {
 		this->freeChunks[ i ] = this->tempChunkPool.alloc();
 	}
+	this->repairChunkIds = new uint32_t[ ServerWorker::chunkCount ];
 
 	this->sealIndicators = new bool*[ ServerWorker::parityChunkCount + 2 ];
 	this->sealIndicators[ ServerWorker::parityChunkCount ] = new bool[ ServerWorker::dataChunkCount ];
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <cstdio>
+#include <algorithm>
 #include "../ack/pending_ack.hh"
 #include "../buffer/mixed_chunk_buffer.hh"
 #include "../buffer/degraded_chunk_buffer.hh"
@@ -10,11 +11,15 @@
 #include "../buffer/remapped_buffer.hh"
 #include "../config/server_config.hh"
 #include "../event/event_queue.hh"
+#include "../ds/delta_buffer.hh"
 #include "../ds/map.hh"
 #include "../ds/pending.hh"
+#include "../ds/snapshot.hh"
+#include "../ds/write_ahead_log.hh"
 // #include "../helper/reconstruction_helper.hh"
 #include "../protocol/protocol.hh"
 #include "../storage/allstorage.hh"
+#include "coding_worker.hh"
 #include "../../common/coding/coding.hh"
 #include "../../common/config/global_config.hh"
 #include "../../common/ds/chunk.hh"
@@ -48,10 +53,10 @@ private:
 	Chunk *dataChunk, *parityChunk;
 	Chunk **chunks;
 	struct {
-		Chunk *dataChunk, *parityChunk;
 		Chunk **chunks;
 	} forward; // For forwarding parity chunk
 	Chunk **freeChunks;
+	uint32_t *repairChunkIds; // For repairing a chunk from its local group
 	bool **sealIndicators;
 
 	ServerPeerSocket **dataServerSockets;
@@ -70,15 +75,28 @@ private:
 	static GetChunkBuffer *getChunkBuffer;
 	static DegradedChunkBuffer *degradedChunkBuffer;
 	static RemappedBuffer *remappedBuffer;
+	static DeltaBuffer *deltaBuffer;
 	static PacketPool *packetPool;
 	static ChunkPool *chunkPool;
+	static WriteAheadLog *wal;
+	static Snapshot *snapshot;
 
 	// ---------- worker.cc ----------
 	void dispatch( MixedEvent event );
 	void dispatch( CodingEvent event );
 	void dispatch( IOEvent event );
+	// Exchange the stripe buffer with the one of a decode task
+	void swapStripeBuffer( DecodeTask *task );
 	ServerPeerSocket *getServers( char *data, uint8_t size, uint32_t &listId, uint32_t &chunkId );
 	bool getServers( uint32_t listId );
+	/**
+	 * Get the chunks that suffice to repair a lost chunk (e.g., its local
+	 * group), given the servers in dataServerSockets and parityServerSockets.
+	 *
+	 * @return number of entries in chunkIds; 0 if any k chunks are needed or
+	 *         some chunks in the repair set are unavailable
+	 */
+	uint32_t getRepairSet( uint32_t chunkId, uint32_t *chunkIds );
 	void free();
 	static void *run( void *argv );
 
@@ -133,6 +151,7 @@ private:
 	bool handleUpdateChunkRequest( ServerPeerEvent event, char *buf, size_t size, bool checkGetChunk );
 	bool handleDeleteChunkRequest( ServerPeerEvent event, char *buf, size_t size, bool checkGetChunk );
 	bool handleSealChunkRequest( ServerPeerEvent event, char *buf, size_t size );
+	bool handleBatchSealChunkRequest( ServerPeerEvent event, char *buf, size_t size );
 	bool handleBatchKeyValueRequest( ServerPeerEvent event, char *buf, size_t size );
 	bool handleBatchChunksRequest( ServerPeerEvent event, char *buf, size_t size );
 
@@ -144,6 +163,7 @@ private:
 	bool handleUpdateResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
 	bool handleDeleteResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
 	bool handleGetChunkResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
+	bool handleDecodedStripe( ServerPeerEvent event, PendingIdentifier pid, ChunkRequest chunkRequest, uint32_t listId, uint32_t stripeId, uint32_t chunkId, Chunk *toBeFreed );
 	bool handleSetChunkResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
 	bool handleUpdateChunkResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
 	bool handleDeleteChunkResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
@@ -208,6 +228,36 @@ private:
 	bool handleBackupServerPromotedMsg( CoordinatorEvent event, char *buf, size_t size );
 	bool handleReconstructionRequest( CoordinatorEvent event, char *buf, size_t size );
 	bool handleReconstructionUnsealedRequest( CoordinatorEvent event, char *buf, size_t size );
+	bool handleRepairChunkRequest( ServerPeerEvent event, char *buf, size_t size );
+	bool handleRepairChunkResponse( ServerPeerEvent event, bool success, char *buf, size_t size );
+	/**
+	 * Repair a lost chunk of a stripe along a chain of helpers, each of which
+	 * adds its share to the partial result and forwards it slice by slice.
+	 * The local server is the last one in the chain.
+	 *
+	 * @return false if the coding scheme cannot combine partial results
+	 */
+	bool sendRepairChunkRequest(
+		uint16_t parentInstanceId, uint32_t parentRequestId,
+		uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint32_t myChunkId,
+		uint32_t *helperIds, uint32_t count
+	);
+	/**
+	 * Add the local chunk multiplied by the coefficient to a slice of the
+	 * partial result and report its seal status in the row.
+	 *
+	 * @return false if the chunk cannot be used for repair
+	 */
+	bool addRepairContribution(
+		uint32_t listId, uint32_t stripeId, uint32_t chunkId, uint8_t coefficient,
+		uint32_t offset, uint32_t size, bool isLastSlice, char *data,
+		uint8_t rowSize, bool *row
+	);
+	// Repair a stripe from the retrieved chunks if pipelined repair fails
+	void sendReconstructionGetChunks(
+		uint16_t parentInstanceId, uint32_t parentRequestId,
+		uint32_t listId, uint32_t stripeId, uint32_t chunkId
+	);
 	bool handleCompletedReconstructionAck();
 
 public:
@@ -222,6 +272,34 @@ public:
 
 	// ---------- server_peer_req_worker.cc ----------
 	bool issueSealChunkRequest( Chunk *chunk, uint32_t startPos = 0 );
+	/**
+	 * Seal the partially filled chunks that have been open for longer than
+	 * [seal] max_age, and then the oldest ones until the unsealed objects
+	 * (replicated at the parity servers) fit in [seal] max_unsealed_size.
+	 */
+	void sealAgedChunks();
+	// Send the batched SEAL_CHUNK requests that are due (or all if force is true)
+	void flushSealChunkRequests( bool force = false );
+	// The batch of the socket is locked when these functions are called
+	bool appendSealChunkRequest( ServerPeerSocket *socket, char *seal, uint32_t sealSize );
+	// Return false (and keep the batch for the next flush) if the message is not fully sent
+	bool sendSealChunkRequests( ServerPeerSocket *socket );
+	// Send the buffered parity deltas that are due (or all if force is true)
+	void flushParityDeltas( bool force = false );
+	// Send the buffered parity deltas of a stripe before its chunks are read
+	void flushParityDeltas( uint32_t listId, uint32_t stripeId );
+	void sendParityDelta( Metadata &metadata, ParityDelta &delta );
+	/**
+	 * Hold a GET_CHUNK request until the parity servers acknowledge the
+	 * sent deltas of its stripe.
+	 * @return true if the request is held
+	 */
+	bool waitParityDeltas( ServerPeerSocket *socket, uint16_t instanceId, uint32_t requestId, Metadata &metadata, bool toSend );
+	/**
+	 * Respond to the client UPDATE requests merged into a sent parity delta
+	 * (except the first) and resume the GET_CHUNK requests held for it
+	 */
+	void respondCoalescedUpdates( uint32_t requestId, bool success );
 };
 
 #endif
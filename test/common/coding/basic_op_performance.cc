@@ -4,6 +4,7 @@
 
 #include "../../../common/util/time.hh"
 #include "../../../common/coding/coding.hh"
+#include "../../../common/coding/xor_kernel.hh"
 
 #ifndef USE_ISAL
 extern "C" {
@@ -13,6 +14,7 @@ extern "C" {
 
 #define CSIZE (4096)
 #define ROUNDS (50000)
+#define XOR_SOURCES (8)
 #define GB ( 1024 * 1024 * 1024 )
 
 int main (void) {
@@ -23,11 +25,35 @@ int main (void) {
 	memset(buf, 4, CSIZE);
 	memset(buf2, 5, CSIZE);
 
-	struct timespec ts = start_timer();
-	for ( int i = 0; i < ROUNDS; i++ ) {
-		Coding::bitwiseXOR( buf, buf, buf2, CSIZE );
+	struct timespec ts;
+	char *srcs[ XOR_SOURCES ];
+	for ( int i = 0; i < XOR_SOURCES; i++ )
+		srcs[ i ] = ( i % 2 ) ? buf2 : buf;
+
+	for ( int t = XOR_KERNEL_SCALAR; t <= XOR_KERNEL_AVX512; t++ ) {
+		XORKernelType type = ( XORKernelType ) t;
+		if ( ! XORKernel::select( type ) )
+			continue;
+
+		ts = start_timer();
+		for ( int i = 0; i < ROUNDS; i++ ) {
+			Coding::bitwiseXOR( buf, buf, buf2, CSIZE );
+		}
+		printf( " XOR (%s): %.4lf GB/s\n", XORKernel::getName( type ), CSIZE * ROUNDS * 1.0 / GB / get_elapsed_time(ts));
+
+		ts = start_timer();
+		for ( int i = 0; i < ROUNDS; i++ ) {
+			Coding::bitwiseXOR( buf, srcs, XOR_SOURCES, CSIZE );
+		}
+		printf( " XOR x%d (%s): %.4lf GB/s\n", XOR_SOURCES, XORKernel::getName( type ), CSIZE * ROUNDS * 1.0 * XOR_SOURCES / GB / get_elapsed_time(ts));
+
+		ts = start_timer();
+		for ( int i = 0; i < ROUNDS; i++ ) {
+			Coding::bitwiseXORDelta( buf2, buf, buf2, CSIZE );
+		}
+		printf( " Delta (%s): %.4lf GB/s\n", XORKernel::getName( type ), CSIZE * ROUNDS * 1.0 / GB / get_elapsed_time(ts));
 	}
-	printf( " XOR: %.4lf GB/s\n", CSIZE * ROUNDS * 1.0 / GB / get_elapsed_time(ts));
+	XORKernel::select();
 
 #ifndef USE_ISAL
 	galois_single_divide( 10, 2 , 8 );
@@ -0,0 +1,527 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <pthread.h>
+#include "../../../common/util/time.hh"
+#include "common.hh"
+
+#define WARMUP_ROUNDS   (16)
+#define GIGA            (1000.0 * 1000.0 * 1000.0)
+
+#ifdef USE_ISAL
+#define BACKEND "isal"
+#else
+#define BACKEND "jerasure"
+#endif
+
+enum BenchmarkOp {
+	BENCHMARK_ENCODE,
+	BENCHMARK_DELTA,
+	BENCHMARK_DECODE
+};
+
+enum FailurePattern {
+	FAILURE_DATA,   // the first f data chunks
+	FAILURE_PARITY, // the last f parity chunks
+	FAILURE_MIXED   // alternately a data chunk from the front and a parity chunk from the back
+};
+
+static const char *opNames[] = { "encode", "delta", "decode" };
+static const char *patternNames[] = { "data", "parity", "mixed" };
+static const char *schemeNames[] = { "raid5", "rdp", "evenodd", "rs", "cauchy", "lrc" };
+static const CodingScheme schemeValues[] = { CS_RAID5, CS_RDP, CS_EVENODD, CS_RS, CS_CAUCHY, CS_LRC };
+
+struct BenchmarkConfig {
+	BenchmarkOp op;
+	CodingScheme scheme;
+	const char *schemeName;
+	uint32_t k;     // number of data chunks
+	uint32_t m;     // number of parity chunks (including the local parity chunks of LRC)
+	uint32_t chunkSize;
+	uint32_t failures;
+	FailurePattern pattern;
+	uint32_t threads;
+};
+
+struct BenchmarkResult {
+	uint32_t ops;
+	uint64_t bytes;
+	double duration;  // in seconds
+	double throughput; // in GB/s
+	// latency per operation in us
+	double avg, p50, p90, p99, p999, max;
+};
+
+struct BenchmarkThread {
+	BenchmarkConfig *config;
+	unsigned int seed;
+	std::vector<double> latencies;
+	double duration;
+	bool success;
+};
+
+static uint32_t localGroups = 2;
+static bool csv = false;
+static bool generic = false;
+static bool headerPrinted = false;
+
+void usage( char **argv ) {
+	fprintf( stderr,
+		"Usage: %s [options]\n"
+		"Sweeps scheme x (k,m) x chunk size x failure pattern x thread count for\n"
+		"encode, delta update and decode, and reports the throughput (GB/s, 1 GB = 10^9 B)\n"
+		"and the latency percentiles of each operation (us).\n\n"
+		"  -s, --scheme      coding schemes (raid5,rdp,evenodd,rs,cauchy,lrc) [rs]\n"
+		"  -k, --k           numbers of data chunks [4,6,8]\n"
+		"  -m, --m           numbers of parity chunks for rs, cauchy and lrc (global parity) [2]\n"
+		"                    (fixed to 1 for raid5 and 2 for rdp and evenodd)\n"
+		"  -l, --local       number of local groups of lrc [2]\n"
+		"  -c, --chunk-size  chunk sizes in bytes [4096,8192]\n"
+		"  -f, --failures    numbers of lost chunks to decode [1,2]\n"
+		"  -p, --pattern     failure patterns (data,parity,mixed) [data]\n"
+		"  -t, --threads     numbers of threads [1]\n"
+		"  -o, --op          operations (encode,delta,decode) [encode,delta,decode]\n"
+		"  -u, --update-size size of each delta update in bytes [64]\n"
+		"  -r, --rounds      operations per thread [1000]\n"
+		"  -g, --generic     disable the compile-time specialized implementations\n"
+		"      --format      output format (json|csv) [json]\n"
+		"  -h, --help        show this message\n",
+		argv[ 0 ]
+	);
+}
+
+bool parseList( char *arg, std::vector<uint32_t> &list ) {
+	char *token, *saveptr;
+	list.clear();
+	for ( token = strtok_r( arg, ",", &saveptr ); token; token = strtok_r( NULL, ",", &saveptr ) ) {
+		int value = atoi( token );
+		if ( value <= 0 )
+			return false;
+		list.push_back( ( uint32_t ) value );
+	}
+	return ! list.empty();
+}
+
+bool parseNames( char *arg, const char **names, uint32_t count, std::vector<uint32_t> &list ) {
+	char *token, *saveptr;
+	uint32_t i;
+	list.clear();
+	for ( token = strtok_r( arg, ",", &saveptr ); token; token = strtok_r( NULL, ",", &saveptr ) ) {
+		for ( i = 0; i < count; i++ ) {
+			if ( strcmp( token, names[ i ] ) == 0 )
+				break;
+		}
+		if ( i == count ) {
+			fprintf( stderr, "Unknown value: %s\n", token );
+			return false;
+		}
+		list.push_back( i );
+	}
+	return ! list.empty();
+}
+
+/**
+ * Set the coding parameters of a configuration and instantiate the code.
+ *
+ * @return number of arbitrary lost chunks that can always be recovered; 0 if the configuration is invalid
+ */
+uint32_t setup( BenchmarkConfig &config, uint32_t m ) {
+	uint32_t tolerance;
+
+	params = CodingParams();
+	params.setScheme( config.scheme );
+	switch( config.scheme ) {
+		case CS_RAID5:
+			config.m = 1;
+			break;
+		case CS_RDP:
+		case CS_EVENODD:
+			config.m = 2;
+			break;
+		case CS_LRC:
+			if ( localGroups == 0 || localGroups > config.k )
+				return 0;
+			config.m = localGroups + m;
+			break;
+		default:
+			config.m = m;
+			break;
+	}
+	if ( config.k + config.m > 32 )
+		return 0;
+
+	params.setN( config.k + config.m );
+	params.setK( config.k );
+	params.setM( config.m );
+	tolerance = config.m;
+	if ( config.scheme == CS_LRC ) {
+		params.setM( m );
+		params.setL( localGroups );
+		tolerance = m + 1;
+	}
+
+	initChunkSize( config.chunkSize );
+	handle = Coding::instantiate( config.scheme, params, config.chunkSize, ! generic );
+	return handle ? tolerance : 0;
+}
+
+/**
+ * Mark the lost chunks of a failure pattern.
+ */
+void getLostChunks( BenchmarkConfig *config, bool *lost ) {
+	uint32_t n = config->k + config->m;
+	for ( uint32_t i = 0; i < n; i++ )
+		lost[ i ] = false;
+	for ( uint32_t i = 0; i < config->failures; i++ ) {
+		switch( config->pattern ) {
+			case FAILURE_DATA:
+				lost[ i ] = true;
+				break;
+			case FAILURE_PARITY:
+				lost[ n - 1 - i ] = true;
+				break;
+			case FAILURE_MIXED:
+				lost[ ( i % 2 == 0 ) ? i / 2 : n - 1 - i / 2 ] = true;
+				break;
+		}
+	}
+}
+
+void *run( void *argv ) {
+	BenchmarkThread *thread = ( BenchmarkThread * ) argv;
+	BenchmarkConfig *config = thread->config;
+	uint32_t k = config->k, m = config->m, n = k + m, chunkSize = config->chunkSize;
+	Chunk **chunks = ( Chunk ** ) malloc( sizeof( Chunk * ) * n );
+	Chunk **readbuf = ( Chunk ** ) malloc( sizeof( Chunk * ) * n );
+	char *delta = ( char * ) malloc( updateSize );
+	bool *lost = ( bool * ) malloc( sizeof( bool ) * n );
+	BitmaskArray bitmap( 1, n );
+	struct timespec st, lt = start_timer();
+	uint32_t dataIndex, offset;
+
+	// init chunks with random data
+	for ( uint32_t i = 0; i < n; i++ ) {
+		chunks[ i ] = tempChunkPool.alloc();
+		readbuf[ i ] = tempChunkPool.alloc();
+		if ( i < k ) {
+			char *data = ChunkUtil::getData( chunks[ i ] );
+			for ( uint32_t j = 0; j < chunkSize; j++ )
+				data[ j ] = ( char ) rand_r( &thread->seed );
+		}
+	}
+	for ( uint32_t i = 0; i < m; i++ )
+		handle->encode( chunks, chunks[ k + i ], i + 1 );
+
+	getLostChunks( config, lost );
+	for ( uint32_t i = 0; i < n; i++ ) {
+		if ( lost[ i ] )
+			bitmap.unset( i, 0 );
+		else
+			bitmap.set( i, 0 );
+		ChunkUtil::copy( readbuf[ i ], 0, ChunkUtil::getData( chunks[ i ] ), chunkSize );
+	}
+
+	thread->success = true;
+	thread->latencies.reserve( rounds );
+	st = start_timer();
+	for ( uint32_t i = 0; i < rounds + WARMUP_ROUNDS; i++ ) {
+		if ( i == WARMUP_ROUNDS )
+			st = start_timer();
+		switch( config->op ) {
+			case BENCHMARK_ENCODE:
+				lt = start_timer();
+				for ( uint32_t j = 0; j < m; j++ )
+					handle->encode( chunks, chunks[ k + j ], j + 1 );
+				break;
+			case BENCHMARK_DELTA:
+				// a random update within a data chunk
+				dataIndex = rand_r( &thread->seed ) % k;
+				offset = rand_r( &thread->seed ) % ( chunkSize - updateSize + 1 );
+				for ( uint32_t j = 0; j < updateSize; j++ )
+					delta[ j ] = ( char ) rand_r( &thread->seed );
+				lt = start_timer();
+				for ( uint32_t j = 0; j < m; j++ )
+					handle->encodeDelta( dataIndex, delta, offset, updateSize, j + 1, chunks[ k + j ] );
+				break;
+			case BENCHMARK_DECODE:
+				// lost chunks are recovered in place
+				for ( uint32_t j = 0; j < n; j++ ) {
+					if ( lost[ j ] )
+						ChunkUtil::clear( readbuf[ j ] );
+				}
+				lt = start_timer();
+				if ( ! handle->decode( readbuf, &bitmap ) )
+					thread->success = false;
+				break;
+		}
+		if ( i >= WARMUP_ROUNDS )
+			thread->latencies.push_back( get_elapsed_time( lt ) * MILLION );
+		if ( ! thread->success )
+			break;
+	}
+	thread->duration = get_elapsed_time( st );
+
+	if ( config->op == BENCHMARK_DECODE && thread->success ) {
+		for ( uint32_t i = 0; i < n; i++ ) {
+			if ( memcmp( ChunkUtil::getData( readbuf[ i ] ), ChunkUtil::getData( chunks[ i ] ), chunkSize ) != 0 ) {
+				fprintf( stderr, "Chunk %u is not correctly recovered.\n", i );
+				thread->success = false;
+				break;
+			}
+		}
+	}
+
+	for ( uint32_t i = 0; i < n; i++ ) {
+		tempChunkPool.free( chunks[ i ] );
+		tempChunkPool.free( readbuf[ i ] );
+	}
+	free( chunks );
+	free( readbuf );
+	free( delta );
+	free( lost );
+	return 0;
+}
+
+double percentile( std::vector<double> &sorted, double p ) {
+	size_t index = ( size_t ) ( p * sorted.size() );
+	if ( index >= sorted.size() )
+		index = sorted.size() - 1;
+	return sorted[ index ];
+}
+
+bool benchmark( BenchmarkConfig &config, BenchmarkResult &result ) {
+	std::vector<BenchmarkThread> threads( config.threads );
+	std::vector<pthread_t> tids( config.threads );
+	std::vector<double> latencies;
+	double sum = 0;
+
+	for ( uint32_t i = 0; i < config.threads; i++ ) {
+		threads[ i ].config = &config;
+		threads[ i ].seed = 12345 + i;
+		pthread_create( &tids[ i ], 0, run, &threads[ i ] );
+	}
+	result.duration = 0;
+	for ( uint32_t i = 0; i < config.threads; i++ ) {
+		pthread_join( tids[ i ], 0 );
+		if ( ! threads[ i ].success )
+			return false;
+		if ( threads[ i ].duration > result.duration )
+			result.duration = threads[ i ].duration;
+		latencies.insert( latencies.end(), threads[ i ].latencies.begin(), threads[ i ].latencies.end() );
+	}
+
+	std::sort( latencies.begin(), latencies.end() );
+	for ( size_t i = 0; i < latencies.size(); i++ )
+		sum += latencies[ i ];
+
+	result.ops = latencies.size();
+	result.bytes = ( uint64_t ) result.ops * ( config.op == BENCHMARK_DELTA ? updateSize : config.k * config.chunkSize );
+	result.throughput = result.bytes / GIGA / result.duration;
+	result.avg = sum / result.ops;
+	result.p50 = percentile( latencies, 0.5 );
+	result.p90 = percentile( latencies, 0.9 );
+	result.p99 = percentile( latencies, 0.99 );
+	result.p999 = percentile( latencies, 0.999 );
+	result.max = latencies.back();
+	return true;
+}
+
+void print( BenchmarkConfig &config, BenchmarkResult &result ) {
+	bool decode = config.op == BENCHMARK_DECODE;
+
+	if ( csv ) {
+		if ( ! headerPrinted ) {
+			printf( "backend,kernel,op,scheme,k,m,chunk_size,update_size,failures,pattern,threads,ops,bytes,seconds,gbps,avg_us,p50_us,p90_us,p99_us,p999_us,max_us\n" );
+			headerPrinted = true;
+		}
+		printf(
+			"%s,%s,%s,%s,%u,%u,%u,%u,%u,%s,%u,%u,%lu,%.6lf,%.4lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf\n",
+			BACKEND, generic ? "generic" : "auto", opNames[ config.op ], config.schemeName, config.k, config.m, config.chunkSize,
+			config.op == BENCHMARK_DELTA ? updateSize : 0,
+			decode ? config.failures : 0, decode ? patternNames[ config.pattern ] : "",
+			config.threads, result.ops, result.bytes, result.duration, result.throughput,
+			result.avg, result.p50, result.p90, result.p99, result.p999, result.max
+		);
+	} else {
+		printf( "%s\n  { ", headerPrinted ? "," : "[" );
+		headerPrinted = true;
+		printf(
+			"\"backend\": \"%s\", \"kernel\": \"%s\", \"op\": \"%s\", \"scheme\": \"%s\", \"k\": %u, \"m\": %u, \"chunk_size\": %u, ",
+			BACKEND, generic ? "generic" : "auto", opNames[ config.op ], config.schemeName, config.k, config.m, config.chunkSize
+		);
+		if ( config.op == BENCHMARK_DELTA )
+			printf( "\"update_size\": %u, ", updateSize );
+		if ( decode )
+			printf( "\"failures\": %u, \"pattern\": \"%s\", ", config.failures, patternNames[ config.pattern ] );
+		printf(
+			"\"threads\": %u, \"ops\": %u, \"bytes\": %lu, \"seconds\": %.6lf, \"gbps\": %.4lf, "
+			"\"latency_us\": { \"avg\": %.3lf, \"p50\": %.3lf, \"p90\": %.3lf, \"p99\": %.3lf, \"p999\": %.3lf, \"max\": %.3lf } }",
+			config.threads, result.ops, result.bytes, result.duration, result.throughput,
+			result.avg, result.p50, result.p90, result.p99, result.p999, result.max
+		);
+	}
+	fflush( stdout );
+}
+
+int main( int argc, char **argv ) {
+	int opt;
+	std::vector<uint32_t> schemes( 1, 3 ), ks, ms( 1, 2 ), chunkSizes, failures, patterns( 1, FAILURE_DATA ), threads( 1, 1 ), ops;
+	static struct option long_options[] = {
+		{ "scheme", required_argument, NULL, 's' },
+		{ "k", required_argument, NULL, 'k' },
+		{ "m", required_argument, NULL, 'm' },
+		{ "local", required_argument, NULL, 'l' },
+		{ "chunk-size", required_argument, NULL, 'c' },
+		{ "failures", required_argument, NULL, 'f' },
+		{ "pattern", required_argument, NULL, 'p' },
+		{ "threads", required_argument, NULL, 't' },
+		{ "op", required_argument, NULL, 'o' },
+		{ "update-size", required_argument, NULL, 'u' },
+		{ "rounds", required_argument, NULL, 'r' },
+		{ "generic", no_argument, NULL, 'g' },
+		{ "format", required_argument, NULL, 'F' },
+		{ "help", no_argument, NULL, 'h' },
+		{ 0, 0, 0, 0 }
+	};
+
+	ks.push_back( 4 );
+	ks.push_back( 6 );
+	ks.push_back( 8 );
+	chunkSizes.push_back( 4096 );
+	chunkSizes.push_back( 8192 );
+	failures.push_back( 1 );
+	failures.push_back( 2 );
+	ops.push_back( BENCHMARK_ENCODE );
+	ops.push_back( BENCHMARK_DELTA );
+	ops.push_back( BENCHMARK_DECODE );
+	updateSize = 64;
+	rounds = 1000;
+
+	opterr = 0;
+	while( ( opt = getopt_long( argc, argv, "s:k:m:l:c:f:p:t:o:u:r:gh", long_options, NULL ) ) != -1 ) {
+		bool valid = true;
+		switch( opt ) {
+			case 's':
+				valid = parseNames( optarg, schemeNames, sizeof( schemeNames ) / sizeof( schemeNames[ 0 ] ), schemes );
+				break;
+			case 'k':
+				valid = parseList( optarg, ks );
+				break;
+			case 'm':
+				valid = parseList( optarg, ms );
+				break;
+			case 'l':
+				localGroups = atoi( optarg );
+				break;
+			case 'c':
+				valid = parseList( optarg, chunkSizes );
+				break;
+			case 'f':
+				valid = parseList( optarg, failures );
+				break;
+			case 'p':
+				valid = parseNames( optarg, patternNames, sizeof( patternNames ) / sizeof( patternNames[ 0 ] ), patterns );
+				break;
+			case 't':
+				valid = parseList( optarg, threads );
+				break;
+			case 'o':
+				valid = parseNames( optarg, opNames, sizeof( opNames ) / sizeof( opNames[ 0 ] ), ops );
+				break;
+			case 'u':
+				updateSize = atoi( optarg );
+				valid = updateSize > 0;
+				break;
+			case 'r':
+				rounds = atoi( optarg );
+				valid = rounds > 0;
+				break;
+			case 'g':
+				generic = true;
+				break;
+			case 'F':
+				if ( strcmp( optarg, "csv" ) == 0 )
+					csv = true;
+				else if ( strcmp( optarg, "json" ) == 0 )
+					csv = false;
+				else
+					valid = false;
+				break;
+			case 'h':
+				usage( argv );
+				return 0;
+			default:
+				valid = false;
+				break;
+		}
+		if ( ! valid ) {
+			usage( argv );
+			return -1;
+		}
+	}
+
+	for ( size_t s = 0; s < schemes.size(); s++ ) {
+	for ( size_t ki = 0; ki < ks.size(); ki++ ) {
+	for ( size_t mi = 0; mi < ms.size(); mi++ ) {
+	for ( size_t ci = 0; ci < chunkSizes.size(); ci++ ) {
+		BenchmarkConfig config;
+		BenchmarkResult result;
+		uint32_t tolerance;
+
+		config.scheme = schemeValues[ schemes[ s ] ];
+		config.schemeName = schemeNames[ schemes[ s ] ];
+		config.k = ks[ ki ];
+		config.chunkSize = chunkSizes[ ci ];
+		// m is fixed for RAID-5, RDP and EVENODD
+		if ( mi > 0 && config.scheme != CS_RS && config.scheme != CS_CAUCHY && config.scheme != CS_LRC )
+			continue;
+		if ( updateSize > config.chunkSize ) {
+			fprintf( stderr, "Skipped chunk size %u (smaller than the update size).\n", config.chunkSize );
+			continue;
+		}
+		tolerance = setup( config, ms[ mi ] );
+		if ( tolerance == 0 ) {
+			fprintf( stderr, "Skipped %s with k = %u, m = %u (invalid parameters).\n", config.schemeName, config.k, ms[ mi ] );
+			continue;
+		}
+
+		for ( size_t oi = 0; oi < ops.size(); oi++ ) {
+			config.op = ( BenchmarkOp ) ops[ oi ];
+			bool decode = config.op == BENCHMARK_DECODE;
+			// failure patterns only apply to decode
+			for ( size_t fi = 0; fi < ( decode ? failures.size() : 1 ); fi++ ) {
+				config.failures = decode ? failures[ fi ] : 0;
+				if ( decode && config.failures > tolerance )
+					continue;
+				for ( size_t pi = 0; pi < ( decode ? patterns.size() : 1 ); pi++ ) {
+					config.pattern = ( FailurePattern ) patterns[ pi ];
+					for ( size_t ti = 0; ti < threads.size(); ti++ ) {
+						config.threads = threads[ ti ];
+						if ( ! benchmark( config, result ) ) {
+							fprintf(
+								stderr, "FAILED to %s with %s (k = %u, m = %u, chunk size = %u, failures = %u, pattern = %s)!!\n",
+								opNames[ config.op ], config.schemeName, config.k, config.m, config.chunkSize,
+								config.failures, patternNames[ config.pattern ]
+							);
+							Coding::destroy( handle );
+							return -1;
+						}
+						print( config, result );
+					}
+				}
+			}
+		}
+
+		Coding::destroy( handle );
+		handle = 0;
+	}
+	}
+	}
+	}
+
+	if ( ! csv )
+		printf( headerPrinted ? "\n]\n" : "[]\n" );
+
+	return 0;
+}
@@ -10,19 +10,22 @@
 #define CHUNK_SIZE (4096)
 #define C_K (8)
 #define C_M (3)
+// number of local groups for LRC (the remaining parity chunks are global)
+#define C_L (2)
 #define FAIL (1)
 #define FAIL2 (2)
 #define FAIL3 (3)
 // range of data modified within a chunk
 #define MODIFY_ST (3012)
 #define MODIFY_ED (4096)
+#define BATCH_SIZE (16)
 
 Coding* handle;
 CodingParams params;
 CodingScheme scheme;
 
 void usage( char* argv ) {
-	fprintf( stderr, "Usage: %s [raid5|cauchy|rdp|rs|evenodd]\n", argv);
+	fprintf( stderr, "Usage: %s [raid5|cauchy|rdp|rs|evenodd|lrc]\n", argv);
 }
 
 void printChunk( char *chunk, uint32_t id = 0 ) {
@@ -61,6 +64,9 @@ bool parseInput( char* arg ) {
 	} else if ( strcmp ( arg, "evenodd" ) == 0 ) {
 		params.setScheme ( CS_EVENODD );
 		scheme  = CS_EVENODD;
+	} else if ( strcmp ( arg, "lrc" ) == 0 ) {
+		params.setScheme ( CS_LRC );
+		scheme  = CS_LRC;
 	} else
 		return false;
 
@@ -73,6 +79,77 @@ void zeroChunks( Chunk **chunks ) {
 	}
 }
 
+/**
+ * Compare the compile-time specialized implementation of a configuration
+ * with the generic one on random data, and decode every recoverable
+ * erasure pattern with the specialized implementation.
+ */
+bool checkSpecialized( CodingScheme scheme, uint32_t k, uint32_t m ) {
+	CodingParams codingParams;
+	TempChunkPool tempChunkPool;
+	Chunk *chunks[ 32 ], *expected[ 32 ];
+	BitmaskArray status( 1, k + m );
+	bool ret = true;
+
+	codingParams.setScheme( scheme );
+	codingParams.setN( k + m );
+	codingParams.setK( k );
+	codingParams.setM( m );
+	Coding *generic = Coding::instantiate( scheme, codingParams, CHUNK_SIZE, false );
+	Coding *specialized = Coding::instantiate( scheme, codingParams, CHUNK_SIZE );
+
+	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
+		chunks[ idx ] = tempChunkPool.alloc();
+		expected[ idx ] = tempChunkPool.alloc();
+		if ( idx < k ) {
+			for ( uint32_t i = 0 ; i < CHUNK_SIZE ; i ++ )
+				ChunkUtil::getData( expected[ idx ] )[ i ] = ( char ) rand();
+		}
+	}
+	for ( uint32_t idx = 0 ; idx < m && ret ; idx ++ ) {
+		generic->encode( expected, expected[ k + idx ], idx + 1 );
+		specialized->encode( expected, chunks[ k + idx ], idx + 1 );
+		if ( memcmp( ChunkUtil::getData( chunks[ k + idx ] ), ChunkUtil::getData( expected[ k + idx ] ), CHUNK_SIZE ) != 0 ) {
+			fprintf( stdout, "FAILED to encode parity chunk %u with the specialized (%u, %u) code!!\n", idx, k, m );
+			ret = false;
+		}
+	}
+
+	for ( uint32_t pattern = 1 ; pattern < ( 1U << ( k + m ) ) && ret ; pattern ++ ) {
+		if ( ( uint32_t ) __builtin_popcount( pattern ) > m )
+			continue;
+		for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
+			if ( pattern & ( 1U << idx ) ) {
+				status.unset( idx, 0 );
+				ChunkUtil::clear( chunks[ idx ] );
+			} else {
+				status.set( idx, 0 );
+				ChunkUtil::dup( chunks[ idx ], expected[ idx ] );
+			}
+		}
+		if ( ! specialized->decode( chunks, &status ) ) {
+			fprintf( stdout, "FAILED to decode with erasure pattern 0x%x with the specialized (%u, %u) code!!\n", pattern, k, m );
+			ret = false;
+			break;
+		}
+		for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
+			if ( memcmp( ChunkUtil::getData( chunks[ idx ] ), ChunkUtil::getData( expected[ idx ] ), CHUNK_SIZE ) != 0 ) {
+				fprintf( stdout, "FAILED to recover chunk %u with erasure pattern 0x%x with the specialized (%u, %u) code!!\n", idx, pattern, k, m );
+				ret = false;
+				break;
+			}
+		}
+	}
+
+	for ( uint32_t idx = 0 ; idx < k + m ; idx ++ ) {
+		tempChunkPool.free( chunks[ idx ] );
+		tempChunkPool.free( expected[ idx ] );
+	}
+	delete generic;
+	delete specialized;
+	return ret;
+}
+
 int main( int argc, char **argv ) {
 
 	if ( argc < 2 ) {
@@ -140,12 +217,23 @@ int main( int argc, char **argv ) {
 			m = C_M;
 			printf( ">> encode K: %d   M: %d   ", C_K, C_M );
 			break;
+		case CS_LRC:
+			m = C_M;
+			printf( ">> encode K: %d   L: %d   M: %d   ", C_K, C_L, C_M - C_L );
+			break;
 		default:
 			return -1;
 	}
 	params.setN( C_K + m );
 	params.setK( C_K );
 	params.setM( m );
+	// number of arbitrary lost chunks that can always be recovered
+	uint32_t tolerance = m;
+	if ( scheme == CS_LRC ) {
+		params.setM( C_M - C_L );
+		params.setL( C_L );
+		tolerance = C_M - C_L + 1;
+	}
 	handle = Coding::instantiate( scheme, params, CHUNK_SIZE );
 	for (uint32_t idx = 0 ; idx < m ; idx ++ ) {
 		handle->encode( chunks, chunks[ C_K + idx ], idx + 1 );
@@ -172,11 +260,49 @@ int main( int argc, char **argv ) {
 		// compute data delta
 		Coding::bitwiseXOR( newData, oldData, newData, len );
 	}
+	// compute and apply parity delta incrementally on a copy of the parity chunks
+	Chunk *deltaParity[ C_M ];
+	// deltas received from the network are not necessarily aligned with the chunks
+	char *unaligned = ( char * ) malloc( MODIFY_ED - MODIFY_ST + 1 );
+	// the parity chunk should only change in the range reported by getDeltaRange()
+	char *before = ( char * ) malloc( CHUNK_SIZE );
+	uint32_t parityOffset, parityLength;
+	for ( uint32_t idx = 0 ; idx < m ; idx ++ ) {
+		deltaParity[ idx ] = tempChunkPool.alloc();
+		ChunkUtil::dup( deltaParity[ idx ], chunks[ C_K + idx ] );
+		for ( uint32_t i = 0; i < m; i++ ) {
+			memcpy( unaligned + 1, ChunkUtil::getData( readbuf[ failed[ i ] ] ) + MODIFY_ST, MODIFY_ED - MODIFY_ST );
+			memcpy( before, ChunkUtil::getData( deltaParity[ idx ] ), CHUNK_SIZE );
+			handle->encodeDelta(
+				failed[ i ], unaligned + 1,
+				MODIFY_ST, MODIFY_ED - MODIFY_ST,
+				idx + 1, deltaParity[ idx ]
+			);
+			handle->getDeltaRange( failed[ i ], MODIFY_ST, MODIFY_ED - MODIFY_ST, idx + 1, parityOffset, parityLength );
+			for ( uint32_t j = 0; j < CHUNK_SIZE; j++ ) {
+				if ( ( j < parityOffset || j >= parityOffset + parityLength ) && before[ j ] != ChunkUtil::getData( deltaParity[ idx ] )[ j ] ) {
+					fprintf( stdout, "FAILED to report the range of parity %u modified by encodeDelta() (offset %u)!!\n", idx, j );
+					return -1;
+				}
+			}
+		}
+	}
+	free( before );
 	// compute and apply parity delta
 	for ( uint32_t idx = 0 ; idx < m ; idx ++ ) {
 		handle->encode( readbuf, readbuf[ C_K + idx ], idx + 1, failed[ 0 ] * CHUNK_SIZE + MODIFY_ST, failed[ m - 1 ] * CHUNK_SIZE + MODIFY_ED );
 		Coding::bitwiseXOR( chunks[ C_K + idx ], readbuf[ C_K + idx ], chunks[ C_K + idx ], CHUNK_SIZE );
 	}
+	// both approaches should yield the same parity chunks
+	for ( uint32_t idx = 0 ; idx < m ; idx ++ ) {
+		if ( memcmp( ChunkUtil::getData( chunks[ C_K + idx ] ), ChunkUtil::getData( deltaParity[ idx ] ), CHUNK_SIZE ) != 0 ) {
+			fprintf( stdout, "FAILED to update parity %u with encodeDelta()!!\n", idx );
+			return -1;
+		}
+		tempChunkPool.free( deltaParity[ idx ] );
+	}
+	free( unaligned );
+	printf( "Parity delta matched\n" );
 	zeroChunks( readbuf );
 #endif
 
@@ -239,7 +365,7 @@ int main( int argc, char **argv ) {
 	}
 
 	// triple failure
-	if ( scheme != CS_RAID5 && scheme != CS_RDP && scheme != CS_EVENODD && m > 2 ) {
+	if ( scheme != CS_RAID5 && scheme != CS_RDP && scheme != CS_EVENODD && tolerance > 2 ) {
 		zeroChunks( readbuf );
 		printf( ">> fail disk %d, ", failed[ 0 ]);
 		bitmap.unset ( failed[ 0 ], 0 );
@@ -273,6 +399,200 @@ int main( int argc, char **argv ) {
 		fprintf( stdout, "\n" );
 	}
 
+	// all erasure patterns on random data, each decoded twice (the second time with the cached decode plan)
+	for ( uint32_t idx = 0 ; idx < C_K ; idx ++ ) {
+		for ( uint32_t i = 0 ; i < CHUNK_SIZE ; i ++ )
+			ChunkUtil::getData( chunks[ idx ] )[ i ] = ( char ) rand();
+	}
+	for ( uint32_t idx = 0 ; idx < m ; idx ++ ) {
+		ChunkUtil::clear( chunks[ C_K + idx ] );
+		handle->encode( chunks, chunks[ C_K + idx ], idx + 1 );
+	}
+	uint32_t patterns = 0, unrecoverable = 0;
+	for ( uint32_t pattern = 1 ; pattern < ( 1U << ( C_K + m ) ) ; pattern ++ ) {
+		if ( ( uint32_t ) __builtin_popcount( pattern ) > m )
+			continue;
+		for ( int round = 0 ; round < 2 ; round ++ ) {
+			zeroChunks( readbuf );
+			for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ ) {
+				if ( pattern & ( 1U << idx ) ) {
+					bitmap.unset( idx, 0 );
+				} else {
+					bitmap.set( idx, 0 );
+					ChunkUtil::copy( readbuf[ idx ], 0, ChunkUtil::getData( chunks[ idx ] ), CHUNK_SIZE );
+				}
+			}
+
+			if ( ! handle->decode( readbuf, &bitmap ) ) {
+				// patterns beyond the tolerance of non-MDS codes may not be recoverable
+				if ( ( uint32_t ) __builtin_popcount( pattern ) <= tolerance ) {
+					fprintf( stdout, "FAILED to decode with erasure pattern 0x%x (round %d)!!\n", pattern, round );
+					return -1;
+				}
+				unrecoverable++;
+				break;
+			}
+
+			for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ ) {
+				if ( memcmp( ChunkUtil::getData( readbuf[ idx ] ), ChunkUtil::getData( chunks[ idx ] ), CHUNK_SIZE ) != 0 ) {
+					fprintf( stdout, "FAILED to recover chunk %u with erasure pattern 0x%x (round %d)!!\n", idx, pattern, round );
+					return -1;
+				}
+			}
+		}
+		patterns++;
+	}
+	for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ )
+		bitmap.set( idx, 0 );
+	printf( ">> all %u erasure patterns recovered\n", patterns - unrecoverable );
+	if ( unrecoverable )
+		printf( ">> %u erasure patterns beyond %u lost chunks are not recoverable\n", unrecoverable, tolerance );
+
+	// single failure repaired from the repair set only (the other chunks are not read)
+	uint32_t repairSet[ C_K + C_M ], localRepairs = 0;
+	for ( uint32_t lostId = 0 ; lostId < C_K + m ; lostId ++ ) {
+		uint32_t count = handle->getRepairSet( lostId, repairSet );
+		if ( ! count )
+			continue;
+		zeroChunks( readbuf );
+		for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ )
+			bitmap.set( idx, 0 );
+		bitmap.unset( lostId, 0 );
+		for ( uint32_t i = 0 ; i < count ; i ++ )
+			ChunkUtil::copy( readbuf[ repairSet[ i ] ], 0, ChunkUtil::getData( chunks[ repairSet[ i ] ] ), CHUNK_SIZE );
+
+		handle->decode( readbuf, &bitmap );
+
+		if ( memcmp( ChunkUtil::getData( readbuf[ lostId ] ), ChunkUtil::getData( chunks[ lostId ] ), CHUNK_SIZE ) != 0 ) {
+			fprintf( stdout, "FAILED to repair chunk %u from %u chunks!!\n", lostId, count );
+			return -1;
+		}
+		localRepairs++;
+	}
+	for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ )
+		bitmap.set( idx, 0 );
+	if ( localRepairs )
+		printf( ">> %u chunks repaired from their local groups\n", localRepairs );
+
+	// single failure repaired by combining the partial results of the helpers one by one
+	// (as along a repair pipeline); the partial result is deliberately misaligned
+	char *partial = ( char * ) malloc( CHUNK_SIZE + 1 );
+	uint8_t coefficients[ C_K + C_M ];
+	uint32_t helperIds[ C_K + C_M ], pipelinedRepairs = 0;
+	for ( uint32_t lostId = 0 ; lostId < C_K + m ; lostId ++ ) {
+		uint32_t count = handle->getRepairSet( lostId, helperIds );
+		if ( ! count ) {
+			for ( uint32_t idx = 0 ; idx < C_K + m && count < C_K ; idx ++ ) {
+				if ( idx != lostId )
+					helperIds[ count++ ] = idx;
+			}
+		}
+		if ( ! handle->getRepairCoefficients( lostId, helperIds, count, coefficients ) )
+			continue;
+
+		memset( partial + 1, 0, CHUNK_SIZE );
+		for ( uint32_t i = 0 ; i < count ; i ++ ) {
+			for ( uint32_t offset = 0 ; offset < CHUNK_SIZE ; offset += CHUNK_SIZE / 4 ) {
+				Coding::multiplyXOR(
+					partial + 1 + offset,
+					ChunkUtil::getData( chunks[ helperIds[ i ] ] ) + offset,
+					coefficients[ i ], CHUNK_SIZE / 4
+				);
+			}
+		}
+
+		if ( memcmp( partial + 1, ChunkUtil::getData( chunks[ lostId ] ), CHUNK_SIZE ) != 0 ) {
+			fprintf( stdout, "FAILED to repair chunk %u by combining %u partial results!!\n", lostId, count );
+			return -1;
+		}
+		pipelinedRepairs++;
+	}
+	free( partial );
+	if ( pipelinedRepairs )
+		printf( ">> %u chunks repaired by combining partial results\n", pipelinedRepairs );
+
+	// batched decode
+	Chunk **stripes[ BATCH_SIZE ], **expected[ BATCH_SIZE ];
+	for ( uint32_t s = 0 ; s < BATCH_SIZE ; s ++ ) {
+		stripes[ s ] = ( Chunk ** ) malloc( sizeof( Chunk * ) * ( C_K + C_M ) );
+		expected[ s ] = ( Chunk ** ) malloc( sizeof( Chunk * ) * ( C_K + C_M ) );
+		for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ ) {
+			stripes[ s ][ idx ] = tempChunkPool.alloc();
+			expected[ s ][ idx ] = tempChunkPool.alloc();
+			ChunkUtil::clear( expected[ s ][ idx ] );
+		}
+		for ( uint32_t idx = 0 ; idx < C_K ; idx ++ ) {
+			for ( uint32_t i = 0 ; i < CHUNK_SIZE ; i ++ )
+				ChunkUtil::getData( expected[ s ][ idx ] )[ i ] = ( char ) rand();
+		}
+		for ( uint32_t idx = 0 ; idx < m ; idx ++ )
+			handle->encode( expected[ s ], expected[ s ][ C_K + idx ], idx + 1 );
+	}
+	for ( uint32_t pattern = 1 ; pattern < ( 1U << ( C_K + m ) ) ; pattern ++ ) {
+		if ( ( uint32_t ) __builtin_popcount( pattern ) != tolerance )
+			continue;
+		for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ ) {
+			if ( pattern & ( 1U << idx ) )
+				bitmap.unset( idx, 0 );
+			else
+				bitmap.set( idx, 0 );
+			for ( uint32_t s = 0 ; s < BATCH_SIZE ; s ++ ) {
+				ChunkUtil::dup( stripes[ s ][ idx ], expected[ s ][ idx ] );
+				if ( pattern & ( 1U << idx ) )
+					ChunkUtil::clear( stripes[ s ][ idx ] );
+			}
+		}
+		if ( ! handle->decodeBatch( stripes, BATCH_SIZE, &bitmap ) ) {
+			fprintf( stdout, "FAILED to decode batch with erasure pattern 0x%x!!\n", pattern );
+			return -1;
+		}
+		for ( uint32_t s = 0 ; s < BATCH_SIZE ; s ++ ) {
+			for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ ) {
+				if ( memcmp( ChunkUtil::getData( stripes[ s ][ idx ] ), ChunkUtil::getData( expected[ s ][ idx ] ), CHUNK_SIZE ) != 0 ) {
+					fprintf( stdout, "FAILED to recover chunk %u of stripe %u in batch with erasure pattern 0x%x!!\n", idx, s, pattern );
+					return -1;
+				}
+			}
+		}
+	}
+	for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ )
+		bitmap.set( idx, 0 );
+	for ( uint32_t s = 0 ; s < BATCH_SIZE ; s ++ ) {
+		for ( uint32_t idx = 0 ; idx < C_K + m ; idx ++ ) {
+			tempChunkPool.free( stripes[ s ][ idx ] );
+			tempChunkPool.free( expected[ s ][ idx ] );
+		}
+		free( stripes[ s ] );
+		free( expected[ s ] );
+	}
+	printf( ">> batches of %u stripes recovered\n", BATCH_SIZE );
+
+	// compile-time specialized configurations
+	std::vector< std::pair<uint32_t, uint32_t> > configs;
+	switch ( scheme ) {
+		case CS_RAID5:
+			for ( uint32_t k = 3 ; k <= 7 ; k ++ )
+				configs.push_back( std::make_pair( k, 1 ) );
+			break;
+		case CS_RS:
+			configs.push_back( std::make_pair( 4, 2 ) );
+			configs.push_back( std::make_pair( 6, 3 ) );
+			configs.push_back( std::make_pair( 10, 4 ) );
+			break;
+		case CS_RDP:
+		case CS_EVENODD:
+			configs.push_back( std::make_pair( 4, 2 ) );
+			break;
+		default:
+			break;
+	}
+	for ( uint32_t i = 0 ; i < configs.size() ; i ++ ) {
+		if ( ! checkSpecialized( scheme, configs[ i ].first, configs[ i ].second ) )
+			return -1;
+	}
+	if ( configs.size() )
+		printf( ">> %lu specialized configurations match the generic implementation\n", configs.size() );
+
 	// clean up
 	free( buf );
 	for ( uint32_t idx = 0 ; idx < m + C_K ; idx ++ ) {
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# Usage: [output CSV file] [benchmark options...]
+# Builds the benchmark against Jerasure and ISA-L in turn, runs the same sweep
+# with both and merges the results into one CSV file (see the "backend" column).
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 [output CSV file] [benchmark options...]"
+	exit 1
+fi
+
+EXE_DIR=$(dirname $0)/..
+OUT=$(readlink -f $1)
+shift
+
+cd ${EXE_DIR}
+
+rm -f ${OUT}
+for backend in jerasure isal; do
+	if [ ${backend} == "isal" ]; then
+		FLAGS="USE_ISAL=1"
+	else
+		FLAGS=""
+	fi
+	make clean > /dev/null
+	make ${FLAGS} benchmark || exit 1
+	if [ -f ${OUT} ]; then
+		./benchmark "$@" --format csv | tail -n +2 >> ${OUT}
+	else
+		./benchmark "$@" --format csv > ${OUT}
+	fi
+done
+make clean > /dev/null
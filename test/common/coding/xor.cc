@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../../../common/coding/coding.hh"
+#include "../../../common/coding/xor_kernel.hh"
+
+#define BUF_SIZE (8192)
+#define SOURCES (11)
+
+char *srcs[ SOURCES ];
+char *expected, *actual, *data, *delta;
+
+void fill( char *buf, uint32_t len ) {
+	for ( uint32_t i = 0; i < len; i++ )
+		buf[ i ] = ( char ) rand();
+}
+
+bool check( const char *name, XORKernelType type, uint32_t len, uint32_t offset ) {
+	if ( memcmp( expected, actual, len ) != 0 ) {
+		printf( "[%s] %s FAILED (len = %u, offset = %u)\n", XORKernel::getName( type ), name, len, offset );
+		return false;
+	}
+	return true;
+}
+
+bool test( XORKernelType type, uint32_t len, uint32_t offset ) {
+	char *inputs[ SOURCES ];
+	uint32_t i, j;
+	bool ret = true;
+
+	for ( i = 0; i < SOURCES; i++ ) {
+		fill( srcs[ i ], BUF_SIZE );
+		inputs[ i ] = srcs[ i ] + offset;
+	}
+
+	// 2-input XOR
+	for ( i = 0; i < len; i++ )
+		expected[ i ] = inputs[ 0 ][ i ] ^ inputs[ 1 ][ i ];
+	Coding::bitwiseXOR( actual, inputs[ 0 ], inputs[ 1 ], len );
+	ret &= check( "bitwiseXOR", type, len, offset );
+
+	// Multi-input XOR
+	for ( j = 1; j <= SOURCES; j++ ) {
+		for ( i = 0; i < len; i++ ) {
+			char c = inputs[ 0 ][ i ];
+			for ( uint32_t s = 1; s < j; s++ )
+				c ^= inputs[ s ][ i ];
+			expected[ i ] = c;
+		}
+		Coding::bitwiseXOR( actual, inputs, j, len );
+		ret &= check( "bitwiseXOR (multiple inputs)", type, len, offset );
+	}
+
+	// Fused delta (separate buffers)
+	memcpy( data, inputs[ 0 ], len );
+	for ( i = 0; i < len; i++ )
+		expected[ i ] = inputs[ 0 ][ i ] ^ inputs[ 1 ][ i ];
+	Coding::bitwiseXORDelta( actual, data, inputs[ 1 ], len );
+	ret &= check( "bitwiseXORDelta (delta)", type, len, offset );
+	memcpy( expected, inputs[ 1 ], len );
+	memcpy( actual, data, len );
+	ret &= check( "bitwiseXORDelta (data)", type, len, offset );
+
+	// Fused delta (delta aliases new data)
+	memcpy( data, inputs[ 0 ], len );
+	memcpy( delta, inputs[ 1 ], len );
+	for ( i = 0; i < len; i++ )
+		expected[ i ] = inputs[ 0 ][ i ] ^ inputs[ 1 ][ i ];
+	Coding::bitwiseXORDelta( delta, data, delta, len );
+	memcpy( actual, delta, len );
+	ret &= check( "bitwiseXORDelta (aliased delta)", type, len, offset );
+	memcpy( expected, inputs[ 1 ], len );
+	memcpy( actual, data, len );
+	ret &= check( "bitwiseXORDelta (aliased data)", type, len, offset );
+
+	return ret;
+}
+
+int main( int argc, char **argv ) {
+	uint32_t lengths[] = { 0, 1, 7, 8, 15, 16, 31, 33, 63, 64, 100, 255, 256, 1000, 4096, 4099 };
+	uint32_t offsets[] = { 0, 1, 3, 8 };
+	bool ret = true;
+
+	for ( uint32_t i = 0; i < SOURCES; i++ )
+		srcs[ i ] = ( char * ) malloc( BUF_SIZE );
+	expected = ( char * ) malloc( BUF_SIZE );
+	actual = ( char * ) malloc( BUF_SIZE );
+	data = ( char * ) malloc( BUF_SIZE );
+	delta = ( char * ) malloc( BUF_SIZE );
+	srand( 0 );
+
+	for ( int t = XOR_KERNEL_SCALAR; t <= XOR_KERNEL_AVX512; t++ ) {
+		XORKernelType type = ( XORKernelType ) t;
+		if ( ! XORKernel::select( type ) ) {
+			printf( "[%s] Not supported by this CPU; skipped.\n", XORKernel::getName( type ) );
+			continue;
+		}
+		bool passed = true;
+		for ( uint32_t l = 0; l < sizeof( lengths ) / sizeof( uint32_t ); l++ )
+			for ( uint32_t o = 0; o < sizeof( offsets ) / sizeof( uint32_t ); o++ )
+				passed &= test( type, lengths[ l ], offsets[ o ] );
+		printf( "[%s] %s\n", XORKernel::getName( type ), passed ? "Passed" : "FAILED" );
+		ret &= passed;
+	}
+
+	XORKernel::select();
+	printf( "Selected kernel: %s\n", XORKernel::getName( XORKernel::getType() ) );
+
+	for ( uint32_t i = 0; i < SOURCES; i++ )
+		free( srcs[ i ] );
+	free( expected );
+	free( actual );
+	free( data );
+	free( delta );
+
+	return ret ? 0 : -1;
+}
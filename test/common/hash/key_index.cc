@@ -0,0 +1,207 @@
+#include <string>
+#include <unordered_map>
+#include <assert.h>
+#include "../../../coordinator/ds/key_index.hh"
+
+// #define DUMP_ALL_DEBUG_MESSAGES
+
+char *generateRandomString( size_t len, char *buf ) {
+	static char alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	static int count = strlen( alphabet );
+	for ( size_t i = 0; i < len; i++ )
+		buf[ i ] = alphabet[ rand() % count ];
+	return buf;
+}
+
+struct {
+	int count;
+	int numTrials;
+	uint8_t keySize;
+} config;
+
+KeyIndex keyIndex;
+std::unordered_map<std::string, uint32_t> map;
+char **keys;
+
+struct KeyIndexEntry *find( char *key ) {
+	return keyIndex.find( KeyIndex::hash( key, config.keySize, false ), key, config.keySize, false );
+}
+
+void insert( int i ) {
+	char *key = keys[ i ];
+	uint64_t hash = KeyIndex::hash( key, config.keySize, false );
+	struct KeyIndexEntry *entry = keyIndex.find( hash, key, config.keySize, false );
+
+	if ( ! entry ) {
+		entry = keyIndex.insert( hash, config.keySize, false );
+		assert( entry->hash == hash && entry->key == 0 && entry->keySize == config.keySize && ! entry->isLarge );
+	}
+	// Keep a copy of every other key, as if their chunks were not sealed
+	if ( i % 2 == 0 )
+		keyIndex.copy( entry, key );
+	entry->stripeId = ( uint32_t ) i;
+	map[ std::string( key, config.keySize ) ] = ( uint32_t ) i;
+}
+
+void erase( int i ) {
+	struct KeyIndexEntry *entry = find( keys[ i ] );
+	if ( entry ) {
+		keyIndex.erase( entry );
+		map.erase( std::string( keys[ i ], config.keySize ) );
+	}
+}
+
+// Check every generated key against the reference map
+void verify( const char *stage ) {
+	struct KeyIndexEntry *entry;
+	std::unordered_map<std::string, uint32_t>::iterator it;
+	uint32_t count = 0;
+
+	for ( int i = 0; i < config.count; i++ ) {
+		entry = find( keys[ i ] );
+		it = map.find( std::string( keys[ i ], config.keySize ) );
+		if ( it == map.end() ) {
+			assert( entry == 0 );
+		} else {
+			assert( entry != 0 );
+			assert( entry->stripeId == it->second );
+		}
+	}
+	for ( uint32_t i = 0; i < keyIndex.getCapacity(); i++ ) {
+		if ( keyIndex.at( i ) )
+			count++;
+	}
+	assert( count == keyIndex.size() );
+	assert( keyIndex.size() == map.size() );
+
+	printf( "%-16s: %u keys in %u slots\n", stage, keyIndex.size(), keyIndex.getCapacity() );
+}
+
+int main( int argc, char **argv ) {
+	if ( argc != 4 ) {
+		fprintf( stderr, "Usage: %s [Object count] [Number of trials] [Key size]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	struct KeyIndexMemoryUsage usage;
+	struct KeyIndexEntry *entry;
+	uint32_t capacity;
+	char *largeKey;
+
+	// Parse arguments
+	config.count = atoi( argv[ 1 ] );
+	config.numTrials = atoi( argv[ 2 ] );
+	config.keySize = ( uint8_t ) atoi( argv[ 3 ] );
+
+	printf(
+		"Number of objects : %d\n"
+		"Number of trials  : %d\n"
+		"Key size          : %u bytes\n\n",
+		config.count, config.numTrials, config.keySize
+	);
+
+	// Generate keys
+	srand( time( 0 ) );
+	keys = ( char ** ) malloc( sizeof( char * ) * config.count );
+	for ( int i = 0; i < config.count; i++ ) {
+		keys[ i ] = ( char * ) malloc( config.keySize + SPLIT_OFFSET_SIZE );
+		generateRandomString( config.keySize, keys[ i ] );
+		memset( keys[ i ] + config.keySize, 0, SPLIT_OFFSET_SIZE );
+#ifdef DUMP_ALL_DEBUG_MESSAGES
+		printf( "[%5d] %.*s\n", i, config.keySize, keys[ i ] );
+#endif
+	}
+
+	// Insert (the table grows from its initial capacity)
+	assert( keyIndex.getCapacity() == KEY_INDEX_INIT_CAPACITY );
+	for ( int i = 0; i < config.count; i++ )
+		insert( i );
+	verify( "Insert" );
+	assert( ( uint64_t ) keyIndex.size() * 4 < ( uint64_t ) keyIndex.getCapacity() * 3 );
+
+	// A large object split is a different key from the small object
+	largeKey = keys[ 0 ];
+	assert( keyIndex.find( KeyIndex::hash( largeKey, config.keySize, true ), largeKey, config.keySize, true ) == 0 );
+
+	// Erase every third key, leaving deleted slots in the probe sequences
+	for ( int i = 0; i < config.count; i += 3 )
+		erase( i );
+	verify( "Erase" );
+
+	// Re-insert the erased keys into the deleted slots
+	for ( int i = 0; i < config.count; i += 3 )
+		insert( i );
+	verify( "Re-insert" );
+
+	// Churn without growing the number of keys: unless the table is more
+	// than half full, the deleted slots are dropped by rehashing at the
+	// same capacity instead of doubling it
+	capacity = keyIndex.getCapacity();
+	bool isHalfFull = ( uint64_t ) keyIndex.size() * 2 >= capacity;
+	for ( int round = 0; round < 8; round++ ) {
+		for ( int i = round % 3; i < config.count; i += 3 )
+			erase( i );
+		for ( int i = round % 3; i < config.count; i += 3 )
+			insert( i );
+	}
+	verify( "Churn" );
+	assert( keyIndex.getCapacity() == capacity || ( isHalfFull && keyIndex.getCapacity() == capacity * 2 ) );
+
+	// Copies of the keys
+	memset( &usage, 0, sizeof( usage ) );
+	keyIndex.getMemoryUsage( usage );
+	assert( usage.keys == keyIndex.size() );
+	assert( usage.slots == keyIndex.getCapacity() );
+	assert( usage.copyBytes == usage.copies * config.keySize );
+	assert( keyIndex.needsRelease() == ( usage.copies >= KEY_INDEX_MIN_RELEASE ) );
+	printf( "%-16s: %lu copies (%lu bytes)\n", "Copy", usage.copies, usage.copyBytes );
+
+	// Release all copies as if all chunks were sealed; the keys are then
+	// matched by their hashes only
+	for ( uint32_t i = 0; i < keyIndex.getCapacity(); i++ ) {
+		if ( ( entry = keyIndex.at( i ) ) ) {
+			keyIndex.release( entry );
+			assert( entry->key == 0 );
+		}
+	}
+	keyIndex.setNextRelease();
+	assert( ! keyIndex.needsRelease() );
+	memset( &usage, 0, sizeof( usage ) );
+	keyIndex.getMemoryUsage( usage );
+	assert( usage.copies == 0 && usage.copyBytes == 0 );
+	verify( "Release" );
+
+	// Copy the keys again after the release
+	for ( int i = 0; i < config.count; i += 2 ) {
+		if ( ( entry = find( keys[ i ] ) ) ) {
+			keyIndex.copy( entry, keys[ i ] );
+			assert( memcmp( entry->key, keys[ i ], config.keySize ) == 0 );
+		}
+	}
+	verify( "Copy again" );
+
+	// Random lookups
+	int success = 0, fail = 0;
+	for ( int i = 0; i < config.numTrials; i++ ) {
+		int index = rand() % config.count;
+		entry = find( keys[ index ] );
+		if ( entry && entry->stripeId == map[ std::string( keys[ index ], config.keySize ) ] )
+			success++;
+		else
+			fail++;
+	}
+	printf(
+		"\n---------- Statistics ----------\n"
+		"Success : %d / %d\n"
+		"Failed  : %d / %d\n",
+		success, config.numTrials,
+		fail, config.numTrials
+	);
+
+	// Release memory
+	for ( int i = 0; i < config.count; i++ )
+		free( keys[ i ] );
+	free( keys );
+
+	return fail == 0 ? 0 : 1;
+}
@@ -11,10 +11,10 @@ ChunkPool chunkPool;
 pthread_mutex_t lock;
 
 void *run( void *argv ) {
-	uint32_t listId = ( uint32_t ) ( rand() % 2000 );
+	uint32_t listId = ( uint32_t ) ( rand() % 256 );
 	Chunk **chunks = ( Chunk ** ) malloc( sizeof( Chunk * ) * numTrials );
 	for ( uint32_t i = 0; i < numTrials; i++ ) {
-		chunks[ i ] = chunkPool.alloc( listId, i, i, 0 );
+		chunks[ i ] = chunkPool.alloc( listId, i, i );
 		if ( chunks[ i ] )
 			memset( ( char * ) chunks[ i ] + CHUNK_IDENTIFIER_SIZE, 255, chunkSize );
 	}
@@ -24,10 +24,11 @@ void *run( void *argv ) {
 	for ( uint32_t i = 0; i < numTrials; i++ ) {
 		if ( chunks[ i ] ) {
 			// Check metadata
-			uint32_t *metadata = ( uint32_t * ) chunks[ i ];
-			printf( "#%u: [%u, %u, %u; size = %u] 0x%p\n", i, metadata[ 0 ], metadata[ 1 ], metadata[ 2 ], metadata[ 3 ], chunks[ i ] );
+			struct ChunkIdentifier *metadata = ( struct ChunkIdentifier * ) chunks[ i ];
+			printf( "#%u: [%u, %u, %u] 0x%p\n", i, metadata->listId, ( uint32_t ) metadata->stripeId, metadata->chunkId, chunks[ i ] );
 
-			assert( listId == metadata[ 0 ] );
+			assert( listId == metadata->listId );
+			assert( i      == metadata->stripeId );
 
 			// Check getChunk() correctness
 			uint32_t offset = rand() % chunkSize;
@@ -35,20 +36,18 @@ void *run( void *argv ) {
 				uint32_t listId;
 				uint32_t stripeId;
 				uint32_t chunkId;
-				uint32_t size;
 				uint32_t offset;
 				Chunk *chunk;
 			} result;
-			result.chunk = chunkPool.getChunk( ( char * ) chunks[ i ] + offset, result.offset );
+			result.chunk = chunkPool.getChunk( ( char * ) chunks[ i ] + CHUNK_IDENTIFIER_SIZE + offset, result.offset );
 
-			ChunkUtil::get( result.chunk, result.listId, result.stripeId, result.chunkId, result.size );
+			ChunkUtil::get( result.chunk, result.listId, result.stripeId, result.chunkId );
 
-			assert( result.listId   == metadata[ 0 ] );
-			assert( result.stripeId == metadata[ 1 ] );
-			assert( result.chunkId  == metadata[ 2 ] );
-			assert( result.size     == metadata[ 3 ] );
-			assert( result.offset   == offset        );
-			assert( result.chunk    == chunks[ i ]   );
+			assert( result.listId   == metadata->listId   );
+			assert( result.stripeId == metadata->stripeId );
+			assert( result.chunkId  == metadata->chunkId  );
+			assert( result.offset   == offset             );
+			assert( result.chunk    == chunks[ i ]        );
 
 			// for ( uint32_t j = 0; j < chunkSize; j++ )
 			// 	printf( "%d ", *( chunks[ i ] + CHUNK_IDENTIFIER_SIZE + j ) );
@@ -67,6 +66,41 @@ void *run( void *argv ) {
 	return 0;
 }
 
+void checkDirty() {
+	uint32_t total, index, count = 0;
+	std::atomic<unsigned int> allocated;
+	char *startAddress;
+	Chunk *chunk;
+
+	chunkPool.exportVars( &total, &allocated, &startAddress );
+	if ( allocated > total )
+		allocated = total;
+	assert( chunkPool.nextDirty( 0 ) == total );
+
+	// Mark every third allocated chunk as dirty (twice to check idempotence)
+	for ( uint32_t i = 0; i < allocated; i += 3 ) {
+		chunk = ( Chunk * )( startAddress + ( uint64_t ) i * ( CHUNK_IDENTIFIER_SIZE + chunkSize ) );
+		chunkPool.setDirty( chunk );
+		chunkPool.setDirty( chunk );
+	}
+	// Chunks outside the pool are ignored
+	chunkPool.setDirty( ( Chunk * )( startAddress - 1 ) );
+	chunkPool.setDirty( ( Chunk * )( startAddress + ( uint64_t ) total * ( CHUNK_IDENTIFIER_SIZE + chunkSize ) ) );
+
+	for ( index = chunkPool.nextDirty( 0 ); index < total; index = chunkPool.nextDirty( index + 1 ) ) {
+		assert( index % 3 == 0 && index < allocated );
+		count++;
+	}
+	assert( count == ( allocated + 2 ) / 3 );
+
+	// clearDirty() reports whether the bit was set
+	for ( uint32_t i = 0; i < allocated; i++ )
+		assert( chunkPool.clearDirty( i ) == ( i % 3 == 0 ) );
+	assert( chunkPool.nextDirty( 0 ) == total );
+
+	printf( "Dirty bitmap: %u of %u chunks marked and cleared.\n", count, ( uint32_t ) allocated );
+}
+
 int main( int argc, char **argv ) {
 	if ( argc != 5 ) {
 		fprintf( stderr, "Usage: %s [chunk size] [capacity] [number of trials] [number of threads]\n", argv[ 0 ] );
@@ -80,6 +114,7 @@ int main( int argc, char **argv ) {
 	pthread_mutex_init( &lock, 0 );
 	srand( time( 0 ) );
 
+	ChunkUtil::init( chunkSize, 1 );
 	chunkPool.init( chunkSize, capacity );
 
 	chunkPool.print();
@@ -98,5 +133,7 @@ int main( int argc, char **argv ) {
 	printf( "\n" );
 	chunkPool.print();
 
+	checkDirty();
+
 	return 0;
 }
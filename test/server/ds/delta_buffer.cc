@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../../../server/ds/delta_buffer.hh"
+
+#define CHUNK_SIZE 4096
+
+char *generateRandomDelta( size_t len, char *buf ) {
+	for ( size_t i = 0; i < len; i++ )
+		buf[ i ] = ( char )( rand() % 256 );
+	return buf;
+}
+
+// Append a delta to the buffer and to the expected chunk-sized delta
+bool append( DeltaBuffer &deltaBuffer, Metadata &metadata, uint32_t offset, uint32_t length, char *expected, uint32_t requestId ) {
+	char delta[ CHUNK_SIZE ];
+
+	generateRandomDelta( length, delta );
+	for ( uint32_t i = 0; i < length; i++ )
+		expected[ offset + i ] ^= delta[ i ];
+	return deltaBuffer.append( metadata, offset, length, delta, requestId /* timestamp */, 1, requestId );
+}
+
+void testMerge() {
+	DeltaBuffer deltaBuffer;
+	std::vector<std::pair<Metadata, ParityDelta>> deltas;
+	Metadata metadata;
+	char *expected = ( char * ) calloc( CHUNK_SIZE, 1 );
+
+	deltaBuffer.init( CHUNK_SIZE, CHUNK_SIZE * 4, 1000 );
+	metadata.set( 1, 2, 3 );
+
+	// Overlapping, disjoint and covering ranges are merged into one delta
+	append( deltaBuffer, metadata, 100, 10, expected, 1 );
+	append( deltaBuffer, metadata, 50, 20, expected, 2 );
+	append( deltaBuffer, metadata, 105, 30, expected, 3 );
+	append( deltaBuffer, metadata, 60, 4, expected, 4 );
+	assert( ! deltaBuffer.isEmpty() );
+
+	deltaBuffer.extract( deltas, true );
+	assert( deltaBuffer.isEmpty() );
+	assert( deltas.size() == 1 );
+
+	ParityDelta &delta = deltas[ 0 ].second;
+	assert( deltas[ 0 ].first.listId == 1 && deltas[ 0 ].first.stripeId == 2 && deltas[ 0 ].first.chunkId == 3 );
+	assert( delta.offset == 50 );
+	assert( delta.length == 85 );
+	assert( delta.timestamp == 4 );
+	assert( memcmp( delta.data, expected, CHUNK_SIZE ) == 0 );
+	// Client UPDATE requests in arrival order
+	assert( delta.requests.size() == 4 );
+	for ( uint32_t i = 0; i < 4; i++ )
+		assert( delta.requests[ i ].instanceId == 1 && delta.requests[ i ].requestId == i + 1 );
+
+	deltaBuffer.release( delta );
+	assert( delta.data == 0 );
+	free( expected );
+
+	printf( "Range merge: OK\n" );
+}
+
+void testExtract() {
+	DeltaBuffer deltaBuffer;
+	std::vector<std::pair<Metadata, ParityDelta>> deltas;
+	Metadata metadata;
+	char *expected = ( char * ) calloc( CHUNK_SIZE, 1 );
+
+	// The deltas are not due within the flush interval
+	deltaBuffer.init( CHUNK_SIZE, CHUNK_SIZE * 16, 60 * 1000 * 1000 );
+	for ( uint32_t stripeId = 0; stripeId < 3; stripeId++ ) {
+		for ( uint32_t chunkId = 0; chunkId < 2; chunkId++ ) {
+			metadata.set( 0, stripeId, chunkId );
+			append( deltaBuffer, metadata, 0, 8, expected, stripeId * 2 + chunkId );
+		}
+	}
+	deltaBuffer.extract( deltas, false );
+	assert( deltas.size() == 0 );
+
+	// Only the deltas of one stripe
+	deltaBuffer.extract( deltas, 0, 1 );
+	assert( deltas.size() == 2 );
+	for ( size_t i = 0; i < deltas.size(); i++ ) {
+		assert( deltas[ i ].first.listId == 0 && deltas[ i ].first.stripeId == 1 );
+		deltaBuffer.release( deltas[ i ].second );
+	}
+	deltas.clear();
+	deltaBuffer.extract( deltas, 0, 1 );
+	assert( deltas.size() == 0 );
+
+	// The rest
+	deltaBuffer.extract( deltas, true );
+	assert( deltas.size() == 4 );
+	for ( size_t i = 0; i < deltas.size(); i++ ) {
+		assert( deltas[ i ].first.stripeId != 1 );
+		deltaBuffer.release( deltas[ i ].second );
+	}
+	assert( deltaBuffer.isEmpty() );
+	deltas.clear();
+
+	// Due at once without a flush interval
+	deltaBuffer.init( CHUNK_SIZE, CHUNK_SIZE * 16, 0 );
+	metadata.set( 0, 0, 0 );
+	append( deltaBuffer, metadata, 0, 8, expected, 0 );
+	deltaBuffer.extract( deltas, false );
+	assert( deltas.size() == 1 );
+	deltaBuffer.release( deltas[ 0 ].second );
+	free( expected );
+
+	printf( "Extract: OK\n" );
+}
+
+void testMemoryLimit() {
+	DeltaBuffer deltaBuffer;
+	Metadata metadata;
+	char *expected = ( char * ) calloc( CHUNK_SIZE, 1 );
+
+	// Each chunk with deltas takes one chunk-sized buffer
+	deltaBuffer.init( CHUNK_SIZE, CHUNK_SIZE * 3, 1000 );
+	assert( deltaBuffer.isEnabled() );
+	metadata.set( 0, 0, 0 );
+	assert( ! append( deltaBuffer, metadata, 0, 16, expected, 0 ) );
+	assert( ! append( deltaBuffer, metadata, 16, 16, expected, 1 ) );
+	metadata.set( 0, 1, 0 );
+	assert( ! append( deltaBuffer, metadata, 0, 16, expected, 2 ) );
+	metadata.set( 0, 2, 0 );
+	assert( append( deltaBuffer, metadata, 0, 16, expected, 3 ) );
+	deltaBuffer.free();
+	assert( deltaBuffer.isEmpty() );
+
+	// Hold at least one delta
+	deltaBuffer.init( CHUNK_SIZE, 1, 1000 );
+	assert( deltaBuffer.maxSize == CHUNK_SIZE );
+	assert( append( deltaBuffer, metadata, 0, 16, expected, 0 ) );
+	deltaBuffer.free();
+
+	// Disabled
+	deltaBuffer.init( CHUNK_SIZE, 0, 1000 );
+	assert( ! deltaBuffer.isEnabled() );
+	free( expected );
+
+	printf( "Memory limit: OK\n" );
+}
+
+void testDeferAndWait() {
+	DeltaBuffer deltaBuffer;
+	std::vector<std::pair<Metadata, ParityDelta>> deltas;
+	std::vector<DeltaRequest> requests;
+	std::vector<DeltaWaiter> waiters;
+	DeltaWaiter waiter;
+	Metadata metadata;
+	char *expected = ( char * ) calloc( CHUNK_SIZE, 1 );
+
+	deltaBuffer.init( CHUNK_SIZE, CHUNK_SIZE * 4, 1000 );
+
+	// Chunk 0 of stripe 5 with three merged UPDATE requests; chunk 1 with one
+	metadata.set( 2, 5, 0 );
+	append( deltaBuffer, metadata, 0, 8, expected, 10 );
+	append( deltaBuffer, metadata, 8, 8, expected, 11 );
+	append( deltaBuffer, metadata, 16, 8, expected, 12 );
+	metadata.set( 2, 5, 1 );
+	append( deltaBuffer, metadata, 0, 8, expected, 20 );
+
+	// Nothing is sent yet
+	metadata.set( 2, 5, 3 );
+	waiter.set( 0, 1, 100, metadata, false );
+	assert( ! deltaBuffer.wait( waiter ) );
+	assert( ! deltaBuffer.isDrained() );
+
+	deltaBuffer.extract( deltas, 2, 5 );
+	assert( deltas.size() == 2 );
+	assert( deltaBuffer.isEmpty() );
+	// The UPDATE_CHUNK requests are sent with the request IDs 1000 and 1001
+	for ( size_t i = 0; i < deltas.size(); i++ ) {
+		deltaBuffer.defer( 1000 + i, deltas[ i ].first, deltas[ i ].second );
+		deltaBuffer.release( deltas[ i ].second );
+	}
+	assert( deltaBuffer.hasSentDeltas( 2, 5 ) );
+	assert( ! deltaBuffer.hasSentDeltas( 2, 6 ) );
+
+	// GET_CHUNK requests of the stripe wait for both deltas
+	assert( deltaBuffer.wait( waiter ) );
+	waiter.set( 0, 1, 101, metadata, true );
+	assert( deltaBuffer.wait( waiter ) );
+	metadata.set( 2, 6, 0 );
+	waiter.set( 0, 1, 102, metadata, true );
+	assert( ! deltaBuffer.wait( waiter ) );
+
+	// Unknown request
+	assert( ! deltaBuffer.take( 999, requests, waiters ) );
+
+	// The first merged request is acknowledged by the UPDATE_CHUNK response itself
+	assert( deltaBuffer.take( 1000, requests, waiters ) );
+	assert( requests.size() == 2 );
+	assert( requests[ 0 ].requestId == 11 && requests[ 1 ].requestId == 12 );
+	assert( waiters.size() == 0 );
+	assert( deltaBuffer.hasSentDeltas( 2, 5 ) );
+	assert( ! deltaBuffer.take( 1000, requests, waiters ) );
+
+	// The last acknowledgement of the stripe resumes the GET_CHUNK requests
+	requests.clear();
+	assert( deltaBuffer.take( 1001, requests, waiters ) );
+	assert( requests.size() == 0 );
+	assert( waiters.size() == 2 );
+	assert( waiters[ 0 ].requestId == 100 && ! waiters[ 0 ].toSend );
+	assert( waiters[ 1 ].requestId == 101 && waiters[ 1 ].toSend );
+	assert( waiters[ 0 ].metadata.listId == 2 && waiters[ 0 ].metadata.stripeId == 5 && waiters[ 0 ].metadata.chunkId == 3 );
+	assert( ! deltaBuffer.hasSentDeltas( 2, 5 ) );
+	assert( deltaBuffer.isDrained() );
+
+	metadata.set( 2, 5, 3 );
+	waiter.set( 0, 1, 103, metadata, false );
+	assert( ! deltaBuffer.wait( waiter ) );
+	free( expected );
+
+	printf( "Deferred acknowledgements and GET_CHUNK barrier: OK\n" );
+}
+
+int main( int argc, char **argv ) {
+	srand( time( 0 ) );
+
+	testMerge();
+	testExtract();
+	testMemoryLimit();
+	testDeferAndWait();
+
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "../../../server/storage/segment_storage.hh"
+#include "../../../common/ds/chunk_util.hh"
+
+uint32_t chunkSize;
+uint32_t numChunks;
+uint32_t numWorkers;
+char path[ STORAGE_PATH_MAX ];
+Chunk **expected;
+uint64_t writtenBytes;
+
+Chunk *allocChunk() {
+	return ( Chunk * ) calloc( CHUNK_IDENTIFIER_SIZE + chunkSize, 1 );
+}
+
+// Fill the chunk with random bytes; the odd chunks end with zeros that are not stored
+void generateChunk( Chunk *chunk, uint32_t i ) {
+	char *data = ChunkUtil::getData( chunk );
+	uint32_t size = ( i % 2 ) ? chunkSize - chunkSize / 4 : chunkSize;
+
+	ChunkUtil::set( chunk, 0, i, i % 4 );
+	for ( uint32_t j = 0; j < chunkSize; j++ )
+		data[ j ] = j < size ? ( char )( rand() % 255 + 1 ) : 0;
+}
+
+void write( SegmentStorage **storages, uint32_t count ) {
+	for ( uint32_t i = 0; i < numChunks; i++ ) {
+		generateChunk( expected[ i ], i );
+		ssize_t ret = storages[ i % count ]->write( expected[ i ], false );
+		assert( ret > 0 );
+		writtenBytes += SEGMENT_RECORD_HEADER_SIZE + ret;
+	}
+}
+
+void verify( SegmentStorage *storage, const char *stage ) {
+	Chunk *chunk = allocChunk();
+
+	for ( uint32_t i = 0; i < numChunks; i++ ) {
+		memset( chunk, 0xff, CHUNK_IDENTIFIER_SIZE + chunkSize );
+		assert( storage->read( chunk, 0, i, i % 4, false ) );
+		assert( memcmp( chunk, expected[ i ], CHUNK_IDENTIFIER_SIZE + chunkSize ) == 0 );
+	}
+	// Partial read
+	memset( chunk, 0, CHUNK_IDENTIFIER_SIZE + chunkSize );
+	assert( storage->read( chunk, 0, 1, 1, false, chunkSize / 2, chunkSize / 4 ) );
+	assert( memcmp( ChunkUtil::getData( chunk ) + chunkSize / 2, ChunkUtil::getData( expected[ 1 ] ) + chunkSize / 2, chunkSize / 4 ) == 0 );
+	// Missing chunk
+	assert( ! storage->read( chunk, 1, numChunks, 0, false ) );
+
+	free( chunk );
+	printf( "%-24s: %u chunks OK\n", stage, numChunks );
+}
+
+// Total size of the segment files; the last one is returned in last
+uint64_t getSegmentSize( char *last ) {
+	DIR *dir = opendir( path );
+	struct dirent *ent;
+	struct stat st;
+	char filename[ STORAGE_PATH_MAX * 2 ];
+	uint32_t segmentId, lastSegmentId = 0;
+	uint64_t size = 0;
+	char *end;
+
+	assert( dir );
+	while ( ( ent = readdir( dir ) ) ) {
+		segmentId = strtoul( ent->d_name, &end, 10 );
+		if ( end == ent->d_name || strcmp( end, ".seg" ) != 0 )
+			continue;
+		snprintf( filename, sizeof( filename ), "%s/%s", path, ent->d_name );
+		assert( stat( filename, &st ) == 0 );
+		size += st.st_size;
+		if ( segmentId >= lastSegmentId ) {
+			lastSegmentId = segmentId;
+			if ( last ) strcpy( last, filename );
+		}
+	}
+	closedir( dir );
+	return size;
+}
+
+void removeSegments() {
+	DIR *dir = opendir( path );
+	struct dirent *ent;
+	char filename[ STORAGE_PATH_MAX * 2 ];
+
+	while ( ( ent = readdir( dir ) ) ) {
+		if ( strstr( ent->d_name, ".seg" ) ) {
+			snprintf( filename, sizeof( filename ), "%s/%s", path, ent->d_name );
+			unlink( filename );
+		}
+	}
+	closedir( dir );
+	rmdir( path );
+}
+
+int main( int argc, char **argv ) {
+	if ( argc != 4 ) {
+		fprintf( stderr, "Usage: %s [chunk size] [number of chunks] [number of workers]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	chunkSize  = ( uint32_t ) atoi( argv[ 1 ] );
+	numChunks  = ( uint32_t ) atoi( argv[ 2 ] );
+	numWorkers = ( uint32_t ) atoi( argv[ 3 ] );
+	srand( time( 0 ) );
+
+	ChunkUtil::init( chunkSize, 1 );
+
+	strcpy( path, "/tmp/segment_storage.XXXXXX" );
+	assert( mkdtemp( path ) );
+
+	ServerConfig config;
+	config.storage.type = STORAGE_TYPE_SEGMENT;
+	strcpy( config.storage.path, path );
+	// A few records per segment and per write buffer
+	config.storage.segmentSize = 5 * ( SEGMENT_RECORD_HEADER_SIZE + chunkSize );
+	config.storage.writeBufferSize = 2 * ( SEGMENT_RECORD_HEADER_SIZE + chunkSize );
+	config.storage.syncInterval = 50;
+
+	expected = ( Chunk ** ) malloc( sizeof( Chunk * ) * numChunks );
+	for ( uint32_t i = 0; i < numChunks; i++ )
+		expected[ i ] = allocChunk();
+
+	printf(
+		"Chunk size        : %u bytes\n"
+		"Number of chunks  : %u\n"
+		"Number of workers : %u\n"
+		"Path              : %s\n\n",
+		chunkSize, numChunks, numWorkers, path
+	);
+
+	/* Write several versions of the chunks through all workers */
+	SegmentStorage **storages = new SegmentStorage *[ numWorkers ];
+	for ( uint32_t i = 0; i < numWorkers; i++ ) {
+		storages[ i ] = new SegmentStorage();
+		storages[ i ]->init( config );
+		assert( storages[ i ]->start() );
+	}
+	for ( uint32_t version = 0; version < 3; version++ )
+		write( storages, numWorkers );
+	// Including the records in the write buffers of the other workers
+	verify( storages[ 0 ], "Written" );
+
+	/* The background syncer writes out the buffers of idle workers */
+	usleep( config.storage.syncInterval * 4 * 1000 );
+	assert( getSegmentSize( 0 ) == writtenBytes );
+	printf( "%-24s: %lu bytes OK\n", "Synchronized", writtenBytes );
+
+	for ( uint32_t i = 0; i < numWorkers; i++ ) {
+		storages[ i ]->stop();
+		delete storages[ i ];
+	}
+
+	/* A partially written record at the tail is ignored */
+	char last[ STORAGE_PATH_MAX * 2 ];
+	getSegmentSize( last );
+	int fd = open( last, O_WRONLY | O_APPEND );
+	assert( fd != -1 );
+	assert( ::write( fd, expected[ 0 ], 7 ) == 7 );
+	close( fd );
+
+	/* Rebuild the index from the segments */
+	SegmentStorage *storage = new SegmentStorage();
+	storage->init( config );
+	assert( storage->start() );
+	verify( storage, "Loaded" );
+
+	// New records supersede the loaded ones
+	write( &storage, 1 );
+	verify( storage, "Written after load" );
+	storage->stop();
+	delete storage;
+
+	storage = new SegmentStorage();
+	storage->init( config );
+	assert( storage->start() );
+	verify( storage, "Loaded again" );
+	storage->stop();
+	delete storage;
+
+	removeSegments();
+	for ( uint32_t i = 0; i < numChunks; i++ )
+		free( expected[ i ] );
+	free( expected );
+	delete[] storages;
+
+	return 0;
+}